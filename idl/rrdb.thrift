@@ -29,7 +29,10 @@ enum filter_type
     FT_NO_FILTER,
     FT_MATCH_ANYWHERE,
     FT_MATCH_PREFIX,
-    FT_MATCH_POSTFIX
+    FT_MATCH_POSTFIX,
+    FT_MATCH_EXACT,
+    FT_MATCH_GLOB // '*' matches any sequence and '?' matches any single byte, the whole key
+                  // should be matched
 }
 
 enum cas_check_type
@@ -153,6 +156,7 @@ struct key_value
     1:dsn.blob      key;
     2:dsn.blob      value;
     3:optional i32  expire_ts_seconds;
+    4:optional i32  value_length; // set only if scan_pushdown.projection is SP_VALUE_LENGTH
 }
 
 struct multi_put_request
@@ -162,6 +166,21 @@ struct multi_put_request
     3:i32           expire_ts_seconds;
 }
 
+struct batch_put_entry
+{
+    1:dsn.blob      hash_key;
+    2:dsn.blob      sort_key;
+    3:dsn.blob      value;
+    4:i32           expire_ts_seconds;
+}
+
+// Put the entries of different hash keys by a single write, all of which must belong to the
+// same partition. The request could be batched with other puts into the same mutation.
+struct batch_put_request
+{
+    1:list<batch_put_entry> entries;
+}
+
 struct multi_remove_request
 {
     1:dsn.blob      hash_key;
@@ -182,6 +201,28 @@ struct multi_remove_response
     6:string        server;
 }
 
+// Delete all the sort keys of `hash_key` within the range by a single range tombstone, rather
+// than a tombstone for each key. Empty `start_sort_key` and `stop_sort_key` with both
+// inclusive mean to delete the whole hash key.
+struct del_range_request
+{
+    1:dsn.blob      hash_key;
+    2:dsn.blob      start_sort_key;
+    3:bool          start_inclusive = true;
+    // Empty means no limit.
+    4:dsn.blob      stop_sort_key;
+    5:bool          stop_inclusive = false;
+}
+
+struct del_range_response
+{
+    1:i32           error;
+    2:i32           app_id;
+    3:i32           partition_index;
+    4:i64           decree;
+    5:string        server;
+}
+
 struct multi_get_request
 {
     1:dsn.blob      hash_key;
@@ -310,6 +351,35 @@ struct check_and_mutate_response
     8:string         server;
 }
 
+enum scan_projection
+{
+    SP_KEY_VALUE,   // return both key and value
+    SP_KEY_ONLY,    // return key only, the same as `no_value`
+    SP_VALUE_LENGTH // return key and the length of value in `key_value.value_length`
+}
+
+// The predicates and projection pushed down to the server side for scan. The predicates
+// are evaluated right next to the rocksdb iterator, so that the filtered rows would never
+// be serialized into the response. All of the predicates set must be satisfied.
+struct scan_pushdown
+{
+    // Filter on the user value, the same as the filters on hash key and sort key.
+    1:optional filter_type  value_filter_type;
+    2:optional dsn.blob     value_filter_pattern;
+
+    // The user value must be within [value_start, value_stop) in bytes order. Unset means
+    // unbounded.
+    3:optional dsn.blob     value_start;
+    4:optional dsn.blob     value_stop;
+
+    // The expire_ts of the record must be within [min_expire_ts_seconds,
+    // max_expire_ts_seconds]. 0 means the record has no ttl. Unset means unbounded.
+    5:optional i32          min_expire_ts_seconds;
+    6:optional i32          max_expire_ts_seconds;
+
+    7:optional scan_projection projection;
+}
+
 struct get_scanner_request
 {
     1:dsn.blob  start_key;
@@ -326,11 +396,28 @@ struct get_scanner_request
     12:optional bool    return_expire_ts;
     13:optional bool full_scan; // true means client want to build 'full scan' context with the server side, false otherwise
     14:optional bool only_return_count = false;
+    15:optional scan_pushdown pushdown;
+    // The max total size of keys and values returned in one batch, <= 0 means no limit.
+    // The batch stops once it reaches either `batch_size` or `max_batch_bytes`.
+    16:optional i32 max_batch_bytes;
+    // True means [start_key, stop_key) is a sub-range of a partition split by get_split_keys,
+    // which may span many hash keys. The server iterates it in total order and bounds the
+    // iterator by stop_key, so that the sub-ranges could be scanned in parallel.
+    17:optional bool sub_range;
+    // True means a streaming scan: the client keeps several scan requests of the context in
+    // flight, each with an increasing `sequence` as a credit for one more batch, rather than
+    // waiting for each batch before requesting the next one. The context id is kept unchanged
+    // between the batches of a streaming scan.
+    18:optional bool stream;
 }
 
 struct scan_request
 {
     1:i64           context_id;
+    // The sequence of the requested batch of a streaming scan, starting from 1 after the
+    // batch returned by get_scanner. An unexpected sequence drops the context, in which case
+    // the client should restart the scan by get_scanner.
+    2:optional i64  sequence;
 }
 
 struct scan_response
@@ -342,14 +429,101 @@ struct scan_response
     5:i32           partition_index;
     6:string        server;
     7:optional i32  kv_count;
+    // True if the context returned by get_scanner supports streaming.
+    8:optional bool stream;
+}
+
+// Get the keys which split [start_key, stop_key) of a partition into split_count sub-ranges
+// of similar data sizes, according to the sst files and the memtables.
+struct get_split_keys_request
+{
+    1:dsn.blob      start_key;
+    2:dsn.blob      stop_key;
+    3:i32           split_count;
+}
+
+struct get_split_keys_response
+{
+    1:i32           error;
+    2:i32           app_id;
+    3:i32           partition_index;
+    4:string        server;
+    // At most split_count - 1 raw keys in ascending order, which may be fewer if the range
+    // is too small to split.
+    5:list<dsn.blob> split_keys;
+}
+
+enum aggregate_top_k_order
+{
+    ATO_ROW_COUNT, // order the hash keys by the number of rows
+    ATO_DATA_SIZE  // order the hash keys by the total size of keys and values
+}
+
+struct hash_key_stat
+{
+    1:dsn.blob      hash_key;
+    2:i64           row_count;
+    3:i64           data_size;
+}
+
+// Aggregate the rows of a partition next to the rocksdb iterator, and return only the
+// aggregated result. One request may not cover the whole range if it exceeds the iteration
+// limits, in which case the client should continue with `next_start_key` (inclusive) and
+// `last_hash_key_stat` from the response.
+struct aggregate_scan_request
+{
+    1:dsn.blob      start_key;
+    2:dsn.blob      stop_key;
+    3:bool          start_inclusive;
+    4:bool          stop_inclusive;
+    5:filter_type   hash_key_filter_type;
+    6:dsn.blob      hash_key_filter_pattern;
+    7:filter_type   sort_key_filter_type;
+    8:dsn.blob      sort_key_filter_pattern;
+    9:optional scan_pushdown pushdown;
+    10:bool         validate_partition_hash;
+    11:bool         full_scan;
+    // The ascending upper bounds of the buckets for the remaining ttl of the records. There
+    // are bounds.size() + 1 buckets, the i-th of which counts the records whose remaining
+    // ttl is in [bounds[i - 1], bounds[i]). The records without ttl are counted separately.
+    12:list<i32>    ttl_bucket_bounds_seconds;
+    // Return at most top_k_count hash keys, 0 means no need.
+    13:i32          top_k_count;
+    14:aggregate_top_k_order top_k_order;
+    // The unfinished hash key of the previous response, if any.
+    15:optional hash_key_stat last_hash_key_stat;
+}
+
+struct aggregate_scan_response
+{
+    1:i32           error;
+    2:i32           app_id;
+    3:i32           partition_index;
+    4:string        server;
+    5:i64           row_count;
+    // The number of hash keys that have been finished, excluding `last_hash_key_stat`.
+    6:i64           hash_key_count;
+    7:i64           key_bytes;
+    8:i64           value_bytes;
+    9:i64           no_ttl_count;
+    10:list<i64>    ttl_histogram;
+    // The top hash keys among the finished ones, in descending order.
+    11:list<hash_key_stat> top_hash_keys;
+    12:optional hash_key_stat last_hash_key_stat;
+    13:bool         complete;
+    14:dsn.blob     next_start_key;
+    15:i64          expire_count;
+    16:i64          filter_count;
 }
 
 service rrdb
 {
     update_response put(1:update_request update);
     update_response multi_put(1:multi_put_request request);
+    update_response batch_put(1:batch_put_request request);
     update_response remove(1:dsn.blob key);
     multi_remove_response multi_remove(1:multi_remove_request request);
+    del_range_response del_range(1:del_range_request request);
     incr_response incr(1:incr_request request);
     check_and_set_response check_and_set(1:check_and_set_request request);
     check_and_mutate_response check_and_mutate(1:check_and_mutate_request request);
@@ -361,6 +535,8 @@ service rrdb
     scan_response get_scanner(1:get_scanner_request request);
     scan_response scan(1:scan_request request);
     oneway void clear_scanner(1:i64 context_id);
+    aggregate_scan_response aggregate_scan(1:aggregate_scan_request request);
+    get_split_keys_response get_split_keys(1:get_split_keys_request request);
 }
 
 service meta
@@ -0,0 +1,423 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "io_uring_aio_provider.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "aio/aio_task.h"
+#include "aio/disk_engine.h"
+#include "rocksdb/env.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "runtime/service_engine.h"
+#include "utils/error_code.h"
+#include "utils/flags.h"
+#include "utils/fmt_logging.h"
+#include "utils/io_uring.h"
+#include "utils/latency_tracer.h"
+#include "utils/ports.h"
+#include "utils/safe_strerror_posix.h"
+
+DSN_DEFINE_uint32(core,
+                  io_uring_queue_depth,
+                  256,
+                  "The number of entries of the submission queue of the io_uring used by "
+                  "dsn::tools::io_uring_aio_provider");
+DSN_DEFINE_validator(io_uring_queue_depth, [](uint32_t value) -> bool { return value >= 2; });
+
+DSN_DECLARE_bool(encrypt_data_at_rest);
+
+namespace dsn {
+
+namespace {
+
+rocksdb::Status io_error(const std::string &context, int err)
+{
+    return rocksdb::Status::IOError(context, utils::safe_strerror(err));
+}
+
+rocksdb::Status pread_fully(int fd, uint64_t offset, size_t n, rocksdb::Slice *result, char *buf)
+{
+    size_t total = 0;
+    while (total < n) {
+        const auto ret = ::pread(fd, buf + total, n - total, static_cast<off_t>(offset + total));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return io_error("pread", errno);
+        }
+        if (ret == 0) {
+            break;
+        }
+        total += static_cast<size_t>(ret);
+    }
+    *result = rocksdb::Slice(buf, total);
+    return rocksdb::Status::OK();
+}
+
+rocksdb::Status pwrite_fully(int fd, uint64_t offset, const char *buf, size_t n)
+{
+    size_t total = 0;
+    while (total < n) {
+        const auto ret = ::pwrite(fd, buf + total, n - total, static_cast<off_t>(offset + total));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return io_error("pwrite", errno);
+        }
+        total += static_cast<size_t>(ret);
+    }
+    return rocksdb::Status::OK();
+}
+
+// The files opened by io_uring_aio_provider, whose file descriptors are used to build the
+// submission queue entries. They also support the synchronous operations for the fallback.
+class uring_read_file : public rocksdb::RandomAccessFile
+{
+public:
+    explicit uring_read_file(int fd) : _fd(fd) {}
+    ~uring_read_file() override { ::close(_fd); }
+
+    rocksdb::Status
+    Read(uint64_t offset, size_t n, rocksdb::Slice *result, char *scratch) const override
+    {
+        return pread_fully(_fd, offset, n, result, scratch);
+    }
+
+    int fd() const { return _fd; }
+
+private:
+    const int _fd;
+};
+
+class uring_rw_file : public rocksdb::RandomRWFile
+{
+public:
+    explicit uring_rw_file(int fd) : _fd(fd) {}
+    ~uring_rw_file() override { Close(); }
+
+    rocksdb::Status Write(uint64_t offset, const rocksdb::Slice &data) override
+    {
+        return pwrite_fully(_fd, offset, data.data(), data.size());
+    }
+
+    rocksdb::Status
+    Read(uint64_t offset, size_t n, rocksdb::Slice *result, char *scratch) const override
+    {
+        return pread_fully(_fd, offset, n, result, scratch);
+    }
+
+    rocksdb::Status Flush() override { return rocksdb::Status::OK(); }
+
+    rocksdb::Status Sync() override
+    {
+        return ::fdatasync(_fd) == 0 ? rocksdb::Status::OK() : io_error("fdatasync", errno);
+    }
+
+    rocksdb::Status Fsync() override
+    {
+        return ::fsync(_fd) == 0 ? rocksdb::Status::OK() : io_error("fsync", errno);
+    }
+
+    rocksdb::Status Close() override
+    {
+        if (_fd >= 0 && ::close(_fd) != 0) {
+            _fd = -1;
+            return io_error("close", errno);
+        }
+        _fd = -1;
+        return rocksdb::Status::OK();
+    }
+
+    int fd() const { return _fd; }
+
+private:
+    int _fd;
+};
+
+} // anonymous namespace
+
+struct io_uring_aio_provider::request
+{
+    aio_task *aio;
+    int fd;
+    bool is_write;
+    struct iovec iov;
+    uint64_t offset;
+};
+
+io_uring_aio_provider::io_uring_aio_provider(disk_engine *disk)
+    : native_linux_aio_provider(disk),
+      _max_inflight_requests(0),
+      _inflight_requests(0),
+      _unsubmitted_requests(0),
+      _submitting(false)
+{
+#ifdef DSN_HAS_IO_URING
+    _ring = utils::io_uring_queue::create(FLAGS_io_uring_queue_depth);
+    if (_ring != nullptr) {
+        // One entry is reserved for the NOP that stops the reaper.
+        _max_inflight_requests = _ring->sq_entries - 1;
+        _reaper = std::thread([this]() { reap_completions(); });
+        LOG_INFO("io_uring_aio_provider is initialized: queue_depth = {}", _ring->sq_entries);
+        return;
+    }
+#endif
+    LOG_WARNING("io_uring is not supported, fall back to native_linux_aio_provider");
+}
+
+io_uring_aio_provider::~io_uring_aio_provider()
+{
+    if (_ring == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        push_request(nullptr);
+    }
+    submit_pending_requests();
+    _reaper.join();
+}
+
+std::unique_ptr<rocksdb::RandomAccessFile>
+io_uring_aio_provider::open_read_file(const std::string &fname)
+{
+    if (_ring == nullptr || FLAGS_encrypt_data_at_rest) {
+        return native_linux_aio_provider::open_read_file(fname);
+    }
+
+    const int fd = ::open(fname.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("open read file '{}' failed, err = {}", fname, utils::safe_strerror(errno));
+        return nullptr;
+    }
+    return std::make_unique<uring_read_file>(fd);
+}
+
+std::unique_ptr<rocksdb::RandomRWFile>
+io_uring_aio_provider::open_write_file(const std::string &fname)
+{
+    if (_ring == nullptr || FLAGS_encrypt_data_at_rest) {
+        return native_linux_aio_provider::open_write_file(fname);
+    }
+
+    const int fd = ::open(fname.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("open write file '{}' failed, err = {}", fname, utils::safe_strerror(errno));
+        return nullptr;
+    }
+    return std::make_unique<uring_rw_file>(fd);
+}
+
+void io_uring_aio_provider::submit_aio_task(aio_task *aio_tsk)
+{
+    auto *aio_ctx = aio_tsk->get_aio_context();
+    int fd = -1;
+    if (_ring != nullptr && !service_engine::instance().is_simulator()) {
+        if (aio_ctx->type == AIO_Read) {
+            const auto *f = dynamic_cast<const uring_read_file *>(aio_ctx->dfile->rfile());
+            fd = f == nullptr ? -1 : f->fd();
+        } else if (aio_ctx->type == AIO_Write) {
+            const auto *f = dynamic_cast<const uring_rw_file *>(aio_ctx->dfile->wfile());
+            fd = f == nullptr ? -1 : f->fd();
+        }
+    }
+    if (fd < 0) {
+        native_linux_aio_provider::submit_aio_task(aio_tsk);
+        return;
+    }
+
+    ADD_POINT(aio_tsk->_tracer);
+    auto *req = new request();
+    req->aio = aio_tsk;
+    req->fd = fd;
+    req->is_write = aio_ctx->type == AIO_Write;
+    req->iov.iov_base = aio_ctx->buffer;
+    req->iov.iov_len = aio_ctx->buffer_size;
+    req->offset = aio_ctx->file_offset;
+
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (!_backlog.empty() || _inflight_requests >= _max_inflight_requests) {
+            _backlog.push_back(req);
+            return;
+        }
+        push_request(req);
+    }
+    submit_pending_requests();
+}
+
+void io_uring_aio_provider::push_request(request *req)
+{
+#ifdef DSN_HAS_IO_URING
+    // The submission queue never overflows since the requests being executed are limited.
+    auto *sqe = _ring->get_sqe();
+    CHECK_NOTNULL(sqe, "the submission queue of io_uring is full");
+    if (req == nullptr) {
+        sqe->opcode = IORING_OP_NOP;
+    } else {
+        sqe->opcode = req->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+        sqe->fd = req->fd;
+        sqe->addr = reinterpret_cast<uint64_t>(&req->iov);
+        sqe->len = 1;
+        sqe->off = req->offset;
+        ++_inflight_requests;
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    ++_unsubmitted_requests;
+#endif
+}
+
+void io_uring_aio_provider::submit_pending_requests()
+{
+#ifdef DSN_HAS_IO_URING
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        if (_submitting || _unsubmitted_requests == 0) {
+            // The requests would be submitted by the thread which is submitting.
+            return;
+        }
+        _submitting = true;
+    }
+
+    while (true) {
+        uint32_t count = 0;
+        {
+            std::lock_guard<std::mutex> l(_lock);
+            count = _unsubmitted_requests;
+            _unsubmitted_requests = 0;
+            if (count == 0) {
+                _submitting = false;
+                return;
+            }
+        }
+
+        while (count > 0) {
+            const int ret = _ring->enter(count, 0, 0);
+            if (ret < 0) {
+                CHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY,
+                      "io_uring_enter failed: {}",
+                      utils::safe_strerror(errno));
+                continue;
+            }
+            count -= static_cast<uint32_t>(ret);
+        }
+    }
+#endif
+}
+
+void io_uring_aio_provider::reap_completions()
+{
+#ifdef DSN_HAS_IO_URING
+    std::vector<std::pair<request *, int>> completed;
+    bool stopping = false;
+    while (true) {
+        const int ret = _ring->enter(0, 1, IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR) {
+            LOG_ERROR("io_uring_enter for completions failed: {}", utils::safe_strerror(errno));
+        }
+
+        // Only this thread updates the head, while the kernel updates the tail.
+        unsigned head = *_ring->cq_head;
+        const unsigned tail = __atomic_load_n(_ring->cq_tail, __ATOMIC_ACQUIRE);
+        completed.clear();
+        for (; head != tail; ++head) {
+            const auto &cqe = _ring->cqes[head & *_ring->cq_mask];
+            completed.emplace_back(reinterpret_cast<request *>(cqe.user_data), cqe.res);
+        }
+        __atomic_store_n(_ring->cq_head, head, __ATOMIC_RELEASE);
+
+        for (const auto &c : completed) {
+            if (c.first == nullptr) {
+                stopping = true;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> l(_lock);
+                --_inflight_requests;
+            }
+            on_request_completed(c.first, c.second);
+        }
+
+        {
+            std::lock_guard<std::mutex> l(_lock);
+            while (!_backlog.empty() && _inflight_requests < _max_inflight_requests) {
+                push_request(_backlog.front());
+                _backlog.pop_front();
+            }
+            // Stop once all the requests submitted before the NOP have been completed.
+            if (stopping && _inflight_requests == 0 && _backlog.empty()) {
+                return;
+            }
+        }
+        submit_pending_requests();
+    }
+#endif
+}
+
+void io_uring_aio_provider::on_request_completed(request *req, int res)
+{
+    std::unique_ptr<request> holder(req);
+    auto *aio_tsk = req->aio;
+    error_code err = ERR_OK;
+    uint64_t processed_bytes = 0;
+    if (res < 0) {
+        LOG_ERROR("{} file failed, err = {}",
+                  req->is_write ? "write" : "read",
+                  utils::safe_strerror(-res));
+        err = ERR_FILE_OPERATION_FAILED;
+    } else if (!req->is_write) {
+        // The same as native_linux_aio_provider::read().
+        processed_bytes = static_cast<uint64_t>(res);
+        err = res == 0 ? ERR_HANDLE_EOF : ERR_OK;
+    } else {
+        // Short writes hardly happen for regular files, just write the remaining data
+        // synchronously.
+        const auto written = static_cast<size_t>(res);
+        if (written < req->iov.iov_len) {
+            const auto s = pwrite_fully(req->fd,
+                                        req->offset + written,
+                                        static_cast<const char *>(req->iov.iov_base) + written,
+                                        req->iov.iov_len - written);
+            if (!s.ok()) {
+                LOG_ERROR("write file failed, err = {}", s.ToString());
+                err = ERR_FILE_OPERATION_FAILED;
+            }
+        }
+        if (err == ERR_OK) {
+            processed_bytes = req->iov.iov_len;
+        }
+    }
+
+    ADD_CUSTOM_POINT(aio_tsk->_tracer, "completed");
+    complete_io(aio_tsk, err, processed_bytes);
+}
+
+} // namespace dsn
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "aio/native_linux_aio_provider.h"
+
+namespace rocksdb {
+class RandomAccessFile;
+class RandomRWFile;
+} // namespace rocksdb
+
+namespace dsn {
+class aio_task;
+class disk_engine;
+
+namespace utils {
+struct io_uring_queue;
+} // namespace utils
+
+// io_uring_aio_provider submits the reads and writes of the files opened by it to an io_uring
+// instead of executing them by pread/pwrite on the thread pools of the tasks, so that a disk
+// is kept busy by much fewer threads.
+//
+// The submissions are batched: while a thread is entering the kernel, the requests submitted
+// by the other threads are queued on the ring and then submitted by that thread in a single
+// io_uring_enter(). The completions are reaped by a dedicated thread.
+//
+// It falls back to native_linux_aio_provider if io_uring is not supported by the kernel, for
+// the simulator, or for the files opened while FLAGS_encrypt_data_at_rest is enabled since
+// the data has to be encrypted by the rocksdb env.
+class io_uring_aio_provider : public native_linux_aio_provider
+{
+public:
+    explicit io_uring_aio_provider(disk_engine *disk);
+    ~io_uring_aio_provider() override;
+
+    std::unique_ptr<rocksdb::RandomAccessFile> open_read_file(const std::string &fname) override;
+    std::unique_ptr<rocksdb::RandomRWFile> open_write_file(const std::string &fname) override;
+
+    void submit_aio_task(aio_task *aio) override;
+
+private:
+    struct request;
+
+    // Put the request onto the submission queue, nullptr for a NOP. Must be called with
+    // `_lock` held.
+    void push_request(request *req);
+    // Enter the kernel to submit the queued requests unless another thread is doing that.
+    void submit_pending_requests();
+    void reap_completions();
+    void on_request_completed(request *req, int res);
+
+    std::unique_ptr<utils::io_uring_queue> _ring;
+    // The max number of requests being executed by the kernel, the others are kept in
+    // `_backlog` until some of the former are completed, thus the completion queue would
+    // never overflow.
+    uint32_t _max_inflight_requests;
+
+    std::mutex _lock;
+    std::deque<request *> _backlog;
+    uint32_t _inflight_requests;
+    uint32_t _unsubmitted_requests;
+    bool _submitting;
+
+    std::thread _reaper;
+};
+
+} // namespace dsn
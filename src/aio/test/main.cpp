@@ -22,7 +22,8 @@
 GTEST_API_ int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
-    dsn_run_config("config.ini", false);
+    // The config file could be specified to run the tests with another aio provider.
+    dsn_run_config(argc > 1 ? argv[1] : "config.ini", false);
     int g_test_ret = RUN_ALL_TESTS();
 #ifndef ENABLE_GCOV
     dsn_exit(g_test_ret);
@@ -30,4 +30,9 @@ fi
 
 ./clear.sh
 output_xml="${REPORT_DIR}/dsn_aio_test.xml"
-GTEST_OUTPUT="xml:${output_xml}" ./dsn_aio_test
+GTEST_OUTPUT="xml:${output_xml}" ./dsn_aio_test || exit 1
+
+# Run the same tests with io_uring_aio_provider, the elapsed time of the operations printed by
+# aio_test.basic could be compared with the above ones.
+output_xml="${REPORT_DIR}/dsn_aio_test_io_uring.xml"
+GTEST_OUTPUT="xml:${output_xml}" ./dsn_aio_test config-io-uring.ini
@@ -32,11 +32,15 @@ namespace pegasus {
 
 using multi_put_rpc = dsn::rpc_holder<dsn::apps::multi_put_request, dsn::apps::update_response>;
 
+using batch_put_rpc = dsn::rpc_holder<dsn::apps::batch_put_request, dsn::apps::update_response>;
+
 using put_rpc = dsn::rpc_holder<dsn::apps::update_request, dsn::apps::update_response>;
 
 using multi_remove_rpc =
     dsn::rpc_holder<dsn::apps::multi_remove_request, dsn::apps::multi_remove_response>;
 
+using del_range_rpc = dsn::rpc_holder<dsn::apps::del_range_request, dsn::apps::del_range_response>;
+
 using remove_rpc = dsn::rpc_holder<dsn::blob, dsn::apps::update_response>;
 
 using incr_rpc = dsn::rpc_holder<dsn::apps::incr_request, dsn::apps::incr_response>;
@@ -83,6 +83,21 @@ pegasus_extract_user_data(uint32_t version, std::string &&raw_value, ::dsn::blob
     user_data.assign(std::move(buf), 0, static_cast<unsigned int>(view.length()));
 }
 
+/// Extracts user value from a raw rocksdb value without any copy.
+/// The returned view points into `raw_value`, thus it's only valid while `raw_value` is.
+inline std::string_view pegasus_extract_user_data_view(uint32_t version,
+                                                       std::string_view raw_value)
+{
+    CHECK_LE(version, PEGASUS_DATA_VERSION_MAX);
+
+    dsn::data_input input(raw_value);
+    input.skip(sizeof(uint32_t));
+    if (version == 1) {
+        input.skip(sizeof(uint64_t));
+    }
+    return input.read_str();
+}
+
 /// Extracts timetag from a v1 value.
 inline uint64_t pegasus_extract_timetag(int version, std::string_view value)
 {
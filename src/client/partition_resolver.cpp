@@ -56,7 +56,7 @@ static inline bool error_retry(error_code err)
 {
     return (err != ERR_HANDLER_NOT_FOUND && err != ERR_APP_NOT_EXIST &&
             err != ERR_OPERATION_DISABLED && err != ERR_BUSY && err != ERR_SPLITTING &&
-            err != ERR_DISK_INSUFFICIENT);
+            err != ERR_DISK_INSUFFICIENT && err != ERR_PARTITION_HASH_MISMATCHED);
 }
 
 void partition_resolver::call_task(const rpc_response_task_ptr &t)
@@ -106,6 +106,12 @@ void partition_resolver::call_task(const rpc_response_task_ptr &t)
             }
         }
 
+        if (req->header->gpid.value() != 0 && err == ERR_PARTITION_HASH_MISMATCHED) {
+            // Not retried, but the partition count should be refreshed for the caller to regroup
+            // the rows of the request.
+            on_access_failure(req->header->gpid.get_partition_index(), err);
+        }
+
         if (oc)
             oc(err, req, resp);
     };
@@ -97,6 +97,9 @@ public:
 
     const char *log_prefix() const { return _app_name.c_str(); }
 
+    // Get the partition count of the app, -1 if it has not been resolved yet.
+    virtual int get_partition_count() const = 0;
+
 protected:
     partition_resolver(host_port meta_server, const char *app_name)
         : _app_name(app_name), _meta_server(meta_server)
@@ -97,7 +97,7 @@ void partition_resolver_simple::on_access_failure(int partition_index, error_cod
     }
 
     zauto_write_lock l(_config_lock);
-    if (err == ERR_PARENT_PARTITION_MISUSED) {
+    if (err == ERR_PARENT_PARTITION_MISUSED || err == ERR_PARTITION_HASH_MISMATCHED) {
         LOG_INFO("clear all partition configuration cache due to access failure {} at {}.{}",
                  err,
                  _app_id,
@@ -59,7 +59,7 @@ public:
 
     virtual void on_access_failure(int partition_index, error_code err) override;
 
-    int get_partition_count() const { return _app_partition_count; }
+    int get_partition_count() const override { return _app_partition_count; }
 
 private:
     struct partition_info
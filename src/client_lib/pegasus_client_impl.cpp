@@ -20,12 +20,16 @@
 #include <fmt/core.h>
 #include <pegasus/error.h>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "common/common.h"
 #include "common/replication_other_types.h"
@@ -37,6 +41,7 @@
 #include "rpc/group_host_port.h"
 #include "rpc/serialization.h"
 #include "rrdb/rrdb.client.h"
+#include "runtime/api_layer1.h"
 #include "task/async_calls.h"
 #include "task/task_code.h"
 #include "utils/error_code.h"
@@ -235,6 +240,132 @@ void pegasus_client_impl::async_multi_set(const std::string &hash_key,
                        partition_hash);
 }
 
+int pegasus_client_impl::batch_set(const std::vector<batch_set_item> &items,
+                                   int timeout_milliseconds)
+{
+    ::dsn::utils::notify_event op_completed;
+    int ret = -1;
+    auto callback = [&](int err) {
+        ret = err;
+        op_completed.notify();
+    };
+    async_batch_set(items, std::move(callback), timeout_milliseconds);
+    op_completed.wait();
+    return ret;
+}
+
+void pegasus_client_impl::async_batch_set(const std::vector<batch_set_item> &items,
+                                          async_batch_set_callback_t &&callback,
+                                          int timeout_milliseconds)
+{
+    // check params
+    if (items.empty()) {
+        LOG_ERROR("invalid items: items should not be empty");
+        if (callback != nullptr)
+            callback(PERR_INVALID_VALUE);
+        return;
+    }
+    for (const auto &item : items) {
+        if (item.hash_key.size() == 0) {
+            LOG_ERROR("invalid hash key: hash key should not be empty for batch_set");
+            if (callback != nullptr)
+                callback(PERR_INVALID_HASH_KEY);
+            return;
+        }
+        if (item.hash_key.size() >= UINT16_MAX) {
+            LOG_ERROR("invalid hash key: hash key length should be less than UINT16_MAX, but {}",
+                      item.hash_key.size());
+            if (callback != nullptr)
+                callback(PERR_INVALID_HASH_KEY);
+            return;
+        }
+    }
+
+    // The items are owned by the context, since the entries referring to them may be resent
+    // after this function returns.
+    auto ctx = std::make_shared<batch_set_context>();
+    ctx->items = items;
+    ctx->error = PERR_OK;
+    ctx->user_callback = std::move(callback);
+    ctx->deadline_ms = dsn_now_ms() + timeout_milliseconds;
+
+    std::vector<::dsn::apps::batch_put_entry> entries;
+    entries.reserve(ctx->items.size());
+    const auto now = utils::epoch_now();
+    for (const auto &item : ctx->items) {
+        ::dsn::apps::batch_put_entry entry;
+        entry.hash_key = ::dsn::blob(item.hash_key.data(), 0, item.hash_key.size());
+        entry.sort_key = ::dsn::blob(item.sort_key.data(), 0, item.sort_key.size());
+        entry.value = ::dsn::blob(item.value.data(), 0, item.value.size());
+        entry.expire_ts_seconds = item.ttl_seconds == 0 ? 0 : item.ttl_seconds + now;
+        entries.emplace_back(std::move(entry));
+    }
+
+    async_batch_put(ctx, std::move(entries), _client->get_partition_count());
+}
+
+void pegasus_client_impl::async_batch_put(const std::shared_ptr<batch_set_context> &ctx,
+                                          std::vector<::dsn::apps::batch_put_entry> &&entries,
+                                          int partition_count)
+{
+    // Group the entries by the partition they belong to. Before the partition count is resolved,
+    // the entries are grouped by the hash key, which would never span partitions.
+    struct batch
+    {
+        uint64_t partition_hash;
+        ::dsn::apps::batch_put_request req;
+    };
+    std::map<uint64_t, batch> batches;
+    for (auto &entry : entries) {
+        const auto partition_hash = pegasus_hash_key_hash(entry.hash_key);
+        auto &b = batches[partition_count > 0 ? partition_hash % partition_count : partition_hash];
+        if (b.req.entries.empty()) {
+            b.partition_hash = partition_hash;
+        }
+        b.req.entries.emplace_back(std::move(entry));
+    }
+
+    // The batch being regrouped, if any, is still counted in `remaining`.
+    ctx->remaining += batches.size();
+
+    const auto now_ms = dsn_now_ms();
+    const auto timeout = std::chrono::milliseconds(
+        ctx->deadline_ms > now_ms ? ctx->deadline_ms - now_ms : static_cast<uint64_t>(1));
+    for (auto &b : batches) {
+        // wrap the user-defined-callback-function, the user callback is invoked once all the
+        // batches have finished, with the first error of them.
+        auto new_callback = [this, ctx, entries = b.second.req.entries](
+                                ::dsn::error_code err,
+                                dsn::message_ex *,
+                                dsn::message_ex *resp) mutable {
+            if (err == ::dsn::ERR_PARTITION_HASH_MISMATCHED && dsn_now_ms() < ctx->deadline_ms) {
+                // The batch has been grouped by an out-of-date partition count, e.g. before the
+                // partition is split. Regroup it by the hash key, which never spans partitions.
+                async_batch_put(ctx, std::move(entries), -1);
+            } else {
+                if (err == ::dsn::ERR_PARTITION_HASH_MISMATCHED) {
+                    err = ::dsn::ERR_TIMEOUT;
+                }
+                ::dsn::apps::update_response response;
+                if (err == ::dsn::ERR_OK) {
+                    ::dsn::unmarshall(resp, response);
+                }
+                auto ret = get_client_error(
+                    (err == ::dsn::ERR_OK) ? get_rocksdb_server_error(response.error) : int(err));
+                if (ret != PERR_OK) {
+                    int expected = PERR_OK;
+                    ctx->error.compare_exchange_strong(expected, ret);
+                }
+            }
+            if (--ctx->remaining == 0 && ctx->user_callback != nullptr) {
+                ctx->user_callback(ctx->error.load());
+            }
+        };
+        _client->batch_put(
+            b.second.req, std::move(new_callback), timeout, b.second.partition_hash);
+    }
+}
+
 int pegasus_client_impl::get(const std::string &hash_key,
                              const std::string &sort_key,
                              std::string &value,
@@ -1218,6 +1349,17 @@ void pegasus_client_impl::async_get_unordered_scanners(
         if (err == ERR_OK) {
             ::dsn::unmarshall(resp, response);
             if (response.err == ERR_OK) {
+                const int splits_per_partition = std::min(
+                    options.max_splits_per_partition, max_split_count / response.partition_count);
+                if (splits_per_partition > 1) {
+                    async_get_sub_range_scanners(response.partition_count,
+                                                 splits_per_partition,
+                                                 options,
+                                                 async_get_unordered_scanners_callback_t(
+                                                     user_callback));
+                    return;
+                }
+
                 const int split_count = std::min(response.partition_count, max_split_count);
                 scanners.reserve(split_count);
 
@@ -1253,6 +1395,81 @@ void pegasus_client_impl::async_get_unordered_scanners(
                      0);
 }
 
+void pegasus_client_impl::async_get_sub_range_scanners(
+    int partition_count,
+    int splits_per_partition,
+    const scan_options &options,
+    async_get_unordered_scanners_callback_t &&callback)
+{
+    struct split_state
+    {
+        std::atomic_int pending;
+        std::vector<std::vector<::dsn::blob>> split_keys;
+        async_get_unordered_scanners_callback_t callback;
+    };
+    auto state = std::make_shared<split_state>();
+    state->pending = partition_count;
+    state->split_keys.resize(partition_count);
+    state->callback = std::move(callback);
+
+    auto on_all_split = [this, state, options]() {
+        scan_options sub_range_options(options);
+        sub_range_options.start_inclusive = true;
+        sub_range_options.stop_inclusive = false;
+
+        std::vector<pegasus_scanner *> scanners;
+        for (int i = 0; i < static_cast<int>(state->split_keys.size()); ++i) {
+            const auto &keys = state->split_keys[i];
+            if (keys.empty()) {
+                scanners.push_back(new pegasus_scanner_impl(_client,
+                                                            std::vector<uint64_t>({uint64_t(i)}),
+                                                            options,
+                                                            true,
+                                                            true));
+                continue;
+            }
+            for (size_t j = 0; j <= keys.size(); ++j) {
+                scanners.push_back(new pegasus_scanner_impl(
+                    _client,
+                    std::vector<uint64_t>({uint64_t(i)}),
+                    sub_range_options,
+                    j == 0 ? pegasus_scanner_impl::_min : keys[j - 1],
+                    j == keys.size() ? pegasus_scanner_impl::_max : keys[j],
+                    true,
+                    true,
+                    true));
+            }
+        }
+        state->callback(PERR_OK, std::move(scanners));
+    };
+
+    ::dsn::apps::get_split_keys_request req;
+    req.start_key = pegasus_scanner_impl::_min;
+    req.stop_key = pegasus_scanner_impl::_max;
+    req.split_count = splits_per_partition;
+    for (int i = 0; i < partition_count; ++i) {
+        _client->get_split_keys(
+            req,
+            [state, on_all_split, i](
+                ::dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) {
+                if (err == ERR_OK) {
+                    ::dsn::apps::get_split_keys_response response;
+                    ::dsn::unmarshall(resp, response);
+                    if (response.error == 0) {
+                        state->split_keys[i] = std::move(response.split_keys);
+                    }
+                }
+                // A partition failed to be split, e.g. the server does not support
+                // get_split_keys yet, will be scanned as a whole.
+                if (--state->pending == 0) {
+                    on_all_split();
+                }
+            },
+            std::chrono::milliseconds(options.timeout_ms),
+            i);
+    }
+}
+
 int pegasus_client_impl::get_unordered_scanners(int max_split_count,
                                                 const scan_options &options,
                                                 std::vector<pegasus_scanner *> &scanners)
@@ -22,6 +22,7 @@
 #include <pegasus/client.h>
 #include <rrdb/rrdb.client.h>
 #include <stdint.h>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <map>
@@ -34,10 +35,10 @@
 #include "rpc/rpc_host_port.h"
 #include "rrdb/rrdb_types.h"
 #include "utils/blob.h"
+#include "utils/error_code.h"
 #include "utils/zlocks.h"
 
 namespace dsn {
-class error_code;
 class message_ex;
 class task_tracker;
 } // namespace dsn
@@ -81,6 +82,13 @@ public:
                                  int timeout_milliseconds = 5000,
                                  int ttl_seconds = 0) override;
 
+    virtual int batch_set(const std::vector<batch_set_item> &items,
+                          int timeout_milliseconds = 5000) override;
+
+    virtual void async_batch_set(const std::vector<batch_set_item> &items,
+                                 async_batch_set_callback_t &&callback = nullptr,
+                                 int timeout_milliseconds = 5000) override;
+
     virtual int get(const std::string &hashkey,
                     const std::string &sortkey,
                     std::string &value,
@@ -292,7 +300,8 @@ public:
                              const ::dsn::blob &start_key,
                              const ::dsn::blob &stop_key,
                              bool validate_partition_hash,
-                             bool full_scan);
+                             bool full_scan,
+                             bool sub_range = false);
 
     private:
         enum class async_scan_type : char
@@ -320,18 +329,49 @@ public:
         volatile bool _rpc_started;
         bool _validate_partition_hash;
         bool _full_scan;
+        // Whether [_start_key, _stop_key) is a sub-range split by get_split_keys.
+        bool _sub_range;
         async_scan_type _type;
 
+        // The batches of a streaming scan which have been requested ahead of the consumer. It
+        // is shared with the callbacks of the requests, which may be called after the scanner
+        // has been destructed.
+        struct scan_stream
+        {
+            ::dsn::zlock lock;
+            // Increased once the stream is closed, to drop the responses of its requests.
+            int64_t epoch{0};
+            // The responses which have not been consumed, by sequence.
+            std::map<int64_t, std::pair<::dsn::error_code, ::dsn::apps::scan_response>> ready;
+            // The sequence the consumer is waiting for, 0 means not waiting. Only while the
+            // consumer is waiting could the callback of the request use the scanner.
+            int64_t waiting_sequence{0};
+        };
+        std::shared_ptr<scan_stream> _stream;
+        // Whether `_context` is a streaming context, whose batches are requested ahead.
+        bool _streaming;
+        int64_t _consume_sequence;
+        int64_t _request_sequence;
+
         void _async_next_internal();
         void _start_scan();
         void _next_batch();
         void _on_scan_response(::dsn::error_code, dsn::message_ex *, dsn::message_ex *);
+        void _on_scan_batch(::dsn::error_code, ::dsn::apps::scan_response &&);
         void _split_reset();
 
+        void _open_stream();
+        void _close_stream();
+        void _request_stream_batch();
+        void _next_stream_batch();
+        void _on_stream_batch(::dsn::error_code, ::dsn::apps::scan_response &&);
+
     private:
         static const char _holder[];
         static const ::dsn::blob _min;
         static const ::dsn::blob _max;
+
+        friend class pegasus_client_impl;
     };
 
     static int get_client_error(int server_error);
@@ -361,6 +401,32 @@ private:
         }
     };
 
+private:
+    struct batch_set_context
+    {
+        std::vector<batch_set_item> items;
+        // The number of the batches which have not finished.
+        std::atomic<size_t> remaining{0};
+        std::atomic<int> error;
+        async_batch_set_callback_t user_callback;
+        uint64_t deadline_ms;
+    };
+
+    // Send `entries` grouped by `partition_count` as the part of the batch_set of `ctx`. If a
+    // group turns out to span partitions, e.g. after the partition is split, it is regrouped by
+    // the hash key and resent until the deadline.
+    void async_batch_put(const std::shared_ptr<batch_set_context> &ctx,
+                         std::vector<::dsn::apps::batch_put_entry> &&entries,
+                         int partition_count);
+
+    // Split each of the `partition_count` partitions into at most `splits_per_partition`
+    // sub-ranges by get_split_keys, and create one scanner for each sub-range. The partitions
+    // failed to be split are scanned as a whole.
+    void async_get_sub_range_scanners(int partition_count,
+                                      int splits_per_partition,
+                                      const scan_options &options,
+                                      async_get_unordered_scanners_callback_t &&callback);
+
 private:
     std::string _cluster_name;
     std::string _app_name;
@@ -76,7 +76,8 @@ pegasus_client_impl::pegasus_scanner_impl::pegasus_scanner_impl(::dsn::apps::rrd
                                                                 const ::dsn::blob &start_key,
                                                                 const ::dsn::blob &stop_key,
                                                                 bool validate_partition_hash,
-                                                                bool full_scan)
+                                                                bool full_scan,
+                                                                bool sub_range)
     : _client(client),
       _start_key(start_key),
       _stop_key(stop_key),
@@ -88,7 +89,12 @@ pegasus_client_impl::pegasus_scanner_impl::pegasus_scanner_impl(::dsn::apps::rrd
       _rpc_started(false),
       _validate_partition_hash(validate_partition_hash),
       _full_scan(full_scan),
-      _type(async_scan_type::NORMAL)
+      _sub_range(sub_range),
+      _type(async_scan_type::NORMAL),
+      _stream(std::make_shared<scan_stream>()),
+      _streaming(false),
+      _consume_sequence(0),
+      _request_sequence(0)
 {
 }
 
@@ -216,7 +222,11 @@ void pegasus_client_impl::pegasus_scanner_impl::_async_next_internal()
             } else {
                 // valid context_id
                 _lock.unlock();
-                _next_batch();
+                if (_streaming) {
+                    _next_stream_batch();
+                } else {
+                    _next_batch();
+                }
                 return;
             }
         }
@@ -299,6 +309,12 @@ void pegasus_client_impl::pegasus_scanner_impl::_start_scan()
     req.__set_return_expire_ts(_options.return_expire_ts);
     req.__set_full_scan(_full_scan);
     req.__set_only_return_count(_options.only_return_count);
+    if (_sub_range) {
+        req.__set_sub_range(true);
+    }
+    if (_options.stream_credits > 1 && !_options.only_return_count) {
+        req.__set_stream(true);
+    }
 
     CHECK(!_rpc_started, "");
     _rpc_started = true;
@@ -320,6 +336,20 @@ void pegasus_client_impl::pegasus_scanner_impl::_on_scan_response(::dsn::error_c
     ::dsn::apps::scan_response response;
     if (err == ERR_OK) {
         ::dsn::unmarshall(resp, response);
+        if (response.error == 0 && response.__isset.stream && response.stream &&
+            response.context_id >= SCAN_CONTEXT_ID_VALID_MIN) {
+            // Request the following batches before consuming this one.
+            _context = response.context_id;
+            _open_stream();
+        }
+    }
+    _on_scan_batch(err, std::move(response));
+}
+
+void pegasus_client_impl::pegasus_scanner_impl::_on_scan_batch(
+    ::dsn::error_code err, ::dsn::apps::scan_response &&response)
+{
+    if (err == ERR_OK) {
         _info.app_id = response.app_id;
         _info.partition_index = response.partition_index;
         _info.decree = -1;
@@ -369,6 +399,97 @@ void pegasus_client_impl::pegasus_scanner_impl::_on_scan_response(::dsn::error_c
     }
 }
 
+void pegasus_client_impl::pegasus_scanner_impl::_open_stream()
+{
+    CHECK(!_streaming, "");
+    _streaming = true;
+    _consume_sequence = 1;
+    _request_sequence = 1;
+    for (int i = 0; i < _options.stream_credits; ++i) {
+        _request_stream_batch();
+    }
+}
+
+void pegasus_client_impl::pegasus_scanner_impl::_close_stream()
+{
+    _streaming = false;
+    ::dsn::zauto_lock l(_stream->lock);
+    ++_stream->epoch;
+    _stream->ready.clear();
+    _stream->waiting_sequence = 0;
+}
+
+void pegasus_client_impl::pegasus_scanner_impl::_request_stream_batch()
+{
+    ::dsn::apps::scan_request req;
+    req.context_id = _context;
+    req.__set_sequence(_request_sequence++);
+
+    int64_t epoch = 0;
+    {
+        ::dsn::zauto_lock l(_stream->lock);
+        epoch = _stream->epoch;
+    }
+    _client->scan(
+        req,
+        [this, stream = _stream, epoch, sequence = req.sequence](
+            ::dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) mutable {
+            ::dsn::apps::scan_response response;
+            if (err == ERR_OK) {
+                ::dsn::unmarshall(resp, response);
+            }
+            {
+                ::dsn::zauto_lock l(stream->lock);
+                if (stream->epoch != epoch) {
+                    // The stream has been closed, and the scanner may have been destructed.
+                    return;
+                }
+                stream->ready.emplace(sequence, std::make_pair(err, std::move(response)));
+                if (stream->waiting_sequence != sequence) {
+                    return;
+                }
+                stream->waiting_sequence = 0;
+            }
+            // The consumer is waiting for this batch, thus the scanner is still alive.
+            _next_stream_batch();
+        },
+        std::chrono::milliseconds(_options.timeout_ms),
+        _hash);
+}
+
+void pegasus_client_impl::pegasus_scanner_impl::_next_stream_batch()
+{
+    std::pair<::dsn::error_code, ::dsn::apps::scan_response> batch;
+    {
+        ::dsn::zauto_lock l(_stream->lock);
+        auto iter = _stream->ready.find(_consume_sequence);
+        if (iter == _stream->ready.end()) {
+            // Consume it once it is received.
+            _stream->waiting_sequence = _consume_sequence;
+            return;
+        }
+        batch = std::move(iter->second);
+        _stream->ready.erase(iter);
+    }
+    _on_stream_batch(batch.first, std::move(batch.second));
+}
+
+void pegasus_client_impl::pegasus_scanner_impl::_on_stream_batch(
+    ::dsn::error_code err, ::dsn::apps::scan_response &&response)
+{
+    ++_consume_sequence;
+    if (err == ERR_OK && response.error == 0 &&
+        response.context_id >= SCAN_CONTEXT_ID_VALID_MIN) {
+        // Grant the server a credit for one more batch in place of the consumed one.
+        _request_stream_batch();
+    } else {
+        // The scan is completed, or failed, or should be restarted since the context has been
+        // dropped by the server.
+        _close_stream();
+    }
+    _on_scan_batch(err, std::move(response));
+}
+
 void pegasus_client_impl::pegasus_scanner_impl::_split_reset()
 {
     _kvs.clear();
@@ -383,6 +504,9 @@ pegasus_client_impl::pegasus_scanner_impl::~pegasus_scanner_impl()
     CHECK(!_rpc_started, "all scan-rpc should be completed here");
     CHECK(_queue.empty(), "queue should be empty");
 
+    if (_streaming) {
+        _close_stream();
+    }
     if (_client) {
         if (_context >= SCAN_CONTEXT_ID_VALID_MIN)
             _client->clear_scanner(_context, _hash);
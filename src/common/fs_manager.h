@@ -109,6 +109,10 @@ public:
     bool has(const dsn::gpid &pid) const;
     uint64_t remove(const dsn::gpid &pid);
     void update_disk_stat();
+    const metric_entity_ptr &disk_metric_entity() const
+    {
+        return disk_capacity.disk_metric_entity();
+    }
 };
 
 // Track the data directories and replicas.
@@ -87,6 +87,8 @@ const std::string replica_envs::ROCKSDB_CHECKPOINT_RESERVE_TIME_SECONDS(
 const std::string replica_envs::ROCKSDB_ITERATION_THRESHOLD_TIME_MS(
     "replica.rocksdb_iteration_threshold_time_ms");
 const std::string replica_envs::ROCKSDB_BLOCK_CACHE_ENABLED("replica.rocksdb_block_cache_enabled");
+/// true means the decoded values read by get requests are cached in front of rocksdb
+const std::string replica_envs::HOT_ROW_CACHE_ENABLED("replica.hot_row_cache_enabled");
 const std::string replica_envs::BUSINESS_INFO("business.info");
 const std::string replica_envs::REPLICA_ACCESS_CONTROLLER_ALLOWED_USERS(
     "replica_access_controller.allowed_users");
@@ -99,6 +101,14 @@ const std::string replica_envs::READ_SIZE_THROTTLING("replica.read_throttling_by
 const std::string
     replica_envs::SPLIT_VALIDATE_PARTITION_HASH("replica.split.validate_partition_hash");
 
+/// the max number of mutations that a secondary could ack before they are logged, 0 means the
+/// prepares are acked only after logged. Once > 0, the writes are acked without waiting for the
+/// private logs of the secondaries, which would lose the latest writes within the window if the
+/// primary and the secondaries failed at the same time. Only for the tables which could tolerate
+/// such loss, e.g. the cache-like tables
+const std::string
+    replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW("replica.secondary_unlogged_ack_window");
+
 /// json string which represents user specified compaction
 const std::string replica_envs::USER_SPECIFIED_COMPACTION("user_specified_compaction");
 const std::string replica_envs::BACKUP_REQUEST_QPS_THROTTLING("replica.backup_request_throttling");
@@ -46,6 +46,7 @@ public:
     static const std::string ROCKSDB_CHECKPOINT_RESERVE_TIME_SECONDS;
     static const std::string ROCKSDB_ITERATION_THRESHOLD_TIME_MS;
     static const std::string ROCKSDB_BLOCK_CACHE_ENABLED;
+    static const std::string HOT_ROW_CACHE_ENABLED;
     static const std::string MANUAL_COMPACT_ONCE_PREFIX;
     static const std::string MANUAL_COMPACT_PERIODIC_PREFIX;
     static const std::string MANUAL_COMPACT_DISABLED;
@@ -65,6 +66,7 @@ public:
     static const std::string READ_SIZE_THROTTLING;
     static const std::string BACKUP_REQUEST_QPS_THROTTLING;
     static const std::string SPLIT_VALIDATE_PARTITION_HASH;
+    static const std::string SECONDARY_UNLOGGED_ACK_WINDOW;
     static const std::string USER_SPECIFIED_COMPACTION;
     static const std::string ROCKSDB_ALLOW_INGEST_BEHIND;
     static const std::string UPDATE_MAX_REPLICA_COUNT;
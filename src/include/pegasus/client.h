@@ -27,6 +27,7 @@
 #include <pegasus/error.h>
 #include <functional>
 #include <memory>
+#include <utility>
 
 #include "utils/fmt_utils.h"
 
@@ -87,7 +88,8 @@ public:
         FT_MATCH_ANYWHERE = 1,
         FT_MATCH_PREFIX = 2,
         FT_MATCH_POSTFIX = 3,
-        FT_MATCH_EXACT = 4
+        FT_MATCH_EXACT = 4,
+        FT_MATCH_GLOB = 5
     };
 
     struct multi_get_options
@@ -117,6 +119,22 @@ public:
         }
     };
 
+    struct batch_set_item
+    {
+        std::string hash_key;
+        std::string sort_key;
+        std::string value;
+        int ttl_seconds; // 0 means no ttl
+        batch_set_item() : ttl_seconds(0) {}
+        batch_set_item(std::string hk, std::string sk, std::string v, int ttl = 0)
+            : hash_key(std::move(hk)),
+              sort_key(std::move(sk)),
+              value(std::move(v)),
+              ttl_seconds(ttl)
+        {
+        }
+    };
+
     // TODO(yingchun): duplicate with cas_check_type in idl/rrdb.thrift
     enum cas_check_type
     {
@@ -256,6 +274,16 @@ public:
         bool no_value; // only fetch hash_key and sort_key, but not fetch value
         bool return_expire_ts;
         bool only_return_count;
+        // Used by get_unordered_scanners() only. Split each partition into at most
+        // max_splits_per_partition sub-ranges of similar data sizes, which could be scanned
+        // in parallel. The total count of the scanners is still limited by max_split_count.
+        int max_splits_per_partition;
+        // The max count of the batches requested ahead of the consumer, each of which is a
+        // credit granted to the server. The following batches are requested as the former ones
+        // are consumed, thus the server could keep sending batches without waiting for a round
+        // trip between them. <= 1 means to request each batch only after the former one has
+        // been consumed.
+        int stream_credits;
         scan_options()
             : timeout_ms(5000),
               batch_size(100),
@@ -265,7 +293,9 @@ public:
               sort_key_filter_type(FT_NO_FILTER),
               no_value(false),
               return_expire_ts(false),
-              only_return_count(false)
+              only_return_count(false),
+              max_splits_per_partition(1),
+              stream_credits(1)
         {
         }
         scan_options(const scan_options &o)
@@ -279,7 +309,9 @@ public:
               sort_key_filter_pattern(o.sort_key_filter_pattern),
               no_value(o.no_value),
               return_expire_ts(o.return_expire_ts),
-              only_return_count(o.only_return_count)
+              only_return_count(o.only_return_count),
+              max_splits_per_partition(o.max_splits_per_partition),
+              stream_credits(o.stream_credits)
         {
         }
     };
@@ -290,6 +322,7 @@ public:
     typedef std::function<void(int /*error_code*/, internal_info && /*info*/)> async_set_callback_t;
     typedef std::function<void(int /*error_code*/, internal_info && /*info*/)>
         async_multi_set_callback_t;
+    typedef std::function<void(int /*error_code*/)> async_batch_set_callback_t;
     typedef std::function<void(
         int /*error_code*/, std::string && /*value*/, internal_info && /*info*/)>
         async_get_callback_t;
@@ -516,6 +549,41 @@ public:
                                  int timeout_milliseconds = 5000,
                                  int ttl_seconds = 0) = 0;
 
+    ///
+    /// \brief batch_set
+    ///     store multiple k-v of different hashkeys to the cluster. the items are grouped by
+    ///     the partition they belong to, and each group is written by a single request.
+    ///     atomicity is only guaranteed for the items in the same partition.
+    /// \param items
+    /// all <hashkey,sortkey,value,ttl> items to be set. should not be empty
+    /// \param timeout_milliseconds
+    /// if wait longer than this value, will return time out error
+    /// \return
+    /// int, the error indicates whether or not the operation is succeeded.
+    /// this error can be converted to a string using get_error_string().
+    /// if any of the groups fails, the first error is returned, and the items of the other
+    /// groups might have been written.
+    ///
+    virtual int batch_set(const std::vector<batch_set_item> &items,
+                          int timeout_milliseconds = 5000) = 0;
+
+    ///
+    /// \brief asynchronous batch_set
+    ///     store multiple k-v of different hashkeys to the cluster.
+    ///     will not be blocked, return immediately.
+    /// \param items
+    /// all <hashkey,sortkey,value,ttl> items to be set. should not be empty
+    /// \param callback
+    /// the callback function will be invoked after all the groups finished or error occurred.
+    /// \param timeout_milliseconds
+    /// if wait longer than this value, will return time out error
+    /// \return
+    /// void.
+    ///
+    virtual void async_batch_set(const std::vector<batch_set_item> &items,
+                                 async_batch_set_callback_t &&callback = nullptr,
+                                 int timeout_milliseconds = 5000) = 0;
+
     ///
     /// \brief get
     ///     get value by key from the cluster.
@@ -103,6 +103,24 @@ public:
                                   reply_thread_hash);
     }
 
+    // ---------- call RPC_RRDB_RRDB_BATCH_PUT ------------
+    // - asynchronous with on-stack batch_put_request and update_response
+    template <typename TCallback>
+    ::dsn::task_ptr batch_put(const batch_put_request &args,
+                              TCallback &&callback,
+                              std::chrono::milliseconds timeout,
+                              uint64_t request_partition_hash,
+                              int reply_thread_hash = 0)
+    {
+        return _resolver->call_op(RPC_RRDB_RRDB_BATCH_PUT,
+                                  args,
+                                  &_tracker,
+                                  std::forward<TCallback>(callback),
+                                  timeout,
+                                  request_partition_hash,
+                                  reply_thread_hash);
+    }
+
     // ---------- call RPC_RRDB_RRDB_REMOVE ------------
     // - synchronous
     std::pair<::dsn::error_code, update_response>
@@ -162,6 +180,22 @@ public:
                                   reply_thread_hash);
     }
 
+    // ---------- call RPC_RRDB_RRDB_DEL_RANGE ------------
+    // - synchronous
+    std::pair<::dsn::error_code, del_range_response>
+    del_range_sync(const del_range_request &args,
+                   std::chrono::milliseconds timeout,
+                   uint64_t partition_hash)
+    {
+        return ::dsn::rpc::wait_and_unwrap<del_range_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_DEL_RANGE,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash));
+    }
+
     // ---------- call RPC_RRDB_RRDB_INCR ------------
     // - synchronous
     std::pair<::dsn::error_code, incr_response>
@@ -460,6 +494,72 @@ public:
                            partition_hash);
     }
 
+    // ---------- call RPC_RRDB_RRDB_AGGREGATE_SCAN ------------
+    // - synchronous
+    std::pair<::dsn::error_code, aggregate_scan_response>
+    aggregate_scan_sync(const aggregate_scan_request &args,
+                        std::chrono::milliseconds timeout,
+                        uint64_t partition_hash)
+    {
+        return ::dsn::rpc::wait_and_unwrap<aggregate_scan_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_AGGREGATE_SCAN,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash));
+    }
+
+    // - asynchronous with on-stack aggregate_scan_request and aggregate_scan_response
+    template <typename TCallback>
+    ::dsn::task_ptr aggregate_scan(const aggregate_scan_request &args,
+                                   TCallback &&callback,
+                                   std::chrono::milliseconds timeout,
+                                   uint64_t request_partition_hash,
+                                   int reply_thread_hash = 0)
+    {
+        return _resolver->call_op(RPC_RRDB_RRDB_AGGREGATE_SCAN,
+                                  args,
+                                  &_tracker,
+                                  std::forward<TCallback>(callback),
+                                  timeout,
+                                  request_partition_hash,
+                                  reply_thread_hash);
+    }
+
+    // ---------- call RPC_RRDB_RRDB_GET_SPLIT_KEYS ------------
+    // - synchronous
+    std::pair<::dsn::error_code, get_split_keys_response>
+    get_split_keys_sync(const get_split_keys_request &args,
+                        std::chrono::milliseconds timeout,
+                        uint64_t partition_hash)
+    {
+        return ::dsn::rpc::wait_and_unwrap<get_split_keys_response>(
+            _resolver->call_op(RPC_RRDB_RRDB_GET_SPLIT_KEYS,
+                               args,
+                               &_tracker,
+                               empty_rpc_handler,
+                               timeout,
+                               partition_hash));
+    }
+
+    // - asynchronous with on-stack get_split_keys_request and get_split_keys_response
+    template <typename TCallback>
+    ::dsn::task_ptr get_split_keys(const get_split_keys_request &args,
+                                   TCallback &&callback,
+                                   std::chrono::milliseconds timeout,
+                                   uint64_t request_partition_hash,
+                                   int reply_thread_hash = 0)
+    {
+        return _resolver->call_op(RPC_RRDB_RRDB_GET_SPLIT_KEYS,
+                                  args,
+                                  &_tracker,
+                                  std::forward<TCallback>(callback),
+                                  timeout,
+                                  request_partition_hash,
+                                  reply_thread_hash);
+    }
+
     // ---------- call RPC_RRDB_RRDB_DUPLICATE ------------
 
     // - asynchronous with on-stack duplicate_request and duplicate_response
@@ -469,6 +569,9 @@ public:
         return rpc.call(_resolver, tracker, std::forward<TCallback &&>(callback));
     }
 
+    // The partition count of the table, -1 if it is unknown yet.
+    int get_partition_count() const { return _resolver->get_partition_count(); }
+
 private:
     dsn::replication::partition_resolver_ptr _resolver;
     dsn::task_tracker _tracker;
@@ -278,6 +278,7 @@ void app_env_validator::register_all_validators()
         {replica_envs::ROCKSDB_ITERATION_THRESHOLD_TIME_MS,
          {ValueType::kInt64, ">= 0", "1000", [](int64_t new_value) { return new_value >= 0; }}},
         {replica_envs::ROCKSDB_BLOCK_CACHE_ENABLED, {ValueType::kBool}},
+        {replica_envs::HOT_ROW_CACHE_ENABLED, {ValueType::kBool}},
         {replica_envs::READ_QPS_THROTTLING,
          {ValueType::kString, check_throttling_limit, check_throttling_sample, &check_throttling}},
         {replica_envs::READ_SIZE_THROTTLING,
@@ -286,6 +287,8 @@ void app_env_validator::register_all_validators()
           "20000*delay*100,20000*reject*100",
           &utils::token_bucket_throttling_controller::validate}},
         {replica_envs::SPLIT_VALIDATE_PARTITION_HASH, {ValueType::kBool}},
+        {replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW,
+         {ValueType::kInt64, ">= 0", "8", [](int64_t new_value) { return new_value >= 0; }}},
         {replica_envs::USER_SPECIFIED_COMPACTION, {ValueType::kString}},
         {replica_envs::BACKUP_REQUEST_QPS_THROTTLING,
          {ValueType::kString, check_throttling_limit, check_throttling_sample, &check_throttling}},
@@ -26,7 +26,11 @@
 
 #include "log_file.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <fmt/core.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
@@ -35,21 +39,34 @@
 #include <vector>
 
 #include "aio/file_io.h"
+#include "common/replication.codes.h"
 #include "log_file_stream.h"
 #include "replica/log_block.h"
 #include "replica/mutation.h"
+#include "task/async_calls.h"
 #include "utils/binary_reader.h"
 #include "utils/binary_writer.h"
 #include "utils/blob.h"
 #include "utils/crc.h"
 #include "utils/env.h"
 #include "utils/filesystem.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/latency_tracer.h"
 #include "utils/ports.h"
+#include "utils/safe_strerror_posix.h"
 #include "utils/string_conv.h"
 #include "utils/strings.h"
 
+DSN_DEFINE_uint64(replication,
+                  plog_bytes_per_sync,
+                  0,
+                  "Once more than this many bytes are written into the private log since last "
+                  "time, start the writeback of them and drop the pages written back last time "
+                  "from the page cache, so that the log does not evict the pages of the other "
+                  "data, e.g. the block cache of rocksdb. 0 means disabled");
+DSN_TAG_VARIABLE(plog_bytes_per_sync, FT_MUTABLE);
+
 namespace dsn {
 class disk_file;
 class task_tracker;
@@ -148,7 +165,8 @@ log_file::parse_log_file_name(const char *path, int &index, int64_t &start_offse
     return lf;
 }
 
-/*static*/ log_file_ptr log_file::create_write(const char *dir, int index, int64_t start_offset)
+/*static*/ log_file_ptr
+log_file::create_write(const char *dir, int index, int64_t start_offset, int64_t preallocate_bytes)
 {
     char path[512];
     sprintf(path, "%s/log.%d.%" PRId64, dir, index, start_offset);
@@ -164,7 +182,32 @@ log_file::parse_log_file_name(const char *path, int &index, int64_t &start_offse
         return nullptr;
     }
 
-    return new log_file(path, hfile, index, start_offset, false);
+    log_file_ptr lf(new log_file(path, hfile, index, start_offset, false));
+#if defined(__linux__)
+    if (preallocate_bytes > 0 || FLAGS_plog_bytes_per_sync > 0) {
+        // The file is opened again by path since disk_file does not expose its descriptor,
+        // which is fine since both fallocate() and the page cache advices work on the inode.
+        const int fd = ::open(path, O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
+            LOG_WARNING(
+                "open log file {} for advices failed: {}", path, utils::safe_strerror(errno));
+        } else {
+            if (preallocate_bytes > 0 &&
+                ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(preallocate_bytes))) {
+                LOG_WARNING("preallocate {} bytes for log file {} failed: {}",
+                            preallocate_bytes,
+                            path,
+                            utils::safe_strerror(errno));
+            }
+            if (FLAGS_plog_bytes_per_sync > 0) {
+                lf->_page_cache_fd = fd;
+            } else {
+                ::close(fd);
+            }
+        }
+    }
+#endif
+    return lf;
 }
 
 log_file::log_file(
@@ -176,7 +219,12 @@ log_file::log_file(
       _is_read(is_read),
       _path(path),
       _index(index),
-      _last_write_time(0)
+      _last_write_time(0),
+      _page_cache_fd(-1),
+      _written_offset(0),
+      _writeback_offset(0),
+      _dropped_offset(0),
+      _writeback_running(false)
 {
     memset(&_header, 0, sizeof(_header));
 
@@ -202,6 +250,14 @@ void log_file::close()
 
         _handle = nullptr;
     }
+
+    zauto_lock writeback_lock(_writeback_lock);
+    if (_page_cache_fd >= 0) {
+        if (!_writeback_running) {
+            ::close(_page_cache_fd);
+        }
+        _page_cache_fd = -1;
+    }
 }
 
 void log_file::flush() const
@@ -317,8 +373,23 @@ aio_task_ptr log_file::commit_log_blocks(log_appender &pending,
         _crc32 = hdr->body_crc;
     }
 
-    aio_task_ptr tsk;
     int64_t local_offset = pending.start_offset() - start_offset();
+    if (_page_cache_fd >= 0) {
+        // The pages are written back only after the write completes, otherwise the system calls
+        // would block on the pages still being written.
+        callback = [self = log_file_ptr(this),
+                    end = local_offset + size,
+                    cb = std::move(callback)](error_code err, size_t sz) mutable {
+            if (err == ERR_OK) {
+                self->on_pages_written(end);
+            }
+            if (cb) {
+                cb(err, sz);
+            }
+        };
+    }
+
+    aio_task_ptr tsk;
     if (callback) {
         tsk = file::write_vector(_handle,
                                  buffer_vector.data(),
@@ -351,10 +422,66 @@ aio_task_ptr log_file::commit_log_blocks(log_appender &pending,
     return tsk;
 }
 
-void log_file::reset_stream(size_t offset /*default = 0*/)
+void log_file::on_pages_written(int64_t end)
+{
+#if defined(__linux__)
+    const auto bytes_per_sync = static_cast<int64_t>(FLAGS_plog_bytes_per_sync);
+    zauto_lock l(_writeback_lock);
+    if (_page_cache_fd < 0 || bytes_per_sync == 0) {
+        return;
+    }
+
+    _written_offset = std::max(_written_offset, end);
+    if (_writeback_running || _written_offset - _writeback_offset < bytes_per_sync) {
+        return;
+    }
+
+    _writeback_running = true;
+    log_file_ptr self(this);
+    tasking::enqueue(LPC_PLOG_WRITEBACK, nullptr, [self]() { self->writeback_written_pages(); });
+#endif
+}
+
+void log_file::writeback_written_pages()
+{
+#if defined(__linux__)
+    int fd = -1;
+    int64_t dropped = 0;
+    int64_t begin = 0;
+    int64_t end = 0;
+    {
+        zauto_lock l(_writeback_lock);
+        fd = _page_cache_fd;
+        dropped = _dropped_offset;
+        begin = _writeback_offset;
+        end = _written_offset;
+    }
+
+    if (fd >= 0) {
+        // The pages whose writeback was started last time are most likely clean now. The ones
+        // still being written back are skipped by the kernel.
+        if (begin > dropped) {
+            ::posix_fadvise(fd, dropped, begin - dropped, POSIX_FADV_DONTNEED);
+        }
+        ::sync_file_range(fd, begin, end - begin, SYNC_FILE_RANGE_WRITE);
+    }
+
+    zauto_lock l(_writeback_lock);
+    _dropped_offset = begin;
+    _writeback_offset = end;
+    _writeback_running = false;
+    if (fd >= 0 && _page_cache_fd < 0) {
+        // The file has been closed while running.
+        ::close(fd);
+    }
+#endif
+}
+
+void log_file::reset_stream(size_t offset /*default = 0*/,
+                            size_t read_ahead_blocks /*default = 2*/)
 {
-    if (_stream == nullptr) {
-        _stream.reset(new file_streamer(_handle, offset));
+    if (_stream == nullptr || _stream->buffer_count() != read_ahead_blocks) {
+        _stream.reset(new file_streamer(_handle, offset, read_ahead_blocks));
     } else {
         _stream->reset(offset);
     }
@@ -116,10 +116,13 @@ public:
 
     // open the log file for write
     // the file path is '{dir}/log.{index}.{start_offset}'
+    // the disk space of `preallocate_bytes` would be allocated without changing the file size,
+    // thus the appends would not need to allocate blocks.
     // returns:
     //   - non-null if open succeed
     //   - null if open failed
-    static log_file_ptr create_write(const char *dir, int index, int64_t start_offset);
+    static log_file_ptr
+    create_write(const char *dir, int index, int64_t start_offset, int64_t preallocate_bytes = 0);
 
     // close the log file
     void close();
@@ -174,7 +177,9 @@ public:
 
     // Reset file_streamer to point to `offset`.
     // offset=0 means the start of this log file.
-    void reset_stream(size_t offset = 0);
+    // `read_ahead_blocks` is the number of blocks read ahead asynchronously by the stream, the
+    // stream would be recreated once it is changed.
+    void reset_stream(size_t offset = 0, size_t read_ahead_blocks = 2);
     // end offset in the global space: end_offset = start_offset + file_size
     int64_t end_offset() const { return _end_offset.load(); }
     // start offset in the global space
@@ -214,6 +219,16 @@ private:
     // make private, user should create log_file through open_read() or open_write()
     log_file(const char *path, disk_file *handle, int index, int64_t start_offset, bool is_read);
 
+    // Called once the data before the local offset `end` has been written. Once more than
+    // FLAGS_plog_bytes_per_sync bytes have been written since the last writeback, start a
+    // background task to write them back, see writeback_written_pages().
+    void on_pages_written(int64_t end);
+
+    // Drop the pages written back last time from the page cache, so that the log would not
+    // evict the pages of the other data, and start the writeback of the pages written since
+    // then. Both system calls may block, thus it runs in LPC_PLOG_WRITEBACK.
+    void writeback_written_pages();
+
     friend class ParseLogFileNameTest;
     friend class mock_log_file;
 
@@ -233,6 +248,20 @@ private:
 
     mutable zlock _write_lock;
 
+    // Protect the following members, which are accessed by both the completion of the writes
+    // and the writeback task.
+    mutable zlock _writeback_lock;
+    // Used to advise the kernel about the page cache of the file for write, -1 if disabled or
+    // closed. If the file is closed while the writeback task is running, the task closes it.
+    int _page_cache_fd;
+    // The local offset before which the data has been written.
+    int64_t _written_offset;
+    // The local offset before which the writeback has been started.
+    int64_t _writeback_offset;
+    // The local offset before which the pages have been dropped from the page cache.
+    int64_t _dropped_offset;
+    bool _writeback_running;
+
     // this data is used for garbage collection, and is part of file header.
     // for read, the value is read from file header.
     // for write, the value is set by write_file_header().
@@ -28,39 +28,54 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
+
 #include "log_file.h"
 #include "common/replication.codes.h"
 
 namespace dsn {
 namespace replication {
 
+// file_streamer reads a log file sequentially. It keeps `buffer_count` blocks being read
+// ahead asynchronously, thus the reading of the following blocks is overlapped with the
+// decoding of the current one.
 class log_file::file_streamer
 {
 public:
-    explicit file_streamer(disk_file *fd, size_t file_offset)
-        : _file_dispatched_bytes(file_offset), _file_handle(fd)
+    explicit file_streamer(disk_file *fd, size_t file_offset, size_t buffer_count = 2)
+        : _buffers(new buffer_t[buffer_count]),
+          _buffer_count(buffer_count),
+          _current(0),
+          _file_dispatched_bytes(file_offset),
+          _file_handle(fd)
     {
-        _current_buffer = _buffers + 0;
-        _next_buffer = _buffers + 1;
+        CHECK_GE(_buffer_count, 2);
         fill_buffers();
     }
-    ~file_streamer()
-    {
-        _current_buffer->wait_ongoing_task();
-        _next_buffer->wait_ongoing_task();
-    }
+    ~file_streamer() { wait_all_buffers(); }
+
+    size_t buffer_count() const { return _buffer_count; }
+
     // try to reset file_offset
     void reset(size_t file_offset)
     {
-        _current_buffer->wait_ongoing_task();
-        _next_buffer->wait_ongoing_task();
-        // fast path if we can just move the cursor
-        if (_current_buffer->_file_offset_of_buffer <= file_offset &&
-            _current_buffer->_file_offset_of_buffer + _current_buffer->_end > file_offset) {
-            _current_buffer->_begin = file_offset - _current_buffer->_file_offset_of_buffer;
+        // fast path if we can just move the cursor, in which case the blocks being read ahead
+        // are still valid and need not be waited for.
+        auto *current = current_buffer();
+        current->wait_ongoing_task();
+        if (current->_file_offset_of_buffer <= file_offset &&
+            current->_file_offset_of_buffer + current->_end > file_offset) {
+            current->_begin = file_offset - current->_file_offset_of_buffer;
+        } else if (current->_end == block_size_bytes &&
+                   current->_file_offset_of_buffer + current->_end == file_offset) {
+            // The cursor is moved to the beginning of the next buffer.
+            current->_begin = current->_end;
         } else {
-            _current_buffer->_begin = _current_buffer->_end = _next_buffer->_begin =
-                _next_buffer->_end = 0;
+            wait_all_buffers();
+            for (size_t i = 0; i < _buffer_count; ++i) {
+                _buffers[i]._begin = _buffers[i]._end = 0;
+            }
             _file_dispatched_bytes = file_offset;
         }
         fill_buffers();
@@ -86,33 +101,35 @@ public:
         }                                                                                          \
     } while (0)
 
-        TRY(_current_buffer->wait_ongoing_task());
-        if (size < _current_buffer->length()) {
-            result.assign(_current_buffer->_buffer.get(), _current_buffer->_begin, size);
-            _current_buffer->_begin += size;
+        auto *current = current_buffer();
+        TRY(current->wait_ongoing_task());
+        if (size < current->length()) {
+            result.assign(current->_buffer.get(), current->_begin, size);
+            current->_begin += size;
         } else {
-            _current_buffer->drain(writer);
+            current->drain(writer);
             // we can now assign result since writer must have allocated a buffer.
             CHECK_GT(writer.total_size(), 0);
+            // Consume the following buffers in the order of their file offsets.
+            for (size_t i = 1; i < _buffer_count && size > writer.total_size(); ++i) {
+                auto *next = &_buffers[(_current + i) % _buffer_count];
+                TRY(next->wait_ongoing_task());
+                next->consume(writer, std::min(size - writer.total_size(), next->length()));
+            }
+            // We hope that this never happens, it would deteriorate performance
             if (size > writer.total_size()) {
-                TRY(_next_buffer->wait_ongoing_task());
-                _next_buffer->consume(writer,
-                                      std::min(size - writer.total_size(), _next_buffer->length()));
-                // We hope that this never happens, it would deteriorate performance
-                if (size > writer.total_size()) {
-                    auto task =
-                        file::read(_file_handle,
-                                   writer.get_current_buffer().buffer().get() + writer.total_size(),
-                                   size - writer.total_size(),
-                                   _file_dispatched_bytes,
-                                   LPC_AIO_IMMEDIATE_CALLBACK,
-                                   nullptr,
-                                   nullptr);
-                    task->wait();
-                    writer.write_empty(task->get_transferred_size());
-                    _file_dispatched_bytes += task->get_transferred_size();
-                    TRY(task->error());
-                }
+                auto task = file::read(_file_handle,
+                                       writer.get_current_buffer().buffer().get() +
+                                           writer.total_size(),
+                                       size - writer.total_size(),
+                                       _file_dispatched_bytes,
+                                       LPC_AIO_IMMEDIATE_CALLBACK,
+                                       nullptr,
+                                       nullptr);
+                task->wait();
+                writer.write_empty(task->get_transferred_size());
+                _file_dispatched_bytes += task->get_transferred_size();
+                TRY(task->error());
             }
             result = writer.get_current_buffer();
         }
@@ -122,21 +139,35 @@ public:
     }
 
 private:
+    struct buffer_t;
+
+    buffer_t *current_buffer() const { return &_buffers[_current]; }
+
+    void wait_all_buffers()
+    {
+        for (size_t i = 0; i < _buffer_count; ++i) {
+            _buffers[i].wait_ongoing_task();
+        }
+    }
+
+    // The buffers starting from `_current` are ordered by their file offsets, thus a drained
+    // buffer is always refilled with the data following the last one.
     void fill_buffers()
     {
-        while (!_current_buffer->_have_ongoing_task && _current_buffer->empty()) {
-            _current_buffer->_begin = _current_buffer->_end = 0;
-            _current_buffer->_file_offset_of_buffer = _file_dispatched_bytes;
-            _current_buffer->_have_ongoing_task = true;
-            _current_buffer->_task = file::read(_file_handle,
-                                                _current_buffer->_buffer.get(),
-                                                block_size_bytes,
-                                                _file_dispatched_bytes,
-                                                LPC_AIO_IMMEDIATE_CALLBACK,
-                                                nullptr,
-                                                nullptr);
+        while (!current_buffer()->_have_ongoing_task && current_buffer()->empty()) {
+            auto *current = current_buffer();
+            current->_begin = current->_end = 0;
+            current->_file_offset_of_buffer = _file_dispatched_bytes;
+            current->_have_ongoing_task = true;
+            current->_task = file::read(_file_handle,
+                                        current->_buffer.get(),
+                                        block_size_bytes,
+                                        _file_dispatched_bytes,
+                                        LPC_AIO_IMMEDIATE_CALLBACK,
+                                        nullptr,
+                                        nullptr);
             _file_dispatched_bytes += block_size_bytes;
-            std::swap(_current_buffer, _next_buffer);
+            _current = (_current + 1) % _buffer_count;
         }
     }
 
@@ -184,8 +215,10 @@ private:
                 return ERR_OK;
             }
         }
-    } _buffers[2];
-    buffer_t *_current_buffer, *_next_buffer;
+    };
+    std::unique_ptr<buffer_t[]> _buffers;
+    const size_t _buffer_count;
+    size_t _current;
 
     // number of bytes we have issued read operations
     size_t _file_dispatched_bytes;
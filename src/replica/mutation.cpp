@@ -35,6 +35,7 @@
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "common/gpid.h"
 #include "common/replication.codes.h"
@@ -63,6 +64,34 @@ DSN_DEFINE_uint64(replication,
                   "may be slightly more than this value");
 DSN_TAG_VARIABLE(row_lock_map_capacity, FT_MUTABLE);
 
+DSN_DEFINE_bool(replication,
+                pipeline_atomic_writes,
+                false,
+                "Whether an idempotent atomic write (incr, check_and_set or check_and_mutate) "
+                "could enter 2PC while the former atomic writes on the same hash key have not "
+                "been applied, reading their results from the pending write overlay of the "
+                "storage engine. It would still be blocked by the non-atomic writes which have "
+                "not been applied");
+DSN_TAG_VARIABLE(pipeline_atomic_writes, FT_MUTABLE);
+
+DSN_DEFINE_bool(replication,
+                adaptive_write_batch_enabled,
+                false,
+                "Whether to hold the pending mutation of the primary replica to batch more "
+                "write requests while there are mutations in 2PC, as long as the p99 latency "
+                "of the recent writes is below adaptive_write_batch_p99_target_ms. Once there "
+                "is no mutation in 2PC, the pending mutation is always released immediately");
+DSN_TAG_VARIABLE(adaptive_write_batch_enabled, FT_MUTABLE);
+
+DSN_DEFINE_uint32(replication,
+                  adaptive_write_batch_p99_target_ms,
+                  10,
+                  "The p99 latency target in milliseconds for adaptive write batching, "
+                  "measured from the time a mutation is created to the time it is committed. "
+                  "It is also the max time a pending mutation is held if no mutation in 2PC "
+                  "is committed meanwhile");
+DSN_TAG_VARIABLE(adaptive_write_batch_p99_target_ms, FT_MUTABLE);
+
 namespace dsn::replication {
 
 std::atomic<uint64_t> mutation::s_tid(0);
@@ -76,7 +105,8 @@ mutation::mutation()
       _appro_data_bytes(sizeof(mutation_header)),
       _create_ts_ns(dsn_now_ns()),
       _tid(++s_tid),
-      _is_sync_to_child(false)
+      _is_sync_to_child(false),
+      _acked_before_logged(false)
 {
     _not_logged = 1;
     _left_secondary_ack_count = 0;
@@ -137,6 +167,7 @@ void mutation::copy_from(mutation_ptr &old)
 {
     data.updates = old->data.updates;
     client_requests = old->client_requests;
+    extra_partition_hashes = old->extra_partition_hashes;
     _appro_data_bytes = old->_appro_data_bytes;
     _create_ts_ns = old->_create_ts_ns;
 
@@ -178,13 +209,12 @@ void mutation::add_client_request(dsn::message_ex *request)
         update.__set_start_time_ns(static_cast<int64_t>(dsn_now_ns()));
         request->add_ref(); // released on dctor
 
-        void *ptr = nullptr;
-        size_t size = 0;
-        CHECK(request->read_next(&ptr, &size), "payload is not present");
+        // The update shares the buffer of the request rather than copying it, so that it could
+        // be referenced by the log block and the prepare messages as well.
+        CHECK(request->read_next(update.data), "payload is not present");
         request->read_commit(0); // so we can re-read the request buffer in replicated app
-        update.data.assign(static_cast<const char *>(ptr), 0, size);
 
-        _appro_data_bytes += static_cast<int>(sizeof(int) + size); // data size
+        _appro_data_bytes += static_cast<int>(sizeof(int) + update.data.length()); // data size
     } else {
         update.code = RPC_REPLICATION_WRITE_EMPTY;
         _appro_data_bytes += static_cast<int>(sizeof(int)); // empty data size
@@ -219,7 +249,7 @@ void mutation::write_to(const std::function<void(const blob &)> &inserter) const
     }
 }
 
-void mutation::write_to(binary_writer &writer, dsn::message_ex * /*to*/) const
+void mutation::write_to(binary_writer &writer, dsn::message_ex *to) const
 {
     write_mutation_header(writer, data.header);
     writer.write_pod(static_cast<int>(data.updates.size()));
@@ -236,9 +266,15 @@ void mutation::write_to(binary_writer &writer, dsn::message_ex * /*to*/) const
 
         writer.write_pod(static_cast<int>(update.data.length()));
     }
-    // TODO(qinzuoyan): directly append buffer to message to avoid memory copy
     for (const mutation_update &update : data.updates) {
-        writer.write(update.data.data(), update.data.length());
+        // Directly append the buffer to the message to avoid memory copy, as long as the buffer
+        // could be shared by the message.
+        if (to != nullptr && update.data.buffer() != nullptr) {
+            writer.flush();
+            to->write_append(update.data);
+        } else {
+            writer.write(update.data.data(), update.data.length());
+        }
     }
 }
 
@@ -365,6 +401,7 @@ mutation_queue::mutation_queue(replica *r,
       _max_concurrent_op(max_concurrent_op),
       _batch_write_disabled(batch_write_disabled)
 {
+    _commit_latencies.reserve(kCommitLatencyWindow);
     CHECK_NE_MSG(gpid.get_app_id(), 0, "invalid gpid");
     _pcount = dsn_task_queue_virtual_length_ptr(RPC_PREPARE, gpid.thread_hash());
 }
@@ -373,6 +410,7 @@ void mutation_queue::promote_pending()
 {
     _queue.push(_pending_mutation);
     _pending_mutation.reset();
+    _pending_held = false;
     ++(*_pcount);
 }
 
@@ -408,6 +446,9 @@ void mutation_queue::enter_2pc(const mutation_ptr &mu)
 {
     const decree d = mu->get_decree();
 
+    // The mutation holding the idempotent requests translated from an atomic write.
+    const bool atomic = mu->idem_writer != nullptr;
+
     for (auto *request : mu->client_requests) {
         if (request == nullptr) {
             continue;
@@ -415,41 +456,56 @@ void mutation_queue::enter_2pc(const mutation_ptr &mu)
 
         CHECK_RPC_REQUEST_IS_WRITE(request);
 
-        const auto result = _row_locks.try_emplace(request->header->client.partition_hash);
-        if (!result.second) {
-            // The lock for this hash key has existed.
-            if (d > result.first->second->second) {
-                // Update the value only when `mu` has higher decree. Besides, the primary
-                // replica might also call replay_prepare_list() which could incur lower
-                // decrees.
-                result.first->second->second = d;
-            }
-
-            // The latest entry is moved to the head of the LRU list.
-            _lru_rows.splice(_lru_rows.begin(), _lru_rows, result.first->second);
-            continue;
-        }
+        lock_row(request->header->client.partition_hash, d, atomic);
+    }
 
-        // If the lock for this hash key is newly created, just push it into the head of the
-        // LRU list.
-        _lru_rows.emplace_front(request->header->client.partition_hash, d);
-        result.first->second = _lru_rows.begin();
+    // A request might write the rows of other hash keys besides the one in its header, all of
+    // which should be locked.
+    for (const auto partition_hash : mu->extra_partition_hashes) {
+        lock_row(partition_hash, d, atomic);
     }
 
     // Once the row lock mapping table is too large, check the tail to decide whether to discard
     // it to make room.
     while (_row_locks.size() > FLAGS_row_lock_map_capacity) {
-        if (dsn_unlikely(!applied(_lru_rows.back().second))) {
+        if (dsn_unlikely(!applied(_lru_rows.back().max_decree))) {
             // The max decree of the oldest has not be applied to the storage engine, no need
             // to check others.
             break;
         }
 
-        _row_locks.erase(_lru_rows.back().first);
+        _row_locks.erase(_lru_rows.back().partition_hash);
         _lru_rows.pop_back();
     }
 }
 
+void mutation_queue::lock_row(uint64_t partition_hash, decree d, bool atomic)
+{
+    const auto result = _row_locks.try_emplace(partition_hash);
+    if (!result.second) {
+        // The lock for this hash key has existed.
+        auto &row = *result.first->second;
+
+        // Update the values only when `d` is higher. Besides, the primary replica might also
+        // call replay_prepare_list() which could incur lower decrees.
+        if (d > row.max_decree) {
+            row.max_decree = d;
+        }
+        if (!atomic && d > row.max_non_atomic_decree) {
+            row.max_non_atomic_decree = d;
+        }
+
+        // The latest entry is moved to the head of the LRU list.
+        _lru_rows.splice(_lru_rows.begin(), _lru_rows, result.first->second);
+        return;
+    }
+
+    // If the lock for this hash key is newly created, just push it into the head of the
+    // LRU list.
+    _lru_rows.push_front({partition_hash, d, atomic ? invalid_decree : d});
+    result.first->second = _lru_rows.begin();
+}
+
 bool mutation_queue::row_locked(const mutation &mu)
 {
     for (auto *request : mu.client_requests) {
@@ -465,8 +521,10 @@ bool mutation_queue::row_locked(const mutation &mu)
         }
 
         // Only after the max decree of a hash key in 2PC phase is applied to the storage engine
-        // could it be unlocked.
-        if (applied(entry->second->second)) {
+        // could it be unlocked. While pipelining atomic writes, the pending atomic writes are
+        // read from the overlay of the storage engine, thus only the non-atomic ones lock it.
+        const auto &row = *entry->second;
+        if (applied(FLAGS_pipeline_atomic_writes ? row.max_non_atomic_decree : row.max_decree)) {
             continue;
         }
 
@@ -497,7 +555,7 @@ mutation_ptr mutation_queue::try_unblock()
         (void)_blocking_mutations.erase_after(prev);
 
         // Increment the count as this mutation will be returned and processed in 2PC phase.
-        ++_current_op_count;
+        on_dispatch(*mu);
 
         return mu;
     }
@@ -508,7 +566,7 @@ mutation_ptr mutation_queue::try_unblock()
 bool mutation_queue::try_block(const mutation_ptr &mu)
 {
     if (!mu->is_blocking_candidate || !row_locked(*mu)) {
-        ++_current_op_count;
+        on_dispatch(*mu);
         return false;
     }
 
@@ -524,6 +582,75 @@ bool mutation_queue::try_block(const mutation_ptr &mu)
     return true;
 }
 
+void mutation_queue::on_dispatch(const mutation &mu)
+{
+    ++_current_op_count;
+    METRIC_SET(*_replica, write_batch_size, static_cast<int64_t>(mu.client_requests.size()));
+}
+
+bool mutation_queue::should_hold_pending(task_spec *spec) const
+{
+    if (!FLAGS_adaptive_write_batch_enabled || _batch_write_disabled ||
+        !spec->rpc_request_is_write_allow_batch || _pending_mutation->is_full()) {
+        return false;
+    }
+
+    // Flush immediately while idle: the held mutation would only be released by next_work()
+    // once a mutation in 2PC is committed.
+    if (_current_op_count <= 0 ||
+        _replica->max_prepared_decree() <= _replica->last_committed_decree()) {
+        return false;
+    }
+
+    // Stop growing the batch once the latency target is exceeded.
+    const uint64_t target_ns = FLAGS_adaptive_write_batch_p99_target_ms * 1000000ULL;
+    if (_p99_commit_latency_ns == 0 || _p99_commit_latency_ns >= target_ns) {
+        return false;
+    }
+
+    // Holding is worthwhile only if more requests are expected to arrive before the mutations
+    // in 2PC are committed.
+    return _arrival_interval_ns < _p99_commit_latency_ns;
+}
+
+void mutation_queue::record_commit_latency(uint64_t latency_ns)
+{
+    _commit_latencies.push_back(latency_ns);
+    if (_commit_latencies.size() < kCommitLatencyWindow) {
+        return;
+    }
+
+    // Estimate the p99 latency once per window.
+    const auto p99 = _commit_latencies.begin() + kCommitLatencyWindow * 99 / 100;
+    std::nth_element(_commit_latencies.begin(), p99, _commit_latencies.end());
+    _p99_commit_latency_ns = *p99;
+    _commit_latencies.clear();
+}
+
+bool mutation_queue::need_schedule_release()
+{
+    if (!_pending_held || _release_scheduled) {
+        return false;
+    }
+
+    _release_scheduled = true;
+    return true;
+}
+
+mutation_ptr mutation_queue::release_held(int current_running_count)
+{
+    _release_scheduled = false;
+
+    // Nothing to release if the held mutation has been popped by next_work() since the release
+    // was scheduled. Otherwise the held one, which might be held after the release was
+    // scheduled, is released a little earlier.
+    if (!_pending_held) {
+        return {};
+    }
+
+    return next_work(current_running_count);
+}
+
 mutation_ptr mutation_queue::pop_or_block_queue()
 {
     while (true) {
@@ -542,6 +669,7 @@ mutation_ptr mutation_queue::pop_or_block_pending()
 {
     mutation_ptr mu = _pending_mutation;
     _pending_mutation.reset();
+    _pending_held = false;
 
     if (!try_block(mu)) {
         return mu;
@@ -550,13 +678,20 @@ mutation_ptr mutation_queue::pop_or_block_pending()
     return {};
 }
 
-mutation_ptr mutation_queue::add_work(message_ex *request)
+mutation_ptr mutation_queue::add_work(message_ex *request,
+                                      std::vector<uint64_t> &&extra_partition_hashes)
 {
     CHECK_NOTNULL(request, "");
 
     auto *spec = task_spec::get(request->rpc_code());
     CHECK_NOTNULL(spec, "");
 
+    const auto now_ns = dsn_now_ns();
+    if (_last_arrival_ns != 0 && now_ns > _last_arrival_ns) {
+        _arrival_interval_ns = (_arrival_interval_ns * 7 + (now_ns - _last_arrival_ns)) / 8;
+    }
+    _last_arrival_ns = now_ns;
+
     // If this request is not allowed to be batched, promote `_pending_mutation` if it is
     // non-null. We don't check `_batch_write_disabled` since `_pending_mutation` must be
     // null now if it is true.
@@ -578,6 +713,10 @@ mutation_ptr mutation_queue::add_work(message_ex *request)
 
     // Append the incoming client request to `_pending_mutation`.
     _pending_mutation->add_client_request(request);
+    if (!extra_partition_hashes.empty()) {
+        auto &hashes = _pending_mutation->extra_partition_hashes;
+        hashes.insert(hashes.end(), extra_partition_hashes.begin(), extra_partition_hashes.end());
+    }
 
     // Throttling is triggered as there are too many mutations being processed as 2PC. Return
     // null in case more mutations flow into the write pipeline.
@@ -599,7 +738,13 @@ mutation_ptr mutation_queue::add_work(message_ex *request)
 
     if (_queue.empty()) {
         // `_pending_mutation` must be non-null now. There's no need to promote it as `_queue`
-        // is empty: pop it as the next work candidate to be processed if it is not blocked.
+        // is empty: hold it to batch more requests if it is worthwhile, otherwise pop it as
+        // the next work candidate to be processed if it is not blocked.
+        if (should_hold_pending(spec)) {
+            _pending_held = true;
+            METRIC_INCREMENT(*_replica, held_write_batches);
+            return {};
+        }
         return pop_or_block_pending();
     }
 
@@ -660,6 +805,8 @@ void mutation_queue::clear()
     if (_pending_mutation != nullptr) {
         _pending_mutation.reset();
     }
+    _pending_held = false;
+    _release_scheduled = false;
 
     _row_locks.clear();
 }
@@ -685,6 +832,8 @@ void mutation_queue::clear(std::vector<mutation_ptr> &queued_mutations)
         queued_mutations.emplace_back(std::move(_pending_mutation));
         _pending_mutation.reset();
     }
+    _pending_held = false;
+    _release_scheduled = false;
 
     _row_locks.clear();
 
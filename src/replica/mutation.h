@@ -162,6 +162,8 @@ public:
     //   - the private log may be transfered to other node with different program
     //   - the private/shared log may be replayed by different program when server restart
     void write_to(const std::function<void(const blob &)> &inserter) const;
+    // If `to` is not null, `writer` must be the stream writing into `to`, and the buffers of the
+    // updates are appended to `to` directly instead of being copied.
     void write_to(binary_writer &writer, dsn::message_ex *to) const;
     static mutation_ptr read_from(binary_reader &reader, dsn::message_ex *from);
 
@@ -174,6 +176,13 @@ public:
     // user requests
     std::vector<dsn::message_ex *> client_requests;
 
+    // The partition hashes of the rows written by `client_requests` besides the ones in their
+    // headers, see replication_app_base::get_write_partition_hashes(). They are locked along
+    // with the others once this mutation enters 2PC phase.
+    //
+    // This field is only used by primary replicas.
+    std::vector<uint64_t> extra_partition_hashes;
+
     // A mutation will be a blocking candidate if this field is true. Typically, to hold an
     // atomic write request while idempotence is enabled, a mutation will be will be created
     // as a blocking candidate.
@@ -207,6 +216,11 @@ public:
     void set_is_sync_to_child(bool sync_to_child) { _is_sync_to_child = sync_to_child; }
     bool is_sync_to_child() { return _is_sync_to_child; }
 
+    // Whether the secondary has acked the prepare before the mutation is logged, see
+    // replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW.
+    void set_acked_before_logged() { _acked_before_logged = true; }
+    bool is_acked_before_logged() const { return _acked_before_logged; }
+
 private:
     union
     {
@@ -237,6 +251,7 @@ private:
     uint64_t _tid;          // trace id, unique in process
     static std::atomic<uint64_t> s_tid;
     bool _is_sync_to_child; // for partition split
+    bool _acked_before_logged;
 
     DISALLOW_COPY_AND_ASSIGN(mutation);
     DISALLOW_MOVE_AND_ASSIGN(mutation);
@@ -272,6 +287,15 @@ class replica;
 // 3. FLAGS_batch_write_disabled is set to true. As the global configuration, it decides whether
 // to disallow batching for all kinds of write requests.
 //
+// Once FLAGS_adaptive_write_batch_enabled is set, `_pending_mutation` might be held instead of
+// being popped immediately while other mutations are in 2PC phase, thus more requests could be
+// batched into it under load. It will be popped by next_work() once a mutation in 2PC phase is
+// committed, or by release_held() which is scheduled FLAGS_adaptive_write_batch_p99_target_ms
+// after the holding starts in case no mutation is committed in time. The holding stops once the
+// p99 latency of the recent mutations, measured from creation to commit, reaches
+// FLAGS_adaptive_write_batch_p99_target_ms, or the requests do not arrive frequently enough to
+// grow the batch.
+//
 // This class is only used by primary replicas.
 class mutation_queue
 {
@@ -295,10 +319,13 @@ public:
     //
     // Parameters:
     // - request: the incoming write request from a client, must be non-null.
+    // - extra_partition_hashes: the partition hashes of the rows written by the request besides
+    // the one in its header.
     //
     // Return the next mutation needing to be processed in 2PC phase. If the returned mutation
     // is null, it means the queue is empty, or all mutations in the queue is being blocked.
-    mutation_ptr add_work(dsn::message_ex *request);
+    mutation_ptr add_work(dsn::message_ex *request,
+                          std::vector<uint64_t> &&extra_partition_hashes = {});
 
     // Get the next mutation from the queue, typically called immediately after the current
     // mutation was applied, or the membership was changed and we became the primary replica.
@@ -327,6 +354,21 @@ public:
     // the dequeue operation. These steps may fail and return an error to the client.
     void enter_2pc(const mutation_ptr &mu);
 
+    // Record the latency of a mutation from creation to commit, used by adaptive write
+    // batching. Called once a mutation carrying client requests is applied on the primary
+    // replica.
+    void record_commit_latency(uint64_t latency_ns);
+
+    // Return true if `_pending_mutation` is being held by adaptive write batching and no
+    // release has been scheduled for it, in which case the caller should schedule a call to
+    // release_held(). Once true is returned, false will be returned until release_held() or
+    // clear() is called.
+    bool need_schedule_release();
+
+    // Release the held `_pending_mutation` if any, even if no mutation in 2PC phase has been
+    // committed. The parameter and the returned mutation are the same as next_work().
+    mutation_ptr release_held(int current_running_count);
+
     // Clear the entire queue.
     void clear();
 
@@ -338,6 +380,8 @@ public:
     void clear(std::vector<mutation_ptr> &queued_mutations);
 
 private:
+    friend class mutation_queue_test;
+
     // Promote `_pending_mutation` to `_queue`. Before the promotion, `_pending_mutation`
     // should not be null (otherwise the behaviour is undefined).
     void promote_pending();
@@ -351,10 +395,22 @@ private:
     // request is allowed to be batched.
     void try_promote_pending(task_spec *spec);
 
+    // Return true if `_pending_mutation` should be held to batch more client requests rather
+    // than popped to be processed in 2PC phase, i.e. adaptive write batching is enabled, some
+    // mutations are in 2PC phase, and the latency target allows. `spec` is the specification
+    // for the incoming client request.
+    bool should_hold_pending(task_spec *spec) const;
+
+    // Called once the mutation `mu` is popped to be processed in 2PC phase.
+    void on_dispatch(const mutation &mu);
+
     // Return true if the decree `d` has been applied into storage engine; otherwise return
     // false.
     [[nodiscard]] bool applied(decree d) const;
 
+    // Lock the row of `partition_hash` by the decree `d` of a mutation entering 2PC phase.
+    void lock_row(uint64_t partition_hash, decree d, bool atomic);
+
     // Check each client request within the blocking candidate `mu` one by one:
     // - If any request's `partition_hash` exists in the row lock mapping table, it means that
     // the corresponding hash key is locked. In this case, return true, indicating that the
@@ -418,6 +474,22 @@ private:
     // FLAGS_batch_write_disabled.
     bool _batch_write_disabled;
 
+    // The statistics for adaptive write batching:
+    // - `_commit_latencies` collects the latencies of the recently committed mutations, from
+    // which `_p99_commit_latency_ns` is estimated once every kCommitLatencyWindow mutations.
+    // - `_arrival_interval_ns` is the moving average of the intervals between the arrivals of
+    // client requests.
+    static constexpr size_t kCommitLatencyWindow = 128;
+    std::vector<uint64_t> _commit_latencies;
+    uint64_t _p99_commit_latency_ns{0};
+    uint64_t _last_arrival_ns{0};
+    uint64_t _arrival_interval_ns{0};
+
+    // Whether `_pending_mutation` is being held by adaptive write batching, and whether a
+    // release_held() has been scheduled for it.
+    bool _pending_held{false};
+    bool _release_scheduled{false};
+
     volatile int *_pcount;
     mutation_ptr _pending_mutation;
     std::queue<mutation_ptr> _queue;
@@ -469,13 +541,20 @@ private:
     // it does not affect the correctness of program execution.
     //
     // The value for the row lock mapping table looks a little bit more complicated: it is an
-    // iterator pointing to an LRU entry whose structure is (partition_hash, max_decree).
+    // iterator pointing to an LRU entry whose structure is (partition_hash, max_decree,
+    // max_non_atomic_decree).
     //
     // `max_decree` is the max decree that has entered the 2PC phase, used to decide whether a
     // blocking candidate could get popped from the mutation queue or blocked: if the max decree
     // has been applied to storage engine, it will be popped from the queue; otherwise, it will
     // be blocked.
     //
+    // `max_non_atomic_decree` is the max decree of the mutations that have entered the 2PC
+    // phase without holding an idempotent writer. Once FLAGS_pipeline_atomic_writes is enabled,
+    // it is used instead of `max_decree` to decide whether a blocking candidate is blocked,
+    // since the results of the pending atomic writes could be read by the following ones
+    // from the storage engine before they are applied.
+    //
     // Since frequent insertion and deletion of row locks in the mapping table may impact
     // performance, `lru_row_list` is introduced to implement the LRU strategy:
     // - The latest entry will always pushed into the head of the LRU list, which means the
@@ -495,7 +574,13 @@ private:
     // Have tried to introduce absl::flat_hash_map; however, it could not pass the ASAN
     // tests due to segmentation fault caused by dereferencing a null pointer inside
     // "absl/container/internal/raw_hash_set.h". Would try it again later.
-    using lru_row_list = std::list<std::pair<uint64_t, decree>>;
+    struct row_lock_entry
+    {
+        uint64_t partition_hash;
+        decree max_decree;
+        decree max_non_atomic_decree;
+    };
+    using lru_row_list = std::list<row_lock_entry>;
     using row_lock_map = boost::unordered_flat_map<uint64_t, lru_row_list::iterator>;
     row_lock_map _row_locks;
     lru_row_list _lru_rows;
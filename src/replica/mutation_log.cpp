@@ -58,6 +58,12 @@ DSN_DEFINE_bool(replication,
                 plog_force_flush,
                 false,
                 "when write private log, whether to flush file after write done");
+DSN_DEFINE_bool(replication,
+                plog_preallocate,
+                false,
+                "Whether to preallocate the disk space of log_private_file_size_mb for each "
+                "private log file without changing its size, so that the appends would not "
+                "need to allocate blocks for the file");
 
 namespace dsn {
 namespace replication {
@@ -588,8 +594,11 @@ error_code mutation_log::create_new_log_file()
 {
     // create file
     uint64_t start = dsn_now_ns();
-    log_file_ptr logf =
-        log_file::create_write(_dir.c_str(), _last_file_index + 1, _global_end_offset);
+    log_file_ptr logf = log_file::create_write(_dir.c_str(),
+                                               _last_file_index + 1,
+                                               _global_end_offset,
+                                               FLAGS_plog_preallocate ? _max_log_file_size_in_bytes
+                                                                      : 0);
     if (logf == nullptr) {
         LOG_ERROR("cannot create log file with index {}", _last_file_index + 1);
         return ERR_FILE_OPERATION_FAILED;
@@ -38,48 +38,30 @@
 #include "utils/error_code.h"
 #include "utils/errors.h"
 #include "utils/fail_point.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/ports.h"
 
-namespace dsn::replication {
-
-/*static*/ error_code mutation_log::replay(log_file_ptr log,
-                                           replay_callback callback,
-                                           /*out*/ int64_t &end_offset)
-{
-    end_offset = log->start_offset();
-    LOG_INFO("start to replay mutation log {}, offset = [{}, {}), size = {}",
-             log->path(),
-             log->start_offset(),
-             log->end_offset(),
-             log->end_offset() - log->start_offset());
-
-    ::dsn::blob bb;
-    log->reset_stream();
-    error_s err;
-    size_t start_offset = 0;
-    while (true) {
-        err = replay_block(log, callback, start_offset, end_offset);
-        if (!err.is_ok()) {
-            // Stop immediately if failed
-            break;
-        }
-
-        start_offset = static_cast<size_t>(end_offset - log->start_offset());
-    }
+DSN_DEFINE_uint32(replication,
+                  log_replay_read_ahead_blocks,
+                  4,
+                  "The number of blocks (1MB for each) read ahead asynchronously while replaying "
+                  "a log file, so that reading the following blocks is overlapped with decoding "
+                  "and applying the mutations of the current one");
+DSN_DEFINE_validator(log_replay_read_ahead_blocks,
+                     [](uint32_t value) -> bool { return value >= 2; });
 
-    LOG_INFO("finish to replay mutation log ({}) [err: {}]", log->path(), err);
-    return err.code();
-}
+namespace dsn::replication {
 
 namespace {
 
-dsn::error_s read_block(dsn::replication::log_file_ptr &log,
-                        size_t start_offset,
-                        int64_t &end_offset,
-                        std::unique_ptr<dsn::binary_reader> &reader)
+// Read the next block from the current position of the stream, which should be `start_offset`
+// of the file.
+dsn::error_s read_next_block(dsn::replication::log_file_ptr &log,
+                             size_t start_offset,
+                             int64_t &end_offset,
+                             std::unique_ptr<dsn::binary_reader> &reader)
 {
-    log->reset_stream(start_offset); // Start reading from given offset.
     int64_t global_start_offset = static_cast<int64_t>(start_offset) + log->start_offset();
     end_offset = global_start_offset; // Reset end_offset to the start.
 
@@ -107,6 +89,43 @@ dsn::error_s read_block(dsn::replication::log_file_ptr &log,
     return dsn::error_s::ok();
 }
 
+dsn::error_s read_block(dsn::replication::log_file_ptr &log,
+                        size_t start_offset,
+                        int64_t &end_offset,
+                        std::unique_ptr<dsn::binary_reader> &reader)
+{
+    log->reset_stream(start_offset); // Start reading from given offset.
+    return read_next_block(log, start_offset, end_offset, reader);
+}
+
+// Decode the mutations from the block and execute `callback` for each of them.
+dsn::error_s replay_mutations(dsn::binary_reader &reader,
+                              dsn::replication::mutation_log::replay_callback &callback,
+                              int64_t &end_offset)
+{
+    while (!reader.is_eof()) {
+        auto old_size = reader.get_remaining_size();
+        mutation_ptr mu = mutation::read_from(reader, nullptr);
+        CHECK_NOTNULL(mu, "");
+        mu->set_logged();
+
+        if (mu->data.header.log_offset != end_offset) {
+            return FMT_ERR(ERR_INVALID_DATA,
+                           "offset mismatch in log entry and mutation {} vs {}",
+                           end_offset,
+                           mu->data.header.log_offset);
+        }
+
+        int log_length = old_size - reader.get_remaining_size();
+
+        callback(log_length, mu);
+
+        end_offset += log_length;
+    }
+
+    return dsn::error_s::ok();
+}
+
 } // anonymous namespace
 
 /*static*/ error_s mutation_log::replay_block(log_file_ptr &log,
@@ -120,28 +139,41 @@ dsn::error_s read_block(dsn::replication::log_file_ptr &log,
 
     std::unique_ptr<binary_reader> reader;
     RETURN_NOT_OK(read_block(log, start_offset, end_offset, reader));
+    return replay_mutations(*reader, callback, end_offset);
+}
 
-    while (!reader->is_eof()) {
-        auto old_size = reader->get_remaining_size();
-        mutation_ptr mu = mutation::read_from(*reader, nullptr);
-        CHECK_NOTNULL(mu, "");
-        mu->set_logged();
+/*static*/ error_code mutation_log::replay(log_file_ptr log,
+                                           replay_callback callback,
+                                           /*out*/ int64_t &end_offset)
+{
+    end_offset = log->start_offset();
+    LOG_INFO("start to replay mutation log {}, offset = [{}, {}), size = {}",
+             log->path(),
+             log->start_offset(),
+             log->end_offset(),
+             log->end_offset() - log->start_offset());
 
-        if (mu->data.header.log_offset != end_offset) {
-            return FMT_ERR(ERR_INVALID_DATA,
-                           "offset mismatch in log entry and mutation {} vs {}",
-                           end_offset,
-                           mu->data.header.log_offset);
+    // The blocks are read sequentially without resetting the stream for each of them, thus
+    // the following blocks are read ahead while the current one is being decoded and applied.
+    log->reset_stream(0, FLAGS_log_replay_read_ahead_blocks);
+    error_s err;
+    size_t start_offset = 0;
+    while (true) {
+        std::unique_ptr<binary_reader> reader;
+        err = read_next_block(log, start_offset, end_offset, reader);
+        if (err.is_ok()) {
+            err = replay_mutations(*reader, callback, end_offset);
+        }
+        if (!err.is_ok()) {
+            // Stop immediately if failed
+            break;
         }
 
-        int log_length = old_size - reader->get_remaining_size();
-
-        callback(log_length, mu);
-
-        end_offset += log_length;
+        start_offset = static_cast<size_t>(end_offset - log->start_offset());
     }
 
-    return error_s::ok();
+    LOG_INFO("finish to replay mutation log ({}) [err: {}]", log->path(), err);
+    return err.code();
 }
 
 /*static*/ error_code mutation_log::replay(std::vector<std::string> &log_files,
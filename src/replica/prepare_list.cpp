@@ -26,6 +26,7 @@
 
 #include "prepare_list.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
@@ -159,6 +160,14 @@ void prepare_list::commit(decree d, commit_type ct)
         for (decree d0 = last_committed_decree() + 1; d0 <= d; d0++) {
             mutation_ptr mu = get_mutation_by_decree(d0);
 
+            // The primary might have committed a mutation which was acked by this secondary
+            // before it is logged. Defer the commit until it is logged, so that the app is never
+            // ahead of the private log.
+            if (mu != nullptr && !mu->is_logged() && mu->is_acked_before_logged()) {
+                _deferred_commit_decree = std::max(_deferred_commit_decree, d);
+                return;
+            }
+
             CHECK_PREFIX_MSG(
                 mu != nullptr && mu->is_logged(), "mutation {} is missing in prepare list", d0);
             CHECK_GE_PREFIX(mu->data.header.ballot, last_bt);
@@ -81,11 +81,16 @@ public:
                        bool secondary_commit = true);
     virtual void commit(decree decree, commit_type ct); // ordered commit
 
+    // Continue the COMMIT_TO_DECREE_HARD which has been deferred by the mutations acked before
+    // logged, once they are logged.
+    void commit_deferred() { commit(_deferred_commit_decree, COMMIT_TO_DECREE_HARD); }
+
     virtual ~prepare_list() = default;
 
 private:
     friend class mutation_buffer;
     decree _last_committed_decree;
+    decree _deferred_commit_decree{0};
     mutation_committer _committer;
 };
 
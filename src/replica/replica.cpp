@@ -54,6 +54,7 @@
 #include "rpc/rpc_message.h"
 #include "security/access_controller.h"
 #include "split/replica_split_manager.h"
+#include "task/async_calls.h"
 #include "utils/filesystem.h"
 #include "utils/flags.h"
 #include "utils/fmt_logging.h"
@@ -212,6 +213,54 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kRequests,
                       "The number of failed RPC_PREPARE requests");
 
+METRIC_DEFINE_percentile_int64(replica,
+                               write_batch_size,
+                               dsn::metric_unit::kRequests,
+                               "The number of client requests batched in each mutation that "
+                               "enters 2PC. Only used for the primary replicas");
+
+METRIC_DEFINE_counter(replica,
+                      held_write_batches,
+                      dsn::metric_unit::kMutations,
+                      "The number of times that the pending mutation is held by adaptive "
+                      "write batching to batch more client requests. Only used for the "
+                      "primary replicas");
+
+METRIC_DEFINE_counter(replica,
+                      acked_before_logged_prepares,
+                      dsn::metric_unit::kRequests,
+                      "The number of RPC_PREPARE requests acked before the mutations are logged. "
+                      "Only used for the secondary replicas");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          unlogged_acked_mutations,
+                          dsn::metric_unit::kMutations,
+                          "The number of mutations that have been acked but not logged yet. Only "
+                          "used for the secondary replicas");
+
+METRIC_DEFINE_counter(replica,
+                      unlogged_acked_log_failures,
+                      dsn::metric_unit::kMutations,
+                      "The number of mutations acked before logged whose logs failed, after which "
+                      "the replica would be removed and re-learn the lost writes from the primary");
+
+METRIC_DEFINE_counter(replica,
+                      private_log_replayed_mutations,
+                      dsn::metric_unit::kMutations,
+                      "The number of mutations replayed from the private log while the replica "
+                      "is being opened");
+
+METRIC_DEFINE_counter(replica,
+                      private_log_replayed_bytes,
+                      dsn::metric_unit::kBytes,
+                      "The size of the mutations replayed from the private log while the replica "
+                      "is being opened");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          private_log_replay_duration_ms,
+                          dsn::metric_unit::kMilliSeconds,
+                          "The duration of replaying the private log while the replica was opened");
+
 METRIC_DEFINE_counter(replica,
                       group_check_failed_requests,
                       dsn::metric_unit::kRequests,
@@ -309,6 +358,14 @@ replica::replica(replica_stub *stub,
       METRIC_VAR_INIT_replica(learn_failed_count),
       METRIC_VAR_INIT_replica(learn_successful_count),
       METRIC_VAR_INIT_replica(prepare_failed_requests),
+      METRIC_VAR_INIT_replica(write_batch_size),
+      METRIC_VAR_INIT_replica(held_write_batches),
+      METRIC_VAR_INIT_replica(acked_before_logged_prepares),
+      METRIC_VAR_INIT_replica(unlogged_acked_mutations),
+      METRIC_VAR_INIT_replica(unlogged_acked_log_failures),
+      METRIC_VAR_INIT_replica(private_log_replayed_mutations),
+      METRIC_VAR_INIT_replica(private_log_replayed_bytes),
+      METRIC_VAR_INIT_replica(private_log_replay_duration_ms),
       METRIC_VAR_INIT_replica(group_check_failed_requests),
       METRIC_VAR_INIT_replica(emergency_checkpoints),
       METRIC_VAR_INIT_replica(write_size_exceed_threshold_requests),
@@ -438,25 +495,39 @@ void replica::on_client_read(dsn::message_ex *request, bool ignore_throttling)
     }
 
     CHECK(_app, "");
-    auto storage_error = _app->on_request(request);
+    handle_read_storage_error(_app->on_request(request));
+}
+
+void replica::on_async_read_storage_error(int storage_error)
+{
+    tasking::enqueue(
+        LPC_REPLICATION_ERROR,
+        &_tracker,
+        [this, storage_error]() { handle_read_storage_error(storage_error); },
+        get_gpid().thread_hash());
+}
+
+void replica::handle_read_storage_error(int storage_error)
+{
     // kNotFound is normal, it indicates that the key is not found (including expired)
     // in the storage engine, so just ignore it.
-    if (dsn_unlikely(storage_error != rocksdb::Status::kOk &&
-                     storage_error != rocksdb::Status::kNotFound)) {
-        switch (storage_error) {
-        // TODO(yingchun): Now only kCorruption and kIOError are dealt, consider to deal with
-        //  more storage engine errors.
-        case rocksdb::Status::kCorruption:
-            handle_local_failure(ERR_RDB_CORRUPTION);
-            break;
-        case rocksdb::Status::kIOError:
-            handle_local_failure(ERR_DISK_IO_ERROR);
-            break;
-        default:
-            LOG_ERROR_PREFIX("client read encountered an unhandled error: {}", storage_error);
-        }
+    if (dsn_likely(storage_error == rocksdb::Status::kOk ||
+                   storage_error == rocksdb::Status::kNotFound)) {
         return;
     }
+
+    switch (storage_error) {
+    // TODO(yingchun): Now only kCorruption and kIOError are dealt, consider to deal with
+    //  more storage engine errors.
+    case rocksdb::Status::kCorruption:
+        handle_local_failure(ERR_RDB_CORRUPTION);
+        break;
+    case rocksdb::Status::kIOError:
+        handle_local_failure(ERR_DISK_IO_ERROR);
+        break;
+    default:
+        LOG_ERROR_PREFIX("client read encountered an unhandled error: {}", storage_error);
+    }
 }
 
 void replica::response_client_read(dsn::message_ex *request, error_code error)
@@ -500,6 +571,13 @@ void replica::execute_mutation(mutation_ptr &mu)
         check_state_completeness();
         CHECK_EQ(_app->last_committed_decree() + 1, d);
         err = _app->apply_mutation(mu);
+
+        // Only the mutations carrying client requests are sampled, since the empty ones and
+        // the ones inherited from the former primary were not created by the write queue.
+        if (err == ERR_OK && !mu->client_requests.empty() &&
+            mu->client_requests.front() != nullptr) {
+            _primary_states.write_queue.record_commit_latency(dsn_now_ns() - mu->create_ts_ns());
+        }
     } break;
 
     case partition_status::PS_SECONDARY:
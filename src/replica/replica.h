@@ -184,6 +184,9 @@ public:
     //
     void on_client_write(message_ex *request, bool ignore_throttling);
     void on_client_read(message_ex *request, bool ignore_throttling);
+    // Handle the storage error of a client read whose response is filled by the storage engine
+    // after on_request() returns, could be called from any thread.
+    void on_async_read_storage_error(int storage_error);
 
     //
     //    messages and tools from/for meta server
@@ -362,6 +365,8 @@ public:
     METRIC_DEFINE_INCREMENT(backup_file_upload_failed_count)
     METRIC_DEFINE_INCREMENT(backup_file_upload_successful_count)
     METRIC_DEFINE_INCREMENT_BY(backup_file_upload_total_bytes)
+    METRIC_DEFINE_SET(write_batch_size, int64_t)
+    METRIC_DEFINE_INCREMENT(held_write_batches)
 
 protected:
     // this method is marked protected to enable us to mock it in unit tests.
@@ -477,6 +482,10 @@ private:
         init_prepare(mu, reconciliation, false);
     }
 
+    // Release the pending mutation held by adaptive write batching in the write queue and
+    // launch 2PC for it, in case no mutation in 2PC phase is committed in time.
+    void release_held_write_batch();
+
     // Reply to the client with the error if 2PC failed.
     //
     // Parameters:
@@ -538,6 +547,8 @@ private:
     /////////////////////////////////////////////////////////////////
     // failure handling
     void handle_local_failure(error_code error);
+    // Handle the error (rocksdb::Status::Code) returned by the storage engine for a client read.
+    void handle_read_storage_error(int storage_error);
     void handle_remote_failure(partition_status::type status,
                                const host_port &node,
                                error_code error,
@@ -686,6 +697,9 @@ private:
     // update envs to deny client request
     void update_deny_client(const std::map<std::string, std::string> &envs);
 
+    // update env of the window of the mutations acked by the secondary before logged
+    void update_secondary_unlogged_ack_window(const std::map<std::string, std::string> &envs);
+
     // Write the specified `info` into .app_info file under the specified `dir` directory.
     error_code store_app_info(app_info &info, const std::string &dir);
 
@@ -845,6 +859,11 @@ private:
     std::unique_ptr<replica_split_manager> _split_mgr;
     bool _validate_partition_hash{false};
 
+    // See replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW, only used by the secondaries.
+    int64_t _secondary_unlogged_ack_window{0};
+    // The number of mutations that have been acked but not logged yet.
+    int64_t _unlogged_acked_mutations{0};
+
     // disk migrator
     std::unique_ptr<replica_disk_migrator> _disk_migrator;
 
@@ -876,6 +895,14 @@ private:
     METRIC_VAR_DECLARE_counter(learn_successful_count);
 
     METRIC_VAR_DECLARE_counter(prepare_failed_requests);
+    METRIC_VAR_DECLARE_percentile_int64(write_batch_size);
+    METRIC_VAR_DECLARE_counter(held_write_batches);
+    METRIC_VAR_DECLARE_counter(acked_before_logged_prepares);
+    METRIC_VAR_DECLARE_gauge_int64(unlogged_acked_mutations);
+    METRIC_VAR_DECLARE_counter(unlogged_acked_log_failures);
+    METRIC_VAR_DECLARE_counter(private_log_replayed_mutations);
+    METRIC_VAR_DECLARE_counter(private_log_replayed_bytes);
+    METRIC_VAR_DECLARE_gauge_int64(private_log_replay_duration_ms);
 
     METRIC_VAR_DECLARE_counter(group_check_failed_requests);
 
@@ -107,6 +107,7 @@ DSN_DEFINE_uint64(
 
 DSN_DECLARE_int32(max_mutation_count_in_prepare_list);
 DSN_DECLARE_int32(staleness_for_commit);
+DSN_DECLARE_uint32(adaptive_write_batch_p99_target_ms);
 
 namespace dsn {
 namespace replication {
@@ -181,6 +182,20 @@ void replica::on_client_write(dsn::message_ex *request, bool ignore_throttling)
         return;
     }
 
+    // Besides the partition hash in the header, all the rows written by the request should
+    // belong to this partition, and be locked once it enters 2PC phase. The request is parsed
+    // only once for both.
+    std::vector<uint64_t> extra_partition_hashes;
+    if (_app->get_write_partition_hashes(request, extra_partition_hashes) &&
+        _validate_partition_hash) {
+        for (const auto partition_hash : extra_partition_hashes) {
+            if (!_split_mgr->check_partition_hash(partition_hash, "write")) {
+                response_client_write(request, ERR_PARTITION_HASH_MISMATCHED);
+                return;
+            }
+        }
+    }
+
     if (FLAGS_reject_write_when_disk_insufficient &&
         (_dir_node->status != disk_status::NORMAL || _primary_states.secondary_disk_abnormal())) {
         response_client_write(request, disk_status_to_error_code(_dir_node->status));
@@ -230,9 +245,36 @@ void replica::on_client_write(dsn::message_ex *request, bool ignore_throttling)
     }
 
     LOG_DEBUG_PREFIX("got write request from {}", request->header->from_address);
-    auto mu = _primary_states.write_queue.add_work(request);
+    auto mu = _primary_states.write_queue.add_work(request, std::move(extra_partition_hashes));
     if (mu != nullptr) {
         init_prepare(mu, false);
+        return;
+    }
+
+    // The pending mutation held for batching is usually released once a mutation in 2PC phase
+    // is committed. In case the commit is delayed (e.g. by a slow secondary), release it after
+    // the latency target anyway.
+    if (_primary_states.write_queue.need_schedule_release()) {
+        tasking::enqueue(
+            LPC_REPLICATION_COMMON,
+            &_tracker,
+            [this]() { release_held_write_batch(); },
+            get_gpid().thread_hash(),
+            std::chrono::milliseconds(FLAGS_adaptive_write_batch_p99_target_ms));
+    }
+}
+
+void replica::release_held_write_batch()
+{
+    if (status() != partition_status::PS_PRIMARY) {
+        // The write queue has been cleared once this replica is no longer the primary.
+        return;
+    }
+
+    auto next = _primary_states.write_queue.release_held(
+        static_cast<int>(max_prepared_decree() - last_committed_decree()));
+    if (next != nullptr) {
+        init_prepare(next, false);
     }
 }
 
@@ -628,8 +670,8 @@ void replica::on_prepare(dsn::message_ex *request)
     _uniq_timestamp_us.try_update(mu->data.header.timestamp);
     auto mu2 = _prepare_list->get_mutation_by_decree(decree);
     if (mu2 != nullptr && mu2->data.header.ballot == mu->data.header.ballot) {
-        if (mu2->is_logged()) {
-            // already logged, just response ERR_OK
+        if (mu2->is_logged() || mu2->is_acked_before_logged()) {
+            // already logged or acked, just response ERR_OK
             ack_prepare_message(ERR_OK, mu);
         } else {
             // not logged, combine duplicate request to old mutation
@@ -671,6 +713,17 @@ void replica::on_prepare(dsn::message_ex *request)
                                                     std::placeholders::_2),
                                           get_gpid().thread_hash());
     CHECK_NOTNULL(mu->log_task(), "");
+
+    // For the tables which could tolerate losing the latest writes, ack before the mutation is
+    // logged as long as the unlogged mutations are within the window. The commit of the mutation
+    // would be deferred until it is logged, see prepare_list::commit().
+    if (partition_status::PS_SECONDARY == status() && !mu->is_sync_to_child() &&
+        _unlogged_acked_mutations < _secondary_unlogged_ack_window) {
+        mu->set_acked_before_logged();
+        METRIC_VAR_SET(unlogged_acked_mutations, ++_unlogged_acked_mutations);
+        METRIC_VAR_INCREMENT(acked_before_logged_prepares);
+        ack_prepare_message(ERR_OK, mu);
+    }
 }
 
 void replica::on_append_log_completed(mutation_ptr &mu, error_code err, size_t size)
@@ -688,6 +741,15 @@ void replica::on_append_log_completed(mutation_ptr &mu, error_code err, size_t s
         LOG_ERROR_PREFIX("append shared log failed for mutation {}, err = {}", mu->name(), err);
     }
 
+    if (mu->is_acked_before_logged()) {
+        METRIC_VAR_SET(unlogged_acked_mutations, --_unlogged_acked_mutations);
+        if (err != ERR_OK) {
+            // The primary has been told that the mutation is prepared. The replica would be
+            // removed from the group due to the failure below, and re-learn from the primary.
+            METRIC_VAR_INCREMENT(unlogged_acked_log_failures);
+        }
+    }
+
     // skip old mutations
     if (mu->data.header.ballot >= get_ballot() && status() != partition_status::PS_INACTIVE) {
         switch (status()) {
@@ -703,10 +765,14 @@ void replica::on_append_log_completed(mutation_ptr &mu, error_code err, size_t s
             if (err != ERR_OK) {
                 handle_local_failure(err);
             }
-            // always ack
-            ack_prepare_message(err, mu);
+            // always ack unless it has been acked before logged
+            if (!mu->is_acked_before_logged()) {
+                ack_prepare_message(err, mu);
+            }
             // all mutations with lower decree must be ready
             _prepare_list->commit(mu->data.header.last_committed_decree, COMMIT_TO_DECREE_HARD);
+            // continue the commit deferred by this mutation if any
+            _prepare_list->commit_deferred();
             break;
         case partition_status::PS_PARTITION_SPLIT:
             if (err != ERR_OK) {
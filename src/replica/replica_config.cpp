@@ -80,6 +80,9 @@
 
 DSN_DEFINE_bool(replication, plog_gc_enabled, true, "Whether to enable plog garbage collection.");
 
+DSN_DECLARE_int32(max_mutation_count_in_prepare_list);
+DSN_DECLARE_int32(staleness_for_commit);
+
 /// The configuration management part of replica.
 
 namespace dsn {
@@ -552,6 +555,8 @@ void replica::update_app_envs_internal(const std::map<std::string, std::string>
     update_allow_ingest_behind(envs);
 
     update_deny_client(envs);
+
+    update_secondary_unlogged_ack_window(envs);
 }
 
 void replica::update_bool_envs(const std::map<std::string, std::string> &envs,
@@ -627,6 +632,32 @@ void replica::update_deny_client(const std::map<std::string, std::string> &envs)
     _deny_client.write = (sub_sargs[1] == "write" || sub_sargs[1] == "all");
 }
 
+void replica::update_secondary_unlogged_ack_window(
+    const std::map<std::string, std::string> &envs)
+{
+    int64_t new_window = 0;
+    const auto *env = gutil::FindOrNull(envs, replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW);
+    if (env != nullptr && (!buf2int64(*env, new_window) || new_window < 0)) {
+        LOG_WARNING_PREFIX(
+            "invalid value of env {}: {}", replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW, *env);
+        return;
+    }
+
+    // The primary would prepare at most FLAGS_staleness_for_commit mutations beyond its committed
+    // decree, while the commit on the secondary might fall behind the primary by the window since
+    // it is deferred by the unlogged mutations. Limit the window to make sure the prepare list of
+    // the secondary (which also holds the last committed mutation) would never overflow.
+    new_window = std::min<int64_t>(
+        new_window, FLAGS_max_mutation_count_in_prepare_list - FLAGS_staleness_for_commit - 1);
+    if (new_window != _secondary_unlogged_ack_window) {
+        LOG_INFO_PREFIX("switch env[{}] from {} to {}",
+                        replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW,
+                        _secondary_unlogged_ack_window,
+                        new_window);
+        _secondary_unlogged_ack_window = new_window;
+    }
+}
+
 void replica::query_app_envs(/*out*/ std::map<std::string, std::string> &envs)
 {
     if (_app) {
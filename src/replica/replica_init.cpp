@@ -50,6 +50,7 @@
 #include "utils/filesystem.h"
 #include "utils/flags.h"
 #include "utils/fmt_logging.h"
+#include "utils/metrics.h"
 #include "utils/ports.h"
 #include "utils/uniq_timestamp_us.h"
 
@@ -156,7 +157,11 @@ error_code replica::init_app_and_prepare_list(bool create_new)
 
                 uint64_t start_time = dsn_now_ms();
                 err = _private_log->open(
-                    [this](int log_length, mutation_ptr &mu) { return replay_mutation(mu, true); },
+                    [this](int log_length, mutation_ptr &mu) {
+                        METRIC_VAR_INCREMENT(private_log_replayed_mutations);
+                        METRIC_VAR_INCREMENT_BY(private_log_replayed_bytes, log_length);
+                        return replay_mutation(mu, true);
+                    },
                     [this](error_code err) {
                         tasking::enqueue(
                             LPC_REPLICATION_ERROR,
@@ -167,6 +172,8 @@ error_code replica::init_app_and_prepare_list(bool create_new)
                     replay_condition);
 
                 uint64_t finish_time = dsn_now_ms();
+                METRIC_VAR_SET(private_log_replay_duration_ms,
+                               static_cast<int64_t>(finish_time - start_time));
 
                 if (err == ERR_OK) {
                     LOG_INFO_PREFIX("replay private log succeed, durable = {}, committed = {}, "
@@ -169,6 +169,11 @@ bool replication_app_base::is_duplication_follower() const
 
 const ballot &replication_app_base::get_ballot() const { return _replica->get_ballot(); }
 
+void replication_app_base::report_async_read_error(int storage_error)
+{
+    _replica->on_async_read_storage_error(storage_error);
+}
+
 error_code replication_app_base::open_internal(replica *r)
 {
     LOG_AND_RETURN_NOT_TRUE(ERROR_PREFIX,
@@ -273,6 +273,17 @@ public:
                                 std::vector<dsn::message_ex *> &new_requests,
                                 pegasus::idempotent_writer_ptr &idem_writer) = 0;
 
+    // Get the partition hashes of all the rows written by a request whose rows could not be
+    // represented by the single partition hash in its header, e.g. a batch put across multiple
+    // hash keys. Return false for the other requests. Only called by primary replicas, once for
+    // each incoming request before it is added to a mutation, thus the read cursor of `request`
+    // must be kept unchanged.
+    virtual bool get_write_partition_hashes(dsn::message_ex *request,
+                                            std::vector<uint64_t> &partition_hashes)
+    {
+        return false;
+    }
+
     // Apply batched write requests from a mutation. This is a virtual function, and base class
     // provide a naive implementation that just call on_request for each request. Storage engine
     // may override this function to get better performance.
@@ -349,6 +360,10 @@ public:
 protected:
     explicit replication_app_base(replication::replica *replica);
 
+    // Report the storage error (rocksdb::Status::Code) of a client read whose response is filled
+    // after on_request() returns, thus the error could not be returned by on_request().
+    void report_async_read_error(int storage_error);
+
     std::string _dir_data;        // ${replica_dir}/data
     std::string _dir_learn;       // ${replica_dir}/learn
     std::string _dir_backup;      // ${replica_dir}/backup
@@ -27,9 +27,15 @@
 #include "replica/log_block.h"
 #include "replica/log_file.h"
 #include "replica_test_base.h"
+#include "test_util/test_util.h"
 #include "utils/autoref_ptr.h"
+#include "utils/blob.h"
+#include "utils/env.h"
 #include "utils/error_code.h"
 #include "utils/filesystem.h"
+#include "utils/flags.h"
+
+DSN_DECLARE_uint64(plog_bytes_per_sync);
 
 namespace dsn::replication {
 
@@ -205,4 +211,67 @@ TEST_P(log_file_test, commit_log_blocks)
     ASSERT_EQ(tsk->get_aio_context()->file_offset, appender->start_offset() - _start_offset);
 }
 
+TEST_P(log_file_test, preallocate_and_drop_written_pages)
+{
+    PRESERVE_FLAG(plog_bytes_per_sync);
+    FLAGS_plog_bytes_per_sync = 4096;
+
+    const int64_t start_offset = 1000;
+    auto logf = log_file::create_write(_log_dir.c_str(), 2, start_offset, 4 << 20);
+    ASSERT_NE(nullptr, logf);
+
+    // The preallocated space does not change the file size.
+    int64_t file_size = 0;
+    ASSERT_TRUE(utils::filesystem::file_size(
+        logf->path(), dsn::utils::FileDataType::kSensitive, file_size));
+    ASSERT_EQ(0, file_size);
+
+    size_t written_sz = 0;
+    int written_blocks = 0;
+    for (int round = 0; round < 3; ++round) {
+        auto appender = std::make_shared<log_appender>(start_offset + written_sz);
+        for (int i = 0; i < 16; i++) {
+            appender->append_mutation(create_test_mutation(1 + i, std::string(1024, 'a').c_str()),
+                                      nullptr);
+        }
+        auto tsk = logf->commit_log_blocks(
+            *appender, LPC_WRITE_REPLICATION_LOG_PRIVATE, nullptr, nullptr, 0);
+        tsk->wait();
+        ASSERT_EQ(ERR_OK, tsk->error());
+        written_sz += appender->size();
+        written_blocks += appender->all_blocks().size();
+    }
+
+    ASSERT_EQ(start_offset + written_sz, logf->end_offset());
+    ASSERT_TRUE(utils::filesystem::file_size(
+        logf->path(), dsn::utils::FileDataType::kSensitive, file_size));
+    ASSERT_EQ(written_sz, file_size);
+    const auto path = logf->path();
+    logf->close();
+    logf = nullptr;
+
+    // Only the written blocks are read back, while the preallocated tail is never read as
+    // log data.
+    error_code err;
+    logf = log_file::open_read(path.c_str(), err);
+    ASSERT_EQ(ERR_OK, err);
+    ASSERT_EQ(start_offset + written_sz, logf->end_offset());
+    logf->reset_stream();
+    int block_count = 0;
+    size_t read_sz = 0;
+    while (true) {
+        blob bb;
+        err = logf->read_next_log_block(bb);
+        if (err != ERR_OK) {
+            break;
+        }
+        ++block_count;
+        read_sz += sizeof(log_block_header) + bb.length();
+    }
+    ASSERT_EQ(ERR_HANDLE_EOF, err);
+    ASSERT_EQ(written_blocks, block_count);
+    ASSERT_EQ(written_sz, read_sz);
+    logf->close();
+}
+
 } // namespace dsn::replication
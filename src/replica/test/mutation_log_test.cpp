@@ -47,9 +47,12 @@
 #include "utils/blob.h"
 #include "utils/env.h"
 #include "utils/filesystem.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/ports.h"
 
+DSN_DECLARE_uint32(log_replay_read_ahead_blocks);
+
 namespace dsn {
 class message_ex;
 } // namespace dsn
@@ -444,6 +447,47 @@ public:
             ASSERT_GE(log_files.size(), 1);
         }
     }
+
+    void test_replay_with_read_ahead_blocks()
+    {
+        std::vector<mutation_ptr> mutations;
+
+        { // writing logs, which would span multiple blocks of the stream
+            mutation_log_ptr mlog = create_private_log(32);
+            const std::string value(1024, 'v');
+            for (int i = 0; i < 5000; i++) {
+                mutation_ptr mu = create_test_mutation(2 + i, value.c_str());
+                mutations.push_back(mu);
+                mlog->append(mu, LPC_AIO_IMMEDIATE_CALLBACK, nullptr, nullptr, 0);
+            }
+            mlog->tracker()->wait_outstanding_tasks();
+        }
+
+        PRESERVE_FLAG(log_replay_read_ahead_blocks);
+        for (uint32_t blocks : {2, 3, 8}) {
+            FLAGS_log_replay_read_ahead_blocks = blocks;
+
+            std::string log_file_path = _log_dir + "/log.1.0";
+            error_code ec;
+            log_file_ptr file = log_file::open_read(log_file_path.c_str(), ec);
+            ASSERT_EQ(ERR_OK, ec);
+
+            int64_t end_offset;
+            int mutation_index = -1;
+            ec = mutation_log::replay(
+                file,
+                [&mutations, &mutation_index](int log_length, mutation_ptr &mu) -> bool {
+                    mutation_ptr wmu = mutations[++mutation_index];
+                    EXPECT_EQ(wmu->data.header, mu->data.header);
+                    ASSERT_BLOB_EQ(wmu->data.updates[0].data, mu->data.updates[0].data);
+                    return true;
+                },
+                end_offset);
+            ASSERT_EQ(ERR_HANDLE_EOF, ec);
+            ASSERT_EQ(mutation_index + 1, (int)mutations.size());
+            ASSERT_EQ(file->end_offset(), end_offset);
+        }
+    }
 };
 
 INSTANTIATE_TEST_SUITE_P(, mutation_log_test, ::testing::Values(false, true));
@@ -460,6 +504,8 @@ TEST_P(mutation_log_test, replay_single_file_1) { test_replay_single_file(1); }
 
 TEST_P(mutation_log_test, replay_single_file_10) { test_replay_single_file(10); }
 
+TEST_P(mutation_log_test, replay_with_read_ahead_blocks) { test_replay_with_read_ahead_blocks(); }
+
 // mutation_log::open
 TEST_P(mutation_log_test, open)
 {
@@ -0,0 +1,240 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "common/replication.codes.h"
+#include "gtest/gtest.h"
+#include "metadata_types.h"
+#include "replica/mutation.h"
+#include "replica/prepare_list.h"
+#include "replica/test/mock_utils.h"
+#include "replica_test_base.h"
+#include "rpc/rpc_message.h"
+#include "runtime/api_layer1.h"
+#include "task/task_code.h"
+#include "test_util/test_util.h"
+#include "utils/autoref_ptr.h"
+#include "utils/error_code.h"
+#include "utils/flags.h"
+
+DSN_DECLARE_bool(adaptive_write_batch_enabled);
+DSN_DECLARE_uint32(adaptive_write_batch_p99_target_ms);
+
+namespace dsn::replication {
+
+DEFINE_STORAGE_WRITE_RPC_CODE(RPC_MUTATION_QUEUE_TEST_WRITE, ALLOW_BATCH, IS_IDEMPOTENT)
+
+class mutation_queue_test : public replica_test_base
+{
+protected:
+    static constexpr uint64_t kMsToNs = 1000000;
+    static constexpr size_t kCommitLatencyWindow = mutation_queue::kCommitLatencyWindow;
+
+    mutation_queue_test()
+        : _queue(std::make_unique<mutation_queue>(_replica.get(), _replica->get_gpid(), 8, false))
+    {
+    }
+
+    mutation_ptr add_write()
+    {
+        static const char kValue[] = "value";
+        auto *request = message_ex::create_received_request(
+            RPC_MUTATION_QUEUE_TEST_WRITE, DSF_THRIFT_BINARY, kValue, sizeof(kValue) - 1);
+        auto mu = _queue->add_work(request);
+
+        // The mutation has held its own reference to the request.
+        request->release_ref();
+        return mu;
+    }
+
+    // Make one mutation in 2PC phase, i.e. prepared but not committed.
+    void prepare_one_mutation()
+    {
+        _replica->set_last_committed_decree(0);
+        auto mu = create_test_mutation(1, 0, "1");
+        ASSERT_EQ(ERR_OK, _replica->get_plist()->prepare(mu, partition_status::PS_PRIMARY));
+        ASSERT_GT(_replica->max_prepared_decree(), _replica->last_committed_decree());
+
+        // Reset the count of the mutations in 2PC phase.
+        ASSERT_EQ(nullptr, _queue->next_work(1));
+    }
+
+    void fill_commit_latencies(uint64_t latency_ns)
+    {
+        for (size_t i = 0; i < kCommitLatencyWindow; ++i) {
+            _queue->record_commit_latency(latency_ns);
+        }
+    }
+
+    uint64_t p99_commit_latency_ns() const { return _queue->_p99_commit_latency_ns; }
+    uint64_t arrival_interval_ns() const { return _queue->_arrival_interval_ns; }
+    void set_last_arrival_ns(uint64_t ns) { _queue->_last_arrival_ns = ns; }
+    void set_arrival_interval_ns(uint64_t ns) { _queue->_arrival_interval_ns = ns; }
+    bool pending_held() const { return _queue->_pending_held; }
+    size_t pending_size() const
+    {
+        return _queue->_pending_mutation == nullptr
+                   ? 0
+                   : _queue->_pending_mutation->client_requests.size();
+    }
+
+    std::unique_ptr<mutation_queue> _queue;
+};
+
+INSTANTIATE_TEST_SUITE_P(, mutation_queue_test, ::testing::Values(false, true));
+
+TEST_P(mutation_queue_test, estimate_p99_commit_latency)
+{
+    // The p99 latency is not estimated until a window of samples is collected.
+    for (size_t i = 1; i < kCommitLatencyWindow; ++i) {
+        _queue->record_commit_latency(i * kMsToNs);
+    }
+    ASSERT_EQ(0, p99_commit_latency_ns());
+
+    _queue->record_commit_latency(kCommitLatencyWindow * kMsToNs);
+    ASSERT_EQ((kCommitLatencyWindow * 99 / 100 + 1) * kMsToNs, p99_commit_latency_ns());
+
+    // The next window starts from scratch.
+    fill_commit_latencies(3 * kMsToNs);
+    ASSERT_EQ(3 * kMsToNs, p99_commit_latency_ns());
+}
+
+TEST_P(mutation_queue_test, update_arrival_interval)
+{
+    // The first arrival has no interval.
+    set_last_arrival_ns(0);
+    set_arrival_interval_ns(0);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_EQ(0, arrival_interval_ns());
+
+    // The interval is folded into the moving average with a weight of 1/8.
+    set_last_arrival_ns(dsn_now_ns() - 8 * kMsToNs);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_GE(arrival_interval_ns(), 1 * kMsToNs);
+    ASSERT_LT(arrival_interval_ns(), 2 * kMsToNs);
+
+    set_last_arrival_ns(dsn_now_ns() - 8 * kMsToNs);
+    set_arrival_interval_ns(16 * kMsToNs);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_GE(arrival_interval_ns(), 15 * kMsToNs);
+    ASSERT_LT(arrival_interval_ns(), 16 * kMsToNs);
+}
+
+TEST_P(mutation_queue_test, hold_and_release_by_next_work)
+{
+    PRESERVE_FLAG(adaptive_write_batch_enabled);
+    PRESERVE_FLAG(adaptive_write_batch_p99_target_ms);
+    FLAGS_adaptive_write_batch_enabled = true;
+    FLAGS_adaptive_write_batch_p99_target_ms = 10;
+
+    fill_commit_latencies(5 * kMsToNs);
+    set_arrival_interval_ns(0);
+    prepare_one_mutation();
+
+    // The pending mutation is held to batch the following requests.
+    ASSERT_EQ(nullptr, add_write());
+    ASSERT_TRUE(pending_held());
+    ASSERT_EQ(nullptr, add_write());
+    ASSERT_EQ(2, pending_size());
+
+    // The held mutation is released once the mutation in 2PC phase is committed.
+    const auto mu = _queue->next_work(0);
+    ASSERT_NE(nullptr, mu);
+    ASSERT_EQ(2, mu->client_requests.size());
+    ASSERT_FALSE(pending_held());
+    ASSERT_EQ(nullptr, _queue->next_work(0));
+}
+
+TEST_P(mutation_queue_test, hold_and_release_by_timer)
+{
+    PRESERVE_FLAG(adaptive_write_batch_enabled);
+    PRESERVE_FLAG(adaptive_write_batch_p99_target_ms);
+    FLAGS_adaptive_write_batch_enabled = true;
+    FLAGS_adaptive_write_batch_p99_target_ms = 10;
+
+    fill_commit_latencies(5 * kMsToNs);
+    set_arrival_interval_ns(0);
+    prepare_one_mutation();
+
+    ASSERT_EQ(nullptr, add_write());
+    ASSERT_TRUE(pending_held());
+
+    // Only one release is scheduled for the held mutation.
+    ASSERT_TRUE(_queue->need_schedule_release());
+    ASSERT_EQ(nullptr, add_write());
+    ASSERT_FALSE(_queue->need_schedule_release());
+
+    // The held mutation is released even if the mutation in 2PC phase is not committed.
+    const auto mu = _queue->release_held(1);
+    ASSERT_NE(nullptr, mu);
+    ASSERT_EQ(2, mu->client_requests.size());
+    ASSERT_FALSE(pending_held());
+
+    // Nothing is released once the held mutation has been popped.
+    ASSERT_FALSE(_queue->need_schedule_release());
+    ASSERT_EQ(nullptr, _queue->release_held(1));
+
+    // A release could be scheduled again for the next held mutation.
+    ASSERT_EQ(nullptr, add_write());
+    ASSERT_TRUE(_queue->need_schedule_release());
+
+    // Clearing the queue drops the held mutation along with the scheduled release.
+    _queue->clear();
+    ASSERT_FALSE(pending_held());
+    ASSERT_EQ(nullptr, _queue->release_held(1));
+}
+
+TEST_P(mutation_queue_test, no_hold)
+{
+    PRESERVE_FLAG(adaptive_write_batch_enabled);
+    PRESERVE_FLAG(adaptive_write_batch_p99_target_ms);
+    FLAGS_adaptive_write_batch_enabled = true;
+    FLAGS_adaptive_write_batch_p99_target_ms = 10;
+
+    // No hold while there is no mutation in 2PC phase.
+    fill_commit_latencies(5 * kMsToNs);
+    set_arrival_interval_ns(0);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_FALSE(pending_held());
+
+    prepare_one_mutation();
+
+    // No hold once the latency target is exceeded.
+    fill_commit_latencies(20 * kMsToNs);
+    set_arrival_interval_ns(0);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_FALSE(pending_held());
+
+    // No hold if the requests arrive slower than the mutations are committed.
+    fill_commit_latencies(5 * kMsToNs);
+    set_last_arrival_ns(0);
+    set_arrival_interval_ns(10 * kMsToNs);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_FALSE(pending_held());
+
+    // No hold once adaptive write batching is disabled.
+    FLAGS_adaptive_write_batch_enabled = false;
+    set_arrival_interval_ns(0);
+    ASSERT_NE(nullptr, add_write());
+    ASSERT_FALSE(pending_held());
+    ASSERT_FALSE(_queue->need_schedule_release());
+}
+
+} // namespace dsn::replication
@@ -43,6 +43,8 @@
 #include "http/http_status_code.h"
 #include "metadata_types.h"
 #include "replica/disk_cleaner.h"
+#include "replica/mutation.h"
+#include "replica/prepare_list.h"
 #include "replica/replica.h"
 #include "replica/replica_http_service.h"
 #include "replica/replica_stub.h"
@@ -70,6 +72,8 @@
 DSN_DECLARE_bool(fd_disabled);
 DSN_DECLARE_string(cold_backup_root);
 DSN_DECLARE_uint32(mutation_2pc_min_replica_count);
+DSN_DECLARE_int32(max_mutation_count_in_prepare_list);
+DSN_DECLARE_int32(staleness_for_commit);
 
 using pegasus::AssertEventually;
 
@@ -153,6 +157,12 @@ public:
         return _mock_replica->_deny_client;
     }
 
+    int64_t update_secondary_unlogged_ack_window(const std::map<std::string, std::string> &envs)
+    {
+        _mock_replica->update_secondary_unlogged_ack_window(envs);
+        return _mock_replica->_secondary_unlogged_ack_window;
+    }
+
     void mock_app_info()
     {
         _app_info.app_id = 2;
@@ -621,6 +631,59 @@ TEST_P(replica_test, update_deny_client_test)
     }
 }
 
+TEST_P(replica_test, update_secondary_unlogged_ack_window_test)
+{
+    const auto &env_name = replica_envs::SECONDARY_UNLOGGED_ACK_WINDOW;
+    ASSERT_EQ(0, update_secondary_unlogged_ack_window({}));
+    ASSERT_EQ(8, update_secondary_unlogged_ack_window({{env_name, "8"}}));
+
+    // Invalid values are ignored.
+    ASSERT_EQ(8, update_secondary_unlogged_ack_window({{env_name, "-1"}}));
+    ASSERT_EQ(8, update_secondary_unlogged_ack_window({{env_name, "invalid"}}));
+
+    // The window is limited by the capacity of the prepare list.
+    ASSERT_EQ(FLAGS_max_mutation_count_in_prepare_list - FLAGS_staleness_for_commit - 1,
+              update_secondary_unlogged_ack_window({{env_name, "100000"}}));
+
+    ASSERT_EQ(0, update_secondary_unlogged_ack_window({}));
+}
+
+TEST_P(replica_test, defer_commit_of_unlogged_acked_mutation)
+{
+    std::vector<decree> committed;
+    prepare_list plist(_mock_replica.get(), 0, 10, [&committed](mutation_ptr &mu) {
+        committed.push_back(mu->get_decree());
+    });
+
+    auto mu1 = create_test_mutation(1, 0, "1");
+    ASSERT_EQ(ERR_OK, plist.prepare(mu1, partition_status::PS_SECONDARY));
+
+    // The mutation 2 is acked before logged.
+    mutation_ptr mu2(new mutation());
+    mu2->data.header.ballot = 1;
+    mu2->data.header.decree = 2;
+    mu2->data.header.pid = get_gpid();
+    mu2->data.header.last_committed_decree = 1;
+    mu2->data.updates.emplace_back();
+    mu2->data.updates.back().code = RPC_COLD_BACKUP;
+    mu2->client_requests.push_back(nullptr);
+    mu2->set_acked_before_logged();
+    ASSERT_EQ(ERR_OK, plist.prepare(mu2, partition_status::PS_SECONDARY));
+    ASSERT_EQ(1, plist.last_committed_decree());
+
+    // The primary has committed the mutation 2, whose commit is deferred until it is logged.
+    auto mu3 = create_test_mutation(3, 2, "3");
+    ASSERT_EQ(ERR_OK, plist.prepare(mu3, partition_status::PS_SECONDARY));
+    ASSERT_EQ(1, plist.last_committed_decree());
+    plist.commit_deferred();
+    ASSERT_EQ(1, plist.last_committed_decree());
+
+    mu2->set_logged();
+    plist.commit_deferred();
+    ASSERT_EQ(2, plist.last_committed_decree());
+    ASSERT_EQ(std::vector<decree>({1, 2}), committed);
+}
+
 TEST_P(replica_test, test_update_app_max_replica_count)
 {
     const auto original_max_replica_count = _app_info.max_replica_count;
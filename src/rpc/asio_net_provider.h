@@ -86,6 +86,10 @@ public:
 protected:
     boost::asio::io_service &get_io_service();
 
+    ::dsn::rpc_address _address;
+    // NOTE: '_hp' is possible to be invalid if '_address' can not be reverse resolved.
+    ::dsn::host_port _hp;
+
 private:
     void do_accept();
 
@@ -94,9 +98,6 @@ private:
     std::shared_ptr<boost::asio::ip::tcp::acceptor> _acceptor;
     std::vector<std::unique_ptr<boost::asio::io_service>> _io_services;
     std::vector<std::shared_ptr<std::thread>> _workers;
-    ::dsn::rpc_address _address;
-    // NOTE: '_hp' is possible to be invalid if '_address' can not be reverse resolved.
-    ::dsn::host_port _hp;
 };
 
 // TODO(Tangyanzhao): change the network model like asio_network_provider
@@ -0,0 +1,767 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "io_uring_net_provider.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string>
+#include <utility>
+
+#include "fmt/core.h"
+#include "io_uring_rpc_session.h"
+#include "rpc/message_parser.h"
+#include "runtime/tool_api.h"
+#include "task/task.h"
+#include "task/task_worker.h"
+#include "utils/autoref_ptr.h"
+#include "utils/defer.h"
+#include "utils/flags.h"
+#include "utils/fmt_logging.h"
+#include "utils/io_uring.h"
+#include "utils/rand.h"
+#include "utils/safe_strerror_posix.h"
+
+DSN_DEFINE_uint32(network,
+                  io_uring_net_queue_depth,
+                  1024,
+                  "The number of entries of the submission queue of each event loop of "
+                  "dsn::tools::io_uring_network_provider");
+DSN_DEFINE_validator(io_uring_net_queue_depth,
+                     [](uint32_t value) -> bool { return value >= 2 && value <= 32768; });
+DSN_DEFINE_uint32(network,
+                  io_uring_net_recv_buffer_count,
+                  256,
+                  "The number of the buffers provided to the kernel by each event loop of "
+                  "dsn::tools::io_uring_network_provider for multishot recv, which must be a "
+                  "power of 2");
+DSN_DEFINE_validator(io_uring_net_recv_buffer_count, [](uint32_t value) -> bool {
+    return value > 0 && value <= 32768 && (value & (value - 1)) == 0;
+});
+DSN_DEFINE_uint32(network,
+                  io_uring_net_recv_buffer_bytes,
+                  16 * 1024,
+                  "The size of each buffer provided to the kernel for multishot recv");
+DSN_DEFINE_validator(io_uring_net_recv_buffer_bytes,
+                     [](uint32_t value) -> bool { return value >= 1024; });
+
+DSN_DECLARE_uint32(io_service_worker_count);
+
+namespace dsn {
+namespace tools {
+
+namespace {
+
+thread_local io_uring_event_loop *tls_current_loop = nullptr;
+
+// Each ring has only one group of provided buffers.
+constexpr uint16_t kRecvBufferGroup = 0;
+
+inline uint64_t make_user_data(io_uring_handler *handler, uint8_t op)
+{
+    const auto user_data = reinterpret_cast<uint64_t>(handler);
+    DCHECK((user_data & io_uring_handler::kMaxOp) == 0, "the handler is not aligned");
+    DCHECK(op <= io_uring_handler::kMaxOp, "invalid operation {}", op);
+    return user_data | op;
+}
+
+} // anonymous namespace
+
+io_uring_event_loop::io_uring_event_loop()
+    : _unsubmitted(0),
+      _wakeup_fd(-1),
+      _wakeup_value(0),
+      _wakeup_pending(false),
+      _stopped(false),
+      _stopping(false),
+      _inflight(0),
+      _multishot_recv(false),
+      _buffer_ring(nullptr),
+      _buffer_ring_size(0),
+      _buffer_ring_tail(0)
+{
+}
+
+io_uring_event_loop::~io_uring_event_loop()
+{
+    // The provided buffers are unregistered once the ring is closed.
+    _queue.reset();
+    if (_buffer_ring != nullptr) {
+        ::munmap(_buffer_ring, _buffer_ring_size);
+    }
+    if (_wakeup_fd >= 0) {
+        ::close(_wakeup_fd);
+    }
+}
+
+bool io_uring_event_loop::init()
+{
+#ifdef DSN_HAS_IO_URING
+    // A multishot recv might post many completions for a single submission, thus the
+    // completion queue is made much larger than the submission queue.
+    _queue = utils::io_uring_queue::create(FLAGS_io_uring_net_queue_depth,
+                                           FLAGS_io_uring_net_queue_depth * 4);
+    if (_queue == nullptr) {
+        return false;
+    }
+    LOG_WARNING_IF((_queue->features & IORING_FEAT_NODROP) == 0,
+                   "the completions of io_uring might be dropped once the completion queue "
+                   "overflows, please upgrade the kernel");
+
+    _wakeup_fd = ::eventfd(0, EFD_CLOEXEC);
+    if (_wakeup_fd < 0) {
+        LOG_ERROR("create eventfd failed: {}", utils::safe_strerror(errno));
+        _queue.reset();
+        return false;
+    }
+
+    init_provided_buffers();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void io_uring_event_loop::init_provided_buffers()
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    const auto count = FLAGS_io_uring_net_recv_buffer_count;
+    _buffer_ring_size = count * sizeof(io_uring_buf);
+    // The ring must be page-aligned.
+    _buffer_ring = ::mmap(
+        nullptr, _buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (_buffer_ring == MAP_FAILED) {
+        _buffer_ring = nullptr;
+        LOG_WARNING("mmap the provided buffer ring failed: {}", utils::safe_strerror(errno));
+        return;
+    }
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_buffer_ring);
+    reg.ring_entries = count;
+    reg.bgid = kRecvBufferGroup;
+    if (_queue->register_op(IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LOG_WARNING("the provided buffer ring is not supported: {}, fall back to single-shot "
+                    "recv",
+                    utils::safe_strerror(errno));
+        ::munmap(_buffer_ring, _buffer_ring_size);
+        _buffer_ring = nullptr;
+        return;
+    }
+
+    _buffers.reset(new char[static_cast<size_t>(count) * FLAGS_io_uring_net_recv_buffer_bytes]);
+    for (uint32_t bid = 0; bid < count; ++bid) {
+        add_provided_buffer(static_cast<uint16_t>(bid));
+    }
+
+    // Some kernels accept the ring while never selecting a buffer from it, i.e. each recv
+    // would fail with ENOBUFS and be retried by a single-shot one.
+    if (!probe_provided_buffers()) {
+        LOG_WARNING("no buffer could be selected from the provided buffer ring, fall back to "
+                    "single-shot recv");
+        memset(&reg, 0, sizeof(reg));
+        reg.bgid = kRecvBufferGroup;
+        _queue->register_op(IORING_UNREGISTER_PBUF_RING, &reg, 1);
+        ::munmap(_buffer_ring, _buffer_ring_size);
+        _buffer_ring = nullptr;
+        _buffers.reset();
+        return;
+    }
+    _multishot_recv = true;
+#endif
+}
+
+bool io_uring_event_loop::probe_provided_buffers()
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    int fds[2];
+    if (::pipe2(fds, O_CLOEXEC) != 0) {
+        LOG_WARNING("create pipe failed: {}", utils::safe_strerror(errno));
+        return false;
+    }
+    const auto cleanup = dsn::defer([&fds]() {
+        ::close(fds[0]);
+        ::close(fds[1]);
+    });
+
+    const char byte = 0;
+    if (::write(fds[1], &byte, 1) != 1) {
+        LOG_WARNING("write pipe failed: {}", utils::safe_strerror(errno));
+        return false;
+    }
+
+    // The loop is not running yet, thus the completion is reaped here at once.
+    auto *sqe = _queue->get_sqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fds[0];
+    sqe->off = static_cast<uint64_t>(-1);
+    sqe->len = 1;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvBufferGroup;
+    sqe->user_data = make_user_data(this, 0);
+    if (_queue->enter(1, 1, IORING_ENTER_GETEVENTS) < 0) {
+        LOG_WARNING("io_uring_enter failed: {}", utils::safe_strerror(errno));
+        return false;
+    }
+
+    reap_completions();
+    CHECK_EQ(_completions.size(), 1);
+    const auto c = _completions.front();
+    _completions.clear();
+    if (c.res != 1 || provided_buffer(c.flags) == nullptr) {
+        LOG_WARNING("read into a provided buffer failed: {}",
+                    c.res < 0 ? utils::safe_strerror(-c.res) : fmt::format("res = {}", c.res));
+        return false;
+    }
+    recycle_provided_buffer(c.flags);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void io_uring_event_loop::add_provided_buffer(uint16_t bid)
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    // The tail of the ring overlays the reserved field of the first buffer, thus the fields
+    // must be filled one by one.
+    auto *ring = static_cast<io_uring_buf_ring *>(_buffer_ring);
+    auto *buf = &ring->bufs[_buffer_ring_tail & (FLAGS_io_uring_net_recv_buffer_count - 1)];
+    buf->addr = reinterpret_cast<uint64_t>(_buffers.get() +
+                                           static_cast<size_t>(bid) *
+                                               FLAGS_io_uring_net_recv_buffer_bytes);
+    buf->len = FLAGS_io_uring_net_recv_buffer_bytes;
+    buf->bid = bid;
+    ++_buffer_ring_tail;
+    __atomic_store_n(&ring->tail, _buffer_ring_tail, __ATOMIC_RELEASE);
+#endif
+}
+
+/*static*/ bool io_uring_event_loop::has_more(uint32_t flags)
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    return (flags & IORING_CQE_F_MORE) != 0;
+#else
+    return false;
+#endif
+}
+
+const char *io_uring_event_loop::provided_buffer(uint32_t flags) const
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    if ((flags & IORING_CQE_F_BUFFER) != 0) {
+        const auto bid = flags >> IORING_CQE_BUFFER_SHIFT;
+        return _buffers.get() + static_cast<size_t>(bid) * FLAGS_io_uring_net_recv_buffer_bytes;
+    }
+#endif
+    return nullptr;
+}
+
+void io_uring_event_loop::recycle_provided_buffer(uint32_t flags)
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    add_provided_buffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+#endif
+}
+
+bool io_uring_event_loop::in_loop_thread() const { return tls_current_loop == this; }
+
+void io_uring_event_loop::dispatch(std::function<void()> &&callback)
+{
+    if (in_loop_thread()) {
+        callback();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _posted_callbacks.emplace_back(std::move(callback));
+    }
+
+    // Only the first callback posted since the loop ran the last ones wakes it up.
+    if (!_wakeup_pending.exchange(true)) {
+        wakeup();
+    }
+}
+
+void io_uring_event_loop::wakeup()
+{
+    const uint64_t value = 1;
+    if (::write(_wakeup_fd, &value, sizeof(value)) < 0) {
+        LOG_ERROR("wake up the io_uring event loop failed: {}", utils::safe_strerror(errno));
+    }
+}
+
+void io_uring_event_loop::stop()
+{
+    _stopped = true;
+    wakeup();
+}
+
+void io_uring_event_loop::register_handler(io_uring_handler *handler)
+{
+    std::lock_guard<std::mutex> l(_lock);
+    _handlers.insert(handler);
+}
+
+void io_uring_event_loop::unregister_handler(io_uring_handler *handler)
+{
+    std::lock_guard<std::mutex> l(_lock);
+    _handlers.erase(handler);
+}
+
+void io_uring_event_loop::run()
+{
+#ifdef DSN_HAS_IO_URING
+    tls_current_loop = this;
+    submit_wakeup_read();
+
+    while (true) {
+        bool has_posted_callbacks = false;
+        {
+            std::lock_guard<std::mutex> l(_lock);
+            has_posted_callbacks = !_posted_callbacks.empty();
+
+            // The handlers are notified under the lock so that none of them is destroyed in the
+            // meantime, thus they must not release their last references in on_loop_stopping().
+            if (_stopped.load() && !_stopping) {
+                _stopping = true;
+                for (auto *handler : _handlers) {
+                    handler->on_loop_stopping();
+                }
+            }
+        }
+
+        if (_stopping && _inflight == 0 && !has_posted_callbacks) {
+            break;
+        }
+
+        // Submit the operations queued during the last round, and wait for a completion unless
+        // there is something else to do.
+        const uint32_t min_complete = has_posted_callbacks || !_completions.empty() ? 0 : 1;
+        const int ret = _queue->enter(_unsubmitted, min_complete, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            // EBUSY means that the completion queue has overflowed, which is solved by reaping.
+            CHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY,
+                  "io_uring_enter failed: {}",
+                  utils::safe_strerror(errno));
+        } else {
+            _unsubmitted -= static_cast<uint32_t>(ret);
+        }
+
+        reap_completions();
+        // The handlers might submit operations, which would reap more completions once the
+        // submission queue is full.
+        for (size_t i = 0; i < _completions.size(); ++i) {
+            const auto c = _completions[i];
+            auto *handler = reinterpret_cast<io_uring_handler *>(c.user_data & ~uint64_t(kMaxOp));
+            if (handler != this && !has_more(c.flags)) {
+                --_inflight;
+            }
+            handler->on_completion(static_cast<uint8_t>(c.user_data & kMaxOp), c.res, c.flags);
+        }
+        _completions.clear();
+
+        run_posted_callbacks();
+    }
+
+    tls_current_loop = nullptr;
+#endif
+}
+
+void io_uring_event_loop::run_posted_callbacks()
+{
+    std::vector<std::function<void()>> callbacks;
+    _wakeup_pending = false;
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        callbacks.swap(_posted_callbacks);
+    }
+    for (auto &callback : callbacks) {
+        callback();
+    }
+}
+
+void io_uring_event_loop::reap_completions()
+{
+#ifdef DSN_HAS_IO_URING
+    // Only this thread updates the head, while the kernel updates the tail.
+    unsigned head = *_queue->cq_head;
+    const unsigned tail = __atomic_load_n(_queue->cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+        const auto &cqe = _queue->cqes[head & *_queue->cq_mask];
+        _completions.push_back({cqe.user_data, cqe.res, cqe.flags});
+    }
+    __atomic_store_n(_queue->cq_head, head, __ATOMIC_RELEASE);
+#endif
+}
+
+io_uring_sqe *io_uring_event_loop::get_sqe(io_uring_handler *handler, uint8_t op)
+{
+#ifdef DSN_HAS_IO_URING
+    DCHECK(in_loop_thread(), "the operations must be submitted in the loop thread");
+    while (true) {
+        auto *sqe = _queue->get_sqe();
+        if (sqe != nullptr) {
+            ++_unsubmitted;
+            if (handler != this) {
+                ++_inflight;
+            }
+            sqe->user_data = make_user_data(handler, op);
+            return sqe;
+        }
+
+        // The submission queue is full, submit the queued operations in advance.
+        const int ret = _queue->enter(_unsubmitted, 0, 0);
+        if (ret >= 0) {
+            _unsubmitted -= static_cast<uint32_t>(ret);
+            continue;
+        }
+        CHECK(errno == EINTR || errno == EAGAIN || errno == EBUSY,
+              "io_uring_enter failed: {}",
+              utils::safe_strerror(errno));
+        if (errno == EBUSY) {
+            reap_completions();
+        }
+    }
+#else
+    return nullptr;
+#endif
+}
+
+void io_uring_event_loop::submit_wakeup_read()
+{
+#ifdef DSN_HAS_IO_URING
+    auto *sqe = get_sqe(this, 0);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = _wakeup_fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&_wakeup_value);
+    sqe->len = sizeof(_wakeup_value);
+#endif
+}
+
+void io_uring_event_loop::on_completion(uint8_t op, int res, uint32_t flags)
+{
+    // The wakeup read is the only operation of the loop itself. The posted callbacks are run
+    // at the end of this round.
+    if (res < 0 && res != -EINTR) {
+        LOG_ERROR("read the eventfd of the io_uring event loop failed: {}",
+                  utils::safe_strerror(-res));
+    }
+    submit_wakeup_read();
+}
+
+void io_uring_event_loop::submit_recv(
+    io_uring_handler *handler, uint8_t op, int fd, void *buf, size_t len)
+{
+#ifdef DSN_HAS_IO_URING
+    auto *sqe = get_sqe(handler, op);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(buf);
+    sqe->len = static_cast<uint32_t>(len);
+#endif
+}
+
+void io_uring_event_loop::submit_multishot_recv(io_uring_handler *handler, uint8_t op, int fd)
+{
+#if defined(DSN_HAS_IO_URING) && defined(IORING_RECV_MULTISHOT)
+    DCHECK(_multishot_recv, "multishot recv is not supported");
+    auto *sqe = get_sqe(handler, op);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvBufferGroup;
+#endif
+}
+
+void io_uring_event_loop::submit_sendmsg(
+    io_uring_handler *handler, uint8_t op, int fd, const msghdr *msg, bool link)
+{
+#ifdef DSN_HAS_IO_URING
+    auto *sqe = get_sqe(handler, op);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(msg);
+    sqe->len = 1;
+    // With MSG_WAITALL, a short write is retried by the kernel, or fails the linked ones.
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    if (link) {
+        sqe->flags = IOSQE_IO_LINK;
+    }
+#endif
+}
+
+void io_uring_event_loop::submit_connect(
+    io_uring_handler *handler, uint8_t op, int fd, const sockaddr *addr, socklen_t addr_len)
+{
+#ifdef DSN_HAS_IO_URING
+    auto *sqe = get_sqe(handler, op);
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->off = addr_len;
+#endif
+}
+
+void io_uring_event_loop::submit_accept(
+    io_uring_handler *handler, uint8_t op, int fd, sockaddr *addr, socklen_t *addr_len)
+{
+#ifdef DSN_HAS_IO_URING
+    auto *sqe = get_sqe(handler, op);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(addr);
+    sqe->addr2 = reinterpret_cast<uint64_t>(addr_len);
+    sqe->accept_flags = SOCK_CLOEXEC;
+#endif
+}
+
+void io_uring_event_loop::submit_cancel(io_uring_handler *handler, uint8_t target_op, uint8_t op)
+{
+#ifdef DSN_HAS_IO_URING
+    auto *sqe = get_sqe(handler, op);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = make_user_data(handler, target_op);
+#endif
+}
+
+// Accepts the connections in the first event loop, while the accepted sessions are spread
+// over all the loops.
+class io_uring_network_provider::acceptor : public io_uring_handler
+{
+public:
+    acceptor(io_uring_network_provider &net, int fd) : _net(net), _fd(fd), _addr_len(0)
+    {
+        memset(&_addr, 0, sizeof(_addr));
+        _net._loops[0]->register_handler(this);
+    }
+
+    ~acceptor() override
+    {
+        _net._loops[0]->unregister_handler(this);
+        ::close(_fd);
+    }
+
+    void start()
+    {
+        _net._loops[0]->dispatch([this]() { do_accept(); });
+    }
+
+    void on_completion(uint8_t op, int res, uint32_t flags) override
+    {
+        if (op == OP_CANCEL_ACCEPT) {
+            return;
+        }
+
+        if (res >= 0) {
+            on_accepted(res);
+        } else if (res != -ECANCELED) {
+            LOG_ERROR("io_uring accept failed: {}", utils::safe_strerror(-res));
+        }
+
+        do_accept();
+    }
+
+    void on_loop_stopping() override
+    {
+        _net._loops[0]->submit_cancel(this, OP_ACCEPT, OP_CANCEL_ACCEPT);
+    }
+
+private:
+    enum operation : uint8_t
+    {
+        OP_ACCEPT,
+        OP_CANCEL_ACCEPT,
+    };
+
+    void do_accept()
+    {
+        if (_net._loops[0]->stopping()) {
+            return;
+        }
+
+        _addr_len = sizeof(_addr);
+        _net._loops[0]->submit_accept(
+            this, OP_ACCEPT, _fd, reinterpret_cast<sockaddr *>(&_addr), &_addr_len);
+    }
+
+    void on_accepted(int fd)
+    {
+        ::dsn::rpc_address client_addr(ntohl(_addr.sin_addr.s_addr), ntohs(_addr.sin_port));
+
+        message_parser_ptr null_parser;
+        rpc_session_ptr s = new io_uring_rpc_session(
+            _net, _net.get_event_loop(), client_addr, fd, null_parser, false);
+
+        // when server connection threshold is hit, close the session, otherwise accept it
+        if (_net.check_if_conn_threshold_exceeded(s->remote_address())) {
+            LOG_WARNING("close rpc connection from {} to {} due to hitting server "
+                        "connection threshold per ip",
+                        s->remote_address(),
+                        _net.address());
+            s->close();
+            return;
+        }
+
+        _net.on_server_session_accepted(s);
+
+        // we should start read immediately after the rpc session is completely created.
+        s->start_read_next();
+    }
+
+    io_uring_network_provider &_net;
+    const int _fd;
+    sockaddr_in _addr;
+    socklen_t _addr_len;
+};
+
+io_uring_network_provider::io_uring_network_provider(rpc_engine *srv, network *inner_provider)
+    : asio_network_provider(srv, inner_provider)
+{
+    for (uint32_t i = 0; i < FLAGS_io_service_worker_count; ++i) {
+        auto loop = std::make_unique<io_uring_event_loop>();
+        if (!loop->init()) {
+            LOG_WARNING("io_uring is not supported, fall back to asio_network_provider");
+            _loops.clear();
+            return;
+        }
+        _loops.emplace_back(std::move(loop));
+    }
+}
+
+io_uring_network_provider::~io_uring_network_provider()
+{
+    // Each loop shuts down the sessions bound to it and cancels the accept, then exits once
+    // all of their operations are completed, thus the operations in flight release their
+    // references of the sessions rather than completing on a destroyed ring.
+    for (auto &loop : _loops) {
+        loop->stop();
+    }
+
+    for (auto &w : _loop_workers) {
+        w->join();
+    }
+
+    _uring_acceptor.reset();
+    _loops.clear();
+}
+
+error_code io_uring_network_provider::start(rpc_channel channel, int port, bool client_only)
+{
+    if (_loops.empty()) {
+        return asio_network_provider::start(channel, port, client_only);
+    }
+
+    if (_uring_acceptor != nullptr) {
+        return ERR_SERVICE_ALREADY_RUNNING;
+    }
+
+    // The same as asio_network_provider, start() could be invoked multiple times.
+    for (auto i = _loop_workers.size(); _loop_workers.size() < _loops.size(); ++i) {
+        _loop_workers.push_back(std::make_shared<std::thread>([this, i]() {
+            task::set_tls_dsn_context(node(), nullptr);
+
+            const char *name = ::dsn::tools::get_service_node_name(node());
+            const auto full_name = fmt::format("{}.io_uring.{}", name, i);
+            task_worker::set_name(full_name.c_str());
+
+            _loops[i]->run();
+        }));
+    }
+
+    CHECK(channel == RPC_CHANNEL_TCP || channel == RPC_CHANNEL_UDP,
+          "invalid given channel {}",
+          channel);
+
+    _address = rpc_address(get_local_ipv4(), port);
+    _hp = ::dsn::host_port::from_address(_address);
+    LOG_WARNING_IF(!_hp, "'{}' can not be reverse resolved", _address);
+
+    if (client_only) {
+        return ERR_OK;
+    }
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("io_uring tcp acceptor open failed, error = {}", utils::safe_strerror(errno));
+        return ERR_NETWORK_INIT_FAILED;
+    }
+
+    const int reuse_address = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse_address, sizeof(reuse_address));
+
+    sockaddr_in endpoint;
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.sin_family = AF_INET;
+    endpoint.sin_addr.s_addr = htonl(INADDR_ANY);
+    endpoint.sin_port = htons(_address.port());
+    if (::bind(fd, reinterpret_cast<sockaddr *>(&endpoint), sizeof(endpoint)) != 0) {
+        LOG_ERROR("io_uring tcp acceptor bind address '{}' failed, error = {}",
+                  _address,
+                  utils::safe_strerror(errno));
+        ::close(fd);
+        return ERR_NETWORK_INIT_FAILED;
+    }
+
+    if (::listen(fd, SOMAXCONN) != 0) {
+        LOG_ERROR("io_uring tcp acceptor listen failed, port = {}, error = {}",
+                  _address.port(),
+                  utils::safe_strerror(errno));
+        ::close(fd);
+        return ERR_NETWORK_INIT_FAILED;
+    }
+
+    _uring_acceptor = std::make_unique<acceptor>(*this, fd);
+    _uring_acceptor->start();
+
+    return ERR_OK;
+}
+
+rpc_session_ptr io_uring_network_provider::create_client_session(::dsn::rpc_address server_addr)
+{
+    if (_loops.empty()) {
+        return asio_network_provider::create_client_session(server_addr);
+    }
+
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    LOG_ERROR_IF(
+        fd < 0, "create the socket to {} failed: {}", server_addr, utils::safe_strerror(errno));
+
+    message_parser_ptr parser(new_message_parser(_client_hdr_format));
+    return {new io_uring_rpc_session(*this, get_event_loop(), server_addr, fd, parser, true)};
+}
+
+// use a round-robin scheme to choose the next event loop to use.
+io_uring_event_loop &io_uring_network_provider::get_event_loop()
+{
+    return *_loops[rand::next_u32(0, static_cast<uint32_t>(_loops.size()) - 1)];
+}
+
+} // namespace tools
+} // namespace dsn
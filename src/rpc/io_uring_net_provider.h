@@ -0,0 +1,219 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "rpc/asio_net_provider.h"
+#include "rpc/network.h"
+#include "rpc/rpc_address.h"
+#include "task/task_spec.h"
+#include "utils/error_code.h"
+#include "utils/ports.h"
+
+struct io_uring_sqe;
+
+namespace dsn {
+class rpc_engine;
+
+namespace utils {
+struct io_uring_queue;
+} // namespace utils
+
+namespace tools {
+
+// The handler of the operations submitted to an io_uring_event_loop. The user_data of an
+// operation is the address of its handler, whose lowest 3 bits (which are always zero since the
+// handlers are aligned) tell which one of the operations of the handler is completed.
+class io_uring_handler
+{
+public:
+    static constexpr uint8_t kMaxOp = 7;
+
+    virtual ~io_uring_handler() = default;
+
+    // `res` and `flags` are those of the completion queue entry, see io_uring_enter(2).
+    virtual void on_completion(uint8_t op, int res, uint32_t flags) = 0;
+
+    // Called in the loop thread once the loop is being stopped, if the handler is registered
+    // to the loop. The handler should get its operations in flight completed soon, e.g. by
+    // shutting down the socket or cancelling them, and submit no more operations since then.
+    virtual void on_loop_stopping() {}
+};
+
+// An io_uring with the only thread that submits the operations to it and reaps their
+// completions, which is the counterpart of an io_service of asio_network_provider.
+//
+// The other threads hand their operations over by dispatch(); they are queued and then
+// submitted together by the loop thread once it wakes up, thus a single io_uring_enter()
+// serves all the sessions that get ready during a round.
+//
+// The sessions receive by multishot recv into a ring of buffers provided to the kernel, so
+// that a connection needs neither a submission per read nor a buffer of its own while it is
+// idle. The received data is then copied once from the provided buffer into message_reader,
+// since the message parsers require the data of a message to be contiguous. It falls back to
+// the single-shot recv into the buffer of message_reader on the kernels older than 6.0.
+//
+// Once stop() is called, the loop notifies the registered handlers by on_loop_stopping(), and
+// keeps running until all the operations submitted by the handlers are completed, so that no
+// completion would refer to a handler after the ring is destroyed.
+class io_uring_event_loop : public io_uring_handler
+{
+public:
+    io_uring_event_loop();
+    ~io_uring_event_loop() override;
+
+    // Returns false if io_uring is not supported by the kernel.
+    bool init();
+
+    // Run the loop in the calling thread until stop() is called and all the operations in
+    // flight are completed.
+    void run();
+    void stop();
+
+    bool in_loop_thread() const;
+
+    // Whether the loop is being stopped, in which case no more operations should be submitted.
+    // Must be called in the loop thread.
+    bool stopping() const { return _stopping; }
+
+    // The registered handlers are notified once the loop is being stopped. A handler must be
+    // unregistered before it is destroyed.
+    void register_handler(io_uring_handler *handler);
+    void unregister_handler(io_uring_handler *handler);
+
+    // Run `callback` in the loop thread, immediately if it is called in the loop thread.
+    void dispatch(std::function<void()> &&callback);
+
+    //
+    // The following functions must be called in the loop thread. The operations are submitted
+    // in the next round of the loop.
+    //
+    void submit_recv(io_uring_handler *handler, uint8_t op, int fd, void *buf, size_t len);
+    void submit_multishot_recv(io_uring_handler *handler, uint8_t op, int fd);
+    // The message is written as a whole unless the socket fails. A linked operation starts
+    // after the former one is completed, and is cancelled once the former one fails.
+    void
+    submit_sendmsg(io_uring_handler *handler, uint8_t op, int fd, const msghdr *msg, bool link);
+    void submit_connect(
+        io_uring_handler *handler, uint8_t op, int fd, const sockaddr *addr, socklen_t addr_len);
+    void submit_accept(
+        io_uring_handler *handler, uint8_t op, int fd, sockaddr *addr, socklen_t *addr_len);
+    // Cancel the operation `target_op` of `handler`, this one is completed as `op`.
+    void submit_cancel(io_uring_handler *handler, uint8_t target_op, uint8_t op);
+
+    // Whether multishot recv with the provided buffers is supported.
+    bool multishot_recv_enabled() const { return _multishot_recv; }
+    void disable_multishot_recv() { _multishot_recv = false; }
+
+    // Whether more completions would be posted for a multishot operation.
+    static bool has_more(uint32_t flags);
+
+    // The provided buffer filled by a multishot recv, which must be recycled once consumed.
+    const char *provided_buffer(uint32_t flags) const;
+    void recycle_provided_buffer(uint32_t flags);
+
+private:
+    struct completion
+    {
+        uint64_t user_data;
+        int res;
+        uint32_t flags;
+    };
+
+    void on_completion(uint8_t op, int res, uint32_t flags) override;
+
+    io_uring_sqe *get_sqe(io_uring_handler *handler, uint8_t op);
+    void reap_completions();
+    void run_posted_callbacks();
+
+    void wakeup();
+    void submit_wakeup_read();
+
+    void init_provided_buffers();
+    // Read a byte from a pipe into a provided buffer, returns false if the kernel could not
+    // select a buffer from the ring.
+    bool probe_provided_buffers();
+    void add_provided_buffer(uint16_t bid);
+
+    std::unique_ptr<utils::io_uring_queue> _queue;
+    uint32_t _unsubmitted;
+    std::vector<completion> _completions;
+
+    int _wakeup_fd;
+    uint64_t _wakeup_value;
+    std::atomic_bool _wakeup_pending;
+    std::atomic_bool _stopped;
+
+    // Accessed only in the loop thread: whether the handlers have been notified of stopping,
+    // and the number of the operations submitted by the handlers which are not completed yet.
+    bool _stopping;
+    uint64_t _inflight;
+
+    std::mutex _lock;
+    std::vector<std::function<void()>> _posted_callbacks;
+    std::unordered_set<io_uring_handler *> _handlers;
+
+    bool _multishot_recv;
+    void *_buffer_ring;
+    size_t _buffer_ring_size;
+    std::unique_ptr<char[]> _buffers;
+    uint16_t _buffer_ring_tail;
+
+    DISALLOW_COPY_AND_ASSIGN(io_uring_event_loop);
+    DISALLOW_MOVE_AND_ASSIGN(io_uring_event_loop);
+};
+
+/// io_uring_network_provider is a connection_oriented_network built on io_uring rather than the
+/// epoll reactor of Boost.Asio. Like asio_network_provider, FLAGS_io_service_worker_count event
+/// loops are created, and each session is bound to one of them in a round-robin scheme.
+///
+/// It falls back to asio_network_provider if io_uring is not supported by the kernel.
+class io_uring_network_provider : public asio_network_provider
+{
+public:
+    io_uring_network_provider(rpc_engine *srv, network *inner_provider);
+
+    ~io_uring_network_provider() override;
+
+    error_code start(rpc_channel channel, int port, bool client_only) override;
+    rpc_session_ptr create_client_session(::dsn::rpc_address server_addr) override;
+
+private:
+    class acceptor;
+
+    io_uring_event_loop &get_event_loop();
+
+    std::vector<std::unique_ptr<io_uring_event_loop>> _loops;
+    std::vector<std::shared_ptr<std::thread>> _loop_workers;
+    std::unique_ptr<acceptor> _uring_acceptor;
+};
+
+} // namespace tools
+} // namespace dsn
@@ -0,0 +1,500 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "io_uring_rpc_session.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <limits.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "utils/autoref_ptr.h"
+#include "utils/defer.h"
+#include "utils/flags.h"
+#include "utils/fmt_logging.h"
+#include "utils/safe_strerror_posix.h"
+
+DSN_DECLARE_int32(socket_send_buffer_bytes);
+DSN_DECLARE_int32(socket_recv_buffer_bytes);
+
+namespace dsn {
+class message_ex;
+
+namespace tools {
+
+io_uring_rpc_session::io_uring_rpc_session(io_uring_network_provider &net,
+                                           io_uring_event_loop &loop,
+                                           ::dsn::rpc_address remote_addr,
+                                           int fd,
+                                           message_parser_ptr &parser,
+                                           bool is_client)
+    : rpc_session(net, remote_addr, parser, is_client),
+      _loop(loop),
+      _socket(fd),
+      _recv_armed(false),
+      _recv_multishot(false),
+      _read_paused(false),
+      _has_unparsed_data(false),
+      _read_next(0),
+      _connect_inflight(false),
+      _send_signature(0),
+      _send_iov_index(0),
+      _sendmsg_inflight(0),
+      _sendmsg_written(0),
+      _sendmsg_error(0)
+{
+    memset(&_remote_sockaddr, 0, sizeof(_remote_sockaddr));
+    _remote_sockaddr.sin_family = AF_INET;
+    _remote_sockaddr.sin_addr.s_addr = htonl(remote_addr.ip());
+    _remote_sockaddr.sin_port = htons(remote_addr.port());
+
+    // The same as asio_rpc_session, the local address of a client-side session is decided
+    // after the connection is established.
+    if (!is_client) {
+        _local_addr = net.address();
+    }
+
+    set_options();
+    _loop.register_handler(this);
+}
+
+io_uring_rpc_session::~io_uring_rpc_session()
+{
+    // Every operation holds a reference of the session until it is completed, thus nothing is
+    // in flight now.
+    _loop.unregister_handler(this);
+    if (_socket >= 0) {
+        ::close(_socket);
+    }
+}
+
+void io_uring_rpc_session::set_options()
+{
+    if (_socket < 0) {
+        return;
+    }
+
+    if (FLAGS_socket_send_buffer_bytes > 0) {
+        set_option(SOL_SOCKET, SO_SNDBUF, FLAGS_socket_send_buffer_bytes, "send_buffer_size");
+    }
+
+    if (FLAGS_socket_recv_buffer_bytes > 0) {
+        set_option(SOL_SOCKET, SO_RCVBUF, FLAGS_socket_recv_buffer_bytes, "receive_buffer_size");
+    }
+
+    // See asio_rpc_session::set_no_delay() for the reason.
+    set_option(IPPROTO_TCP, TCP_NODELAY, 1, "no_delay");
+}
+
+void io_uring_rpc_session::set_option(int level, int name, int value, const char *opt_name)
+{
+    int old_value = 0;
+    socklen_t len = sizeof(old_value);
+    if (::getsockopt(_socket, level, name, &old_value, &len) != 0) {
+        LOG_WARNING_PREFIX("[io_uring socket] get old {} failed: error = {}",
+                           opt_name,
+                           utils::safe_strerror(errno));
+    } else if (old_value == value) {
+        LOG_DEBUG_PREFIX(
+            "[io_uring socket] no need to set {} since it has already been {}", opt_name, value);
+        return;
+    }
+
+    if (::setsockopt(_socket, level, name, &value, sizeof(value)) != 0) {
+        LOG_WARNING_PREFIX("[io_uring socket] set {} to {} failed: error = {}",
+                           opt_name,
+                           value,
+                           utils::safe_strerror(errno));
+        return;
+    }
+
+    LOG_DEBUG_PREFIX("[io_uring socket] set {} {} => {}", opt_name, old_value, value);
+}
+
+void io_uring_rpc_session::on_completion(uint8_t op, int res, uint32_t flags)
+{
+    switch (op) {
+    case OP_RECV:
+        on_recv_completed(res, flags);
+        break;
+    case OP_SEND:
+        on_sendmsg_completed(res);
+        break;
+    case OP_CONNECT:
+        on_connect_completed(res);
+        break;
+    case OP_CANCEL_RECV:
+    case OP_CANCEL_CONNECT:
+        // The cancelled operation is completed by itself with -ECANCELED.
+        release_ref();
+        break;
+    default:
+        CHECK(false, "invalid io_uring operation {}", op);
+    }
+}
+
+void io_uring_rpc_session::on_loop_stopping()
+{
+    // The recv and sendmsg in flight are completed once the socket is shut down, while the
+    // connect in flight has to be cancelled. No reference could be released here, see
+    // io_uring_event_loop::run().
+    close();
+    if (_connect_inflight) {
+        add_ref();
+        _loop.submit_cancel(this, OP_CONNECT, OP_CANCEL_CONNECT);
+    }
+}
+
+void io_uring_rpc_session::do_read(int read_next)
+{
+    if (!_loop.in_loop_thread()) {
+        add_ref();
+        _loop.dispatch([this, read_next]() {
+            do_read(read_next);
+            release_ref();
+        });
+        return;
+    }
+
+    _read_paused = false;
+    _read_next = read_next;
+
+    if (_has_unparsed_data) {
+        _has_unparsed_data = false;
+        process_received();
+        return;
+    }
+
+    if (!_recv_armed) {
+        submit_recv(read_next, _loop.multishot_recv_enabled());
+    }
+}
+
+void io_uring_rpc_session::submit_recv(int read_next, bool multishot)
+{
+    // The socket has been shut down.
+    if (_loop.stopping()) {
+        return;
+    }
+
+    // Released once the recv would not be completed any more.
+    add_ref();
+    _recv_armed = true;
+
+    _recv_multishot = multishot;
+    if (_recv_multishot) {
+        _loop.submit_multishot_recv(this, OP_RECV, _socket);
+        return;
+    }
+
+    void *ptr = _reader.read_buffer_ptr(read_next);
+    _loop.submit_recv(this, OP_RECV, _socket, ptr, _reader.read_buffer_capacity());
+}
+
+void io_uring_rpc_session::on_recv_completed(int res, uint32_t flags)
+{
+    const bool more = _recv_multishot && io_uring_event_loop::has_more(flags);
+    if (!more) {
+        _recv_armed = false;
+    }
+    const auto cleanup = dsn::defer([this, more]() {
+        if (!more) {
+            release_ref();
+        }
+    });
+
+    if (res == -ECANCELED) {
+        // The recv is cancelled since the reading was paused. Rearm it if the reading has been
+        // resumed.
+        if (!_read_paused && !_recv_armed) {
+            submit_recv(_read_next, _loop.multishot_recv_enabled());
+        }
+        return;
+    }
+
+    if (res == -ENOBUFS) {
+        // All the provided buffers are in use. Rather than rearming the multishot recv, which
+        // might fail again before the buffers are recycled, receive once into the buffer of
+        // message_reader.
+        if (!_read_paused && !_recv_armed) {
+            submit_recv(_read_next, false);
+        }
+        return;
+    }
+
+    if (res == -EINVAL && _recv_multishot) {
+        LOG_WARNING_PREFIX("multishot recv is not supported, fall back to single-shot recv");
+        _loop.disable_multishot_recv();
+        if (!_read_paused && !_recv_armed) {
+            submit_recv(_read_next, false);
+        }
+        return;
+    }
+
+    if (res <= 0) {
+        if (res == 0) {
+            LOG_INFO_PREFIX(
+                "io_uring read from {} failed: error = eof, local = {}", _remote_addr, _local_addr);
+        } else {
+            LOG_ERROR_PREFIX("io_uring read from {} failed: error = {}, local = {}",
+                             _remote_addr,
+                             utils::safe_strerror(-res),
+                             _local_addr);
+        }
+
+        on_failure(false);
+        return;
+    }
+
+    if (_recv_multishot) {
+        const char *buf = _loop.provided_buffer(flags);
+        CHECK_NOTNULL_PREFIX_MSG(buf, "no buffer is selected by multishot recv");
+        memcpy(_reader.read_buffer_ptr(res), buf, res);
+        _loop.recycle_provided_buffer(flags);
+    }
+    _reader.mark_read(res);
+
+    if (_read_paused) {
+        _has_unparsed_data = true;
+        return;
+    }
+
+    process_received();
+}
+
+void io_uring_rpc_session::process_received()
+{
+    int read_next = -1;
+
+    if (_parser == nullptr) {
+        read_next = prepare_parser();
+    }
+
+    if (_parser != nullptr) {
+        message_ex *msg = _parser->get_message_on_receive(&_reader, read_next);
+
+        while (msg != nullptr) {
+            this->on_message_read(msg);
+            msg = _parser->get_message_on_receive(&_reader, read_next);
+        }
+    }
+
+    if (read_next == -1) {
+        LOG_ERROR_PREFIX("io_uring read from {} failed: local = {}", _remote_addr, _local_addr);
+
+        on_failure(false);
+        return;
+    }
+
+    // The reading is resumed at once by do_read() unless it is delayed.
+    _read_paused = true;
+    start_read_next(read_next);
+    if (_read_paused && _recv_armed && _recv_multishot) {
+        // Stop receiving until the reading is resumed.
+        add_ref();
+        _loop.submit_cancel(this, OP_RECV, OP_CANCEL_RECV);
+    }
+}
+
+void io_uring_rpc_session::send(uint64_t signature)
+{
+    const auto bcount = _sending_buffers.size();
+    _send_iovs.resize(bcount);
+    for (size_t i = 0; i < bcount; ++i) {
+        _send_iovs[i].iov_base = _sending_buffers[i].buf;
+        _send_iovs[i].iov_len = _sending_buffers[i].sz;
+    }
+    _send_iov_index = 0;
+    _send_signature = signature;
+
+    // Released once the batch is written.
+    add_ref();
+    _loop.dispatch([this]() { submit_send(); });
+}
+
+void io_uring_rpc_session::submit_send()
+{
+    // The socket has been shut down, release the reference of the batch.
+    if (_loop.stopping()) {
+        on_failure(true);
+        release_ref();
+        return;
+    }
+
+    // A sendmsg could write at most IOV_MAX buffers, the batch with more buffers is written by
+    // the linked ones.
+    const size_t iov_max = IOV_MAX;
+    const size_t count = _send_iovs.size() - _send_iov_index;
+    const size_t msg_count = (count + iov_max - 1) / iov_max;
+
+    _send_msgs.assign(msg_count, msghdr());
+    for (size_t i = 0; i < msg_count; ++i) {
+        _send_msgs[i].msg_iov = &_send_iovs[_send_iov_index + i * iov_max];
+        _send_msgs[i].msg_iovlen = std::min(iov_max, count - i * iov_max);
+    }
+
+    _sendmsg_inflight = static_cast<int>(msg_count);
+    _sendmsg_written = 0;
+    _sendmsg_error = 0;
+    for (size_t i = 0; i < msg_count; ++i) {
+        _loop.submit_sendmsg(this, OP_SEND, _socket, &_send_msgs[i], i + 1 < msg_count);
+    }
+}
+
+void io_uring_rpc_session::on_sendmsg_completed(int res)
+{
+    if (res > 0) {
+        _sendmsg_written += static_cast<size_t>(res);
+    } else if (res < 0 && res != -ECANCELED && _sendmsg_error == 0) {
+        _sendmsg_error = res;
+    }
+
+    if (--_sendmsg_inflight > 0) {
+        return;
+    }
+
+    if (_sendmsg_error == 0 && _sendmsg_written == 0) {
+        _sendmsg_error = -EPIPE;
+    }
+
+    if (_sendmsg_error != 0) {
+        LOG_ERROR_PREFIX("io_uring write to {} failed: error = {}, local = {}",
+                         _remote_addr,
+                         utils::safe_strerror(-_sendmsg_error),
+                         _local_addr);
+
+        on_failure(true);
+        release_ref();
+        return;
+    }
+
+    // Skip the written buffers. The linked sendmsg following a short write is cancelled, then
+    // the remaining buffers are written again.
+    size_t written = _sendmsg_written;
+    while (_send_iov_index < _send_iovs.size()) {
+        auto &iov = _send_iovs[_send_iov_index];
+        if (iov.iov_len > written) {
+            iov.iov_base = static_cast<char *>(iov.iov_base) + written;
+            iov.iov_len -= written;
+            break;
+        }
+        written -= iov.iov_len;
+        ++_send_iov_index;
+    }
+
+    if (_send_iov_index < _send_iovs.size()) {
+        submit_send();
+        return;
+    }
+
+    on_send_completed(_send_signature);
+    release_ref();
+}
+
+void io_uring_rpc_session::connect()
+{
+    if (!mark_connecting()) {
+        return;
+    }
+
+    if (_socket < 0) {
+        LOG_ERROR_PREFIX("connect to {} failed: error = invalid socket", _remote_addr);
+        on_failure(true);
+        return;
+    }
+
+    add_ref();
+    _loop.dispatch([this]() {
+        if (_loop.stopping()) {
+            on_failure(true);
+            release_ref();
+            return;
+        }
+
+        _connect_inflight = true;
+        _loop.submit_connect(this,
+                             OP_CONNECT,
+                             _socket,
+                             reinterpret_cast<const sockaddr *>(&_remote_sockaddr),
+                             sizeof(_remote_sockaddr));
+    });
+}
+
+void io_uring_rpc_session::on_connect_completed(int res)
+{
+    _connect_inflight = false;
+    const auto cleanup = dsn::defer([this]() { release_ref(); });
+
+    if (res < 0) {
+        LOG_ERROR_PREFIX(
+            "connect to {} failed: error = {}", _remote_addr, utils::safe_strerror(-res));
+
+        on_failure(true);
+        return;
+    }
+
+    sockaddr_in local;
+    socklen_t len = sizeof(local);
+    if (::getsockname(_socket, reinterpret_cast<sockaddr *>(&local), &len) != 0) {
+        LOG_ERROR_PREFIX("failed to get the local endpoint: error = {}, remote = {}",
+                         utils::safe_strerror(errno),
+                         _remote_addr);
+
+        on_failure(true);
+        return;
+    }
+
+    _local_addr = ::dsn::rpc_address(ntohl(local.sin_addr.s_addr), ntohs(local.sin_port));
+
+    LOG_DEBUG_PREFIX("connect to {} successfully: local = {}", _remote_addr, _local_addr);
+
+    set_options();
+    mark_connected();
+    on_send_completed(0);
+    start_read_next();
+}
+
+void io_uring_rpc_session::close()
+{
+    if (_socket < 0) {
+        return;
+    }
+
+    if (::shutdown(_socket, SHUT_RDWR) != 0 && errno != ENOTCONN) {
+        LOG_WARNING_PREFIX("io_uring socket shutdown failed: error = {}, local = {}, remote = {}",
+                           utils::safe_strerror(errno),
+                           _local_addr,
+                           _remote_addr);
+    }
+}
+
+void io_uring_rpc_session::on_failure(bool is_write)
+{
+    rpc_session::on_failure(is_write);
+
+    // Shut the socket down, otherwise a multishot recv, which holds a reference of the session,
+    // would never be completed until the remote closes the connection.
+    close();
+}
+
+} // namespace tools
+} // namespace dsn
@@ -0,0 +1,135 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+#include "rpc/io_uring_net_provider.h"
+#include "rpc/message_parser.h"
+#include "rpc/network.h"
+#include "rpc/rpc_address.h"
+
+namespace dsn {
+class message_ex;
+
+namespace tools {
+
+// A TCP session implementation based on io_uring, whose operations are all submitted and
+// completed in the event loop it is bound to.
+// Thread-safe
+class io_uring_rpc_session : public rpc_session, public io_uring_handler
+{
+public:
+    // The session owns `fd`, which is closed once the session is destroyed.
+    io_uring_rpc_session(io_uring_network_provider &net,
+                         io_uring_event_loop &loop,
+                         rpc_address remote_addr,
+                         int fd,
+                         message_parser_ptr &parser,
+                         bool is_client);
+
+    ~io_uring_rpc_session() override;
+
+    rpc_address local_address() const override { return _local_addr; }
+
+    void send(uint64_t signature) override;
+
+    // The socket is just shut down, while the file descriptor is closed in the destructor,
+    // since it might be still used by the operations in flight.
+    void close() override;
+
+    void connect() override;
+
+    void on_failure(bool is_write) override;
+
+    void on_completion(uint8_t op, int res, uint32_t flags) override;
+
+    void on_loop_stopping() override;
+
+private:
+    enum operation : uint8_t
+    {
+        OP_RECV,
+        OP_SEND,
+        OP_CONNECT,
+        OP_CANCEL_RECV,
+        OP_CANCEL_CONNECT,
+    };
+
+    void set_options();
+    void set_option(int level, int name, int value, const char *opt_name);
+
+    void do_read(int read_next) override;
+
+    void submit_recv(int read_next, bool multishot);
+    void on_recv_completed(int res, uint32_t flags);
+    // Parse the messages from the received data, then start the next read.
+    void process_received();
+
+    void submit_send();
+    void on_sendmsg_completed(int res);
+
+    void on_connect_completed(int res);
+
+    void on_message_read(message_ex *msg)
+    {
+        if (!on_recv_message(msg, 0)) {
+            on_failure(false);
+        }
+    }
+
+    io_uring_event_loop &_loop;
+    const int _socket;
+    rpc_address _local_addr;
+    sockaddr_in _remote_sockaddr;
+
+    //
+    // The following fields are accessed only in the loop thread.
+    //
+    // Whether there is a recv in flight, and whether it is multishot.
+    bool _recv_armed;
+    bool _recv_multishot;
+    // Whether the reading is paused by start_read_next(), e.g. to throttle the requests. The
+    // data received during the pause is parsed after the reading is resumed by do_read().
+    bool _read_paused;
+    bool _has_unparsed_data;
+    // The bytes expected by the parser, see start_read_next().
+    int _read_next;
+    // Whether there is a connect in flight.
+    bool _connect_inflight;
+
+    // The batch being written, which would not be changed until it is completed, see
+    // rpc_session::on_send_completed().
+    uint64_t _send_signature;
+    std::vector<iovec> _send_iovs;
+    size_t _send_iov_index;
+    std::vector<msghdr> _send_msgs;
+    int _sendmsg_inflight;
+    size_t _sendmsg_written;
+    int _sendmsg_error;
+};
+
+} // namespace tools
+} // namespace dsn
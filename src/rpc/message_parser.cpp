@@ -36,6 +36,7 @@
 
 #include "message_parser_manager.h"
 #include "rpc/message_parser.h"
+#include "rpc/message_pool.h"
 #include "task/task_spec.h"
 #include "utils/blob.h"
 #include "utils/fmt_logging.h"
@@ -151,7 +152,7 @@ char *message_reader::read_buffer_ptr(unsigned int read_next)
         // TODO(wutao1): make it a buffer queue like what sofa-pbrpc does
         //               (https://github.com/baidu/sofa-pbrpc/blob/master/src/sofa/pbrpc/buffer.h)
         //               to reduce memory copy.
-        _buffer.assign(dsn::utils::make_shared_array<char>(sz), 0, sz);
+        _buffer.assign(message_pool::instance().allocate_buffer(sz), 0, sz);
         _buffer_occupied = 0;
 
         // copy
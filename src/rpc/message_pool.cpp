@@ -0,0 +1,313 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rpc/message_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+#include "utils/flags.h"
+
+METRIC_DEFINE_counter(server,
+                      message_pool_hits,
+                      dsn::metric_unit::kAllocations,
+                      "The number of rpc message allocations served by the recycled memory of "
+                      "message_pool");
+
+METRIC_DEFINE_counter(server,
+                      message_pool_misses,
+                      dsn::metric_unit::kAllocations,
+                      "The number of rpc message allocations that message_pool failed to serve "
+                      "and fell back to the system allocator");
+
+DSN_DEFINE_bool(network,
+                enable_message_pool,
+                true,
+                "Whether to recycle the memory of the rpc messages and the receive buffers by "
+                "message_pool");
+DSN_DEFINE_uint32(network,
+                  message_pool_max_block_size,
+                  65536,
+                  "The size of the largest block recycled by message_pool, which should be the "
+                  "same as message_buffer_block_size of the network providers. Larger allocations "
+                  "bypass the pool");
+DSN_DEFINE_validator(message_pool_max_block_size, [](uint32_t value) -> bool {
+    return value >= 64 && value <= (1 << 20) && (value & (value - 1)) == 0;
+});
+DSN_DEFINE_uint32(network,
+                  message_pool_thread_cache_bytes,
+                  4 << 20,
+                  "The max bytes of the blocks of each size class cached privately by a thread "
+                  "for message_pool");
+DSN_DEFINE_uint64(network,
+                  message_pool_central_cache_bytes,
+                  64 << 20,
+                  "The max bytes of the blocks of each size class shared by all threads for "
+                  "message_pool");
+
+namespace dsn {
+namespace {
+
+constexpr int kMinSizeShift = 6;
+constexpr int kMaxSizeShift = 20;
+constexpr int kMaxSizeClassCount = kMaxSizeShift - kMinSizeShift + 1;
+constexpr size_t kMaxCentralListCapacity = 4096;
+
+// Set once the thread cache of the current thread is destroyed, after which the blocks freed by
+// the thread (e.g. by the destructors of other thread-local objects) go to the central lists.
+__thread bool t_cache_destroyed = false;
+
+int log2_ceil(size_t size) { return size <= 1 ? 0 : 64 - __builtin_clzll(size - 1); }
+
+} // anonymous namespace
+
+// A bounded multi-producer multi-consumer queue, where each cell carries a sequence number
+// telling whether it is ready for the next push or pop, thus it is free from the ABA problem
+// that a lock-free stack suffers from.
+class message_pool::central_list
+{
+public:
+    void init(size_t capacity)
+    {
+        _cells.reset(new cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        _mask = capacity - 1;
+    }
+
+    bool push(void *ptr)
+    {
+        cell *c;
+        size_t pos = _push_pos.load(std::memory_order_relaxed);
+        while (true) {
+            c = &_cells[pos & _mask];
+            const auto diff = static_cast<intptr_t>(c->seq.load(std::memory_order_acquire)) -
+                              static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The list is full.
+                return false;
+            } else {
+                pos = _push_pos.load(std::memory_order_relaxed);
+            }
+        }
+        c->ptr = ptr;
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    void *pop()
+    {
+        cell *c;
+        size_t pos = _pop_pos.load(std::memory_order_relaxed);
+        while (true) {
+            c = &_cells[pos & _mask];
+            const auto diff = static_cast<intptr_t>(c->seq.load(std::memory_order_acquire)) -
+                              static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                // The list is empty.
+                return nullptr;
+            } else {
+                pos = _pop_pos.load(std::memory_order_relaxed);
+            }
+        }
+        void *ptr = c->ptr;
+        c->seq.store(pos + _mask + 1, std::memory_order_release);
+        return ptr;
+    }
+
+private:
+    struct cell
+    {
+        std::atomic<size_t> seq;
+        void *ptr;
+    };
+
+    std::unique_ptr<cell[]> _cells;
+    size_t _mask = 0;
+    alignas(CACHELINE_SIZE) std::atomic<size_t> _push_pos{0};
+    alignas(CACHELINE_SIZE) std::atomic<size_t> _pop_pos{0};
+};
+
+struct message_pool::thread_cache
+{
+    struct free_block
+    {
+        free_block *next;
+    };
+
+    free_block *heads[kMaxSizeClassCount] = {};
+    uint32_t counts[kMaxSizeClassCount] = {};
+
+    ~thread_cache()
+    {
+        t_cache_destroyed = true;
+        auto &pool = message_pool::instance();
+        for (int i = 0; i < kMaxSizeClassCount; ++i) {
+            while (heads[i] != nullptr) {
+                auto *block = heads[i];
+                heads[i] = block->next;
+                pool.spill(i, block);
+            }
+        }
+    }
+};
+
+/*static*/ message_pool &message_pool::instance()
+{
+    static message_pool *pool = new message_pool();
+    return *pool;
+}
+
+/*static*/ message_pool::thread_cache *message_pool::local_cache()
+{
+    if (dsn_unlikely(t_cache_destroyed)) {
+        return nullptr;
+    }
+    static thread_local thread_cache t_cache;
+    return &t_cache;
+}
+
+message_pool::message_pool()
+    : _enabled(FLAGS_enable_message_pool),
+      _size_class_count(log2_ceil(FLAGS_message_pool_max_block_size) - kMinSizeShift + 1),
+      _thread_cache_bytes(FLAGS_message_pool_thread_cache_bytes),
+      _central_lists(new central_list[kMaxSizeClassCount]),
+      METRIC_VAR_INIT_server(message_pool_hits),
+      METRIC_VAR_INIT_server(message_pool_misses)
+{
+    for (int i = 0; i < _size_class_count; ++i) {
+        auto capacity = std::max<uint64_t>(
+            2,
+            std::min<uint64_t>(kMaxCentralListCapacity,
+                               FLAGS_message_pool_central_cache_bytes >> (i + kMinSizeShift)));
+        // Round down to a power of two.
+        capacity = uint64_t(1) << (63 - __builtin_clzll(capacity));
+        _central_lists[i].init(capacity);
+    }
+}
+
+int message_pool::size_class(size_t size) const
+{
+    if (!_enabled) {
+        return -1;
+    }
+    const int index = std::max(log2_ceil(size), kMinSizeShift) - kMinSizeShift;
+    return index < _size_class_count ? index : -1;
+}
+
+size_t message_pool::block_size(size_t size) const
+{
+    const int index = size_class(size);
+    return index < 0 ? size : size_t(1) << (index + kMinSizeShift);
+}
+
+void *message_pool::allocate(size_t size)
+{
+    const int index = size_class(size);
+    if (index < 0) {
+        return ::operator new(size);
+    }
+
+    void *ptr = pop(index);
+    if (ptr != nullptr) {
+        METRIC_VAR_INCREMENT(message_pool_hits);
+        return ptr;
+    }
+
+    METRIC_VAR_INCREMENT(message_pool_misses);
+    return ::operator new(size_t(1) << (index + kMinSizeShift));
+}
+
+void message_pool::deallocate(void *ptr, size_t size)
+{
+    if (ptr == nullptr) {
+        return;
+    }
+
+    const int index = size_class(size);
+    if (index < 0) {
+        ::operator delete(ptr);
+        return;
+    }
+    push(index, ptr);
+}
+
+std::shared_ptr<char> message_pool::allocate_buffer(size_t size)
+{
+    return std::shared_ptr<char>(static_cast<char *>(allocate(size)),
+                                 [size](char *ptr) { instance().deallocate(ptr, size); });
+}
+
+void *message_pool::pop(int index)
+{
+    auto *cache = local_cache();
+    if (cache != nullptr && cache->heads[index] != nullptr) {
+        auto *block = cache->heads[index];
+        cache->heads[index] = block->next;
+        --cache->counts[index];
+        return block;
+    }
+    return _central_lists[index].pop();
+}
+
+void message_pool::push(int index, void *ptr)
+{
+    auto *cache = local_cache();
+    if (cache == nullptr) {
+        spill(index, ptr);
+        return;
+    }
+
+    const uint32_t max_count =
+        std::max<uint32_t>(2, _thread_cache_bytes >> (index + kMinSizeShift));
+    if (cache->counts[index] >= max_count) {
+        // Move half of the cached blocks into the central list in favor of the threads that
+        // allocate more than they free, e.g. the io threads receiving the requests.
+        for (uint32_t i = 0; i < max_count / 2; ++i) {
+            auto *block = cache->heads[index];
+            cache->heads[index] = block->next;
+            --cache->counts[index];
+            spill(index, block);
+        }
+    }
+
+    auto *block = static_cast<thread_cache::free_block *>(ptr);
+    block->next = cache->heads[index];
+    cache->heads[index] = block;
+    ++cache->counts[index];
+}
+
+void message_pool::spill(int index, void *ptr)
+{
+    if (!_central_lists[index].push(ptr)) {
+        ::operator delete(ptr);
+    }
+}
+
+} // namespace dsn
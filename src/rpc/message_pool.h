@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#include "utils/metrics.h"
+#include "utils/ports.h"
+
+namespace dsn {
+
+// message_pool recycles the memory frequently allocated by the rpc layer, i.e. the message_ex
+// objects, the message headers, the write buffers and the receive buffers of the sessions, to
+// take the allocator off the critical path of each request and reply.
+//
+// The memory is organized into power-of-two size classes, from 64 bytes up to
+// `[network] message_pool_max_block_size` which is supposed to be the same as
+// message_buffer_block_size, so that the receive buffers fill exactly the largest class. Larger
+// allocations bypass the pool.
+//
+// Each thread caches the freed blocks of each class in a private free list, which needs no
+// synchronization at all. Once a thread cache is full, the blocks spill over into a bounded
+// lock-free queue shared by all threads, where the other threads could pick them up. This is
+// needed since the blocks are usually allocated by the io threads and freed by the workers.
+class message_pool
+{
+public:
+    // The pool is never destroyed, since the messages might be released while exiting.
+    static message_pool &instance();
+
+    // Return a block of at least `size` bytes.
+    void *allocate(size_t size);
+    // `size` must be the same as the one passed to allocate().
+    void deallocate(void *ptr, size_t size);
+
+    // Return a buffer of at least `size` bytes, whose memory is recycled into the pool once all
+    // the blobs sharing it are released.
+    std::shared_ptr<char> allocate_buffer(size_t size);
+
+    // Whether `size` bytes fit a size class, otherwise they bypass the pool.
+    bool is_pooled(size_t size) const { return size_class(size) >= 0; }
+
+    // Return the size of the memory actually allocated for `size` bytes, i.e. the size of the
+    // class if `size` is pooled, otherwise `size` itself.
+    size_t block_size(size_t size) const;
+
+private:
+    friend class message_pool_test;
+
+    message_pool();
+    ~message_pool() = delete;
+
+    // Return the index of the size class serving `size` bytes, or -1 if it is not pooled.
+    int size_class(size_t size) const;
+
+    void *pop(int index);
+    void push(int index, void *ptr);
+    // Return the block into the shared list of the size class, or free it if the list is full.
+    void spill(int index, void *ptr);
+
+    class central_list;
+    struct thread_cache;
+    static thread_cache *local_cache();
+
+    const bool _enabled;
+    const int _size_class_count;
+    const uint32_t _thread_cache_bytes;
+    std::unique_ptr<central_list[]> _central_lists;
+
+    METRIC_VAR_DECLARE_counter(message_pool_hits);
+    METRIC_VAR_DECLARE_counter(message_pool_misses);
+
+    DISALLOW_COPY_AND_ASSIGN(message_pool);
+};
+
+} // namespace dsn
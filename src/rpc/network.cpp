@@ -26,6 +26,7 @@
 
 #include "network.h"
 
+#include <string.h>
 #include <unistd.h>
 #include <algorithm>
 #include <cerrno>
@@ -38,6 +39,7 @@
 #include "fmt/core.h"
 #include "gutil/map_util.h"
 #include "message_parser_manager.h"
+#include "rpc/message_pool.h"
 #include "rpc/rpc_address.h"
 #include "rpc/rpc_engine.h"
 #include "runtime/api_task.h"
@@ -67,6 +69,17 @@ METRIC_DEFINE_gauge_int64(server,
                           dsn::metric_unit::kSessions,
                           "The number of sessions from server side");
 
+METRIC_DEFINE_counter(server,
+                      network_send_batches,
+                      dsn::metric_unit::kBatches,
+                      "The number of batches written by the sessions, each of which is written "
+                      "by a single syscall unless the socket buffer is full");
+
+METRIC_DEFINE_counter(server,
+                      network_sent_messages,
+                      dsn::metric_unit::kMessages,
+                      "The number of messages written by the sessions");
+
 DSN_DEFINE_uint32(network,
                   conn_threshold_per_ip,
                   0,
@@ -79,6 +92,27 @@ DSN_DEFINE_uint32(network,
                   "remote address (i.e. <ip>:<port>)");
 DSN_DEFINE_validator(conn_pool_max_size, [](uint32_t value) -> bool { return value > 0; });
 
+DSN_DEFINE_int32(network,
+                 max_buffer_block_count_per_send,
+                 64,
+                 "The maximum number of buffers written by a session at a time, which should be "
+                 "no more than what a single syscall could write (64 for boost asio)");
+DSN_DEFINE_validator(max_buffer_block_count_per_send,
+                     [](int32_t value) -> bool { return value > 0; });
+DSN_DEFINE_uint32(network,
+                  max_bytes_per_send,
+                  1024 * 1024,
+                  "The maximum bytes of the messages batched into a single write of a session, "
+                  "while at least one message would be sent");
+DSN_TAG_VARIABLE(max_bytes_per_send, FT_MUTABLE);
+DSN_DEFINE_uint32(network,
+                  send_coalesce_threshold_bytes,
+                  512,
+                  "Once multiple messages are batched into a write of a session, the buffers "
+                  "smaller than this are copied together so that more messages could be written "
+                  "by a single syscall. 0 means never copying");
+DSN_TAG_VARIABLE(send_coalesce_threshold_bytes, FT_MUTABLE);
+
 DSN_DEFINE_string(network, unknown_message_header_format, "", "format for unknown message headers");
 DSN_DEFINE_string(network,
                   explicit_host_address,
@@ -208,6 +242,7 @@ void rpc_session::clear_send_queue(bool resend_msgs)
         _queued_msg_count -= static_cast<int>(_sending_msgs.size());
         _sending_msgs.swap(swapped_sending_msgs);
         _sending_buffers.clear();
+        _coalesce_buffer.reset();
     }
 
     // resend pending messages if need
@@ -230,6 +265,7 @@ void rpc_session::clear_send_queue(bool resend_msgs)
         dlink *msg{nullptr};
         {
             utils::auto_lock<utils::ex_lock_nr> l(_lock);
+            _batched_msg_count += _incoming_msgs.pop_all(&_batched_msgs);
             msg = _batched_msgs.next();
             if (msg == &_batched_msgs) {
                 break;
@@ -262,26 +298,69 @@ inline bool rpc_session::unlink_message_for_send()
 {
     auto *n = _batched_msgs.next();
     int bcount = 0;
+    uint64_t bytes = 0;
 
     DCHECK_EQ_PREFIX(0, _sending_buffers.size());
     DCHECK_EQ_PREFIX(0, _sending_msgs.size());
 
+    // The small buffers (typically the headers and the bodies of small replies) are packed into
+    // a contiguous buffer once there are multiple messages to be sent, so that more of them fit
+    // into the buffers written by a single syscall. A lone message is still sent without copying.
+    const uint32_t coalesce_threshold =
+        _batched_msg_count > 1 ? FLAGS_send_coalesce_threshold_bytes : 0;
+    size_t coalesced = 0;
+
     while (n != &_batched_msgs) {
         auto *lmsg = CONTAINING_RECORD(n, message_ex, dl); // NOLINT
-        const auto lcount = _parser->get_buffer_count_on_send(lmsg);
-        if (bcount > 0 && bcount + lcount > _max_buffer_block_count_per_send) {
+        if (bcount > 0 && bytes >= FLAGS_max_bytes_per_send) {
             break;
         }
 
+        const auto lcount = _parser->get_buffer_count_on_send(lmsg);
         _sending_buffers.resize(bcount + lcount);
         const auto rcount = _parser->get_buffers_on_send(lmsg, &_sending_buffers[bcount]);
         CHECK_GE_PREFIX(lcount, rcount);
 
-        if (lcount != rcount) {
-            _sending_buffers.resize(bcount + rcount);
+        // The last buffer of the former message might be extended by coalescing, which should
+        // be restored if this message does not fit into the batch.
+        const auto last_sz = bcount > 0 ? _sending_buffers[bcount - 1].sz : 0;
+        const auto last_coalesced = coalesced;
+        auto count = bcount;
+        for (int i = bcount; i < bcount + rcount; ++i) {
+            const auto buf = _sending_buffers[i];
+            bytes += buf.sz;
+            if (buf.sz >= coalesce_threshold ||
+                coalesced + buf.sz > static_cast<size_t>(_net.message_buffer_block_size())) {
+                _sending_buffers[count++] = buf;
+                continue;
+            }
+
+            if (!_coalesce_buffer) {
+                _coalesce_buffer =
+                    message_pool::instance().allocate_buffer(_net.message_buffer_block_size());
+            }
+            char *dst = _coalesce_buffer.get() + coalesced;
+            memcpy(dst, buf.buf, buf.sz);
+            coalesced += buf.sz;
+
+            // Extend the previous buffer if it ends right at the copied data.
+            auto *last = count > 0 ? &_sending_buffers[count - 1] : nullptr;
+            if (last != nullptr && static_cast<char *>(last->buf) + last->sz == dst) {
+                last->sz += buf.sz;
+            } else {
+                _sending_buffers[count++] = {dst, buf.sz};
+            }
         }
 
-        bcount += rcount;
+        if (bcount > 0 && count > _max_buffer_block_count_per_send) {
+            _sending_buffers.resize(bcount);
+            _sending_buffers[bcount - 1].sz = last_sz;
+            coalesced = last_coalesced;
+            break;
+        }
+
+        _sending_buffers.resize(count);
+        bcount = count;
         _sending_msgs.push_back(lmsg);
 
         n = n->next();
@@ -290,7 +369,12 @@ inline bool rpc_session::unlink_message_for_send()
 
     // added in send_message
     _batched_msg_count -= static_cast<int>(_sending_msgs.size());
-    return !_sending_msgs.empty();
+    if (_sending_msgs.empty()) {
+        return false;
+    }
+
+    _net.on_send_batch(static_cast<int64_t>(_sending_msgs.size()));
+    return true;
 }
 
 DEFINE_TASK_CODE(LPC_DELAY_RPC_REQUEST_RATE, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
@@ -356,29 +440,19 @@ void rpc_session::send_message(message_ex *msg)
     CHECK_NOTNULL_PREFIX_MSG(_parser, "parser should not be null when send");
     _parser->prepare_on_send(msg);
 
-    uint64_t sig{0};
-    {
-        utils::auto_lock<utils::ex_lock_nr> l(_lock);
+    // Cache the message firstly, to be sent in batch later. The message is pushed without
+    // `_lock`, so that the threads replying through the same session do not contend on it.
+    ++_queued_msg_count;
+    _incoming_msgs.push(&msg->dl);
 
-        // Cache the message firstly, to be sent in batch later.
-        msg->dl.insert_before(&_batched_msgs);
-        ++_batched_msg_count;
-        ++_queued_msg_count;
-
-        // Messages cannot be sent until following conditions are met:
-        // 1. the connection should be established successfully, since connecting to remote
-        // is asynchronous, and
-        // 2. there is not another batch being sent.
-        if ((SS_CONNECTED != _connect_state) || _is_sending_next) {
-            return;
-        }
-
-        _is_sending_next = true;
-        sig = _message_sent + 1;
-        unlink_message_for_send();
+    // Only one thread could send the next batch. If there is another batch being sent, the
+    // message will be picked up once it is completed.
+    bool expected = false;
+    if (_is_sending_next.load() || !_is_sending_next.compare_exchange_strong(expected, true)) {
+        return;
     }
 
-    this->send(sig);
+    send_next();
 }
 
 bool rpc_session::cancel(message_ex *request)
@@ -389,6 +463,8 @@ bool rpc_session::cancel(message_ex *request)
     {
         utils::auto_lock<utils::ex_lock_nr> l(_lock);
 
+        // The request might be still in `_incoming_msgs`.
+        _batched_msg_count += _incoming_msgs.pop_all(&_batched_msgs);
         if (request->dl.is_alone()) {
             return false;
         }
@@ -406,44 +482,75 @@ bool rpc_session::cancel(message_ex *request)
 
 void rpc_session::on_send_completed(uint64_t signature)
 {
-    uint64_t sig = 0;
-    {
+    if (signature == 0) {
+        // Try to send the messages queued before the session is connected.
+        bool expected = false;
+        if (!_is_sending_next.compare_exchange_strong(expected, true)) {
+            return;
+        }
+    } else {
         utils::auto_lock<utils::ex_lock_nr> l(_lock);
-        if (signature != 0) {
-            CHECK_PREFIX_MSG(_is_sending_next && signature == _message_sent + 1,
-                             "sent msg must be sending");
-            _is_sending_next = false;
-
-            // the _sending_msgs may have been cleared when reading of the rpc_session is failed.
-            if (_sending_msgs.empty()) {
-                CHECK_EQ_PREFIX_MSG(_connect_state,
-                                    SS_DISCONNECTED,
-                                    "assume sending queue is cleared due to session closed");
-                return;
-            }
+        CHECK_PREFIX_MSG(_is_sending_next && signature == _message_sent + 1,
+                         "sent msg must be sending");
+
+        // the _sending_msgs may have been cleared when reading of the rpc_session is failed.
+        if (_sending_msgs.empty()) {
+            CHECK_EQ_PREFIX_MSG(_connect_state,
+                                SS_DISCONNECTED,
+                                "assume sending queue is cleared due to session closed");
+            return;
+        }
+
+        for (auto &msg : _sending_msgs) {
+            // added in rpc_engine::reply (for server) or rpc_session::send_message (for client)
+            msg->release_ref();
+            _message_sent++;
+        }
+
+        _queued_msg_count -= static_cast<int>(_sending_msgs.size());
+        _sending_msgs.clear();
+        _sending_buffers.clear();
+        _coalesce_buffer.reset();
+    }
+
+    // for next send messages
+    send_next();
+}
 
-            for (auto &msg : _sending_msgs) {
-                // added in rpc_engine::reply (for server) or rpc_session::send_message (for client)
-                msg->release_ref();
-                _message_sent++;
+void rpc_session::send_next()
+{
+    while (true) {
+        uint64_t sig = 0;
+        {
+            utils::auto_lock<utils::ex_lock_nr> l(_lock);
+            if (SS_CONNECTED == _connect_state) {
+                _batched_msg_count += _incoming_msgs.pop_all(&_batched_msgs);
+                if (unlink_message_for_send()) {
+                    sig = _message_sent + 1;
+                }
             }
 
-            _queued_msg_count -= static_cast<int>(_sending_msgs.size());
-            _sending_msgs.clear();
-            _sending_buffers.clear();
+            if (sig == 0) {
+                // Reset the flag in the lock, so that the messages queued before the session
+                // is connected are sent by the on_send_completed(0) following mark_connected().
+                _is_sending_next = false;
+                if (SS_CONNECTED != _connect_state) {
+                    return;
+                }
+            }
         }
 
-        if (!_is_sending_next) {
-            if (unlink_message_for_send()) {
-                sig = _message_sent + 1;
-                _is_sending_next = true;
-            }
+        if (sig != 0) {
+            this->send(sig);
+            return;
         }
-    }
 
-    // for next send messages
-    if (sig != 0) {
-        this->send(sig);
+        // The messages pushed after `_incoming_msgs` was drained might have found that
+        // `_is_sending_next` was still set, thus have to be sent here.
+        bool expected = false;
+        if (_incoming_msgs.empty() || !_is_sending_next.compare_exchange_strong(expected, true)) {
+            return;
+        }
     }
 }
 
@@ -629,7 +736,7 @@ network::network(rpc_engine *srv, network *inner_provider)
     : _engine(srv), _client_hdr_format(NET_HDR_DSN), _unknown_msg_header_format(NET_HDR_INVALID)
 {
     _message_buffer_block_size = 1024 * 64;
-    _max_buffer_block_count_per_send = 64; // TODO: windows, how about the other platforms?
+    _max_buffer_block_count_per_send = FLAGS_max_buffer_block_count_per_send;
     _unknown_msg_header_format =
         network_header_format::from_string(FLAGS_unknown_message_header_format, NET_HDR_INVALID);
 }
@@ -685,7 +792,10 @@ uint32_t network::get_local_ipv4()
 }
 
 connection_oriented_network::connection_oriented_network(rpc_engine *srv, network *inner_provider)
-    : network(srv, inner_provider), METRIC_VAR_INIT_server(network_server_sessions)
+    : network(srv, inner_provider),
+      METRIC_VAR_INIT_server(network_server_sessions),
+      METRIC_VAR_INIT_server(network_send_batches),
+      METRIC_VAR_INIT_server(network_sent_messages)
 {
 }
 
@@ -208,6 +208,13 @@ public:
     // called by rpc engine
     void inject_drop_message(message_ex *msg, bool is_send) override;
 
+    // called by the sessions once a batch of `message_count` messages is to be written
+    void on_send_batch(int64_t message_count)
+    {
+        METRIC_VAR_INCREMENT(network_send_batches);
+        METRIC_VAR_INCREMENT_BY(network_sent_messages, message_count);
+    }
+
     // to be defined
     virtual rpc_session_ptr create_client_session(rpc_address server_addr) = 0;
 
@@ -233,6 +240,8 @@ private:
     uint32_t remove_server_conn_count(const rpc_session_ptr &session);
 
     METRIC_VAR_DECLARE_gauge_int64(network_server_sessions);
+    METRIC_VAR_DECLARE_counter(network_send_batches);
+    METRIC_VAR_DECLARE_counter(network_sent_messages);
 };
 
 /*!
@@ -317,6 +326,7 @@ public:
     // should always be called in lock
     bool unlink_message_for_send();
     virtual void send(uint64_t signature) = 0;
+    // signature == 0 means there is no batch completed, but the session is just connected.
     void on_send_completed(uint64_t signature);
     virtual void on_failure(bool is_write);
 
@@ -343,18 +353,23 @@ protected:
     // `_pending_msgs`. Once succeeded, all of them would be moved to "_batched_msgs".
     std::vector<message_ex *> _pending_msgs;
 
-    // Messages are sent in batch, firstly all of them are linked together in a doubly-linked
-    // list "_batched_msgs".
+    // Messages are sent in batch, firstly all of them are pushed into the lock-free queue
+    // "_incoming_msgs" (the only field here that could be accessed without `_lock`), which
+    // is drained into the doubly-linked list "_batched_msgs" in the lock.
     //
     // If no message are on-the-flying, a batch of messages are moved from `_batched_msgs`
     // to `_sending_msgs`, while the buffers of them are put into `_sending_buffers`.
+    dlink_mpsc_queue _incoming_msgs;
     dlink _batched_msgs;
     int _batched_msg_count; // Count of `_batched_msgs`.
 
-    bool _is_sending_next;
+    // Set by the only thread that sends the next batch, which could be reset only in the lock.
+    std::atomic_bool _is_sending_next;
 
     std::vector<message_ex *> _sending_msgs;
     std::vector<message_parser::send_buf> _sending_buffers;
+    // The small buffers of `_sending_msgs` copied together, see unlink_message_for_send().
+    std::shared_ptr<char> _coalesce_buffer;
 
     uint64_t _message_sent;
     // ]
@@ -374,6 +389,9 @@ protected:
     void clear_send_queue(bool resend_msgs);
     bool on_disconnected(bool is_write);
 
+    // send the next batch if any, should be called with `_is_sending_next` set by the caller.
+    void send_next();
+
     // constant info
     connection_oriented_network &_net;
     const rpc_address _remote_addr;
@@ -34,6 +34,7 @@
 #include <utility>
 
 #include "network.h"
+#include "rpc/message_pool.h"
 #include "rpc/rpc_address.h"
 #include "rpc/rpc_host_port.h"
 #include "rpc/rpc_message.h"
@@ -96,6 +97,16 @@ message_ex::~message_ex()
     }
 }
 
+/*static*/ void *message_ex::operator new(size_t size)
+{
+    return message_pool::instance().allocate(size);
+}
+
+/*static*/ void message_ex::operator delete(void *ptr, size_t size)
+{
+    message_pool::instance().deallocate(ptr, size);
+}
+
 error_code message_ex::error()
 {
     dsn::error_code code;
@@ -164,11 +175,10 @@ message_ex *message_ex::create_received_request(dsn::task_code code,
 message_ex *message_ex::copy_message_no_reply(const message_ex &old_msg)
 {
     auto *msg = new message_ex();
-    size_t header_size = sizeof(message_header);
-    std::string str(header_size, '\0');
-    msg->header = reinterpret_cast<message_header *>(const_cast<char *>(str.data()));
+    auto hdr = create_header_buffer();
+    msg->header = reinterpret_cast<message_header *>(const_cast<char *>(hdr.data()));
 
-    msg->buffers.emplace_back(blob::create_from_bytes(std::move(str)));
+    msg->buffers.push_back(std::move(hdr));
     if (old_msg.buffers.size() == 1) {
         // if old_msg only has header, consider its header as data
         msg->buffers.emplace_back(old_msg.buffers[0]);
@@ -230,7 +240,7 @@ message_ex *message_ex::copy(bool clone_content, bool copy_for_receive)
         msg->buffers = buffers;
     } else {
         int total_length = body_size() + sizeof(dsn::message_header);
-        std::shared_ptr<char> recv_buffer(dsn::utils::make_shared_array<char>(total_length));
+        std::shared_ptr<char> recv_buffer(message_pool::instance().allocate_buffer(total_length));
         char *ptr = recv_buffer.get();
 
         if ((const char *)header != buffers[0].data()) {
@@ -365,10 +375,18 @@ message_ex *message_ex::create_response()
     return msg;
 }
 
+/*static*/ blob message_ex::create_header_buffer()
+{
+    const size_t header_size = sizeof(message_header);
+    auto ptr(message_pool::instance().allocate_buffer(header_size));
+    memset(ptr.get(), 0, header_size);
+    return blob(std::move(ptr), header_size);
+}
+
 void message_ex::prepare_buffer_header()
 {
     size_t header_size = sizeof(message_header);
-    auto ptr(dsn::utils::make_shared_array<char>(header_size));
+    auto ptr(message_pool::instance().allocate_buffer(header_size));
 
     // here we should call placement new,
     // so the gpid & rpc_address can be initialized
@@ -394,12 +412,17 @@ void message_ex::write_next(void **ptr, size_t *size, size_t min_size)
     CHECK(!this->_is_read && this->_rw_committed,
           "there are pending msg write not committed"
           ", please invoke dsn_msg_write_next and dsn_msg_write_commit in pairs");
-    auto ptr_data(utils::make_shared_array<char>(min_size));
-    *size = min_size;
+    // Hand out the whole block if the size fits a size class of the pool, which saves the
+    // following write_next() calls of the stream. Otherwise, e.g. for a large value or once the
+    // pool is disabled, allocate exactly the size requested rather than rounding it up.
+    auto &pool = message_pool::instance();
+    const size_t block_size = pool.is_pooled(min_size) ? pool.block_size(min_size) : min_size;
+    auto ptr_data(pool.allocate_buffer(block_size));
+    *size = block_size;
     *ptr = ptr_data.get();
     this->_rw_committed = false;
 
-    ::dsn::blob buffer(ptr_data, min_size);
+    ::dsn::blob buffer(ptr_data, block_size);
     this->_rw_index++;
     this->_rw_offset = 0;
     this->buffers.push_back(buffer);
@@ -420,6 +443,24 @@ void message_ex::write_commit(size_t size)
     this->header->body_length += (int)size;
 }
 
+void message_ex::write_append(const blob &data)
+{
+    CHECK(!this->_is_read && this->_rw_committed,
+          "there are pending msg write not committed"
+          ", please invoke dsn_msg_write_next and dsn_msg_write_commit in pairs");
+    CHECK(data.buffer() != nullptr, "the appended buffer must hold the ownership of its memory");
+    if (data.length() == 0) {
+        return;
+    }
+
+    this->_rw_index++;
+    this->_rw_offset = static_cast<int>(data.length());
+    this->buffers.push_back(data);
+    this->header->body_length += data.length();
+
+    CHECK_EQ_MSG(_rw_index + 1, buffers.size(), "message write buffer count is not right");
+}
+
 bool message_ex::read_next(void **ptr, size_t *size)
 {
     // printf("%p %s %d\n", this, __FUNCTION__, utils::get_current_tid());
@@ -158,6 +158,10 @@ public:
     // message_ex(blob bb, bool parse_hdr = true); // read
     ~message_ex();
 
+    // The memory of message_ex objects is recycled by message_pool.
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     //
     // utility routines
     //
@@ -200,11 +204,11 @@ public:
     {
         auto *msg = new message_ex();
 
-        std::string str(sizeof(message_header), '\0');
-        msg->header = reinterpret_cast<message_header *>(const_cast<char *>(str.data()));
+        auto hdr = create_header_buffer();
+        msg->header = reinterpret_cast<message_header *>(const_cast<char *>(hdr.data()));
         msg->header->body_length = data.length();
 
-        msg->buffers.emplace_back(blob::create_from_bytes(std::move(str)));
+        msg->buffers.push_back(std::move(hdr));
         msg->buffers.push_back(std::forward<TBlob>(data));
 
         msg->_is_read = true;
@@ -235,6 +239,9 @@ public:
     //
     void write_next(void **ptr, size_t *size, size_t min_size);
     void write_commit(size_t size);
+    // Append `data` to the body as a separate buffer without copying it, thus `data` must hold
+    // the ownership of its memory, which is shared by the message until it is destroyed.
+    void write_append(const blob &data);
     bool read_next(void **ptr, size_t *size);
     bool read_next(blob &data);
     void read_commit(size_t size);
@@ -251,6 +258,8 @@ public:
 
 private:
     message_ex();
+    // Create a zeroed buffer for a standalone message_header.
+    static blob create_header_buffer();
     void prepare_buffer_header();
     void release_buffer_header();
 
@@ -0,0 +1,153 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "rpc/message_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "rpc/rpc_message.h"
+#include "task/task_code.h"
+#include "utils/autoref_ptr.h"
+#include "utils/metrics.h"
+#include "utils/threadpool_code.h"
+
+namespace dsn {
+
+DEFINE_TASK_CODE_RPC(RPC_CODE_FOR_TEST_POOL, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+class message_pool_test : public testing::Test
+{
+public:
+    static int64_t hits() { return message_pool::instance().METRIC_VAR_VALUE(message_pool_hits); }
+
+    static int64_t misses()
+    {
+        return message_pool::instance().METRIC_VAR_VALUE(message_pool_misses);
+    }
+};
+
+TEST_F(message_pool_test, block_size)
+{
+    auto &pool = message_pool::instance();
+    ASSERT_EQ(64, pool.block_size(1));
+    ASSERT_EQ(64, pool.block_size(64));
+    ASSERT_EQ(128, pool.block_size(65));
+    ASSERT_EQ(4096, pool.block_size(4000));
+    ASSERT_EQ(65536, pool.block_size(65536));
+    // Larger allocations bypass the pool.
+    ASSERT_FALSE(pool.is_pooled(65537));
+    ASSERT_EQ(65537, pool.block_size(65537));
+}
+
+TEST_F(message_pool_test, write_next)
+{
+    auto *msg = message_ex::create_request(RPC_CODE_FOR_TEST_POOL);
+    void *ptr = nullptr;
+    size_t size = 0;
+
+    // The whole block of the size class is handed out.
+    msg->write_next(&ptr, &size, 1000);
+    ASSERT_EQ(1024, size);
+    msg->write_commit(1000);
+
+    // The sizes larger than any class are allocated exactly.
+    msg->write_next(&ptr, &size, 65537);
+    ASSERT_EQ(65537, size);
+    msg->write_commit(65537);
+
+    msg->add_ref();
+    msg->release_ref();
+}
+
+TEST_F(message_pool_test, recycle_in_thread)
+{
+    auto &pool = message_pool::instance();
+    void *p1 = pool.allocate(1000);
+    memset(p1, 'a', pool.block_size(1000));
+    pool.deallocate(p1, 1000);
+
+    // The block is reused for the sizes of the same class.
+    const auto old_hits = hits();
+    void *p2 = pool.allocate(1024);
+    ASSERT_EQ(p1, p2);
+    ASSERT_EQ(old_hits + 1, hits());
+    pool.deallocate(p2, 1024);
+
+    // The buffers are recycled once released.
+    char *data = nullptr;
+    {
+        auto buf = pool.allocate_buffer(1000);
+        data = buf.get();
+    }
+    ASSERT_EQ(data, pool.allocate_buffer(900).get());
+}
+
+TEST_F(message_pool_test, recycle_across_threads)
+{
+    auto &pool = message_pool::instance();
+    const size_t kSize = 65536;
+    const int kCount = 256;
+
+    // The blocks allocated by a thread while freed by another one, just as the receive buffers
+    // allocated by the io threads, are recycled through the central list.
+    std::vector<void *> blocks;
+    std::thread([&]() {
+        for (int i = 0; i < kCount; ++i) {
+            blocks.push_back(pool.allocate(kSize));
+        }
+    }).join();
+    std::thread([&]() {
+        for (auto *block : blocks) {
+            pool.deallocate(block, kSize);
+        }
+    }).join();
+
+    const auto old_hits = hits();
+    const auto old_misses = misses();
+    blocks.clear();
+    for (int i = 0; i < kCount; ++i) {
+        blocks.push_back(pool.allocate(kSize));
+    }
+    ASSERT_EQ(old_hits + kCount, hits());
+    ASSERT_EQ(old_misses, misses());
+    for (auto *block : blocks) {
+        pool.deallocate(block, kSize);
+    }
+}
+
+TEST_F(message_pool_test, recycle_messages)
+{
+    auto *msg = message_ex::create_request(RPC_CODE_FOR_TEST_POOL);
+    msg->add_ref();
+    msg->release_ref();
+
+    const auto old_hits = hits();
+    msg = message_ex::create_request(RPC_CODE_FOR_TEST_POOL);
+    // Both the message and its header are recycled.
+    ASSERT_EQ(old_hits + 2, hits());
+    msg->add_ref();
+    msg->release_ref();
+}
+
+} // namespace dsn
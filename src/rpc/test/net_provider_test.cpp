@@ -30,9 +30,11 @@
 // IWYU pragma: no_include <boost/asio/impl/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <fmt/core.h>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <set>
@@ -40,10 +42,12 @@
 #include <thread>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "rpc/asio_net_provider.h"
 #include "rpc/asio_rpc_session.h"
+#include "rpc/io_uring_net_provider.h"
 #include "rpc/message_parser.h"
 #include "rpc/network.h"
 #include "rpc/network.sim.h"
@@ -155,6 +159,81 @@ protected:
 
     void wait_response() { _response_completed.wait(); }
 
+    // Echo messages through a single session with a fixed number of requests in flight, and
+    // report the QPS and the latencies, by which the network providers could be compared.
+    template <typename TNetwork>
+    void echo_benchmark(const char *name)
+    {
+        const auto server = std::make_unique<TNetwork>(task::get_current_rpc(), nullptr);
+        ASSERT_EQ(ERR_OK, server->start(RPC_CHANNEL_TCP, _test_port, false));
+
+        const auto net = std::make_unique<TNetwork>(task::get_current_rpc(), nullptr);
+        ASSERT_EQ(ERR_OK, net->start(RPC_CHANNEL_TCP, _test_port, true));
+
+        const auto client =
+            net->create_client_session(rpc_address::from_host_port("localhost", _test_port));
+        client->connect();
+
+        constexpr int kMessageCount = 50000;
+        constexpr int kConcurrency = 32;
+        std::vector<uint64_t> latencies_ns(kMessageCount);
+        std::atomic_int issued{0};
+        std::atomic_int pending{kMessageCount};
+        std::atomic_int failed{0};
+        utils::notify_event completed;
+
+        // Once a request is responded to, the next one is issued.
+        std::function<void()> issue = [&]() {
+            const int i = issued++;
+            if (i >= kMessageCount) {
+                return;
+            }
+
+            message_ex *request = message_ex::create_request(RPC_TEST_NETPROVIDER, 10000, 0);
+            ::dsn::marshall(request, fmt::format("hello world {}", i));
+
+            const auto issue_ns = dsn_now_ns();
+            rpc_response_task_ptr t(new rpc_response_task(
+                request,
+                [&, i, issue_ns](dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) {
+                    latencies_ns[i] = dsn_now_ns() - issue_ns;
+                    if (err != ERR_OK) {
+                        ++failed;
+                    }
+                    if (--pending == 0) {
+                        completed.notify();
+                        return;
+                    }
+                    issue();
+                },
+                0));
+            client->net().engine()->matcher()->on_call(request, t);
+            client->send_message(request);
+        };
+
+        const auto start_ns = dsn_now_ns();
+        for (int i = 0; i < kConcurrency; ++i) {
+            issue();
+        }
+        completed.wait();
+        const auto elapsed_ns = dsn_now_ns() - start_ns;
+
+        ASSERT_EQ(0, failed.load());
+
+        std::sort(latencies_ns.begin(), latencies_ns.end());
+        fmt::print("{}: echoed {} messages with {} in flight in {} ms, qps = {:.0f}, p50 = {} us, "
+                   "p99 = {} us\n",
+                   name,
+                   kMessageCount,
+                   kConcurrency,
+                   elapsed_ns / 1000000,
+                   kMessageCount * 1e9 / elapsed_ns,
+                   latencies_ns[kMessageCount / 2] / 1000,
+                   latencies_ns[kMessageCount * 99 / 100] / 1000);
+
+        client->close();
+    }
+
     static int _test_port;
 
     utils::notify_event _response_completed;
@@ -189,6 +268,48 @@ TEST_F(NetProviderTest, AsioNetProvider)
     test_send(client, false);
 }
 
+TEST_F(NetProviderTest, IoUringNetProvider)
+{
+    const auto net =
+        std::make_unique<tools::io_uring_network_provider>(task::get_current_rpc(), nullptr);
+
+    ASSERT_EQ(ERR_OK, net->start(RPC_CHANNEL_TCP, _test_port, true));
+
+    // Start only client multiple times is ok.
+    ASSERT_EQ(ERR_OK, net->start(RPC_CHANNEL_TCP, _test_port, true));
+
+    ASSERT_EQ(_test_port, net->address().port());
+
+    const auto another_net =
+        std::make_unique<tools::io_uring_network_provider>(task::get_current_rpc(), nullptr);
+    ASSERT_EQ(ERR_OK, another_net->start(RPC_CHANNEL_TCP, _test_port, true));
+
+    ASSERT_EQ(ERR_OK, another_net->start(RPC_CHANNEL_TCP, _test_port, false));
+
+    ASSERT_EQ(ERR_SERVICE_ALREADY_RUNNING, another_net->start(RPC_CHANNEL_TCP, _test_port, false));
+
+    // Both the messages sent by the io_uring client and those by the asio client are handled by
+    // the io_uring server.
+    const auto client =
+        net->create_client_session(rpc_address::from_host_port("localhost", _test_port));
+    client->connect();
+
+    test_send(client, false);
+
+    const auto asio_net =
+        std::make_unique<tools::asio_network_provider>(task::get_current_rpc(), nullptr);
+    ASSERT_EQ(ERR_OK, asio_net->start(RPC_CHANNEL_TCP, _test_port, true));
+
+    const auto asio_client =
+        asio_net->create_client_session(rpc_address::from_host_port("localhost", _test_port));
+    asio_client->connect();
+
+    test_send(asio_client, false);
+
+    client->close();
+    asio_client->close();
+}
+
 TEST_F(NetProviderTest, AsioUdpProvider)
 {
     const auto net = std::make_unique<tools::asio_udp_provider>(task::get_current_rpc(), nullptr);
@@ -516,4 +637,127 @@ TEST_F(NetProviderTest, SendMessageByPool)
     net->test_send(64, 5678);
 }
 
+// A client session counting the batches it writes, each of which is written by a single
+// syscall as long as the socket buffer is not full.
+class counting_send_session : public tools::asio_rpc_session
+{
+public:
+    counting_send_session(tools::asio_network_provider &net,
+                          ::dsn::rpc_address remote_addr,
+                          std::shared_ptr<boost::asio::ip::tcp::socket> &socket,
+                          message_parser_ptr &parser)
+        : asio_rpc_session(net, remote_addr, socket, parser, true)
+    {
+    }
+
+    ~counting_send_session() override = default;
+
+    void send(uint64_t signature) override
+    {
+        // The batch would not be changed until it is completed.
+        ++_batches;
+        _messages += _sending_msgs.size();
+        _buffers += _sending_buffers.size();
+        asio_rpc_session::send(signature);
+    }
+
+    std::atomic<uint64_t> _batches{0};
+    std::atomic<uint64_t> _messages{0};
+    std::atomic<uint64_t> _buffers{0};
+
+    DISALLOW_COPY_AND_ASSIGN(counting_send_session);
+    DISALLOW_MOVE_AND_ASSIGN(counting_send_session);
+};
+
+class counting_send_network : public tools::asio_network_provider
+{
+public:
+    counting_send_network(rpc_engine *srv, network *inner_provider)
+        : tools::asio_network_provider(srv, inner_provider)
+    {
+    }
+
+    ~counting_send_network() override = default;
+
+    rpc_session_ptr create_client_session(::dsn::rpc_address server_addr) override
+    {
+        auto sock = std::make_shared<boost::asio::ip::tcp::socket>(get_io_service());
+        message_parser_ptr parser(new_message_parser(_client_hdr_format));
+        return {new counting_send_session(*this, server_addr, sock, parser)};
+    }
+
+    DISALLOW_COPY_AND_ASSIGN(counting_send_network);
+    DISALLOW_MOVE_AND_ASSIGN(counting_send_network);
+};
+
+// Echo small messages back-to-back through a single session, and report the writes (i.e. the
+// syscalls) per message, which are saved by batching the messages queued while the former write
+// is in flight.
+TEST_F(NetProviderTest, AsioEchoBatching)
+{
+    const auto server =
+        std::make_unique<tools::asio_network_provider>(task::get_current_rpc(), nullptr);
+    ASSERT_EQ(ERR_OK, server->start(RPC_CHANNEL_TCP, _test_port, false));
+
+    const auto net = std::make_unique<counting_send_network>(task::get_current_rpc(), nullptr);
+    ASSERT_EQ(ERR_OK, net->start(RPC_CHANNEL_TCP, _test_port, true));
+
+    const auto client =
+        net->create_client_session(rpc_address::from_host_port("localhost", _test_port));
+    client->connect();
+
+    constexpr int kMessageCount = 20000;
+    std::atomic_int pending{kMessageCount};
+    std::atomic_int failed{0};
+    utils::notify_event completed;
+
+    const auto start_ns = dsn_now_ns();
+    for (int i = 0; i < kMessageCount; ++i) {
+        message_ex *request = message_ex::create_request(RPC_TEST_NETPROVIDER, 10000, 0);
+        ::dsn::marshall(request, fmt::format("hello world {}", i));
+
+        rpc_response_task_ptr t(new rpc_response_task(
+            request,
+            [&](dsn::error_code err, dsn::message_ex *req, dsn::message_ex *resp) {
+                if (err != ERR_OK) {
+                    ++failed;
+                }
+                if (--pending == 0) {
+                    completed.notify();
+                }
+            },
+            0));
+        client->net().engine()->matcher()->on_call(request, t);
+        client->send_message(request);
+    }
+    completed.wait();
+    const auto elapsed_ns = dsn_now_ns() - start_ns;
+
+    const auto *session = static_cast<counting_send_session *>(client.get());
+    ASSERT_EQ(0, failed.load());
+    ASSERT_EQ(kMessageCount, session->_messages.load());
+    ASSERT_LT(session->_batches.load(), session->_messages.load());
+
+    fmt::print("echoed {} messages in {} ms: {:.3f} writes per message, {:.1f} buffers per "
+               "write\n",
+               kMessageCount,
+               elapsed_ns / 1000000,
+               static_cast<double>(session->_batches) / kMessageCount,
+               static_cast<double>(session->_buffers) / session->_batches);
+
+    client->close();
+}
+
+// The outputs of the following two tests compare io_uring_network_provider with
+// asio_network_provider over loopback.
+TEST_F(NetProviderTest, AsioEchoBenchmark)
+{
+    echo_benchmark<tools::asio_network_provider>("asio_network_provider");
+}
+
+TEST_F(NetProviderTest, IoUringEchoBenchmark)
+{
+    echo_benchmark<tools::io_uring_network_provider>("io_uring_network_provider");
+}
+
 } // namespace dsn
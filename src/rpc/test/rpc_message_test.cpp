@@ -35,11 +35,13 @@
 #include "gtest/gtest.h"
 #include "rpc/rpc_address.h"
 #include "rpc/rpc_message.h"
+#include "rpc/rpc_stream.h"
 #include "rpc/serialization.h"
 #include "runtime/message_utils.h"
 #include "task/task_code.h"
 #include "task/task_spec.h"
 #include "utils/autoref_ptr.h"
+#include "utils/binary_reader.h"
 #include "utils/blob.h"
 #include "utils/crc.h"
 #include "utils/threadpool_code.h"
@@ -228,3 +230,34 @@ TEST(rpc_message_test, copy_message_no_reply)
     // so we only need to call release_ref here.
     msg->release_ref();
 }
+
+TEST(rpc_message_test, write_append)
+{
+    message_ptr request = message_ex::create_request(RPC_CODE_FOR_TEST, 100, 1);
+    const auto data = blob::create_from_bytes("10086");
+    {
+        rpc_write_stream writer(request.get());
+        writer.write_pod(static_cast<int>(data.length()));
+        writer.flush();
+        request->write_append(data);
+        writer.write_pod(static_cast<int>(1));
+    }
+
+    // The appended buffer is shared by the message rather than copied.
+    ASSERT_EQ(4, request->buffers.size());
+    ASSERT_EQ(data.data(), request->buffers[2].data());
+    ASSERT_EQ(sizeof(int) * 2 + data.length(), request->header->body_length);
+
+    // The body is received in the order it was written.
+    message_ptr receive = request->copy(true, true);
+    rpc_read_stream reader(receive.get());
+    int len = 0;
+    reader.read_pod(len);
+    ASSERT_EQ(static_cast<int>(data.length()), len);
+    blob received;
+    reader.read(received, len);
+    ASSERT_EQ(data.to_string(), received.to_string());
+    int tail = 0;
+    reader.read_pod(tail);
+    ASSERT_EQ(1, tail);
+}
@@ -0,0 +1,167 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <fmt/core.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "rpc/asio_net_provider.h"
+#include "rpc/message_parser.h"
+#include "rpc/network.h"
+#include "rpc/rpc_address.h"
+#include "rpc/rpc_message.h"
+#include "rpc/serialization.h"
+#include "runtime/api_layer1.h"
+#include "task/task.h"
+#include "task/task_code.h"
+#include "test_util/test_util.h"
+#include "utils/autoref_ptr.h"
+#include "utils/ports.h"
+#include "utils/threadpool_code.h"
+
+namespace dsn {
+
+DEFINE_TASK_CODE_RPC(RPC_TEST_SEND_QUEUE, TASK_PRIORITY_COMMON, THREAD_POOL_DEFAULT)
+
+// A server session whose writes are completed asynchronously by a dedicated thread, just like
+// the io threads of the real network, while the data is simply dropped.
+class mock_send_session : public rpc_session
+{
+public:
+    mock_send_session(connection_oriented_network &net, message_parser_ptr &parser)
+        : rpc_session(net, rpc_address::from_ip_port("127.0.0.1", 34801), parser, false)
+    {
+        _completer = std::thread([this]() { complete_sends(); });
+    }
+
+    ~mock_send_session() override
+    {
+        if (_completer.joinable()) {
+            stop();
+        }
+    }
+
+    void connect() override {}
+    void close() override {}
+    void do_read(int read_next) override {}
+
+    void send(uint64_t signature) override
+    {
+        ++_batches;
+        _messages += _sending_msgs.size();
+        {
+            std::lock_guard<std::mutex> l(_mtx);
+            _signature = signature;
+        }
+        _cv.notify_one();
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> l(_mtx);
+            _stopped = true;
+        }
+        _cv.notify_one();
+        _completer.join();
+    }
+
+    std::atomic<uint64_t> _batches{0};
+    std::atomic<uint64_t> _messages{0};
+
+private:
+    void complete_sends()
+    {
+        while (true) {
+            uint64_t signature = 0;
+            {
+                std::unique_lock<std::mutex> l(_mtx);
+                _cv.wait(l, [this]() { return _signature != 0 || _stopped; });
+                if (_stopped) {
+                    return;
+                }
+                signature = _signature;
+                _signature = 0;
+            }
+            on_send_completed(signature);
+        }
+    }
+
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    uint64_t _signature{0};
+    bool _stopped{false};
+    std::thread _completer;
+
+    DISALLOW_COPY_AND_ASSIGN(mock_send_session);
+    DISALLOW_MOVE_AND_ASSIGN(mock_send_session);
+};
+
+// Reply through a single session from multiple threads, and report the throughput of the send
+// queue of the session.
+TEST(rpc_session_test, concurrent_send)
+{
+    tools::asio_network_provider net(task::get_current_rpc(), nullptr);
+    message_parser_ptr parser(net.new_message_parser(NET_HDR_DSN));
+
+    constexpr int kMessagesPerThread = 20000;
+    for (const int thread_count : {1, 4, 16}) {
+        rpc_session_ptr session(new mock_send_session(net, parser));
+        auto *mock = static_cast<mock_send_session *>(session.get());
+
+        const auto start_ns = dsn_now_ns();
+        std::vector<std::thread> senders;
+        for (int i = 0; i < thread_count; ++i) {
+            senders.emplace_back([&session]() {
+                for (int j = 0; j < kMessagesPerThread; ++j) {
+                    auto *msg = message_ex::create_request(RPC_TEST_SEND_QUEUE);
+                    ::dsn::marshall(msg, std::string("hello world"));
+                    session->send_message(msg);
+                }
+            });
+        }
+        for (auto &sender : senders) {
+            sender.join();
+        }
+
+        // All the messages should be sent eventually.
+        ASSERT_IN_TIME([&session]() { ASSERT_EQ(0, session->queued_message_count()); }, 10);
+        const auto elapsed_ns = dsn_now_ns() - start_ns;
+        mock->stop();
+
+        const uint64_t total = static_cast<uint64_t>(thread_count) * kMessagesPerThread;
+        ASSERT_EQ(total, mock->_messages.load());
+        fmt::print("{} threads sent {} messages through one session in {} ms: {:.0f} messages "
+                   "per second, {:.1f} messages per batch\n",
+                   thread_count,
+                   total,
+                   elapsed_ns / 1000000,
+                   total * 1e9 / elapsed_ns,
+                   static_cast<double>(total) / mock->_batches);
+    }
+}
+
+} // namespace dsn
@@ -22,4 +22,10 @@ fi
 
 rm -rf data dsn_rpc_tests.xml
 output_xml="${REPORT_DIR}/dsn_rpc_tests.xml"
-GTEST_OUTPUT="xml:${output_xml}" ./dsn_rpc_tests config.ini
+GTEST_OUTPUT="xml:${output_xml}" ./dsn_rpc_tests config.ini || exit 1
+
+# Run the same tests with io_uring_network_provider, the QPS and latencies printed by the echo
+# benchmarks could be compared with the above ones.
+rm -rf data
+output_xml="${REPORT_DIR}/dsn_rpc_tests_io_uring.xml"
+GTEST_OUTPUT="xml:${output_xml}" ./dsn_rpc_tests config-io-uring.ini
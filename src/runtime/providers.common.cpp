@@ -28,6 +28,7 @@
 
 #include "rpc/asio_net_provider.h"
 #include "rpc/dsn_message_parser.h"
+#include "rpc/io_uring_net_provider.h"
 #include "rpc/network.sim.h"
 #include "rpc/raw_message_parser.h"
 #include "rpc/thrift_message_parser.h"
@@ -38,6 +39,7 @@
 #include "task/simple_task_queue.h"
 #include "task/task_spec.h"
 #include "task/task_worker.h"
+#include "task/work_stealing_task_queue.h"
 #include "utils/flags.h"
 #include "utils/lockp.std.h"
 #include "utils/zlock_provider.h"
@@ -68,9 +70,12 @@ void register_common_providers()
         register_component_provider<asio_udp_provider>("dsn::tools::asio_udp_provider");
     }
     register_component_provider<asio_network_provider>("dsn::tools::asio_network_provider");
+    register_component_provider<io_uring_network_provider>(
+        "dsn::tools::io_uring_network_provider");
     register_component_provider<sim_network_provider>("dsn::tools::sim_network_provider");
     register_component_provider<simple_task_queue>("dsn::tools::simple_task_queue");
     register_component_provider<hpc_concurrent_task_queue>("dsn::tools::hpc_concurrent_task_queue");
+    register_component_provider<work_stealing_task_queue>("dsn::tools::work_stealing_task_queue");
     register_component_provider<simple_timer_service>("dsn::tools::simple_timer_service");
 
     register_message_header_parser<dsn_message_parser>(NET_HDR_DSN, {"RDSN"});
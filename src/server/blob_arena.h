@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include "utils/blob.h"
+#include "utils/utils.h"
+
+namespace pegasus {
+namespace server {
+
+/// blob_arena hands out dsn::blob views which are carved from a few large ref-counted
+/// blocks, so that building a response of thousands of rows (multi_get, scan) does not
+/// need a heap allocation per key and per value.
+///
+/// Every returned blob holds a reference to the block it points into, thus the blocks
+/// are released automatically once the response (and all the blobs it holds) is destroyed.
+/// The arena itself could be destroyed at any time.
+///
+/// NOTE: blob_arena is not thread-safe, it's intended to be used by a single request.
+class blob_arena
+{
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    explicit blob_arena(size_t block_size = kDefaultBlockSize) : _block_size(block_size) {}
+
+    blob_arena(const blob_arena &) = delete;
+    blob_arena &operator=(const blob_arena &) = delete;
+
+    // Copy `length` bytes from `data` into the arena and return a blob pointing to them.
+    dsn::blob copy(const char *data, size_t length)
+    {
+        if (length == 0) {
+            return {};
+        }
+
+        // Large pieces are allocated individually, to avoid wasting the remaining space
+        // of the current block, or pinning a huge block by a single small blob.
+        if (length > _block_size / 4) {
+            return dsn::blob::create_from_bytes(data, length);
+        }
+
+        if (_block == nullptr || _block_size - _used < length) {
+            _block = dsn::utils::make_shared_array<char>(_block_size);
+            _used = 0;
+            ++_allocated_blocks;
+        }
+
+        ::memcpy(_block.get() + _used, data, length);
+
+        dsn::blob result;
+        result.assign(_block, static_cast<int>(_used), static_cast<unsigned int>(length));
+        _used += length;
+        return result;
+    }
+
+    dsn::blob copy(std::string_view data) { return copy(data.data(), data.length()); }
+
+    size_t allocated_blocks() const { return _allocated_blocks; }
+
+private:
+    const size_t _block_size;
+    std::shared_ptr<char> _block;
+    size_t _used{0};
+    size_t _allocated_blocks{0};
+};
+
+} // namespace server
+} // namespace pegasus
@@ -268,6 +268,19 @@ void capacity_unit_calculator::add_sortkey_count_cu(dsn::message_ex *req,
     _read_hotkey_collector->capture_hash_key(hash_key, 1);
 }
 
+void capacity_unit_calculator::add_aggregate_scan_cu(dsn::message_ex *req,
+                                                     int32_t status,
+                                                     int64_t read_bytes)
+{
+    if (status != rocksdb::Status::kOk && status != rocksdb::Status::kInvalidArgument) {
+        return;
+    }
+
+    add_read_cu(read_bytes);
+    METRIC_VAR_INCREMENT_BY(scan_bytes, read_bytes);
+    add_backup_request_bytes(req, read_bytes);
+}
+
 void capacity_unit_calculator::add_ttl_cu(dsn::message_ex *req,
                                           int32_t status,
                                           const dsn::blob &key)
@@ -321,6 +334,20 @@ void capacity_unit_calculator::add_multi_put_cu(int32_t status,
     add_write_cu(data_size);
 }
 
+void capacity_unit_calculator::add_batch_put_cu(
+    int32_t status, const std::vector<::dsn::apps::batch_put_entry> &entries)
+{
+    // Each entry is charged as a single put, since they are of different hash keys.
+    for (const auto &entry : entries) {
+        const auto size = entry.hash_key.size() + entry.sort_key.size() + entry.value.size();
+        METRIC_VAR_INCREMENT_BY(put_bytes, size);
+        _write_hotkey_collector->capture_hash_key(entry.hash_key, 1);
+        if (status == rocksdb::Status::kOk) {
+            add_write_cu(size);
+        }
+    }
+}
+
 void capacity_unit_calculator::add_multi_remove_cu(int32_t status,
                                                    const dsn::blob &hash_key,
                                                    const std::vector<::dsn::blob> &sort_keys)
@@ -338,6 +365,20 @@ void capacity_unit_calculator::add_multi_remove_cu(int32_t status,
     add_write_cu(data_size);
 }
 
+void capacity_unit_calculator::add_del_range_cu(int32_t status,
+                                                const dsn::blob &hash_key,
+                                                const dsn::blob &start_sort_key,
+                                                const dsn::blob &stop_sort_key)
+{
+    if (status != rocksdb::Status::kOk) {
+        return;
+    }
+
+    // Only a range tombstone is written, no matter how many keys are covered by it.
+    _write_hotkey_collector->capture_hash_key(hash_key, 1);
+    add_write_cu(hash_key.size() * 2 + start_sort_key.size() + stop_sort_key.size());
+}
+
 void capacity_unit_calculator::add_incr_cu(int32_t status, const dsn::blob &key)
 {
     if (status != rocksdb::Status::kOk && status != rocksdb::Status::kInvalidArgument) {
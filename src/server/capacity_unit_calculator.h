@@ -31,6 +31,7 @@ class blob;
 class message_ex;
 
 namespace apps {
+class batch_put_entry;
 class full_data;
 class key_value;
 class mutate;
@@ -71,6 +72,8 @@ public:
                      int32_t status,
                      const std::vector<::dsn::apps::key_value> &kvs);
     void add_sortkey_count_cu(dsn::message_ex *req, int32_t status, const dsn::blob &hash_key);
+    // `read_bytes` is the size of all the rows iterated, no matter whether they are aggregated.
+    void add_aggregate_scan_cu(dsn::message_ex *req, int32_t status, int64_t read_bytes);
     void add_ttl_cu(dsn::message_ex *req, int32_t status, const dsn::blob &key);
 
     void add_put_cu(int32_t status, const dsn::blob &key, const dsn::blob &value);
@@ -78,9 +81,14 @@ public:
     void add_multi_put_cu(int32_t status,
                           const dsn::blob &hash_key,
                           const std::vector<::dsn::apps::key_value> &kvs);
+    void add_batch_put_cu(int32_t status, const std::vector<::dsn::apps::batch_put_entry> &entries);
     void add_multi_remove_cu(int32_t status,
                              const dsn::blob &hash_key,
                              const std::vector<::dsn::blob> &sort_keys);
+    void add_del_range_cu(int32_t status,
+                          const dsn::blob &hash_key,
+                          const dsn::blob &start_sort_key,
+                          const dsn::blob &stop_sort_key);
     void add_incr_cu(int32_t status, const dsn::blob &key);
     void add_check_and_set_cu(int32_t status,
                               const dsn::blob &hash_key,
@@ -134,7 +142,9 @@ private:
             add_put_cu: weight = 1(write_collector),
             add_remove_cu: weight = 1(write_collector),
             add_multi_put_cu: weight = returned sortkey count(write_collector),
+            add_batch_put_cu: weight = 1 for each entry(write_collector),
             add_multi_remove_cu: weight = returned sortkey count(write_collector),
+            add_del_range_cu: weight = 1(write_collector),
             add_incr_cu: if find the key, weight = 1(write_collector),
                          else weight = 1(read_collector)
             add_check_and_set_cu: if find the key, weight = 1(write_collector),
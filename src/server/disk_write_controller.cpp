@@ -0,0 +1,174 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "disk_write_controller.h"
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/status.h>
+#include <rocksdb/write_buffer_manager.h>
+#include <algorithm>
+#include <map>
+#include <utility>
+
+#include "utils/fmt_logging.h"
+
+METRIC_DEFINE_gauge_int64(disk,
+                          disk_write_buffer_mem_usage_bytes,
+                          dsn::metric_unit::kBytes,
+                          "The memory usage of the memtables of the replicas on the disk");
+
+METRIC_DEFINE_counter(disk,
+                      disk_write_stall_duration_us,
+                      dsn::metric_unit::kMicroSeconds,
+                      "The accumulated duration that the writes of the replicas on the disk "
+                      "were stalled by RocksDB");
+
+METRIC_DEFINE_counter(disk,
+                      disk_proactive_flushes,
+                      dsn::metric_unit::kFlushes,
+                      "The number of flushes proactively triggered for the replicas on the "
+                      "disk once the memory usage of the memtables reached the high watermark");
+
+namespace pegasus {
+namespace server {
+
+/*static*/ std::shared_ptr<disk_write_controller>
+disk_write_controller::get_or_create(const std::string &tag,
+                                     const dsn::metric_entity_ptr &disk_entity,
+                                     size_t buffer_size,
+                                     const std::shared_ptr<rocksdb::Cache> &cache)
+{
+    static std::mutex s_lock;
+    static std::map<std::string, std::weak_ptr<disk_write_controller>> s_controllers;
+
+    std::lock_guard<std::mutex> l(s_lock);
+    auto &controller = s_controllers[tag];
+    auto ptr = controller.lock();
+    if (ptr == nullptr) {
+        LOG_INFO("create write controller for disk {}: buffer_size = {}", tag, buffer_size);
+        ptr = std::make_shared<disk_write_controller>(disk_entity, buffer_size, cache);
+        controller = ptr;
+    }
+    return ptr;
+}
+
+disk_write_controller::disk_write_controller(const dsn::metric_entity_ptr &disk_entity,
+                                             size_t buffer_size,
+                                             const std::shared_ptr<rocksdb::Cache> &cache)
+    : _disk_entity(disk_entity),
+      _write_buffer_manager(std::make_shared<rocksdb::WriteBufferManager>(buffer_size, cache)),
+      METRIC_VAR_INIT_disk(disk_write_buffer_mem_usage_bytes),
+      METRIC_VAR_INIT_disk(disk_write_stall_duration_us),
+      METRIC_VAR_INIT_disk(disk_proactive_flushes)
+{
+}
+
+disk_write_controller::~disk_write_controller()
+{
+    CHECK(_dbs.empty(), "all the dbs should have been removed before the controller is deleted");
+}
+
+void disk_write_controller::add_db(rocksdb::DB *db,
+                                   const std::vector<rocksdb::ColumnFamilyHandle *> &cfs)
+{
+    std::lock_guard<std::mutex> l(_lock);
+    _dbs.push_back({db, cfs, 0});
+}
+
+void disk_write_controller::remove_db(rocksdb::DB *db)
+{
+    std::lock_guard<std::mutex> l(_lock);
+    _dbs.erase(std::remove_if(_dbs.begin(),
+                              _dbs.end(),
+                              [db](const db_entry &entry) { return entry.db == db; }),
+               _dbs.end());
+}
+
+bool disk_write_controller::maybe_flush(uint64_t now_ms,
+                                        uint64_t interval_ms,
+                                        uint32_t watermark_percent)
+{
+    // Only one of the replicas on the disk would do the check for each interval.
+    uint64_t last_check_ms = _last_check_ms.load(std::memory_order_relaxed);
+    if (now_ms < last_check_ms + interval_ms ||
+        !_last_check_ms.compare_exchange_strong(last_check_ms, now_ms)) {
+        return false;
+    }
+
+    METRIC_VAR_SET(disk_write_buffer_mem_usage_bytes,
+                   static_cast<int64_t>(_write_buffer_manager->memory_usage()));
+
+    const auto buffer_size = _write_buffer_manager->buffer_size();
+    if (buffer_size == 0 || _write_buffer_manager->mutable_memtable_memory_usage() * 100 <
+                                static_cast<uint64_t>(buffer_size) * watermark_percent) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> l(_lock);
+
+    db_entry *hottest = nullptr;
+    uint64_t hottest_size = 0;
+    db_entry *coldest = nullptr;
+    uint64_t coldest_size = 0;
+    for (auto &entry : _dbs) {
+        uint64_t size = 0;
+        if (!entry.db->GetAggregatedIntProperty(rocksdb::DB::Properties::kCurSizeActiveMemTable,
+                                                &size)) {
+            continue;
+        }
+
+        const bool cold = size <= entry.last_size;
+        entry.last_size = size;
+        if (cold && size > coldest_size) {
+            coldest = &entry;
+            coldest_size = size;
+        } else if (!cold && size > hottest_size) {
+            hottest = &entry;
+            hottest_size = size;
+        }
+    }
+
+    // Prefer the cold memtable unless it is less than half of the largest hot one.
+    auto *target = (coldest != nullptr && coldest_size * 2 >= hottest_size) ? coldest : hottest;
+    if (target == nullptr) {
+        return false;
+    }
+
+    rocksdb::FlushOptions options;
+    options.wait = false;
+    options.allow_write_stall = true;
+    const auto s = target->db->Flush(options, target->cfs);
+    if (!s.ok()) {
+        LOG_WARNING("proactive flush failed: {}", s.ToString());
+        return false;
+    }
+
+    target->last_size = 0;
+    METRIC_VAR_INCREMENT(disk_proactive_flushes);
+    return true;
+}
+
+void disk_write_controller::add_stall_micros(uint64_t micros)
+{
+    METRIC_VAR_INCREMENT_BY(disk_write_stall_duration_us, static_cast<int64_t>(micros));
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils/metrics.h"
+#include "utils/ports.h"
+
+namespace rocksdb {
+class Cache;
+class ColumnFamilyHandle;
+class DB;
+class WriteBufferManager;
+} // namespace rocksdb
+
+namespace pegasus {
+namespace server {
+
+// disk_write_controller limits the memory used by the memtables of all the replicas placed on
+// the same disk (i.e. dir_node) by a shared rocksdb::WriteBufferManager, so that a hot replica
+// could only stall the writes of the replicas on its own disk rather than the whole server.
+//
+// Besides, once the memory usage reaches the high watermark, it proactively flushes a replica
+// before the write buffer manager has to: a cold replica (whose mutable memtable has not grown
+// since the last check) is preferred as long as its memtable is not much smaller than the
+// largest one, since flushing it does not disturb the active writers.
+class disk_write_controller
+{
+public:
+    // Get the controller of the disk, which is created with the budget of `buffer_size` bytes
+    // (0 means no limit) and charged to `cache` on the first call for this disk.
+    static std::shared_ptr<disk_write_controller>
+    get_or_create(const std::string &tag,
+                  const dsn::metric_entity_ptr &disk_entity,
+                  size_t buffer_size,
+                  const std::shared_ptr<rocksdb::Cache> &cache);
+
+    disk_write_controller(const dsn::metric_entity_ptr &disk_entity,
+                          size_t buffer_size,
+                          const std::shared_ptr<rocksdb::Cache> &cache);
+    ~disk_write_controller();
+
+    const std::shared_ptr<rocksdb::WriteBufferManager> &write_buffer_manager() const
+    {
+        return _write_buffer_manager;
+    }
+
+    // A db must be removed before it is closed.
+    void add_db(rocksdb::DB *db, const std::vector<rocksdb::ColumnFamilyHandle *> &cfs);
+    void remove_db(rocksdb::DB *db);
+
+    // Flush a db if the memory usage reaches the high watermark. It is checked at most once
+    // every `interval_ms` for the disk even if called by all the replicas on it. Return true
+    // if a flush is triggered.
+    bool maybe_flush(uint64_t now_ms, uint64_t interval_ms, uint32_t watermark_percent);
+
+    // Accumulate the duration that the writes of a replica on this disk were stalled.
+    void add_stall_micros(uint64_t micros);
+
+    const dsn::metric_entity_ptr &disk_metric_entity() const { return _disk_entity; }
+
+private:
+    struct db_entry
+    {
+        rocksdb::DB *db;
+        std::vector<rocksdb::ColumnFamilyHandle *> cfs;
+        // The size of the mutable memtable at the last check.
+        uint64_t last_size;
+    };
+
+    const dsn::metric_entity_ptr _disk_entity;
+    std::shared_ptr<rocksdb::WriteBufferManager> _write_buffer_manager;
+
+    std::mutex _lock;
+    std::vector<db_entry> _dbs;
+    std::atomic<uint64_t> _last_check_ms{0};
+
+    METRIC_VAR_DECLARE_gauge_int64(disk_write_buffer_mem_usage_bytes);
+    METRIC_VAR_DECLARE_counter(disk_write_stall_duration_us);
+    METRIC_VAR_DECLARE_counter(disk_proactive_flushes);
+
+    DISALLOW_COPY_AND_ASSIGN(disk_write_controller);
+};
+
+} // namespace server
+} // namespace pegasus
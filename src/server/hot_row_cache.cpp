@@ -0,0 +1,184 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "hot_row_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "pegasus_value_schema.h"
+
+namespace pegasus {
+namespace server {
+
+hot_row_cache::hot_row_cache(uint64_t capacity_bytes, uint32_t shard_count)
+    : _shard_capacity(capacity_bytes / std::max<uint32_t>(shard_count, 1))
+{
+    _shards.reserve(std::max<uint32_t>(shard_count, 1));
+    for (uint32_t i = 0; i < std::max<uint32_t>(shard_count, 1); ++i) {
+        _shards.emplace_back(std::make_unique<shard>());
+        _shards.back()->hand = _shards.back()->ring.end();
+    }
+}
+
+void hot_row_cache::set_enabled(bool enabled)
+{
+    if (this->enabled() == enabled) {
+        return;
+    }
+
+    _enabled_generation.fetch_add(1);
+    if (!enabled) {
+        invalidate_all();
+    }
+}
+
+bool hot_row_cache::lookup(std::string_view raw_key,
+                           uint32_t epoch_now,
+                           std::string &user_value,
+                           uint64_t &ticket)
+{
+    auto &s = get_shard(raw_key);
+    std::lock_guard<std::mutex> l(s.lock);
+    const auto iter = s.index.find(raw_key);
+    if (iter != s.index.end()) {
+        auto &r = *iter->second;
+        if (!check_if_ts_expired(epoch_now, r.expire_ts)) {
+            r.referenced = true;
+            user_value = r.value;
+            return true;
+        }
+        erase(s, iter->second);
+    }
+
+    ticket = s.generation;
+    return false;
+}
+
+void hot_row_cache::insert(std::string_view raw_key,
+                           std::string_view user_value,
+                           uint32_t expire_ts,
+                           uint64_t ticket)
+{
+    if (!enabled()) {
+        return;
+    }
+
+    row r{std::string(raw_key), std::string(user_value), expire_ts, false};
+    const auto row_charge = charge(r);
+    if (row_charge > _shard_capacity) {
+        return;
+    }
+
+    auto &s = get_shard(raw_key);
+    std::lock_guard<std::mutex> l(s.lock);
+    if (ticket != s.generation) {
+        // The row may have been changed since it was read.
+        return;
+    }
+
+    const auto iter = s.index.find(raw_key);
+    if (iter != s.index.end()) {
+        erase(s, iter->second);
+    }
+    evict(s, row_charge);
+
+    // Insert just before the hand, thus the new row is the last one to be visited.
+    const auto pos = s.ring.insert(s.hand, std::move(r));
+    s.index.emplace(pos->key, pos);
+    s.usage += row_charge;
+    _mem_usage.fetch_add(row_charge, std::memory_order_relaxed);
+}
+
+void hot_row_cache::invalidate(std::string_view raw_key)
+{
+    auto &s = get_shard(raw_key);
+    std::lock_guard<std::mutex> l(s.lock);
+    ++s.generation;
+    const auto iter = s.index.find(raw_key);
+    if (iter != s.index.end()) {
+        erase(s, iter->second);
+    }
+}
+
+void hot_row_cache::invalidate_all()
+{
+    for (auto &s : _shards) {
+        std::lock_guard<std::mutex> l(s->lock);
+        clear(*s);
+    }
+}
+
+/*static*/ uint64_t hot_row_cache::charge(const row &r)
+{
+    // Roughly count the overhead of the list node and the index entry.
+    static const uint64_t kRowOverhead = sizeof(row) + 64;
+    return r.key.size() + r.value.size() + kRowOverhead;
+}
+
+hot_row_cache::shard &hot_row_cache::get_shard(std::string_view raw_key)
+{
+    return *_shards[std::hash<std::string_view>()(raw_key) % _shards.size()];
+}
+
+void hot_row_cache::erase(shard &s, std::list<row>::iterator it)
+{
+    if (s.hand == it) {
+        ++s.hand;
+    }
+
+    const auto row_charge = charge(*it);
+    s.usage -= row_charge;
+    _mem_usage.fetch_sub(row_charge, std::memory_order_relaxed);
+
+    // Erase from the index first, whose key is a view of the row.
+    s.index.erase(it->key);
+    s.ring.erase(it);
+}
+
+void hot_row_cache::evict(shard &s, uint64_t needed)
+{
+    while (!s.ring.empty() && s.usage + needed > _shard_capacity) {
+        if (s.hand == s.ring.end()) {
+            s.hand = s.ring.begin();
+        }
+
+        if (s.hand->referenced) {
+            // Give the recently referenced row a second chance.
+            s.hand->referenced = false;
+            ++s.hand;
+        } else {
+            erase(s, s.hand);
+        }
+    }
+}
+
+void hot_row_cache::clear(shard &s)
+{
+    ++s.generation;
+    _mem_usage.fetch_sub(s.usage, std::memory_order_relaxed);
+    s.usage = 0;
+    s.index.clear();
+    s.ring.clear();
+    s.hand = s.ring.end();
+}
+
+} // namespace server
+} // namespace pegasus
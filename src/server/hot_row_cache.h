@@ -0,0 +1,120 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/ports.h"
+
+namespace pegasus {
+namespace server {
+
+// hot_row_cache caches the decoded user values of the rows read by get requests, in front of
+// RocksDB. It is split into shards by the hash of the raw key, each of which is bounded by
+// bytes and evicts rows by the CLOCK algorithm.
+//
+// To never serve a stale row, the writer must call invalidate() for each key after the write
+// has been applied to RocksDB, and the reader must get a ticket by lookup() before reading
+// RocksDB: insert() drops the row if any key of the same shard has been invalidated since the
+// ticket was got.
+class hot_row_cache
+{
+public:
+    hot_row_cache(uint64_t capacity_bytes, uint32_t shard_count);
+
+    // The cache is disabled initially. Once disabled, all the rows are dropped.
+    void set_enabled(bool enabled);
+    bool enabled() const { return is_enabled_generation(enabled_generation()); }
+
+    // The generation is increased each time the cache is enabled or disabled, thus it is odd if
+    // and only if the cache is enabled. The writer could skip invalidating the keys if the cache
+    // is disabled, as long as it invalidates all the keys if the generation got before the write
+    // has been changed after the write is applied.
+    uint64_t enabled_generation() const { return _enabled_generation.load(); }
+    static bool is_enabled_generation(uint64_t generation) { return (generation & 1) != 0; }
+
+    // Return true with the user value if `raw_key` is cached and not expired at `epoch_now`.
+    // Otherwise return false with the `ticket` for insert().
+    bool lookup(std::string_view raw_key,
+                uint32_t epoch_now,
+                std::string &user_value,
+                uint64_t &ticket);
+
+    void insert(std::string_view raw_key,
+                std::string_view user_value,
+                uint32_t expire_ts,
+                uint64_t ticket);
+
+    void invalidate(std::string_view raw_key);
+
+    // Invalidate all the keys, e.g. after external files are ingested.
+    void invalidate_all();
+
+    uint64_t mem_usage() const { return _mem_usage.load(std::memory_order_relaxed); }
+
+private:
+    struct row
+    {
+        std::string key;
+        std::string value;
+        uint32_t expire_ts;
+        bool referenced;
+    };
+
+    struct shard
+    {
+        std::mutex lock;
+        std::list<row> ring;
+        // The keys are the views of `row::key`, which are stable since the rows are in a list.
+        std::unordered_map<std::string_view, std::list<row>::iterator> index;
+        std::list<row>::iterator hand;
+        uint64_t usage{0};
+        // Increased by each invalidation, 0 is never used as a ticket.
+        uint64_t generation{1};
+    };
+
+    static uint64_t charge(const row &r);
+
+    shard &get_shard(std::string_view raw_key);
+
+    // The following functions should be called with the lock of `s` held.
+    void erase(shard &s, std::list<row>::iterator it);
+    void evict(shard &s, uint64_t needed);
+    void clear(shard &s);
+
+    const uint64_t _shard_capacity;
+    std::vector<std::unique_ptr<shard>> _shards;
+    std::atomic<uint64_t> _enabled_generation{0};
+    std::atomic<uint64_t> _mem_usage{0};
+
+    DISALLOW_COPY_AND_ASSIGN(hot_row_cache);
+};
+
+} // namespace server
+} // namespace pegasus
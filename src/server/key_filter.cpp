@@ -0,0 +1,202 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "key_filter.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <stdint.h>
+#include <cstring>
+
+#include "utils/endians.h"
+#include "utils/fmt_logging.h"
+#include "utils/strings.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+#if defined(__AVX2__)
+using simd_vec = __m256i;
+inline simd_vec simd_set1(char c) { return _mm256_set1_epi8(c); }
+inline simd_vec simd_load(const char *p)
+{
+    return _mm256_loadu_si256(reinterpret_cast<const simd_vec *>(p));
+}
+inline uint32_t simd_match_mask(simd_vec first, simd_vec last, const char *p, size_t last_offset)
+{
+    const simd_vec eq_first = _mm256_cmpeq_epi8(first, simd_load(p));
+    const simd_vec eq_last = _mm256_cmpeq_epi8(last, simd_load(p + last_offset));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last)));
+}
+#else
+using simd_vec = __m128i;
+inline simd_vec simd_set1(char c) { return _mm_set1_epi8(c); }
+inline simd_vec simd_load(const char *p)
+{
+    return _mm_loadu_si128(reinterpret_cast<const simd_vec *>(p));
+}
+inline uint32_t simd_match_mask(simd_vec first, simd_vec last, const char *p, size_t last_offset)
+{
+    const simd_vec eq_first = _mm_cmpeq_epi8(first, simd_load(p));
+    const simd_vec eq_last = _mm_cmpeq_epi8(last, simd_load(p + last_offset));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last)));
+}
+#endif
+
+// The candidate positions are those whose first and last bytes both equal to the needle's,
+// which are found for sizeof(simd_vec) positions at a time. Only the candidates are then
+// compared byte by byte.
+//
+// Require: needle.size() >= 2 && haystack.size() >= needle.size().
+size_t simd_find_substring(std::string_view haystack, std::string_view needle)
+{
+    const size_t n = needle.size();
+    const simd_vec first = simd_set1(needle.front());
+    const simd_vec last = simd_set1(needle.back());
+
+    size_t i = 0;
+    for (; i + n - 1 + sizeof(simd_vec) <= haystack.size(); i += sizeof(simd_vec)) {
+        uint32_t mask = simd_match_mask(first, last, haystack.data() + i, n - 1);
+        while (mask != 0) {
+            const size_t pos = i + __builtin_ctz(mask);
+            if (::memcmp(haystack.data() + pos + 1, needle.data() + 1, n - 2) == 0) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    // Process the tail which is not enough for a whole vector.
+    const size_t pos = haystack.substr(i).find(needle);
+    return pos == std::string_view::npos ? pos : i + pos;
+}
+
+#endif
+
+} // anonymous namespace
+
+size_t find_substring(std::string_view haystack, std::string_view needle)
+{
+    if (needle.empty()) {
+        return 0;
+    }
+    if (haystack.size() < needle.size()) {
+        return std::string_view::npos;
+    }
+    if (needle.size() == 1) {
+        const void *p = ::memchr(haystack.data(), needle.front(), haystack.size());
+        return p == nullptr ? std::string_view::npos
+                            : static_cast<const char *>(p) - haystack.data();
+    }
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    return simd_find_substring(haystack, needle);
+#else
+    return haystack.find(needle);
+#endif
+}
+
+key_filter::key_filter(::dsn::apps::filter_type::type filter_type, std::string_view pattern)
+    : _type(filter_type), _pattern(pattern)
+{
+    switch (_type) {
+    case ::dsn::apps::filter_type::FT_NO_FILTER:
+        break;
+    case ::dsn::apps::filter_type::FT_MATCH_ANYWHERE:
+    case ::dsn::apps::filter_type::FT_MATCH_PREFIX:
+    case ::dsn::apps::filter_type::FT_MATCH_POSTFIX:
+        // An empty pattern matches everything.
+        _match_all = _pattern.empty();
+        break;
+    case ::dsn::apps::filter_type::FT_MATCH_EXACT:
+        _match_all = false;
+        break;
+    case ::dsn::apps::filter_type::FT_MATCH_GLOB:
+        // A pattern consisting of '*' only matches everything.
+        _match_all = !_pattern.empty() && _pattern.find_first_not_of('*') == std::string::npos;
+        break;
+    default:
+        _valid = false;
+        break;
+    }
+}
+
+bool key_filter::match(std::string_view data) const
+{
+    if (_match_all) {
+        return true;
+    }
+
+    switch (_type) {
+    case ::dsn::apps::filter_type::FT_MATCH_ANYWHERE:
+        return find_substring(data, _pattern) != std::string_view::npos;
+    case ::dsn::apps::filter_type::FT_MATCH_PREFIX:
+        return data.size() >= _pattern.size() &&
+               ::memcmp(data.data(), _pattern.data(), _pattern.size()) == 0;
+    case ::dsn::apps::filter_type::FT_MATCH_POSTFIX:
+        return data.size() >= _pattern.size() &&
+               ::memcmp(data.data() + data.size() - _pattern.size(),
+                        _pattern.data(),
+                        _pattern.size()) == 0;
+    case ::dsn::apps::filter_type::FT_MATCH_EXACT:
+        return data == _pattern;
+    case ::dsn::apps::filter_type::FT_MATCH_GLOB:
+        return ::dsn::utils::glob_match(data, _pattern);
+    default:
+        CHECK(false, "unsupported filter type: {}", _type);
+    }
+    return false;
+}
+
+raw_key_filter::result raw_key_filter::match(const rocksdb::Slice &raw_key) const
+{
+    if (match_all()) {
+        return result::kMatched;
+    }
+
+    CHECK_GE(raw_key.size(), 2);
+
+    // hash_key_len is in big endian
+    uint16_t hash_key_len =
+        ::dsn::endian::ntoh(*reinterpret_cast<const uint16_t *>(raw_key.data()));
+    CHECK_GE(raw_key.size(), 2 + hash_key_len);
+
+    if (!_hash_key_filter.match_all() &&
+        !_hash_key_filter.match(std::string_view(raw_key.data() + 2, hash_key_len))) {
+        return result::kHashKeyFiltered;
+    }
+
+    if (!_sort_key_filter.match_all() &&
+        !_sort_key_filter.match(std::string_view(raw_key.data() + 2 + hash_key_len,
+                                                 raw_key.size() - 2 - hash_key_len))) {
+        return result::kSortKeyFiltered;
+    }
+
+    return result::kMatched;
+}
+
+} // namespace server
+} // namespace pegasus
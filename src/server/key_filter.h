@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <rocksdb/slice.h>
+#include <rrdb/rrdb_types.h>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace pegasus {
+namespace server {
+
+// Find the first occurrence of `needle` in `haystack`, return std::string_view::npos if
+// not found. SIMD instructions are used once they are enabled for the compiler (AVX2 or
+// SSE2), otherwise it falls back to std::string_view::find().
+size_t find_substring(std::string_view haystack, std::string_view needle);
+
+// key_filter is a filter on hash key or sort key, which is compiled only once for a request
+// (or a scan context), and then could be applied to lots of keys.
+class key_filter
+{
+public:
+    // Construct a filter that matches everything.
+    key_filter() = default;
+
+    // The filter is invalid if `filter_type` is not supported.
+    key_filter(::dsn::apps::filter_type::type filter_type, std::string_view pattern);
+
+    key_filter(key_filter &&) = default;
+    key_filter &operator=(key_filter &&) = default;
+
+    bool valid() const { return _valid; }
+
+    // Return true if every key would pass the filter, thus no need to call match().
+    bool match_all() const { return _match_all; }
+
+    ::dsn::apps::filter_type::type type() const { return _type; }
+    const std::string &pattern() const { return _pattern; }
+
+    // Return true if `data` passes the filter.
+    bool match(std::string_view data) const;
+
+private:
+    ::dsn::apps::filter_type::type _type{::dsn::apps::filter_type::FT_NO_FILTER};
+    std::string _pattern;
+    bool _valid{true};
+    bool _match_all{true};
+};
+
+// raw_key_filter applies the hash key filter and the sort key filter directly on the raw
+// rocksdb key, without restoring the key into blobs.
+class raw_key_filter
+{
+public:
+    raw_key_filter() = default;
+
+    raw_key_filter(::dsn::apps::filter_type::type hash_key_filter_type,
+                   std::string_view hash_key_filter_pattern,
+                   ::dsn::apps::filter_type::type sort_key_filter_type,
+                   std::string_view sort_key_filter_pattern)
+        : _hash_key_filter(hash_key_filter_type, hash_key_filter_pattern),
+          _sort_key_filter(sort_key_filter_type, sort_key_filter_pattern)
+    {
+    }
+
+    raw_key_filter(raw_key_filter &&) = default;
+    raw_key_filter &operator=(raw_key_filter &&) = default;
+
+    bool valid() const { return _hash_key_filter.valid() && _sort_key_filter.valid(); }
+
+    bool match_all() const { return _hash_key_filter.match_all() && _sort_key_filter.match_all(); }
+
+    const key_filter &hash_key_filter() const { return _hash_key_filter; }
+    const key_filter &sort_key_filter() const { return _sort_key_filter; }
+
+    enum class result
+    {
+        kMatched,
+        kHashKeyFiltered,
+        kSortKeyFiltered,
+    };
+
+    // `raw_key` must be encoded as pegasus key schema, see pegasus_generate_key().
+    result match(const rocksdb::Slice &raw_key) const;
+
+private:
+    key_filter _hash_key_filter;
+    key_filter _sort_key_filter;
+};
+
+} // namespace server
+} // namespace pegasus
@@ -109,11 +109,24 @@ using namespace dsn::literals::chrono_literals;
         dsn::from_blob_to_thrift(data, thrift_request);
         return pegasus_hash_key_hash(thrift_request.hash_key);
     }
+    if (tc == dsn::apps::RPC_RRDB_RRDB_BATCH_PUT) {
+        // All the entries belong to the same partition, thus any of them could represent it.
+        dsn::apps::batch_put_request thrift_request;
+        dsn::from_blob_to_thrift(data, thrift_request);
+        return thrift_request.entries.empty()
+                   ? 0
+                   : pegasus_hash_key_hash(thrift_request.entries.front().hash_key);
+    }
     if (tc == dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE) {
         dsn::apps::multi_remove_request thrift_request;
         dsn::from_blob_to_thrift(data, thrift_request);
         return pegasus_hash_key_hash(thrift_request.hash_key);
     }
+    if (tc == dsn::apps::RPC_RRDB_RRDB_DEL_RANGE) {
+        dsn::apps::del_range_request thrift_request;
+        dsn::from_blob_to_thrift(data, thrift_request);
+        return pegasus_hash_key_hash(thrift_request.hash_key);
+    }
     LOG_FATAL("unexpected task code: {}", tc);
     __builtin_unreachable();
 }
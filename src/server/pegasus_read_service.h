@@ -16,6 +16,7 @@
 // under the License.
 
 #pragma once
+#include <rocksdb/status.h>
 #include <iostream>
 #include "replica/replication_app_base.h"
 #include "common/storage_serverlet.h"
@@ -34,6 +35,12 @@ typedef ::dsn::rpc_holder<::dsn::blob, dsn::apps::ttl_response> ttl_rpc;
 typedef ::dsn::rpc_holder<::dsn::apps::get_scanner_request, dsn::apps::scan_response>
     get_scanner_rpc;
 typedef ::dsn::rpc_holder<::dsn::apps::scan_request, dsn::apps::scan_response> scan_rpc;
+typedef ::dsn::rpc_holder<::dsn::apps::aggregate_scan_request,
+                          dsn::apps::aggregate_scan_response>
+    aggregate_scan_rpc;
+typedef ::dsn::rpc_holder<::dsn::apps::get_split_keys_request,
+                          dsn::apps::get_split_keys_response>
+    get_split_keys_rpc;
 
 class pegasus_read_service : public dsn::replication::replication_app_base,
                              public dsn::replication::storage_serverlet<pegasus_read_service>
@@ -52,6 +59,10 @@ protected:
     // all service handlers to be implemented further
     // RPC_RRDB_RRDB_GET
     virtual void on_get(get_rpc rpc) = 0;
+    // Return true if the response of a get might be filled after on_get() returns, in which case
+    // the storage error is reported by report_async_read_error() rather than returned by
+    // on_request().
+    virtual bool is_get_async() const { return false; }
     // RPC_RRDB_RRDB_MULTI_GET
     virtual void on_multi_get(multi_get_rpc rpc) = 0;
     // RPC_RRDB_RRDB_BATCH_GET
@@ -66,10 +77,14 @@ protected:
     virtual void on_scan(scan_rpc rpc) = 0;
     // RPC_RRDB_RRDB_CLEAR_SCANNER
     virtual void on_clear_scanner(const int64_t &args) = 0;
+    // RPC_RRDB_RRDB_AGGREGATE_SCAN
+    virtual void on_aggregate_scan(aggregate_scan_rpc rpc) = 0;
+    // RPC_RRDB_RRDB_GET_SPLIT_KEYS
+    virtual void on_get_split_keys(get_split_keys_rpc rpc) = 0;
 
     static void register_rpc_handlers()
     {
-        register_rpc_handler_with_rpc_holder(dsn::apps::RPC_RRDB_RRDB_GET, "get", on_get);
+        register_async_rpc_handler(dsn::apps::RPC_RRDB_RRDB_GET, "get", on_get_request);
         register_rpc_handler_with_rpc_holder(
             dsn::apps::RPC_RRDB_RRDB_MULTI_GET, "multi_get", on_multi_get);
         register_rpc_handler_with_rpc_holder(
@@ -79,13 +94,24 @@ protected:
         register_rpc_handler_with_rpc_holder(dsn::apps::RPC_RRDB_RRDB_TTL, "ttl", on_ttl);
         register_rpc_handler_with_rpc_holder(
             dsn::apps::RPC_RRDB_RRDB_GET_SCANNER, "get_scanner", on_get_scanner);
-        register_rpc_handler_with_rpc_holder(dsn::apps::RPC_RRDB_RRDB_SCAN, "scan", on_scan);
+        register_async_rpc_handler(dsn::apps::RPC_RRDB_RRDB_SCAN, "scan", on_scan_request);
         register_async_rpc_handler(
             dsn::apps::RPC_RRDB_RRDB_CLEAR_SCANNER, "clear_scanner", on_clear_scanner);
+        register_rpc_handler_with_rpc_holder(
+            dsn::apps::RPC_RRDB_RRDB_AGGREGATE_SCAN, "aggregate_scan", on_aggregate_scan);
+        register_rpc_handler_with_rpc_holder(
+            dsn::apps::RPC_RRDB_RRDB_GET_SPLIT_KEYS, "get_split_keys", on_get_split_keys);
     }
 
 private:
-    static void on_get(pegasus_read_service *svc, get_rpc rpc) { svc->on_get(rpc); }
+    static int on_get_request(pegasus_read_service *svc, dsn::message_ex *request)
+    {
+        auto rpc = get_rpc::auto_reply(request);
+        svc->on_get(rpc);
+        // The response of an async get must not be accessed here since it might be being
+        // filled by another thread.
+        return svc->is_get_async() ? rocksdb::Status::kOk : rpc.response().error;
+    }
     static void on_multi_get(pegasus_read_service *svc, multi_get_rpc rpc)
     {
         svc->on_multi_get(rpc);
@@ -103,11 +129,26 @@ private:
     {
         svc->on_get_scanner(rpc);
     }
-    static void on_scan(pegasus_read_service *svc, scan_rpc rpc) { svc->on_scan(rpc); }
+    static int on_scan_request(pegasus_read_service *svc, dsn::message_ex *request)
+    {
+        auto rpc = scan_rpc::auto_reply(request);
+        svc->on_scan(rpc);
+        // A streaming scan request might be parked and then served by another thread, thus its
+        // response must not be accessed here.
+        return rpc.request().__isset.sequence ? rocksdb::Status::kOk : rpc.response().error;
+    }
     static void on_clear_scanner(pegasus_read_service *svc, const int64_t &args)
     {
         svc->on_clear_scanner(args);
     }
+    static void on_aggregate_scan(pegasus_read_service *svc, aggregate_scan_rpc rpc)
+    {
+        svc->on_aggregate_scan(rpc);
+    }
+    static void on_get_split_keys(pegasus_read_service *svc, get_split_keys_rpc rpc)
+    {
+        svc->on_get_split_keys(rpc);
+    }
 };
 } // namespace server
 } // namespace pegasus
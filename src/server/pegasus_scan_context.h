@@ -19,44 +19,62 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <rocksdb/db.h>
+#include <unordered_map>
+#include <vector>
 #include "runtime/tool_api.h"
 #include "utils/rand.h"
 #include <rrdb/rrdb_types.h>
 
 #include "base/pegasus_utils.h"
+#include "key_filter.h"
+#include "scan_pushdown_filter.h"
 
 namespace pegasus {
 namespace server {
 
+// The iterate_upper_bound of rocksdb::ReadOptions is referenced by the iterator, thus it
+// must outlive the iterator.
+struct scan_upper_bound
+{
+    explicit scan_upper_bound(std::string key_) : key(std::move(key_)), slice(key) {}
+
+    scan_upper_bound(const scan_upper_bound &) = delete;
+    scan_upper_bound &operator=(const scan_upper_bound &) = delete;
+
+    std::string key;
+    rocksdb::Slice slice;
+};
+
 struct pegasus_scan_context
 {
     pegasus_scan_context(std::unique_ptr<rocksdb::Iterator> &&iterator_,
                          const std::string &&stop_,
                          bool stop_inclusive_,
-                         ::dsn::apps::filter_type::type hash_key_filter_type_,
-                         const std::string &&hash_key_filter_pattern_,
-                         ::dsn::apps::filter_type::type sort_key_filter_type_,
-                         const std::string &&sort_key_filter_pattern_,
+                         raw_key_filter &&key_filter_,
+                         scan_pushdown_filter &&pushdown_filter_,
                          int32_t batch_size_,
+                         int32_t max_batch_bytes_,
                          bool no_value_,
                          bool validate_partition_hash_,
                          bool return_expire_ts_,
                          bool only_return_count_)
         : _stop_holder(std::move(stop_)),
-          _hash_key_filter_pattern_holder(std::move(hash_key_filter_pattern_)),
-          _sort_key_filter_pattern_holder(std::move(sort_key_filter_pattern_)),
           iterator(std::move(iterator_)),
           stop(_stop_holder.data(), _stop_holder.size()),
           stop_inclusive(stop_inclusive_),
-          hash_key_filter_type(hash_key_filter_type_),
-          hash_key_filter_pattern(
-              _hash_key_filter_pattern_holder.data(), 0, _hash_key_filter_pattern_holder.length()),
-          sort_key_filter_type(sort_key_filter_type_),
-          sort_key_filter_pattern(
-              _sort_key_filter_pattern_holder.data(), 0, _sort_key_filter_pattern_holder.length()),
+          key_filter(std::move(key_filter_)),
+          pushdown_filter(std::move(pushdown_filter_)),
           batch_size(batch_size_),
+          max_batch_bytes(max_batch_bytes_),
           no_value(no_value_),
           validate_partition_hash(validate_partition_hash_),
           return_expire_ts(return_expire_ts_),
@@ -66,32 +84,48 @@ struct pegasus_scan_context
 
 private:
     std::string _stop_holder;
-    std::string _hash_key_filter_pattern_holder;
-    std::string _sort_key_filter_pattern_holder;
 
 public:
     static const int SCAN_CONTEXT_ID_VALID_MIN = 0;
     static const int SCAN_CONTEXT_ID_COMPLETED = -1;
     static const int SCAN_CONTEXT_ID_NOT_EXIST = -2;
 
+    // Must be declared before `iterator` to be destructed after it.
+    std::unique_ptr<scan_upper_bound> upper_bound;
     std::unique_ptr<rocksdb::Iterator> iterator;
     rocksdb::Slice stop;
     bool stop_inclusive;
-    ::dsn::apps::filter_type::type hash_key_filter_type;
-    dsn::blob hash_key_filter_pattern;
-    ::dsn::apps::filter_type::type sort_key_filter_type;
-    dsn::blob sort_key_filter_pattern;
+    // The hash key and sort key filters, which are compiled only once for the whole scan.
+    raw_key_filter key_filter;
+    // The predicates on value and expire_ts, and the projection.
+    scan_pushdown_filter pushdown_filter;
     int32_t batch_size;
+    // <= 0 means no limit on the total bytes of one batch.
+    int32_t max_batch_bytes;
     bool no_value;
     bool validate_partition_hash;
     bool return_expire_ts;
     bool only_return_count;
+    // Whether the batches are requested by the streaming scan requests, which keep the handle
+    // of the context and must carry `next_sequence` in order.
+    bool stream{false};
+    int64_t next_sequence{1};
 };
 
+// pegasus_context_cache holds the contexts of the unfinished scans between scan requests.
+//
+// The contexts are split into shards by handle to reduce the lock contention. A context is
+// fetched out when it is used and put back with a new handle (or its old handle for a
+// streaming scan), in both cases at the back of its shard, thus the contexts of each shard
+// are ordered by their last access time, with the idle ones always at the front. A context is
+// evicted once it has been idle for a while, or when the total charge exceeds the capacity, in
+// which case the least recently used ones of all the shards are evicted first. The charge of a
+// context is the estimated memory pinned by it, mostly by its rocksdb iterator.
 class pegasus_context_cache
 {
 public:
-    pegasus_context_cache()
+    pegasus_context_cache(uint32_t shard_count, uint64_t capacity_bytes)
+        : _capacity_bytes(capacity_bytes)
     {
         // some comments:
         // 1. we should keep the context id unique when the server restarts, so as to prevent
@@ -104,39 +138,318 @@ public:
         //
         // however, currently the implementation is not 100% correct.
         //
-        _counter = dsn::rand::next_u64(0, 2L << 31);
-        _counter <<= 32;
+        int64_t counter = dsn::rand::next_u64(0, 2L << 31);
+        _counter = counter << 32;
+
+        _shards.reserve(std::max<uint32_t>(shard_count, 1));
+        for (uint32_t i = 0; i < std::max<uint32_t>(shard_count, 1); ++i) {
+            _shards.emplace_back(std::make_unique<shard>());
+        }
     }
 
     void clear()
     {
-        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
-        _map.clear();
+        for (auto &s : _shards) {
+            std::list<entry> evicted;
+            {
+                ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s->lock);
+                while (!s->entries.empty()) {
+                    pop_front(*s, evicted);
+                }
+            }
+            release(evicted);
+        }
     }
 
-    int64_t put(std::unique_ptr<pegasus_scan_context> context)
+    // Return the handle of `context`, and the number of contexts evicted for the capacity by
+    // `evicted_count`.
+    int64_t put(std::unique_ptr<pegasus_scan_context> context,
+                uint64_t charge,
+                uint64_t now_ms,
+                uint64_t &evicted_count)
     {
-        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
-        int64_t handle = _counter++;
-        _map[handle] = std::move(context);
+        const int64_t handle = _counter.fetch_add(1, std::memory_order_relaxed);
+        put_back(handle, std::move(context), charge, now_ms, evicted_count);
         return handle;
     }
 
+    // Put `context` with the `handle` it has been fetched by.
+    void put_back(int64_t handle,
+                  std::unique_ptr<pegasus_scan_context> context,
+                  uint64_t charge,
+                  uint64_t now_ms,
+                  uint64_t &evicted_count)
+    {
+        auto &s = get_shard(handle);
+        {
+            ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+            s.entries.push_back({handle, std::move(context), charge, now_ms});
+            s.index.emplace(handle, std::prev(s.entries.end()));
+        }
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _mem_usage.fetch_add(charge, std::memory_order_relaxed);
+
+        evicted_count = 0;
+        if (_mem_usage.load(std::memory_order_relaxed) > _capacity_bytes) {
+            evicted_count = evict_for_capacity(handle);
+        }
+    }
+
     std::unique_ptr<pegasus_scan_context> fetch(int64_t handle)
     {
-        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(_lock);
-        auto kv = _map.find(handle);
-        if (kv == _map.end())
-            return nullptr;
-        std::unique_ptr<pegasus_scan_context> ret = std::move(kv->second);
-        _map.erase(kv);
+        std::unique_ptr<pegasus_scan_context> ret;
+        auto &s = get_shard(handle);
+        {
+            ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+            auto iter = s.index.find(handle);
+            if (iter == s.index.end()) {
+                return nullptr;
+            }
+            ret = std::move(iter->second->context);
+            on_erase(iter->second->charge);
+            s.entries.erase(iter->second);
+            s.index.erase(iter);
+        }
         return ret;
     }
 
+    // Evict the contexts which have not been accessed since `now_ms - idle_ttl_ms`, return the
+    // number of the evicted contexts.
+    uint64_t evict_idle(uint64_t now_ms, uint64_t idle_ttl_ms)
+    {
+        uint64_t evicted_count = 0;
+        for (auto &s : _shards) {
+            std::list<entry> evicted;
+            {
+                ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s->lock);
+                while (!s->entries.empty() &&
+                       s->entries.front().last_access_ms + idle_ttl_ms <= now_ms) {
+                    pop_front(*s, evicted);
+                }
+            }
+            evicted_count += evicted.size();
+            release(evicted);
+        }
+        return evicted_count;
+    }
+
+    bool contains(int64_t handle)
+    {
+        auto &s = get_shard(handle);
+        ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s.lock);
+        return s.index.find(handle) != s.index.end();
+    }
+
+    uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+
+    uint64_t mem_usage() const { return _mem_usage.load(std::memory_order_relaxed); }
+
+private:
+    struct entry
+    {
+        int64_t handle;
+        std::unique_ptr<pegasus_scan_context> context;
+        uint64_t charge;
+        uint64_t last_access_ms;
+    };
+
+    struct shard
+    {
+        ::dsn::utils::ex_lock_nr_spin lock;
+        // Ordered by the last access time.
+        std::list<entry> entries;
+        std::unordered_map<int64_t, std::list<entry>::iterator> index;
+    };
+
+    shard &get_shard(int64_t handle)
+    {
+        return *_shards[static_cast<uint64_t>(handle) % _shards.size()];
+    }
+
+    void on_erase(uint64_t charge)
+    {
+        _count.fetch_sub(1, std::memory_order_relaxed);
+        _mem_usage.fetch_sub(charge, std::memory_order_relaxed);
+    }
+
+    // Should be called with the lock of `s` held.
+    void pop_front(shard &s, std::list<entry> &evicted)
+    {
+        on_erase(s.entries.front().charge);
+        s.index.erase(s.entries.front().handle);
+        evicted.splice(evicted.end(), s.entries, s.entries.begin());
+    }
+
+    // Release the contexts out of the lock, since destroying the iterators may be expensive.
+    static void release(std::list<entry> &evicted) { evicted.clear(); }
+
+    // Evict the least recently used contexts of the whole cache one by one, until the total
+    // charge is within the capacity. The newly put context `handle` is never evicted.
+    uint64_t evict_for_capacity(int64_t handle)
+    {
+        uint64_t evicted_count = 0;
+        while (mem_usage() > _capacity_bytes) {
+            // The front of each shard is the least recently used one of the shard, thus the
+            // oldest front is the least recently used one of the cache.
+            shard *oldest = nullptr;
+            uint64_t oldest_access_ms = std::numeric_limits<uint64_t>::max();
+            for (auto &s : _shards) {
+                ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(s->lock);
+                if (!s->entries.empty() && s->entries.front().handle != handle &&
+                    s->entries.front().last_access_ms < oldest_access_ms) {
+                    oldest = s.get();
+                    oldest_access_ms = s->entries.front().last_access_ms;
+                }
+            }
+            if (oldest == nullptr) {
+                break;
+            }
+
+            std::list<entry> evicted;
+            {
+                // The front might have been fetched in the meantime, then the next one of the
+                // shard is evicted, which is still among the least recently used ones.
+                ::dsn::utils::auto_lock<::dsn::utils::ex_lock_nr_spin> l(oldest->lock);
+                if (!oldest->entries.empty() && oldest->entries.front().handle != handle) {
+                    pop_front(*oldest, evicted);
+                }
+            }
+            evicted_count += evicted.size();
+            release(evicted);
+        }
+        return evicted_count;
+    }
+
+    const uint64_t _capacity_bytes;
+    std::atomic<int64_t> _counter;
+    std::vector<std::unique_ptr<shard>> _shards;
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _mem_usage{0};
+};
+
+// stream_scan_sequencer serializes the requests of each streaming scan by their sequences.
+//
+// The scan pool is not partitioned, thus the requests in flight of a streaming scan might be
+// picked up by different workers at the same time, or even out of order. A request is admitted
+// only if it holds the next sequence of its scan while no other request of the scan is being
+// served, otherwise it is parked, and handed over to the worker serving its predecessor once
+// that one is done.
+template <typename T>
+class stream_scan_sequencer
+{
+public:
+    // At most so many requests are parked for a scan, the others are admitted at once, and then
+    // break the stream by their unexpected sequences.
+    static constexpr size_t kMaxParkedRequests = 64;
+
+    // Start sequencing the streaming scan of `handle`, whose first request holds sequence 1.
+    void open(int64_t handle)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _scans[handle] = scan_state();
+    }
+
+    enum class admission
+    {
+        // It is the turn of the request, done() must be called once it is served.
+        kServe,
+        // The request is parked, and would be returned by done() once its turn comes.
+        kPark,
+        // The request is unexpected (e.g. its scan is unknown, or its sequence has been served),
+        // serve it at once without the turn, which would find no context or break the stream.
+        kBypass,
+    };
+
+    admission admit(int64_t handle, int64_t sequence, const T &request)
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        auto iter = _scans.find(handle);
+        if (iter == _scans.end()) {
+            return admission::kBypass;
+        }
+
+        auto &scan = iter->second;
+        if (!scan.serving && sequence == scan.next_sequence) {
+            scan.serving = true;
+            return admission::kServe;
+        }
+        if (sequence < scan.next_sequence || scan.parked.size() >= kMaxParkedRequests ||
+            !scan.parked.emplace(sequence, request).second) {
+            return admission::kBypass;
+        }
+        return admission::kPark;
+    }
+
+    // Called once the kServe request of `handle` has been served, `continued` is true if the
+    // scan would be continued by the next sequence. Return the parked requests to be served by
+    // the caller in order: the next one if `continued` and it has arrived, or all of them if the
+    // scan is over, which would find no context.
+    std::vector<T> done(int64_t handle, bool continued)
+    {
+        std::vector<T> requests;
+        std::lock_guard<std::mutex> l(_lock);
+        auto iter = _scans.find(handle);
+        if (iter == _scans.end()) {
+            return requests;
+        }
+
+        auto &scan = iter->second;
+        if (!continued) {
+            for (auto &parked : scan.parked) {
+                requests.emplace_back(std::move(parked.second));
+            }
+            _scans.erase(iter);
+            return requests;
+        }
+
+        ++scan.next_sequence;
+        auto next = scan.parked.find(scan.next_sequence);
+        if (next == scan.parked.end()) {
+            scan.serving = false;
+            return requests;
+        }
+        // Still serving, by the caller on behalf of the parked request.
+        requests.emplace_back(std::move(next->second));
+        scan.parked.erase(next);
+        return requests;
+    }
+
+    // Close the scans which are not being served and satisfy `is_gone` (e.g. whose contexts
+    // have been evicted), return their parked requests, which would find no context.
+    template <typename Pred>
+    std::vector<T> close_if(Pred is_gone)
+    {
+        std::vector<T> requests;
+        std::lock_guard<std::mutex> l(_lock);
+        for (auto iter = _scans.begin(); iter != _scans.end();) {
+            if (iter->second.serving || !is_gone(iter->first)) {
+                ++iter;
+                continue;
+            }
+            for (auto &parked : iter->second.parked) {
+                requests.emplace_back(std::move(parked.second));
+            }
+            iter = _scans.erase(iter);
+        }
+        return requests;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        return _scans.size();
+    }
+
 private:
-    int64_t _counter;
-    std::unordered_map<int64_t, std::unique_ptr<pegasus_scan_context>> _map;
-    ::dsn::utils::ex_lock_nr_spin _lock;
+    struct scan_state
+    {
+        int64_t next_sequence{1};
+        bool serving{false};
+        std::map<int64_t, T> parked;
+    };
+
+    mutable std::mutex _lock;
+    std::unordered_map<int64_t, scan_state> _scans;
 };
 } // namespace server
 } // namespace pegasus
@@ -24,14 +24,17 @@
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
 #include <rocksdb/iterator.h>
+#include <rocksdb/metadata.h>
 #include <rocksdb/rate_limiter.h>
 #include <rocksdb/statistics.h>
 #include <rocksdb/status.h>
 #include <rocksdb/utilities/checkpoint.h>
 #include <rocksdb/utilities/options_util.h>
 #include <rocksdb/write_buffer_manager.h>
+#include <thrift/transport/TTransportException.h>
 #include <unistd.h> // IWYU pragma: keep
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <climits>
 #include <cstdint>
@@ -56,6 +59,7 @@
 #include "common/replication.codes.h"
 #include "common/replication_enums.h"
 #include "consensus_types.h"
+#include "disk_write_controller.h"
 #include "dsn.layer2_types.h"
 #include "hotkey_collector.h"
 #include "pegasus_rpc_types.h"
@@ -63,19 +67,26 @@
 #include "replica_admin_types.h"
 #include "replica/idempotent_writer.h"
 #include "rpc/rpc_message.h"
+#include "rpc/serialization.h"
 #include "rrdb/rrdb.code.definition.h"
 #include "rrdb/rrdb_types.h"
 #include "runtime/api_layer1.h"
+#include "server/blob_arena.h"
 #include "server/key_ttl_compaction_filter.h"
 #include "server/pegasus_manual_compact_service.h"
 #include "server/pegasus_read_service.h"
 #include "server/pegasus_scan_context.h"
 #include "server/range_read_limiter.h"
+#include "server/read_batcher.h"
+#include "server/scan_aggregator.h"
+#include "server/scan_split_keys.h"
 #include "task/async_calls.h"
 #include "task/task_code.h"
 #include "utils/autoref_ptr.h"
+#include "utils/binary_reader.h"
 #include "utils/blob.h"
 #include "utils/defer.h"
+#include "utils/endians.h"
 #include "utils/env.h"
 #include "utils/filesystem.h"
 #include "utils/flags.h"
@@ -110,10 +121,18 @@ DSN_DECLARE_uint32(checkpoint_reserve_min_count);
 DSN_DECLARE_uint32(checkpoint_reserve_time_seconds);
 DSN_DECLARE_uint64(rocksdb_iteration_threshold_time_ms);
 DSN_DECLARE_uint64(rocksdb_slow_query_threshold_ns);
+DSN_DECLARE_bool(rocksdb_batched_get_enabled);
+DSN_DECLARE_uint32(rocksdb_batched_get_max_batch_size);
+DSN_DECLARE_uint64(rocksdb_batched_get_window_us);
+DSN_DECLARE_bool(rocksdb_multi_get_async_io);
+DSN_DECLARE_uint64(scan_context_idle_ttl_seconds);
+DSN_DECLARE_uint32(rocksdb_proactive_flush_watermark_percent);
+DSN_DECLARE_uint64(rocksdb_proactive_flush_check_interval_ms);
 
 namespace pegasus::server {
 
 DEFINE_TASK_CODE(LPC_PEGASUS_SERVER_DELAY, TASK_PRIORITY_COMMON, ::dsn::THREAD_POOL_DEFAULT)
+DEFINE_TASK_CODE(LPC_PEGASUS_BATCHED_GET, TASK_PRIORITY_COMMON, ::dsn::THREAD_POOL_LOCAL_APP)
 
 static std::string chkpt_get_dir_name(int64_t decree)
 {
@@ -355,6 +374,45 @@ int pegasus_server_impl::make_idempotent(dsn::message_ex *request,
     return _server_write->make_idempotent(request, new_requests, idem_writer);
 }
 
+bool pegasus_server_impl::get_write_partition_hashes(dsn::message_ex *request,
+                                                     std::vector<uint64_t> &partition_hashes)
+{
+    if (request->rpc_code() != dsn::apps::RPC_RRDB_RRDB_BATCH_PUT) {
+        return false;
+    }
+
+    // Parse a copy of the body rather than the request itself, whose read cursor should be
+    // kept for the mutation to share its buffer, see mutation::add_client_request().
+    dsn::blob body;
+    if (!request->read_next(body)) {
+        return false;
+    }
+    request->read_commit(0);
+
+    try {
+        dsn::binary_reader reader(body);
+        dsn::apps::batch_put_request batch_put;
+        dsn::unmarshall(
+            reader,
+            batch_put,
+            static_cast<dsn_msg_serialize_format>(request->header->context.u.serialize_format));
+        partition_hashes.clear();
+        partition_hashes.reserve(batch_put.entries.size());
+        for (const auto &entry : batch_put.entries) {
+            partition_hashes.push_back(pegasus_hash_key_hash(entry.hash_key));
+        }
+    } catch (apache::thrift::transport::TTransportException &ex) {
+        // The corrupt request would be ignored while being applied, see
+        // pegasus_server_write::on_batched_writes().
+        LOG_ERROR_PREFIX("parse batch_put request failed: from = {}, exception = {}",
+                         request->header->from_address,
+                         ex.what());
+        return false;
+    }
+
+    return true;
+}
+
 int pegasus_server_impl::on_batched_write_requests(int64_t decree,
                                                    uint64_t timestamp,
                                                    dsn::message_ex **requests,
@@ -428,18 +486,98 @@ void pegasus_server_impl::on_get(get_rpc rpc)
 
     if (dsn_unlikely(FLAGS_inject_read_error_for_test != rocksdb::Status::kOk)) {
         resp.error = FLAGS_inject_read_error_for_test;
+        if (is_get_async()) {
+            report_async_read_error(resp.error);
+        }
         return;
     }
 
     CHECK_READ_THROTTLING();
 
-    METRIC_VAR_AUTO_LATENCY(get_latency_ns);
-
+    const auto start_time_ns = dsn_now_ns();
     const auto &key = rpc.request();
+    uint64_t cache_ticket = 0;
+    if (_hot_row_cache != nullptr && _hot_row_cache->enabled()) {
+        std::string user_value;
+        if (_hot_row_cache->lookup(
+                key.to_string_view(), utils::epoch_now(), user_value, cache_ticket)) {
+            METRIC_VAR_INCREMENT(hot_row_cache_hits);
+            METRIC_VAR_AUTO_LATENCY(get_latency_ns, start_time_ns);
+            resp.error = rocksdb::Status::kOk;
+            resp.value = ::dsn::blob::create_from_bytes(std::move(user_value));
+            _cu_calculator->add_get_cu(rpc.dsn_request(), resp.error, key, resp.value);
+            return;
+        }
+        METRIC_VAR_INCREMENT(hot_row_cache_misses);
+    }
+
+    if (_get_batcher != nullptr) {
+        // The response is sent once the batch holding this request is served.
+        _get_batcher->submit({rpc, start_time_ns, cache_ticket});
+        return;
+    }
+
     rocksdb::Slice skey(key.data(), key.length());
     std::string value;
     rocksdb::Status status = _db->Get(_data_cf_rd_opts, _data_cf, skey, &value);
+    on_get_done(rpc, start_time_ns, cache_ticket, status, std::move(value));
+}
+
+void pegasus_server_impl::on_batched_get(std::vector<pending_get> &batch)
+{
+    std::vector<rocksdb::Slice> keys;
+    keys.reserve(batch.size());
+    for (const auto &get : batch) {
+        keys.emplace_back(get.rpc.request().data(), get.rpc.request().length());
+    }
+
+    std::vector<std::string> values;
+    std::vector<rocksdb::Status> statuses;
+    multi_get(keys, values, statuses);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        on_get_done(batch[i].rpc,
+                    batch[i].start_time_ns,
+                    batch[i].cache_ticket,
+                    statuses[i],
+                    std::move(values[i]));
+    }
+}
 
+void pegasus_server_impl::multi_get(const std::vector<rocksdb::Slice> &keys,
+                                    std::vector<std::string> &values,
+                                    std::vector<rocksdb::Status> &statuses)
+{
+    rocksdb::ReadOptions rd_opts(_data_cf_rd_opts);
+    if (FLAGS_rocksdb_multi_get_async_io) {
+        rd_opts.async_io = true;
+        rd_opts.optimize_multiget_for_io = true;
+    }
+
+    // The batched MultiGet() looks up all the keys level by level together, reading the blocks
+    // from the sst files of a level in parallel if async io is enabled.
+    std::vector<rocksdb::PinnableSlice> pinnable_values(keys.size());
+    statuses.resize(keys.size());
+    _db->MultiGet(
+        rd_opts, _data_cf, keys.size(), keys.data(), pinnable_values.data(), statuses.data());
+
+    values.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (statuses[i].ok()) {
+            values[i].assign(pinnable_values[i].data(), pinnable_values[i].size());
+        }
+    }
+}
+
+void pegasus_server_impl::on_get_done(get_rpc &rpc,
+                                      uint64_t start_time_ns,
+                                      uint64_t cache_ticket,
+                                      rocksdb::Status status,
+                                      std::string &&value)
+{
+    METRIC_VAR_AUTO_LATENCY(get_latency_ns, start_time_ns);
+
+    auto &resp = rpc.response();
+    const auto &key = rpc.request();
     if (status.ok()) {
         if (check_if_record_expired(utils::epoch_now(), value)) {
             METRIC_VAR_INCREMENT(read_expired_values);
@@ -486,8 +624,25 @@ void pegasus_server_impl::on_get(get_rpc rpc)
     }
 
     resp.error = status.code();
+    if (is_get_async() && dsn_unlikely(!status.ok() && !status.IsNotFound())) {
+        // The error could not be returned by on_request() since the response is filled by the
+        // leader of a batch, see pegasus_read_service::on_get_request().
+        report_async_read_error(resp.error);
+    }
     if (status.ok()) {
+        auto expire_ts = pegasus_extract_expire_ts(_pegasus_data_version, value);
         pegasus_extract_user_data(_pegasus_data_version, std::move(value), resp.value);
+        if (cache_ticket != 0) {
+            // The compaction filter may set the expire_ts of a row without ttl to the time it
+            // runs plus the default ttl, which is never earlier than the bound below. Thus the
+            // cached row expires no later than the one in RocksDB.
+            const auto default_ttl = _key_ttl_compaction_filter_factory->GetDefaultTTL();
+            if (expire_ts == 0 && default_ttl != 0) {
+                expire_ts = utils::epoch_now() + default_ttl;
+            }
+            _hot_row_cache->insert(
+                key.to_string_view(), resp.value.to_string_view(), expire_ts, cache_ticket);
+        }
     }
 
     _cu_calculator->add_get_cu(rpc.dsn_request(), resp.error, key, resp.value);
@@ -510,11 +665,15 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
 
     const auto &request = rpc.request();
     dsn::message_ex *req = rpc.dsn_request();
-    if (!is_filter_type_supported(request.sort_key_filter_type)) {
-        LOG_ERROR_PREFIX(
-            "invalid argument for multi_get from {}: sort key filter type {} not supported",
-            rpc.remote_address(),
-            request.sort_key_filter_type);
+    const key_filter sort_key_filter(request.sort_key_filter_type,
+                                     request.sort_key_filter_pattern.to_string_view());
+    if (!sort_key_filter.valid()) {
+        LOG_ERROR_PREFIX("invalid argument for multi_get from {}: sort key filter (type = {}, "
+                         "pattern = \"{}\") not supported",
+                         rpc.remote_address(),
+                         request.sort_key_filter_type,
+                         ::pegasus::utils::c_escape_sensitive_string(
+                             request.sort_key_filter_pattern));
         resp.error = rocksdb::Status::kInvalidArgument;
         _cu_calculator->add_multi_get_cu(req, resp.error, request.hash_key, resp.kvs);
         return;
@@ -608,6 +767,9 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
 
         std::unique_ptr<rocksdb::Iterator> it;
         bool complete = false;
+        // Keys and values of the response are carved from the arena rather than allocated
+        // row by row.
+        blob_arena arena;
 
         std::unique_ptr<range_read_limiter> limiter =
             std::make_unique<range_read_limiter>(max_iteration_count,
@@ -641,10 +803,10 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
 
                 // extract value
                 auto state = append_key_value_for_multi_get(resp.kvs,
+                                                            arena,
                                                             it->key(),
                                                             it->value(),
-                                                            request.sort_key_filter_type,
-                                                            request.sort_key_filter_pattern,
+                                                            sort_key_filter,
                                                             epoch_now,
                                                             request.no_value);
 
@@ -713,10 +875,10 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
 
                 // extract value
                 auto state = append_key_value_for_multi_get(reverse_kvs,
+                                                            arena,
                                                             it->key(),
                                                             it->value(),
-                                                            request.sort_key_filter_type,
-                                                            request.sort_key_filter_pattern,
+                                                            sort_key_filter,
                                                             epoch_now,
                                                             request.no_value);
                 switch (state) {
@@ -801,7 +963,8 @@ void pegasus_server_impl::on_multi_get(multi_get_rpc rpc)
             keys_holder.emplace_back(std::move(raw_key));
         }
 
-        std::vector<rocksdb::Status> statuses = _db->MultiGet(_data_cf_rd_opts, keys, &values);
+        std::vector<rocksdb::Status> statuses;
+        multi_get(keys, values, statuses);
         for (int i = 0; i < keys.size(); i++) {
             rocksdb::Status &status = statuses[i];
             std::string &value = values[i];
@@ -945,7 +1108,8 @@ void pegasus_server_impl::on_batch_get(batch_get_rpc rpc)
     uint64_t expire_count = 0;
 
     std::vector<std::string> values;
-    std::vector<rocksdb::Status> statuses = _db->MultiGet(_data_cf_rd_opts, keys, &values);
+    std::vector<rocksdb::Status> statuses;
+    multi_get(keys, values, statuses);
     response.data.reserve(request.keys.size());
     for (int i = 0; i < keys.size(); i++) {
         const auto &status = statuses[i];
@@ -1165,26 +1329,54 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
 
     const auto &request = rpc.request();
     dsn::message_ex *req = rpc.dsn_request();
-    if (!is_filter_type_supported(request.hash_key_filter_type)) {
-        LOG_ERROR_PREFIX(
-            "invalid argument for get_scanner from {}: hash key filter type {} not supported",
-            rpc.remote_address(),
-            request.hash_key_filter_type);
+    raw_key_filter scan_key_filter(request.hash_key_filter_type,
+                                   request.hash_key_filter_pattern.to_string_view(),
+                                   request.sort_key_filter_type,
+                                   request.sort_key_filter_pattern.to_string_view());
+    if (!scan_key_filter.hash_key_filter().valid()) {
+        LOG_ERROR_PREFIX("invalid argument for get_scanner from {}: hash key filter (type = {}, "
+                         "pattern = \"{}\") not supported",
+                         rpc.remote_address(),
+                         request.hash_key_filter_type,
+                         ::pegasus::utils::c_escape_sensitive_string(
+                             request.hash_key_filter_pattern));
         resp.error = rocksdb::Status::kInvalidArgument;
         _cu_calculator->add_scan_cu(req, resp.error, resp.kvs);
         return;
     }
 
-    if (!is_filter_type_supported(request.sort_key_filter_type)) {
-        LOG_ERROR_PREFIX(
-            "invalid argument for get_scanner from {}: sort key filter type {} not supported",
-            rpc.remote_address(),
-            request.sort_key_filter_type);
+    if (!scan_key_filter.sort_key_filter().valid()) {
+        LOG_ERROR_PREFIX("invalid argument for get_scanner from {}: sort key filter (type = {}, "
+                         "pattern = \"{}\") not supported",
+                         rpc.remote_address(),
+                         request.sort_key_filter_type,
+                         ::pegasus::utils::c_escape_sensitive_string(
+                             request.sort_key_filter_pattern));
         resp.error = rocksdb::Status::kInvalidArgument;
         _cu_calculator->add_scan_cu(req, resp.error, resp.kvs);
         return;
     }
 
+    scan_pushdown_filter pushdown_filter;
+    if (request.__isset.pushdown) {
+        pushdown_filter = scan_pushdown_filter(request.pushdown);
+        if (!pushdown_filter.valid()) {
+            LOG_ERROR_PREFIX("invalid argument for get_scanner from {}: scan pushdown (value "
+                             "filter type = {}, value filter pattern = \"{}\", projection = {}, "
+                             "min expire ts = {}, max expire ts = {}) not supported",
+                             rpc.remote_address(),
+                             request.pushdown.value_filter_type,
+                             ::pegasus::utils::c_escape_sensitive_string(
+                                 request.pushdown.value_filter_pattern),
+                             request.pushdown.projection,
+                             request.pushdown.min_expire_ts_seconds,
+                             request.pushdown.max_expire_ts_seconds);
+            resp.error = rocksdb::Status::kInvalidArgument;
+            _cu_calculator->add_scan_cu(req, resp.error, resp.kvs);
+            return;
+        }
+    }
+
     rocksdb::ReadOptions rd_opts(_data_cf_rd_opts);
     if (_data_cf_opts.prefix_extractor) {
         ::dsn::blob start_hash_key, tmp;
@@ -1196,6 +1388,18 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
             rd_opts.prefix_same_as_start = false;
         }
     }
+    // A sub-range split by get_split_keys may span many hash keys, and the iterator is bounded
+    // by it, so that it never reads the data (including the tombstones) of the other
+    // sub-ranges.
+    std::unique_ptr<scan_upper_bound> upper_bound;
+    if (request.__isset.sub_range && request.sub_range) {
+        rd_opts.total_order_seek = true;
+        rd_opts.prefix_same_as_start = false;
+        if (!request.stop_inclusive) {
+            upper_bound = std::make_unique<scan_upper_bound>(request.stop_key.to_string());
+            rd_opts.iterate_upper_bound = &upper_bound->slice;
+        }
+    }
     bool start_inclusive = request.start_inclusive;
     bool stop_inclusive = request.stop_inclusive;
     rocksdb::Slice start(request.start_key.data(), request.start_key.length());
@@ -1254,16 +1458,22 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
         batch_count = request.batch_size;
     }
     resp.kvs.reserve(batch_count);
+    blob_arena arena;
 
     bool return_expire_ts = request.__isset.return_expire_ts ? request.return_expire_ts : false;
     bool only_return_count = request.__isset.only_return_count ? request.only_return_count : false;
+    bool no_value = request.no_value || pushdown_filter.no_value();
+    bool return_value_length = pushdown_filter.return_value_length();
+    int32_t max_batch_bytes = request.__isset.max_batch_bytes ? request.max_batch_bytes : 0;
+    int64_t batch_bytes = 0;
 
     std::unique_ptr<range_read_limiter> limiter =
         std::make_unique<range_read_limiter>(_rng_rd_opts.rocksdb_max_iteration_count,
                                              0,
                                              _rng_rd_opts.rocksdb_iteration_threshold_time_ms);
 
-    while (count < batch_count && limiter->valid() && it->Valid()) {
+    while (count < batch_count && (max_batch_bytes <= 0 || batch_bytes < max_batch_bytes) &&
+           limiter->valid() && it->Valid()) {
         int c = it->key().compare(stop);
         if (c > 0 || (c == 0 && !stop_inclusive)) {
             // out of range
@@ -1285,10 +1495,8 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
         auto state = validate_key_value_for_scan(
             it->key(),
             it->value(),
-            request.hash_key_filter_type,
-            request.hash_key_filter_pattern,
-            request.sort_key_filter_type,
-            request.sort_key_filter_pattern,
+            scan_key_filter,
+            pushdown_filter,
             epoch_now,
             request.__isset.validate_partition_hash ? request.validate_partition_hash : true);
 
@@ -1296,8 +1504,14 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
         case range_iteration_state::kNormal:
             count++;
             if (!only_return_count) {
-                append_key_value(
-                    resp.kvs, it->key(), it->value(), request.no_value, return_expire_ts);
+                append_key_value(resp.kvs,
+                                 arena,
+                                 it->key(),
+                                 it->value(),
+                                 no_value,
+                                 return_expire_ts,
+                                 return_value_length);
+                batch_bytes += resp.kvs.back().key.length() + resp.kvs.back().value.length();
             }
             break;
         case range_iteration_state::kExpired:
@@ -1363,28 +1577,25 @@ void pegasus_server_impl::on_get_scanner(get_scanner_rpc rpc)
             std::move(it),
             std::string(stop.data(), stop.size()),
             request.stop_inclusive,
-            request.hash_key_filter_type,
-            std::string(request.hash_key_filter_pattern.data(),
-                        request.hash_key_filter_pattern.length()),
-            request.sort_key_filter_type,
-            std::string(request.sort_key_filter_pattern.data(),
-                        request.sort_key_filter_pattern.length()),
+            std::move(scan_key_filter),
+            std::move(pushdown_filter),
             batch_count,
-            request.no_value,
+            max_batch_bytes,
+            no_value,
             request.__isset.validate_partition_hash ? request.validate_partition_hash : true,
             return_expire_ts,
             only_return_count));
-        int64_t handle = _context_cache.put(std::move(context));
-        resp.context_id = handle;
-        // if the context is used, it will be fetched and re-put into cache,
-        // which will change the handle,
-        // then the delayed task will fetch null context by old handle, and do nothing.
-        ::dsn::tasking::enqueue(
-            LPC_PEGASUS_SERVER_DELAY,
-            &_tracker,
-            [this, handle]() { _context_cache.fetch(handle); },
-            0,
-            std::chrono::minutes(5));
+        context->upper_bound = std::move(upper_bound);
+        // Counting only returns a single batch, thus never streams.
+        const bool stream = request.__isset.stream && request.stream && !only_return_count;
+        if (stream) {
+            context->stream = true;
+            resp.__set_stream(true);
+        }
+        resp.context_id = put_scan_context(std::move(context));
+        if (stream) {
+            _stream_scans.open(resp.context_id);
+        }
     } else {
         // scan completed
         resp.context_id = pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED;
@@ -1409,20 +1620,80 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
 
     CHECK_READ_THROTTLING();
 
+    const auto &request = rpc.request();
+    if (!request.__isset.sequence) {
+        scan(rpc);
+        return;
+    }
+
+    // The requests of a streaming scan are served one by one in the order of their sequences.
+    switch (_stream_scans.admit(request.context_id, request.sequence, rpc)) {
+    case stream_scan_sequencer<scan_rpc>::admission::kPark:
+        return;
+    case stream_scan_sequencer<scan_rpc>::admission::kBypass:
+        scan(rpc);
+        return;
+    case stream_scan_sequencer<scan_rpc>::admission::kServe:
+        break;
+    }
+
+    scan_rpc current = rpc;
+    while (true) {
+        scan(current);
+        const auto &current_resp = current.response();
+        if (dsn_unlikely(current_resp.error != rocksdb::Status::kOk &&
+                         current_resp.error != rocksdb::Status::kNotFound)) {
+            // The error could not be returned by on_request(), see
+            // pegasus_read_service::on_scan_request().
+            report_async_read_error(current_resp.error);
+        }
+
+        const bool continued = current_resp.context_id == request.context_id;
+        auto following = _stream_scans.done(request.context_id, continued);
+        if (!continued) {
+            // The scan is over, the parked requests find no context.
+            for (auto &r : following) {
+                scan(r);
+            }
+            return;
+        }
+        if (following.empty()) {
+            return;
+        }
+        current = std::move(following.front());
+    }
+}
+
+void pegasus_server_impl::scan(scan_rpc &rpc)
+{
     METRIC_VAR_AUTO_LATENCY(scan_latency_ns);
 
+    auto &resp = rpc.response();
     const auto &request = rpc.request();
     dsn::message_ex *req = rpc.dsn_request();
     std::unique_ptr<pegasus_scan_context> context = _context_cache.fetch(request.context_id);
+    if (context && context->stream &&
+        (!request.__isset.sequence || request.sequence != context->next_sequence)) {
+        // The batches of a streaming scan are requested in order, a lost or reordered request
+        // breaks the stream, thus drop the context to let the client restart the scan.
+        LOG_WARNING_PREFIX("unexpected sequence of streaming scan from {}: context_id = {}, "
+                           "sequence = {}, expected_sequence = {}",
+                           rpc.remote_address(),
+                           request.context_id,
+                           request.__isset.sequence ? request.sequence : -1,
+                           context->next_sequence);
+        context.reset();
+    }
     if (context) {
         rocksdb::Iterator *it = context->iterator.get();
         const rocksdb::Slice &stop = context->stop;
         bool stop_inclusive = context->stop_inclusive;
-        ::dsn::apps::filter_type::type hash_key_filter_type = context->hash_key_filter_type;
-        const ::dsn::blob &hash_key_filter_pattern = context->hash_key_filter_pattern;
-        ::dsn::apps::filter_type::type sort_key_filter_type = context->sort_key_filter_type;
-        const ::dsn::blob &sort_key_filter_pattern = context->sort_key_filter_pattern;
+        const raw_key_filter &scan_key_filter = context->key_filter;
+        const scan_pushdown_filter &pushdown_filter = context->pushdown_filter;
         bool no_value = context->no_value;
+        bool return_value_length = pushdown_filter.return_value_length();
+        int32_t max_batch_bytes = context->max_batch_bytes;
+        int64_t batch_bytes = 0;
         bool validate_hash = context->validate_partition_hash;
         bool return_expire_ts = context->return_expire_ts;
         bool complete = false;
@@ -1438,8 +1709,11 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
 
         std::unique_ptr<range_read_limiter> limiter = std::make_unique<range_read_limiter>(
             batch_count, 0, _rng_rd_opts.rocksdb_iteration_threshold_time_ms);
+        blob_arena arena;
 
-        while (count < batch_count && limiter->valid() && it->Valid()) {
+        while (count < batch_count &&
+               (max_batch_bytes <= 0 || batch_bytes < max_batch_bytes) && limiter->valid() &&
+               it->Valid()) {
             int c = it->key().compare(stop);
             if (c > 0 || (c == 0 && !stop_inclusive)) {
                 // out of range
@@ -1449,20 +1723,21 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
 
             limiter->add_count();
 
-            auto state = validate_key_value_for_scan(it->key(),
-                                                     it->value(),
-                                                     hash_key_filter_type,
-                                                     hash_key_filter_pattern,
-                                                     sort_key_filter_type,
-                                                     sort_key_filter_pattern,
-                                                     epoch_now,
-                                                     validate_hash);
+            auto state = validate_key_value_for_scan(
+                it->key(), it->value(), scan_key_filter, pushdown_filter, epoch_now, validate_hash);
 
             switch (state) {
             case range_iteration_state::kNormal:
                 count++;
                 if (!context->only_return_count) {
-                    append_key_value(resp.kvs, it->key(), it->value(), no_value, return_expire_ts);
+                    append_key_value(resp.kvs,
+                                     arena,
+                                     it->key(),
+                                     it->value(),
+                                     no_value,
+                                     return_expire_ts,
+                                     return_value_length);
+                    batch_bytes += resp.kvs.back().key.length() + resp.kvs.back().value.length();
                 }
                 break;
             case range_iteration_state::kExpired:
@@ -1523,14 +1798,13 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
                                limiter->max_duration_time());
         } else if (it->Valid() && !complete) {
             // scan not completed
-            int64_t handle = _context_cache.put(std::move(context));
-            resp.context_id = handle;
-            ::dsn::tasking::enqueue(
-                LPC_PEGASUS_SERVER_DELAY,
-                &_tracker,
-                [this, handle]() { _context_cache.fetch(handle); },
-                0,
-                std::chrono::minutes(5));
+            if (context->stream) {
+                // The following batches have been requested by the same handle.
+                ++context->next_sequence;
+                resp.context_id = put_scan_context(std::move(context), request.context_id);
+            } else {
+                resp.context_id = put_scan_context(std::move(context));
+            }
         } else {
             // scan completed
             resp.context_id = pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED;
@@ -1548,6 +1822,271 @@ void pegasus_server_impl::on_scan(scan_rpc rpc)
 
 void pegasus_server_impl::on_clear_scanner(const int64_t &args) { _context_cache.fetch(args); }
 
+int64_t pegasus_server_impl::put_scan_context(std::unique_ptr<pegasus_scan_context> context,
+                                              int64_t handle)
+{
+    // Besides the context itself, the iterator pins about a data block for each level.
+    const uint64_t charge = sizeof(pegasus_scan_context) + context->stop.size() +
+                            _tbl_opts.block_size * (_data_cf_opts.num_levels + 1);
+    uint64_t evicted_count = 0;
+    // If the context is used, it will be fetched and re-put into cache, thus the last access
+    // time of the context is always the time it is put.
+    if (handle >= pegasus_scan_context::SCAN_CONTEXT_ID_VALID_MIN) {
+        _context_cache.put_back(handle, std::move(context), charge, dsn_now_ms(), evicted_count);
+    } else {
+        handle = _context_cache.put(std::move(context), charge, dsn_now_ms(), evicted_count);
+    }
+    METRIC_VAR_INCREMENT_BY(evicted_scan_contexts, evicted_count);
+    return handle;
+}
+
+void pegasus_server_impl::evict_idle_scan_contexts()
+{
+    const auto evicted_count = _context_cache.evict_idle(
+        dsn_now_ms(), FLAGS_scan_context_idle_ttl_seconds * 1000);
+    METRIC_VAR_INCREMENT_BY(evicted_scan_contexts, evicted_count);
+
+    // The requests parked for the streaming scans whose contexts are gone (e.g. their
+    // predecessors have been lost) would never be admitted, fail them.
+    auto orphans =
+        _stream_scans.close_if([this](int64_t handle) { return !_context_cache.contains(handle); });
+    for (auto &rpc : orphans) {
+        scan(rpc);
+    }
+    METRIC_VAR_SET(scan_contexts, _context_cache.count());
+    METRIC_VAR_SET(scan_context_mem_usage_bytes, _context_cache.mem_usage());
+}
+
+void pegasus_server_impl::on_aggregate_scan(aggregate_scan_rpc rpc)
+{
+    CHECK_TRUE(_is_open);
+
+    METRIC_VAR_INCREMENT(scan_requests);
+
+    auto &resp = rpc.response();
+    resp.app_id = _gpid.get_app_id();
+    resp.partition_index = _gpid.get_partition_index();
+    resp.server = _primary_host_port;
+
+    CHECK_READ_THROTTLING();
+
+    METRIC_VAR_AUTO_LATENCY(scan_latency_ns);
+
+    const auto &request = rpc.request();
+    dsn::message_ex *req = rpc.dsn_request();
+
+    raw_key_filter scan_key_filter(request.hash_key_filter_type,
+                                   request.hash_key_filter_pattern.to_string_view(),
+                                   request.sort_key_filter_type,
+                                   request.sort_key_filter_pattern.to_string_view());
+    scan_pushdown_filter pushdown_filter;
+    if (request.__isset.pushdown) {
+        pushdown_filter = scan_pushdown_filter(request.pushdown);
+    }
+    std::string hint;
+    if (!scan_key_filter.valid() || !pushdown_filter.valid() ||
+        !scan_aggregator::validate_request(request, hint)) {
+        LOG_ERROR_PREFIX("invalid argument for aggregate_scan from {}: key filter valid = {}, "
+                         "pushdown valid = {}, hint = {}",
+                         rpc.remote_address(),
+                         scan_key_filter.valid(),
+                         pushdown_filter.valid(),
+                         hint);
+        resp.error = rocksdb::Status::kInvalidArgument;
+        _cu_calculator->add_aggregate_scan_cu(req, resp.error, 0);
+        return;
+    }
+
+    rocksdb::ReadOptions rd_opts(_data_cf_rd_opts);
+    if (_data_cf_opts.prefix_extractor) {
+        ::dsn::blob start_hash_key, tmp;
+        pegasus_restore_key(request.start_key, start_hash_key, tmp);
+        if (start_hash_key.size() == 0 || request.full_scan) {
+            rd_opts.total_order_seek = true;
+            rd_opts.prefix_same_as_start = false;
+        }
+    }
+    // Aggregation touches every row of the range, do not pollute the block cache.
+    rd_opts.fill_cache = false;
+
+    rocksdb::Slice start(request.start_key.data(), request.start_key.length());
+    rocksdb::Slice stop(request.stop_key.data(), request.stop_key.length());
+    const bool validate_hash =
+        request.__isset.validate_partition_hash ? request.validate_partition_hash : true;
+    const uint32_t epoch_now = ::pegasus::utils::epoch_now();
+    scan_aggregator aggregator(request, epoch_now);
+    uint64_t expire_count = 0;
+    uint64_t filter_count = 0;
+    int64_t read_bytes = 0;
+    bool complete = false;
+
+    std::unique_ptr<rocksdb::Iterator> it(_db->NewIterator(rd_opts, _data_cf));
+    it->Seek(start);
+    if (!request.start_inclusive && it->Valid() && it->key().compare(start) == 0) {
+        it->Next();
+    }
+
+    // Unlike the other scans, reaching the limits is not an error here, the partial result
+    // is returned and the client continues from `next_start_key`.
+    range_read_limiter limiter(_rng_rd_opts.aggregate_scan_max_iteration_count,
+                               0,
+                               _rng_rd_opts.aggregate_scan_iteration_threshold_time_ms);
+    while (limiter.valid() && it->Valid()) {
+        int c = it->key().compare(stop);
+        if (c > 0 || (c == 0 && !request.stop_inclusive)) {
+            complete = true;
+            break;
+        }
+
+        limiter.add_count();
+        read_bytes += it->key().size() + it->value().size();
+
+        auto state = validate_key_value_for_scan(
+            it->key(), it->value(), scan_key_filter, pushdown_filter, epoch_now, validate_hash);
+        switch (state) {
+        case range_iteration_state::kNormal: {
+            // hash_key_len is in big endian
+            const auto raw_value = utils::to_string_view(it->value());
+            const uint16_t hash_key_len =
+                ::dsn::endian::ntoh(*reinterpret_cast<const uint16_t *>(it->key().data()));
+            if (!aggregator.add(
+                    std::string_view(it->key().data() + 2, hash_key_len),
+                    it->key().size() - 2,
+                    pegasus_extract_user_data_view(_pegasus_data_version, raw_value).size(),
+                    pegasus_extract_expire_ts(_pegasus_data_version, raw_value))) {
+                expire_count++;
+            }
+            break;
+        }
+        case range_iteration_state::kExpired:
+            expire_count++;
+            break;
+        case range_iteration_state::kFiltered:
+            filter_count++;
+            break;
+        default:
+            break;
+        }
+
+        it->Next();
+    }
+    if (!it->Valid() && it->status().ok()) {
+        complete = true;
+    }
+
+    resp.error = it->status().code();
+    if (!it->status().ok()) {
+        LOG_ERROR_PREFIX("rocksdb scan failed for aggregate_scan from {}: error = {}",
+                         rpc.remote_address(),
+                         it->status().ToString());
+    } else {
+        aggregator.finish(complete, resp);
+        resp.complete = complete;
+        if (!complete) {
+            resp.next_start_key =
+                ::dsn::blob::create_from_bytes(it->key().data(), it->key().size());
+        }
+        resp.expire_count = expire_count;
+        resp.filter_count = filter_count;
+    }
+
+    METRIC_VAR_INCREMENT_BY(read_expired_values, expire_count);
+    METRIC_VAR_INCREMENT_BY(read_filtered_values, filter_count);
+
+    _cu_calculator->add_aggregate_scan_cu(req, resp.error, read_bytes);
+}
+
+void pegasus_server_impl::on_get_split_keys(get_split_keys_rpc rpc)
+{
+    CHECK_TRUE(_is_open);
+
+    auto &resp = rpc.response();
+    resp.app_id = _gpid.get_app_id();
+    resp.partition_index = _gpid.get_partition_index();
+    resp.server = _primary_host_port;
+
+    CHECK_READ_THROTTLING();
+
+    const auto &request = rpc.request();
+    if (request.split_count <= 0) {
+        LOG_ERROR_PREFIX("invalid argument for get_split_keys from {}: split_count = {}",
+                         rpc.remote_address(),
+                         request.split_count);
+        resp.error = rocksdb::Status::kInvalidArgument;
+        return;
+    }
+
+    resp.error = rocksdb::Status::kOk;
+    if (request.split_count == 1) {
+        return;
+    }
+
+    const std::string start(request.start_key.data(), request.start_key.length());
+    const std::string stop(request.stop_key.data(), request.stop_key.length());
+
+    // The boundaries of the sst files are the candidates of the split keys, since they are
+    // cheap to get and spread over the range roughly in proportion to the data.
+    rocksdb::ColumnFamilyMetaData cf_meta;
+    _db->GetColumnFamilyMetaData(_data_cf, &cf_meta);
+    std::vector<std::string> keys;
+    for (const auto &level : cf_meta.levels) {
+        for (const auto &file : level.files) {
+            for (const auto *key : {&file.smallestkey, &file.largestkey}) {
+                if (*key > start && *key < stop) {
+                    keys.push_back(*key);
+                }
+            }
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    // Limit the count of ranges passed to GetApproximateSizes().
+    static const size_t kMaxCandidateCount = 1024;
+    if (keys.size() > kMaxCandidateCount) {
+        std::vector<std::string> sampled;
+        sampled.reserve(kMaxCandidateCount);
+        for (size_t i = 0; i < kMaxCandidateCount; ++i) {
+            sampled.push_back(std::move(keys[i * keys.size() / kMaxCandidateCount]));
+        }
+        keys = std::move(sampled);
+    }
+
+    // The last range is the whole [start, stop), for the total size.
+    std::vector<rocksdb::Range> ranges;
+    ranges.reserve(keys.size() + 1);
+    for (const auto &key : keys) {
+        ranges.emplace_back(start, key);
+    }
+    ranges.emplace_back(start, stop);
+    std::vector<uint64_t> sizes(ranges.size(), 0);
+    rocksdb::SizeApproximationOptions size_opts;
+    size_opts.include_memtables = true;
+    size_opts.include_files = true;
+    auto s = _db->GetApproximateSizes(
+        size_opts, _data_cf, ranges.data(), static_cast<int>(ranges.size()), sizes.data());
+    if (!s.ok()) {
+        LOG_ERROR_PREFIX("get approximate sizes failed for get_split_keys from {}: error = {}",
+                         rpc.remote_address(),
+                         s.ToString());
+        resp.error = s.code();
+        return;
+    }
+
+    std::vector<split_key_candidate> candidates;
+    candidates.reserve(keys.size());
+    uint64_t size_before = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        // The approximate sizes are not guaranteed to be monotonic.
+        size_before = std::max(size_before, sizes[i]);
+        candidates.push_back({std::move(keys[i]), size_before});
+    }
+
+    for (auto &key : select_split_keys(candidates, sizes.back(), request.split_count)) {
+        resp.split_keys.emplace_back(::dsn::blob::create_from_bytes(std::move(key)));
+    }
+}
+
 dsn::error_code pegasus_server_impl::start(int argc, char **argv)
 {
     CHECK_PREFIX_MSG(!_is_open, "replica is already opened");
@@ -1742,9 +2281,18 @@ dsn::error_code pegasus_server_impl::start(int argc, char **argv)
     _data_cf = handles_opened[0];
     _meta_cf = handles_opened[1];
 
+    // Never serve the rows cached before the db is opened.
+    if (_hot_row_cache != nullptr) {
+        _hot_row_cache->invalidate_all();
+    }
+
     // Create _meta_store which provide Pegasus meta data read and write.
     _meta_store = std::make_unique<meta_store>(replica_name(), _db, _meta_cf);
 
+    if (_disk_write_controller != nullptr) {
+        _disk_write_controller->add_db(_db, {_data_cf, _meta_cf});
+    }
+
     if (db_exist) {
         auto cleanup = dsn::defer([this]() { release_db(); });
         uint64_t decree = 0;
@@ -1806,6 +2354,21 @@ dsn::error_code pegasus_server_impl::start(int argc, char **argv)
                     _pegasus_data_version,
                     last_durable_decree());
 
+    if (FLAGS_rocksdb_batched_get_enabled) {
+        _get_batcher = std::make_unique<read_batcher<pending_get>>(
+            FLAGS_rocksdb_batched_get_max_batch_size,
+            std::chrono::microseconds(FLAGS_rocksdb_batched_get_window_us),
+            [this](std::vector<pending_get> &batch) { on_batched_get(batch); },
+            [this](std::chrono::microseconds delay) {
+                // The delay of a task is in milliseconds, thus the window is rounded up.
+                ::dsn::tasking::enqueue(LPC_PEGASUS_BATCHED_GET,
+                                        &_tracker,
+                                        [this]() { _get_batcher->drain(); },
+                                        0,
+                                        std::chrono::ceil<std::chrono::milliseconds>(delay));
+            });
+    }
+
     _is_open = true;
 
     if (!db_exist) {
@@ -1820,6 +2383,19 @@ dsn::error_code pegasus_server_impl::start(int argc, char **argv)
         [this]() { this->update_replica_rocksdb_statistics(); },
         std::chrono::seconds(FLAGS_update_rdb_stat_interval));
 
+    // A single timer for all the scan contexts of this replica, rather than one delayed task for
+    // each put of a context.
+    dsn::tasking::enqueue_timer(
+        LPC_PEGASUS_SERVER_DELAY,
+        &_tracker,
+        [this]() { evict_idle_scan_contexts(); },
+        std::chrono::seconds(std::max<uint64_t>(FLAGS_scan_context_idle_ttl_seconds / 10, 1)));
+
+    if (_disk_write_controller != nullptr) {
+        _last_stall_micros = _statistics->getTickerCount(rocksdb::STALL_MICROS);
+        schedule_check_disk_write_buffer();
+    }
+
     // These counters are singletons on this server shared by all replicas, their metrics update
     // task should be scheduled once an interval on the server view.
     static std::once_flag flag;
@@ -1881,6 +2457,11 @@ void pegasus_server_impl::cancel_background_work(bool wait)
 
     cancel_background_work(true);
 
+    // Serve the pending get requests before the db is released.
+    if (_get_batcher != nullptr) {
+        _get_batcher->stop();
+    }
+
     // stop all tracked tasks when pegasus server is stopped.
     if (_update_replica_rdb_stat != nullptr) {
         _update_replica_rdb_stat->cancel(true);
@@ -1890,6 +2471,9 @@ void pegasus_server_impl::cancel_background_work(bool wait)
     _tracker.cancel_outstanding_tasks();
 
     _context_cache.clear();
+    for (auto &rpc : _stream_scans.close_if([](int64_t) { return true; })) {
+        scan(rpc);
+    }
 
     _is_open = false;
     release_db();
@@ -2346,48 +2930,13 @@ int64_t pegasus_server_impl::last_flushed_decree() const
     return static_cast<int64_t>(decree);
 }
 
-// TODO(wangdan): consider using dsn::utils::pattern_match().
-bool pegasus_server_impl::validate_filter(::dsn::apps::filter_type::type filter_type,
-                                          const ::dsn::blob &filter_pattern,
-                                          const ::dsn::blob &value)
-{
-    switch (filter_type) {
-    case ::dsn::apps::filter_type::FT_NO_FILTER:
-        return true;
-    case ::dsn::apps::filter_type::FT_MATCH_ANYWHERE:
-    case ::dsn::apps::filter_type::FT_MATCH_PREFIX:
-    case ::dsn::apps::filter_type::FT_MATCH_POSTFIX: {
-        if (filter_pattern.length() == 0)
-            return true;
-        if (value.length() < filter_pattern.length())
-            return false;
-        if (filter_type == ::dsn::apps::filter_type::FT_MATCH_ANYWHERE) {
-            return value.to_string_view().find(filter_pattern.to_string_view()) !=
-                   std::string_view::npos;
-        } else if (filter_type == ::dsn::apps::filter_type::FT_MATCH_PREFIX) {
-            return dsn::utils::mequals(
-                value.data(), filter_pattern.data(), filter_pattern.length());
-        } else { // filter_type == ::dsn::apps::filter_type::FT_MATCH_POSTFIX
-            return dsn::utils::mequals(value.data() + value.length() - filter_pattern.length(),
-                                       filter_pattern.data(),
-                                       filter_pattern.length());
-        }
-    }
-    default:
-        CHECK(false, "unsupported filter type: {}", filter_type);
-    }
-    return false;
-}
-
-range_iteration_state pegasus_server_impl::validate_key_value_for_scan(
-    const rocksdb::Slice &key,
-    const rocksdb::Slice &value,
-    ::dsn::apps::filter_type::type hash_key_filter_type,
-    const ::dsn::blob &hash_key_filter_pattern,
-    ::dsn::apps::filter_type::type sort_key_filter_type,
-    const ::dsn::blob &sort_key_filter_pattern,
-    uint32_t epoch_now,
-    bool request_validate_hash)
+range_iteration_state
+pegasus_server_impl::validate_key_value_for_scan(const rocksdb::Slice &key,
+                                                 const rocksdb::Slice &value,
+                                                 const raw_key_filter &scan_key_filter,
+                                                 const scan_pushdown_filter &pushdown_filter,
+                                                 uint32_t epoch_now,
+                                                 bool request_validate_hash)
 {
     if (check_if_record_expired(epoch_now, value)) {
         if (FLAGS_rocksdb_verbose_log) {
@@ -2406,23 +2955,31 @@ range_iteration_state pegasus_server_impl::validate_key_value_for_scan(
         }
     }
 
-    // extract raw key
-    ::dsn::blob raw_key(key.data(), 0, key.size());
-    if (hash_key_filter_type != ::dsn::apps::filter_type::FT_NO_FILTER ||
-        sort_key_filter_type != ::dsn::apps::filter_type::FT_NO_FILTER) {
-        ::dsn::blob hash_key, sort_key;
-        pegasus_restore_key(raw_key, hash_key, sort_key);
-        if (hash_key_filter_type != ::dsn::apps::filter_type::FT_NO_FILTER &&
-            !validate_filter(hash_key_filter_type, hash_key_filter_pattern, hash_key)) {
-            if (FLAGS_rocksdb_verbose_log) {
-                LOG_ERROR_PREFIX("hash key filtered for scan");
-            }
-            return range_iteration_state::kFiltered;
+    // The filters are applied on the raw key directly, without restoring it.
+    switch (scan_key_filter.match(key)) {
+    case raw_key_filter::result::kHashKeyFiltered:
+        if (FLAGS_rocksdb_verbose_log) {
+            LOG_ERROR_PREFIX("hash key filtered for scan");
+        }
+        return range_iteration_state::kFiltered;
+    case raw_key_filter::result::kSortKeyFiltered:
+        if (FLAGS_rocksdb_verbose_log) {
+            LOG_ERROR_PREFIX("sort key filtered for scan");
         }
-        if (sort_key_filter_type != ::dsn::apps::filter_type::FT_NO_FILTER &&
-            !validate_filter(sort_key_filter_type, sort_key_filter_pattern, sort_key)) {
+        return range_iteration_state::kFiltered;
+    default:
+        break;
+    }
+
+    // The predicates on value and expire_ts are applied after the key filters, since they
+    // need to decode the value.
+    if (!pushdown_filter.match_all()) {
+        const auto raw_value = utils::to_string_view(value);
+        if (!pushdown_filter.match(
+                pegasus_extract_expire_ts(_pegasus_data_version, raw_value),
+                pegasus_extract_user_data_view(_pegasus_data_version, raw_value))) {
             if (FLAGS_rocksdb_verbose_log) {
-                LOG_ERROR_PREFIX("sort key filtered for scan");
+                LOG_ERROR_PREFIX("value filtered for scan");
             }
             return range_iteration_state::kFiltered;
         }
@@ -2432,16 +2989,15 @@ range_iteration_state pegasus_server_impl::validate_key_value_for_scan(
 }
 
 void pegasus_server_impl::append_key_value(std::vector<::dsn::apps::key_value> &kvs,
+                                           blob_arena &arena,
                                            const rocksdb::Slice &key,
                                            const rocksdb::Slice &value,
                                            bool no_value,
-                                           bool request_expire_ts)
+                                           bool request_expire_ts,
+                                           bool return_value_length)
 {
     ::dsn::apps::key_value kv;
-    ::dsn::blob raw_key(key.data(), 0, key.size());
-    std::shared_ptr<char> key_buf(::dsn::utils::make_shared_array<char>(raw_key.length()));
-    ::memcpy(key_buf.get(), raw_key.data(), raw_key.length());
-    kv.key.assign(std::move(key_buf), 0, raw_key.length());
+    kv.key = arena.copy(key.data(), key.size());
 
     // extract expire ts if necessary
     if (request_expire_ts) {
@@ -2451,9 +3007,15 @@ void pegasus_server_impl::append_key_value(std::vector<::dsn::apps::key_value> &
     }
 
     // extract value
-    if (!no_value) {
-        std::string value_buf(value.data(), value.size());
-        pegasus_extract_user_data(_pegasus_data_version, std::move(value_buf), kv.value);
+    if (!no_value || return_value_length) {
+        const auto user_data =
+            pegasus_extract_user_data_view(_pegasus_data_version, utils::to_string_view(value));
+        if (!no_value) {
+            kv.value = arena.copy(user_data);
+        }
+        if (return_value_length) {
+            kv.__set_value_length(static_cast<int32_t>(user_data.size()));
+        }
     }
 
     kvs.emplace_back(std::move(kv));
@@ -2461,10 +3023,10 @@ void pegasus_server_impl::append_key_value(std::vector<::dsn::apps::key_value> &
 
 range_iteration_state pegasus_server_impl::append_key_value_for_multi_get(
     std::vector<::dsn::apps::key_value> &kvs,
+    blob_arena &arena,
     const rocksdb::Slice &key,
     const rocksdb::Slice &value,
-    ::dsn::apps::filter_type::type sort_key_filter_type,
-    const ::dsn::blob &sort_key_filter_pattern,
+    const key_filter &sort_key_filter,
     uint32_t epoch_now,
     bool no_value)
 {
@@ -2482,21 +3044,18 @@ range_iteration_state pegasus_server_impl::append_key_value_for_multi_get(
     ::dsn::blob hash_key, sort_key;
     pegasus_restore_key(raw_key, hash_key, sort_key);
 
-    if (sort_key_filter_type != ::dsn::apps::filter_type::FT_NO_FILTER &&
-        !validate_filter(sort_key_filter_type, sort_key_filter_pattern, sort_key)) {
+    if (!sort_key_filter.match_all() && !sort_key_filter.match(sort_key.to_string_view())) {
         if (FLAGS_rocksdb_verbose_log) {
             LOG_ERROR_PREFIX("sort key filtered for multi get");
         }
         return range_iteration_state::kFiltered;
     }
-    std::shared_ptr<char> sort_key_buf(::dsn::utils::make_shared_array<char>(sort_key.length()));
-    ::memcpy(sort_key_buf.get(), sort_key.data(), sort_key.length());
-    kv.key.assign(std::move(sort_key_buf), 0, sort_key.length());
+    kv.key = arena.copy(sort_key.data(), sort_key.length());
 
     // extract value
     if (!no_value) {
-        std::string value_buf(value.data(), value.size());
-        pegasus_extract_user_data(_pegasus_data_version, std::move(value_buf), kv.value);
+        kv.value = arena.copy(
+            pegasus_extract_user_data_view(_pegasus_data_version, utils::to_string_view(value)));
     }
 
     kvs.emplace_back(std::move(kv));
@@ -2523,6 +3082,10 @@ void pegasus_server_impl::update_replica_rocksdb_statistics()
     }
     METRIC_VAR_SET(rdb_total_sst_files, val);
 
+    if (_hot_row_cache != nullptr) {
+        METRIC_VAR_SET(hot_row_cache_mem_usage_bytes, _hot_row_cache->mem_usage());
+    }
+
     if (_db->GetProperty(_data_cf, rocksdb::DB::Properties::kTotalSstFilesSize, &str_val) &&
         dsn::buf2uint64(str_val, val)) {
         static uint64_t bytes_per_mb = 1U << 20U;
@@ -2734,6 +3297,7 @@ void pegasus_server_impl::update_app_envs(const std::map<std::string, std::strin
     update_rocksdb_iteration_threshold(envs);
     update_validate_partition_hash(envs);
     update_user_specified_compaction(envs);
+    update_hot_row_cache_enabled(envs);
     _manual_compact_svc.start_manual_compact_if_needed(envs);
 
     update_throttling_controller(envs);
@@ -2750,6 +3314,7 @@ void pegasus_server_impl::update_app_envs_before_open_db(
     update_rocksdb_iteration_threshold(envs);
     update_validate_partition_hash(envs);
     update_user_specified_compaction(envs);
+    update_hot_row_cache_enabled(envs);
     _manual_compact_svc.start_manual_compact_if_needed(envs);
     set_rocksdb_options_before_creating(envs);
 }
@@ -2820,6 +3385,11 @@ void pegasus_server_impl::update_default_ttl(const std::map<std::string, std::st
             LOG_ERROR_PREFIX("{}={} is invalid.", find->first, find->second);
             return;
         }
+        // The expire_ts of the cached rows are bounded by the default ttl, see on_get_done().
+        if (_hot_row_cache != nullptr &&
+            _key_ttl_compaction_filter_factory->GetDefaultTTL() != static_cast<uint32_t>(ttl)) {
+            _hot_row_cache->invalidate_all();
+        }
         _server_write->set_default_ttl(static_cast<uint32_t>(ttl));
         _key_ttl_compaction_filter_factory->SetDefaultTTL(static_cast<uint32_t>(ttl));
     }
@@ -2963,6 +3533,33 @@ void pegasus_server_impl::update_rocksdb_block_cache_enabled(
     }
 }
 
+void pegasus_server_impl::update_hot_row_cache_enabled(
+    const std::map<std::string, std::string> &envs)
+{
+    if (_hot_row_cache == nullptr) {
+        return;
+    }
+
+    bool enabled = false;
+    auto find = envs.find(dsn::replica_envs::HOT_ROW_CACHE_ENABLED);
+    if (find != envs.end() && !dsn::buf2bool(find->second, enabled)) {
+        LOG_ERROR_PREFIX("{}={} is invalid.", find->first, find->second);
+        return;
+    }
+
+    // The rows may be deleted or changed by the user specified compaction without writes, which
+    // could not be invalidated, thus the cache is never enabled with it.
+    enabled = enabled && _user_specified_compaction.empty();
+
+    if (_hot_row_cache->enabled() != enabled) {
+        LOG_INFO_PREFIX("update app env[{}] from \"{}\" to \"{}\" succeed",
+                        dsn::replica_envs::HOT_ROW_CACHE_ENABLED,
+                        _hot_row_cache->enabled(),
+                        enabled);
+        _hot_row_cache->set_enabled(enabled);
+    }
+}
+
 void pegasus_server_impl::update_validate_partition_hash(
     const std::map<std::string, std::string> &envs)
 {
@@ -3480,9 +4077,44 @@ void pegasus_server_impl::set_partition_version(int32_t partition_version)
     return ::dsn::ERR_OK;
 }
 
+void pegasus_server_impl::check_disk_write_buffer()
+{
+    const auto stall_micros = _statistics->getTickerCount(rocksdb::STALL_MICROS);
+    if (stall_micros > _last_stall_micros) {
+        _disk_write_controller->add_stall_micros(stall_micros - _last_stall_micros);
+    }
+    _last_stall_micros = stall_micros;
+
+    _disk_write_controller->maybe_flush(dsn_now_ms(),
+                                        FLAGS_rocksdb_proactive_flush_check_interval_ms,
+                                        FLAGS_rocksdb_proactive_flush_watermark_percent);
+}
+
+void pegasus_server_impl::schedule_check_disk_write_buffer()
+{
+    dsn::tasking::enqueue(
+        LPC_PEGASUS_SERVER_DELAY,
+        &_tracker,
+        [this]() {
+            check_disk_write_buffer();
+            schedule_check_disk_write_buffer();
+        },
+        0,
+        std::chrono::milliseconds(FLAGS_rocksdb_proactive_flush_check_interval_ms));
+}
+
 void pegasus_server_impl::release_db()
 {
+    // The cached rows belong to the db being released, which may be replaced by another one,
+    // e.g. when a checkpoint is applied.
+    if (_hot_row_cache != nullptr) {
+        _hot_row_cache->invalidate_all();
+    }
+
     if (_db) {
+        if (_disk_write_controller != nullptr) {
+            _disk_write_controller->remove_db(_db);
+        }
         CHECK_NOTNULL_PREFIX(_data_cf);
         CHECK_NOTNULL_PREFIX(_meta_cf);
         _db->DestroyColumnFamilyHandle(_data_cf);
@@ -3513,6 +4145,11 @@ std::string pegasus_server_impl::dump_write_request(dsn::message_ex *request)
                            multi_put.kvs.size());
     }
 
+    if (rpc_code == dsn::apps::RPC_RRDB_RRDB_BATCH_PUT) {
+        auto batch_put = batch_put_rpc(request).request();
+        return fmt::format("batch_put: batch_put_count={}", batch_put.entries.size());
+    }
+
     if (rpc_code == dsn::apps::RPC_RRDB_RRDB_CHECK_AND_SET) {
         auto check_and_set = check_and_set_rpc(request).request();
         return fmt::format("check_and_set: hash_key={}, check_sort_key={}, set_sort_key={}",
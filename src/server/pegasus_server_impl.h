@@ -23,6 +23,7 @@
 #include <rocksdb/compression_type.h>
 #include <rocksdb/options.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/status.h>
 #include <rocksdb/table.h>
 #include <rrdb/rrdb_types.h>
 #include <stdint.h>
@@ -38,6 +39,7 @@
 
 #include "bulk_load_types.h"
 #include "common/gpid.h"
+#include "hot_row_cache.h"
 #include "metadata_types.h"
 #include "pegasus_manual_compact_service.h"
 #include "pegasus_read_service.h"
@@ -45,6 +47,7 @@
 #include "pegasus_utils.h"
 #include "pegasus_value_schema.h"
 #include "range_read_limiter.h"
+#include "read_batcher.h"
 #include "replica/idempotent_writer.h"
 #include "replica/replication_app_base.h"
 #include "task/task.h"
@@ -96,7 +99,9 @@ typedef dsn::utils::token_bucket_throttling_controller throttling_controller;
 namespace pegasus {
 namespace server {
 
+class blob_arena;
 class capacity_unit_calculator;
+class disk_write_controller;
 class hotkey_collector;
 class meta_store;
 class pegasus_server_write;
@@ -124,6 +129,7 @@ public:
 
     // the following methods may set physical error if internal error occurs
     void on_get(get_rpc rpc) override;
+    bool is_get_async() const override { return _get_batcher != nullptr; }
     void on_multi_get(multi_get_rpc rpc) override;
     void on_batch_get(batch_get_rpc rpc) override;
     void on_sortkey_count(sortkey_count_rpc rpc) override;
@@ -132,6 +138,10 @@ public:
     void on_scan(scan_rpc rpc) override;
     void on_clear_scanner(const int64_t &args) override;
 
+    void on_aggregate_scan(aggregate_scan_rpc rpc) override;
+
+    void on_get_split_keys(get_split_keys_rpc rpc) override;
+
     // input:
     //  - argc = 0 : re-open the db
     //  - argc = 2n + 1, n >= 0; normal open the db
@@ -153,6 +163,11 @@ public:
                         std::vector<dsn::message_ex *> &new_requests,
                         idempotent_writer_ptr &idem_writer) override;
 
+    // See replication_app_base::get_write_partition_hashes() for details. Only called by
+    // primary replicas.
+    bool get_write_partition_hashes(dsn::message_ex *request,
+                                    std::vector<uint64_t> &partition_hashes) override;
+
     /// Each of the write request (specifically, the rpc that's configured as write, see
     /// option `rpc_request_is_write_operation` in rDSN `task_spec`) will first be
     /// replicated to the replicas through the underlying PacificA protocol in rDSN, and
@@ -276,45 +291,79 @@ private:
 
     void set_last_durable_decree(int64_t decree) { _last_durable_decree.store(decree); }
 
+    // The key and value are copied into `arena`, which is shared by all the rows of the
+    // same response.
     void append_key_value(std::vector<::dsn::apps::key_value> &kvs,
+                          blob_arena &arena,
                           const rocksdb::Slice &key,
                           const rocksdb::Slice &value,
                           bool no_value,
-                          bool request_expire_ts);
+                          bool request_expire_ts,
+                          bool return_value_length);
 
     range_iteration_state
     validate_key_value_for_scan(const rocksdb::Slice &key,
                                 const rocksdb::Slice &value,
-                                ::dsn::apps::filter_type::type hash_key_filter_type,
-                                const ::dsn::blob &hash_key_filter_pattern,
-                                ::dsn::apps::filter_type::type sort_key_filter_type,
-                                const ::dsn::blob &sort_key_filter_pattern,
+                                const raw_key_filter &scan_key_filter,
+                                const scan_pushdown_filter &pushdown_filter,
                                 uint32_t epoch_now,
                                 bool request_validate_hash);
 
     range_iteration_state
     append_key_value_for_multi_get(std::vector<::dsn::apps::key_value> &kvs,
+                                   blob_arena &arena,
                                    const rocksdb::Slice &key,
                                    const rocksdb::Slice &value,
-                                   ::dsn::apps::filter_type::type sort_key_filter_type,
-                                   const ::dsn::blob &sort_key_filter_pattern,
+                                   const key_filter &sort_key_filter,
                                    uint32_t epoch_now,
                                    bool no_value);
 
-    // return true if the filter type is supported
-    bool is_filter_type_supported(::dsn::apps::filter_type::type filter_type)
-    {
-        return filter_type >= ::dsn::apps::filter_type::FT_NO_FILTER &&
-               filter_type <= ::dsn::apps::filter_type::FT_MATCH_POSTFIX;
-    }
+    // Put the context of an unfinished scan into `_context_cache`, return its handle. The
+    // context is put with a new handle, unless `handle` is valid.
+    int64_t put_scan_context(
+        std::unique_ptr<pegasus_scan_context> context,
+        int64_t handle = pegasus_scan_context::SCAN_CONTEXT_ID_NOT_EXIST);
+
+    // Serve a scan request, without sequencing the streaming ones.
+    void scan(scan_rpc &rpc);
 
-    // return true if the data is valid for the filter
-    static bool validate_filter(::dsn::apps::filter_type::type filter_type,
-                                const ::dsn::blob &filter_pattern,
-                                const ::dsn::blob &value);
+    void evict_idle_scan_contexts();
+
+    // A get request waiting to be served by a batch.
+    struct pending_get
+    {
+        get_rpc rpc;
+        uint64_t start_time_ns;
+        uint64_t cache_ticket;
+    };
+
+    // Serve the get requests coalesced by `_get_batcher` by a single MultiGet().
+    void on_batched_get(std::vector<pending_get> &batch);
+
+    // Fill the response of the get request with the result of rocksdb. The value is put into
+    // `_hot_row_cache` if `cache_ticket` is not 0.
+    void on_get_done(get_rpc &rpc,
+                     uint64_t start_time_ns,
+                     uint64_t cache_ticket,
+                     rocksdb::Status status,
+                     std::string &&value);
+
+    // Get the values of `keys` from the data column family by the batched MultiGet().
+    void multi_get(const std::vector<rocksdb::Slice> &keys,
+                   std::vector<std::string> &values,
+                   std::vector<rocksdb::Status> &statuses);
 
     void update_replica_rocksdb_statistics();
 
+    // Account the write stalls of this replica to its disk, and proactively flush a replica on
+    // the disk if the memtables use too much memory.
+    void check_disk_write_buffer();
+
+    // Schedule the next check_disk_write_buffer() after
+    // FLAGS_rocksdb_proactive_flush_check_interval_ms, which is read each time since it is
+    // mutable.
+    void schedule_check_disk_write_buffer();
+
     static void update_server_rocksdb_statistics();
 
     // get the absolute path of restore directory and the flag whether force restore from env
@@ -338,6 +387,8 @@ private:
 
     void update_rocksdb_block_cache_enabled(const std::map<std::string, std::string> &envs);
 
+    void update_hot_row_cache_enabled(const std::map<std::string, std::string> &envs);
+
     void update_validate_partition_hash(const std::map<std::string, std::string> &envs);
 
     void update_user_specified_compaction(const std::map<std::string, std::string> &envs);
@@ -515,6 +566,11 @@ private:
     rocksdb::ColumnFamilyHandle *_meta_cf;
     static std::shared_ptr<rocksdb::Cache> _s_block_cache;
     static std::shared_ptr<rocksdb::WriteBufferManager> _s_write_buffer_manager;
+    // Shared by the replicas on the same disk, nullptr if
+    // FLAGS_rocksdb_write_buffer_manager_per_disk is false.
+    std::shared_ptr<disk_write_controller> _disk_write_controller;
+    // The value of the STALL_MICROS ticker at the last check_disk_write_buffer().
+    uint64_t _last_stall_micros{0};
     static std::shared_ptr<rocksdb::RateLimiter> _s_rate_limiter;
     static int64_t _rocksdb_limiter_last_total_through;
     volatile bool _is_open;
@@ -532,6 +588,15 @@ private:
     std::deque<int64_t> _checkpoints;           // ordered checkpoints
 
     pegasus_context_cache _context_cache;
+    stream_scan_sequencer<scan_rpc> _stream_scans;
+
+    // Coalesce the concurrent get requests into batches, nullptr if
+    // FLAGS_rocksdb_batched_get_enabled is false.
+    std::unique_ptr<read_batcher<pending_get>> _get_batcher;
+
+    // Cache the values read by get requests, nullptr if FLAGS_hot_row_cache_capacity_mb is 0.
+    // It is enabled by the table env, and invalidated by rocksdb_wrapper on each write.
+    std::unique_ptr<hot_row_cache> _hot_row_cache;
 
     ::dsn::task_ptr _update_replica_rdb_stat;
     static ::dsn::task_ptr _update_server_rdb_stat;
@@ -565,6 +630,12 @@ private:
     METRIC_VAR_DECLARE_counter(read_filtered_values);
     METRIC_VAR_DECLARE_counter(abnormal_read_requests);
     METRIC_VAR_DECLARE_counter(throttling_rejected_read_requests);
+    METRIC_VAR_DECLARE_counter(hot_row_cache_hits);
+    METRIC_VAR_DECLARE_counter(hot_row_cache_misses);
+    METRIC_VAR_DECLARE_gauge_int64(hot_row_cache_mem_usage_bytes);
+    METRIC_VAR_DECLARE_gauge_int64(scan_contexts);
+    METRIC_VAR_DECLARE_gauge_int64(scan_context_mem_usage_bytes);
+    METRIC_VAR_DECLARE_counter(evicted_scan_contexts);
 
     // Server-level metrics for rocksdb.
     METRIC_VAR_DECLARE_gauge_int64(rdb_block_cache_mem_usage_bytes, static);
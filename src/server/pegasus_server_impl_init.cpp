@@ -26,6 +26,7 @@
 #include <rocksdb/table.h>
 #include <rocksdb/write_buffer_manager.h>
 #include <stdio.h>
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <mutex>
@@ -37,12 +38,17 @@
 #include <vector>
 
 #include "base/meta_store.h" // IWYU pragma: keep
+#include "common/fs_manager.h"
 #include "common/gpid.h"
+#include "disk_write_controller.h"
 #include "hashkey_transform.h"
+#include "hot_row_cache.h"
 #include "hotkey_collector.h"
 #include "pegasus_event_listener.h"
 #include "pegasus_server_impl.h"
 #include "pegasus_value_schema.h"
+#include "replica/replica.h"
+#include "replica/replica_stub.h"
 #include "replica_admin_types.h"
 #include "rpc/rpc_host_port.h"
 #include "runtime/api_layer1.h"
@@ -115,6 +121,37 @@ METRIC_DEFINE_counter(replica,
 
 METRIC_DECLARE_counter(throttling_rejected_read_requests);
 
+METRIC_DEFINE_counter(replica,
+                      hot_row_cache_hits,
+                      dsn::metric_unit::kRequests,
+                      "The number of GET requests served by the hot row cache");
+
+METRIC_DEFINE_counter(replica,
+                      hot_row_cache_misses,
+                      dsn::metric_unit::kRequests,
+                      "The number of GET requests missing the hot row cache while it is enabled");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          hot_row_cache_mem_usage_bytes,
+                          dsn::metric_unit::kBytes,
+                          "The memory usage of the hot row cache");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          scan_contexts,
+                          dsn::metric_unit::kContexts,
+                          "The number of the contexts of the unfinished scans");
+
+METRIC_DEFINE_gauge_int64(replica,
+                          scan_context_mem_usage_bytes,
+                          dsn::metric_unit::kBytes,
+                          "The estimated memory pinned by the contexts of the unfinished scans");
+
+METRIC_DEFINE_counter(replica,
+                      evicted_scan_contexts,
+                      dsn::metric_unit::kContexts,
+                      "The number of the scan contexts evicted for being idle or exceeding the "
+                      "capacity");
+
 METRIC_DEFINE_gauge_int64(replica,
                           rdb_total_sst_files,
                           dsn::metric_unit::kFiles,
@@ -331,11 +368,58 @@ DSN_DEFINE_bool(pegasus.server,
                 rocksdb_disable_table_block_cache,
                 false,
                 "Whether to disable RocksDB's block cache");
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_enable_pipelined_write,
+                false,
+                "Corresponding to RocksDB's options.enable_pipelined_write, which pipelines the "
+                "WAL writes and the memtable writes of the write groups");
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_unordered_write,
+                false,
+                "Corresponding to RocksDB's options.unordered_write, which lets the memtable "
+                "writes of different write groups proceed concurrently. It is safe for the data "
+                "since the writes of each replica are serialized by replication, while the "
+                "snapshots are no longer immutable against the concurrent writes");
+DSN_DEFINE_group_validator(rocksdb_unordered_write, [](std::string &message) -> bool {
+    if (FLAGS_rocksdb_unordered_write && FLAGS_rocksdb_enable_pipelined_write) {
+        message = "pegasus.server.rocksdb_unordered_write is incompatible with "
+                  "pegasus.server.rocksdb_enable_pipelined_write";
+        return false;
+    }
+    return true;
+});
 DSN_DEFINE_bool(pegasus.server,
                 rocksdb_enable_write_buffer_manager,
                 false,
                 "enable write buffer manager to limit total memory used by memtables and block "
                 "caches across multiple replicas");
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_write_buffer_manager_per_disk,
+                false,
+                "Whether to share a write buffer manager among the replicas on the same disk "
+                "rather than all the replicas on this server, once "
+                "rocksdb_enable_write_buffer_manager is enabled. The memory limit "
+                "rocksdb_total_size_across_write_buffer is split among the disks in "
+                "proportion to their capacities, thus a hot replica could only stall the "
+                "writes of the replicas on its own disk");
+DSN_DEFINE_uint32(pegasus.server,
+                  rocksdb_proactive_flush_watermark_percent,
+                  90,
+                  "Once the memory usage of the memtables of the replicas on a disk reaches this "
+                  "percentage of its write buffer budget, a replica on the disk is proactively "
+                  "flushed before the write buffer manager stalls the writes. Only valid when "
+                  "rocksdb_write_buffer_manager_per_disk is enabled");
+DSN_TAG_VARIABLE(rocksdb_proactive_flush_watermark_percent, FT_MUTABLE);
+DSN_DEFINE_validator(rocksdb_proactive_flush_watermark_percent,
+                     [](uint32_t value) -> bool { return value > 0 && value <= 100; });
+DSN_DEFINE_uint64(pegasus.server,
+                  rocksdb_proactive_flush_check_interval_ms,
+                  1000,
+                  "The interval in milliseconds to check whether a replica on the disk should be "
+                  "proactively flushed");
+DSN_TAG_VARIABLE(rocksdb_proactive_flush_check_interval_ms, FT_MUTABLE);
+DSN_DEFINE_validator(rocksdb_proactive_flush_check_interval_ms,
+                     [](uint64_t value) -> bool { return value > 0; });
 DSN_DEFINE_bool(pegasus.server,
                 rocksdb_partition_filters,
                 false,
@@ -509,6 +593,71 @@ DSN_DEFINE_uint64(pegasus.server,
                   30000,
                   "max duration for handling one pegasus scan request(sortkey_count/multiget/scan) "
                   "if exceed this threshold, iterator will be stopped, 0 means no check");
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_batched_get_enabled,
+                false,
+                "Whether to coalesce the get requests arriving concurrently on a replica into "
+                "batches, each of which is served by a single RocksDB MultiGet");
+DSN_DEFINE_uint32(pegasus.server,
+                  rocksdb_batched_get_max_batch_size,
+                  32,
+                  "The max count of the get requests in a batch if rocksdb_batched_get_enabled "
+                  "is true");
+DSN_DEFINE_uint64(pegasus.server,
+                  rocksdb_batched_get_window_us,
+                  0,
+                  "The max duration in microseconds to wait for more get requests before serving "
+                  "a batch which is not full, 0 means to serve the requests that have arrived at "
+                  "once. The requests wait in a task delayed by the window rounded up to "
+                  "milliseconds rather than blocking a thread. It bounds the extra latency added "
+                  "to each get request by batching");
+DSN_DEFINE_uint64(pegasus.server,
+                  hot_row_cache_capacity_mb,
+                  64,
+                  "The capacity of the hot row cache of each replica, which caches the values read "
+                  "by get requests in front of rocksdb if the table env "
+                  "'replica.hot_row_cache_enabled' is true, 0 means the cache is never used");
+DSN_DEFINE_uint32(pegasus.server,
+                  hot_row_cache_shard_count,
+                  16,
+                  "The number of shards of the hot row cache of each replica");
+DSN_DEFINE_validator(hot_row_cache_shard_count, [](uint32_t value) -> bool { return value > 0; });
+DSN_DEFINE_uint64(pegasus.server,
+                  scan_context_idle_ttl_seconds,
+                  300,
+                  "The context of an unfinished scan is evicted once it has not been used for "
+                  "this duration, to release the resources pinned by its iterator");
+DSN_DEFINE_validator(scan_context_idle_ttl_seconds,
+                     [](uint64_t value) -> bool { return value > 0; });
+DSN_DEFINE_uint64(pegasus.server,
+                  scan_context_cache_capacity_mb,
+                  256,
+                  "The max estimated memory pinned by the contexts of the unfinished scans of "
+                  "each replica, the least recently used contexts are evicted once exceeded");
+DSN_DEFINE_uint32(pegasus.server,
+                  scan_context_cache_shard_count,
+                  16,
+                  "The number of shards of the scan context cache of each replica");
+DSN_DEFINE_validator(scan_context_cache_shard_count,
+                     [](uint32_t value) -> bool { return value > 0; });
+DSN_DEFINE_bool(pegasus.server,
+                rocksdb_multi_get_async_io,
+                false,
+                "Whether MultiGet reads the data blocks from different sst files in parallel by "
+                "async io, which is backed by io_uring if RocksDB is built with it. Corresponding "
+                "to RocksDB's ReadOptions.async_io and ReadOptions.optimize_multiget_for_io");
+DSN_DEFINE_uint32(pegasus.server,
+                  rocksdb_aggregate_scan_max_iteration_count,
+                  1000000,
+                  "max iteration count for each aggregate scan request, if exceed this threshold, "
+                  "the partial result will be returned and the client should continue from where "
+                  "it stopped.");
+DSN_DEFINE_uint64(pegasus.server,
+                  rocksdb_aggregate_scan_iteration_threshold_time_ms,
+                  3000,
+                  "max duration for handling one aggregate scan request, if exceed this threshold, "
+                  "the partial result will be returned and the client should continue from where "
+                  "it stopped, 0 means no check");
 DSN_DEFINE_uint64(pegasus.server,
                   rocksdb_compaction_readahead_size,
                   2 * 1024 * 1024,
@@ -613,6 +762,8 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
       _pegasus_data_version(PEGASUS_DATA_VERSION_MAX),
       _last_durable_decree(0),
       _is_checkpointing(false),
+      _context_cache(FLAGS_scan_context_cache_shard_count,
+                     FLAGS_scan_context_cache_capacity_mb << 20),
       _manual_compact_svc(this),
       _partition_version(0),
       METRIC_VAR_INIT_replica(get_requests),
@@ -627,6 +778,12 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
       METRIC_VAR_INIT_replica(read_filtered_values),
       METRIC_VAR_INIT_replica(abnormal_read_requests),
       METRIC_VAR_INIT_replica(throttling_rejected_read_requests),
+      METRIC_VAR_INIT_replica(hot_row_cache_hits),
+      METRIC_VAR_INIT_replica(hot_row_cache_misses),
+      METRIC_VAR_INIT_replica(hot_row_cache_mem_usage_bytes),
+      METRIC_VAR_INIT_replica(scan_contexts),
+      METRIC_VAR_INIT_replica(scan_context_mem_usage_bytes),
+      METRIC_VAR_INIT_replica(evicted_scan_contexts),
       METRIC_VAR_INIT_replica(rdb_total_sst_files),
       METRIC_VAR_INIT_replica(rdb_total_sst_size_mb),
       METRIC_VAR_INIT_replica(rdb_estimated_keys),
@@ -662,6 +819,14 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
     _rng_rd_opts.multi_get_max_iteration_size = FLAGS_rocksdb_multi_get_max_iteration_size;
     _rng_rd_opts.rocksdb_max_iteration_count = FLAGS_rocksdb_max_iteration_count;
     _rng_rd_opts.rocksdb_iteration_threshold_time_ms = FLAGS_rocksdb_iteration_threshold_time_ms;
+    _rng_rd_opts.aggregate_scan_max_iteration_count =
+        FLAGS_rocksdb_aggregate_scan_max_iteration_count;
+    _rng_rd_opts.aggregate_scan_iteration_threshold_time_ms =
+        FLAGS_rocksdb_aggregate_scan_iteration_threshold_time_ms;
+    if (FLAGS_hot_row_cache_capacity_mb > 0) {
+        _hot_row_cache = std::make_unique<hot_row_cache>(FLAGS_hot_row_cache_capacity_mb << 20,
+                                                         FLAGS_hot_row_cache_shard_count);
+    }
 
     // init rocksdb::DBOptions
     _db_opts.env = dsn::utils::PegasusEnv(dsn::utils::FileDataType::kSensitive);
@@ -674,6 +839,8 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
         FLAGS_rocksdb_use_direct_io_for_flush_and_compaction;
     _db_opts.compaction_readahead_size = FLAGS_rocksdb_compaction_readahead_size;
     _db_opts.writable_file_max_buffer_size = FLAGS_rocksdb_writable_file_max_buffer_size;
+    _db_opts.enable_pipelined_write = FLAGS_rocksdb_enable_pipelined_write;
+    _db_opts.unordered_write = FLAGS_rocksdb_unordered_write;
 
     _statistics = rocksdb::CreateDBStatistics();
     _statistics->set_stats_level(rocksdb::kExceptDetailedTimers);
@@ -749,7 +916,30 @@ pegasus_server_impl::pegasus_server_impl(dsn::replication::replica *r)
 
     LOG_INFO_PREFIX("rocksdb_enable_write_buffer_manager = {}",
                     FLAGS_rocksdb_enable_write_buffer_manager);
-    if (FLAGS_rocksdb_enable_write_buffer_manager) {
+    const auto *dn = r->get_dir_node();
+    if (FLAGS_rocksdb_enable_write_buffer_manager && FLAGS_rocksdb_write_buffer_manager_per_disk &&
+        dn != nullptr) {
+        // Split the total memory limit among the disks in proportion to their capacities, or
+        // evenly if the capacities are unknown.
+        uint64_t buffer_size = FLAGS_rocksdb_total_size_across_write_buffer;
+        const auto &dir_nodes = r->get_replica_stub()->get_fs_manager()->get_dir_nodes();
+        if (buffer_size > 0 && !dir_nodes.empty()) {
+            int64_t total_capacity_mb = 0;
+            for (const auto &node : dir_nodes) {
+                total_capacity_mb += std::max<int64_t>(node->disk_capacity_mb, 0);
+            }
+            if (total_capacity_mb > 0 && dn->disk_capacity_mb > 0) {
+                buffer_size = static_cast<uint64_t>(static_cast<double>(buffer_size) *
+                                                    dn->disk_capacity_mb / total_capacity_mb);
+            } else {
+                buffer_size /= dir_nodes.size();
+            }
+        }
+
+        _disk_write_controller = disk_write_controller::get_or_create(
+            dn->tag, dn->disk_metric_entity(), buffer_size, _tbl_opts.block_cache);
+        _db_opts.write_buffer_manager = _disk_write_controller->write_buffer_manager();
+    } else if (FLAGS_rocksdb_enable_write_buffer_manager) {
         // If write buffer manager is enabled, all replicas(one DB instance for each
         // replica) on this server will share the same write buffer manager object,
         // thus the same block cache object. It's convenient to control the total memory
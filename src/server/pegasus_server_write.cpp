@@ -186,6 +186,10 @@ int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t
                 auto rpc = remove_rpc::auto_reply(requests[i]);
                 local_err = on_single_remove_in_batch(rpc);
                 _remove_rpc_batch.emplace_back(std::move(rpc));
+            } else if (rpc_code == dsn::apps::RPC_RRDB_RRDB_BATCH_PUT) {
+                auto rpc = batch_put_rpc::auto_reply(requests[i]);
+                local_err = _write_svc->batch_put(_write_ctx, rpc.request(), rpc.response());
+                _batch_put_rpc_batch.emplace_back(std::move(rpc));
             } else {
                 if (_non_batch_write_handlers.find(rpc_code) != _non_batch_write_handlers.end()) {
                     LOG_FATAL_PREFIX("rpc code not allow batch: {}", rpc_code);
@@ -209,7 +213,8 @@ int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t
     }
 
     if (dsn_unlikely(err != rocksdb::Status::kOk ||
-                     (_put_rpc_batch.empty() && _remove_rpc_batch.empty()))) {
+                     (_put_rpc_batch.empty() && _remove_rpc_batch.empty() &&
+                      _batch_put_rpc_batch.empty()))) {
         _write_svc->batch_abort(_decree, err == rocksdb::Status::kOk ? -1 : err);
     } else {
         err = _write_svc->batch_commit(_decree);
@@ -218,6 +223,7 @@ int pegasus_server_write::on_batched_writes(dsn::message_ex **requests, uint32_t
     // reply the batched RPCs
     _put_rpc_batch.clear();
     _remove_rpc_batch.clear();
+    _batch_put_rpc_batch.clear();
     return err;
 }
 
@@ -284,6 +290,11 @@ void pegasus_server_write::init_non_batch_write_handlers()
              auto rpc = multi_remove_rpc::auto_reply(request);
              return _write_svc->multi_remove(_decree, rpc.request(), rpc.response());
          }},
+        {dsn::apps::RPC_RRDB_RRDB_DEL_RANGE,
+         [this](dsn::message_ex *request) -> int {
+             auto rpc = del_range_rpc::auto_reply(request);
+             return _write_svc->del_range(_decree, rpc.request(), rpc.response());
+         }},
         {dsn::apps::RPC_RRDB_RRDB_INCR,
          [this](dsn::message_ex *request) -> int {
              auto rpc = incr_rpc::auto_reply(request);
@@ -114,11 +114,17 @@ private:
                     request->header->context.u.serialize_format)));
         }
 
+        // Make the updates visible to the following atomic writes on the same keys, which
+        // thus could be made idempotent before this one is applied. The updates are released
+        // once the writer is destructed, i.e. after it is applied or once it is dropped.
+        auto pending = _write_svc->record_pending_writes(updates);
+
         idem_writer = std::make_unique<pegasus::idempotent_writer>(
             std::move(rpc),
             typename pegasus::idempotent_writer::template apply_func_t<TRpcHolder>(
-                [this](const std::vector<dsn::apps::update_request> &updates,
-                       const TRpcHolder &rpc) -> int {
+                [this, pending = std::move(pending)](
+                    const std::vector<dsn::apps::update_request> &updates,
+                    const TRpcHolder &rpc) -> int {
                     return _write_svc->put(_write_ctx, updates, rpc.request(), rpc.response());
                 }),
             std::move(updates));
@@ -158,6 +164,7 @@ private:
     std::unique_ptr<pegasus_write_service> _write_svc;
     std::vector<put_rpc> _put_rpc_batch;
     std::vector<remove_rpc> _remove_rpc_batch;
+    std::vector<batch_put_rpc> _batch_put_rpc_batch;
 
     db_write_context _write_ctx;
     int64_t _decree{invalid_decree};
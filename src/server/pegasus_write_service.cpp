@@ -57,6 +57,11 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kRequests,
                       "The number of MULTI_PUT requests");
 
+METRIC_DEFINE_counter(replica,
+                      batch_put_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of BATCH_PUT requests");
+
 METRIC_DEFINE_counter(replica,
                       remove_requests,
                       dsn::metric_unit::kRequests,
@@ -67,6 +72,11 @@ METRIC_DEFINE_counter(replica,
                       dsn::metric_unit::kRequests,
                       "The number of MULTI_REMOVE requests");
 
+METRIC_DEFINE_counter(replica,
+                      del_range_requests,
+                      dsn::metric_unit::kRequests,
+                      "The number of DEL_RANGE requests");
+
 METRIC_DEFINE_counter(replica,
                       incr_requests,
                       dsn::metric_unit::kRequests,
@@ -120,6 +130,11 @@ METRIC_DEFINE_percentile_int64(replica,
                                dsn::metric_unit::kNanoSeconds,
                                "The latency of MULTI_PUT requests");
 
+METRIC_DEFINE_percentile_int64(replica,
+                               batch_put_latency_ns,
+                               dsn::metric_unit::kNanoSeconds,
+                               "The latency of BATCH_PUT requests");
+
 METRIC_DEFINE_percentile_int64(replica,
                                remove_latency_ns,
                                dsn::metric_unit::kNanoSeconds,
@@ -130,6 +145,11 @@ METRIC_DEFINE_percentile_int64(replica,
                                dsn::metric_unit::kNanoSeconds,
                                "The latency of MULTI_REMOVE requests");
 
+METRIC_DEFINE_percentile_int64(replica,
+                               del_range_latency_ns,
+                               dsn::metric_unit::kNanoSeconds,
+                               "The latency of DEL_RANGE requests");
+
 METRIC_DEFINE_percentile_int64(replica,
                                incr_latency_ns,
                                dsn::metric_unit::kNanoSeconds,
@@ -184,8 +204,10 @@ pegasus_write_service::pegasus_write_service(pegasus_server_impl *server)
       _cu_calculator(server->_cu_calculator.get()),
       METRIC_VAR_INIT_replica(put_requests),
       METRIC_VAR_INIT_replica(multi_put_requests),
+      METRIC_VAR_INIT_replica(batch_put_requests),
       METRIC_VAR_INIT_replica(remove_requests),
       METRIC_VAR_INIT_replica(multi_remove_requests),
+      METRIC_VAR_INIT_replica(del_range_requests),
       METRIC_VAR_INIT_replica(incr_requests),
       METRIC_VAR_INIT_replica(check_and_set_requests),
       METRIC_VAR_INIT_replica(check_and_mutate_requests),
@@ -194,8 +216,10 @@ pegasus_write_service::pegasus_write_service(pegasus_server_impl *server)
       METRIC_VAR_INIT_replica(make_check_and_mutate_idempotent_latency_ns),
       METRIC_VAR_INIT_replica(put_latency_ns),
       METRIC_VAR_INIT_replica(multi_put_latency_ns),
+      METRIC_VAR_INIT_replica(batch_put_latency_ns),
       METRIC_VAR_INIT_replica(remove_latency_ns),
       METRIC_VAR_INIT_replica(multi_remove_latency_ns),
+      METRIC_VAR_INIT_replica(del_range_latency_ns),
       METRIC_VAR_INIT_replica(incr_latency_ns),
       METRIC_VAR_INIT_replica(check_and_set_latency_ns),
       METRIC_VAR_INIT_replica(check_and_mutate_latency_ns),
@@ -241,6 +265,23 @@ int pegasus_write_service::multi_remove(int64_t decree,
     return err;
 }
 
+int pegasus_write_service::del_range(int64_t decree,
+                                     const dsn::apps::del_range_request &update,
+                                     dsn::apps::del_range_response &resp)
+{
+    METRIC_VAR_AUTO_LATENCY(del_range_latency_ns);
+    METRIC_VAR_INCREMENT(del_range_requests);
+
+    int err = _impl->del_range(decree, update, resp);
+
+    if (_server->is_primary()) {
+        _cu_calculator->add_del_range_cu(
+            resp.error, update.hash_key, update.start_sort_key, update.stop_sort_key);
+    }
+
+    return err;
+}
+
 int pegasus_write_service::make_idempotent(const dsn::apps::incr_request &req,
                                            dsn::apps::incr_response &err_resp,
                                            std::vector<dsn::apps::update_request> &updates)
@@ -374,6 +415,12 @@ int pegasus_write_service::check_and_mutate(int64_t decree,
     return err;
 }
 
+pending_write_overlay::holder_ptr
+pegasus_write_service::record_pending_writes(const std::vector<dsn::apps::update_request> &updates)
+{
+    return _impl->record_pending_writes(updates);
+}
+
 void pegasus_write_service::batch_prepare(int64_t decree)
 {
     CHECK_EQ_MSG(
@@ -428,6 +475,23 @@ int pegasus_write_service::batch_put(const db_write_context &ctx,
     return err;
 }
 
+int pegasus_write_service::batch_put(const db_write_context &ctx,
+                                     const dsn::apps::batch_put_request &update,
+                                     dsn::apps::update_response &resp)
+{
+    CHECK_GT_MSG(_batch_start_time, 0, "batch_put must be called after batch_prepare");
+
+    ++batch_size(batch_write_type::batch_put);
+
+    const int err = _impl->batch_put(ctx, update, resp);
+
+    if (_server->is_primary()) {
+        _cu_calculator->add_batch_put_cu(resp.error, update.entries);
+    }
+
+    return err;
+}
+
 int pegasus_write_service::batch_remove(int64_t decree,
                                         const dsn::blob &key,
                                         dsn::apps::update_response &resp)
@@ -483,6 +547,7 @@ void pegasus_write_service::batch_finish()
     // request within it, since the latency of each request could not be known.
     UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(put);
     UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(remove);
+    UPDATE_BATCH_METRICS_FOR_SINGLE_WRITE(batch_put);
 
     // These idempotent updates are translated from the atomic write requests. See comments
     // in batch_put() for the two possible situations where we are now.
@@ -533,7 +598,8 @@ int pegasus_write_service::duplicate(int64_t decree,
         dsn::message_ex *write =
             dsn::from_blob_to_received_msg(request.task_code, request.raw_message);
         bool is_delete = request.task_code == dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE ||
-                         request.task_code == dsn::apps::RPC_RRDB_RRDB_REMOVE;
+                         request.task_code == dsn::apps::RPC_RRDB_RRDB_REMOVE ||
+                         request.task_code == dsn::apps::RPC_RRDB_RRDB_DEL_RANGE;
         auto remote_timetag = generate_timetag(request.timestamp, request.cluster_id, is_delete);
         auto ctx =
             db_write_context::create_duplicate(decree, remote_timetag, request.verify_timetag);
@@ -554,6 +620,30 @@ int pegasus_write_service::duplicate(int64_t decree,
             }
             continue;
         }
+        if (request.task_code == dsn::apps::RPC_RRDB_RRDB_DEL_RANGE) {
+            // Like MULTI_REMOVE, the range tombstone is applied without verifying the timetags
+            // of the keys it covers.
+            del_range_rpc rpc(write);
+            resp.__set_error(_impl->del_range(ctx.decree, rpc.request(), rpc.response()));
+            if (resp.error != rocksdb::Status::kOk) {
+                return resp.error;
+            }
+            continue;
+        }
+        if (request.task_code == dsn::apps::RPC_RRDB_RRDB_BATCH_PUT) {
+            batch_put_rpc rpc(write);
+            int err = _impl->batch_put(ctx, rpc.request(), rpc.response());
+            if (!err) {
+                err = _impl->batch_commit(ctx.decree);
+            } else {
+                _impl->batch_abort(ctx.decree, err);
+            }
+            resp.__set_error(err);
+            if (resp.error != rocksdb::Status::kOk) {
+                return resp.error;
+            }
+            continue;
+        }
         put_rpc put;
         remove_rpc remove;
         if (request.task_code == dsn::apps::RPC_RRDB_RRDB_PUT ||
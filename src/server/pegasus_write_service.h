@@ -25,6 +25,7 @@
 #include <memory>
 #include <vector>
 
+#include "pending_write_overlay.h"
 #include "replica/replica_base.h"
 #include "utils/metrics.h"
 
@@ -32,10 +33,13 @@ namespace dsn {
 class blob;
 
 namespace apps {
+class batch_put_request;
 class check_and_mutate_request;
 class check_and_mutate_response;
 class check_and_set_request;
 class check_and_set_response;
+class del_range_request;
+class del_range_response;
 class duplicate_request;
 class duplicate_response;
 class incr_request;
@@ -138,6 +142,11 @@ public:
                      const dsn::apps::multi_remove_request &update,
                      dsn::apps::multi_remove_response &resp);
 
+    // Write DEL_RANGE record.
+    int del_range(int64_t decree,
+                  const dsn::apps::del_range_request &update,
+                  dsn::apps::del_range_response &resp);
+
     // Translate an INCR request into an idempotent PUT request. Only called by primary
     // replicas.
     int make_idempotent(const dsn::apps::incr_request &req,
@@ -191,6 +200,12 @@ public:
                          const dsn::apps::check_and_mutate_request &update,
                          dsn::apps::check_and_mutate_response &resp);
 
+    // Record the idempotent updates translated from an atomic write, which would be read by
+    // make_idempotent() of the following atomic writes until the returned holder is released.
+    // Only called by primary replicas.
+    pending_write_overlay::holder_ptr
+    record_pending_writes(const std::vector<dsn::apps::update_request> &updates);
+
     // Handles DUPLICATE duplicated from remote.
     int duplicate(int64_t decree,
                   const dsn::apps::duplicate_request &update,
@@ -215,6 +230,13 @@ public:
                   const dsn::apps::update_request &update,
                   dsn::apps::update_response &resp);
 
+    // Add the entries of a BATCH_PUT record in batch write.
+    // \returns rocksdb::Status::Code.
+    // NOTE that `resp` should not be moved or freed while the batch is not committed.
+    int batch_put(const db_write_context &ctx,
+                  const dsn::apps::batch_put_request &update,
+                  dsn::apps::update_response &resp);
+
     // Add REMOVE record in batch write.
     // \returns rocksdb::Status::Code.
     // NOTE that `resp` should not be moved or freed while the batch is not committed.
@@ -243,6 +265,7 @@ private:
         incr,
         check_and_set,
         check_and_mutate,
+        batch_put,
         COUNT,
     };
 
@@ -283,13 +306,15 @@ private:
     //
     // Each request of single put, single remove, incr and check_and_set contains only one
     // write operation, while check_and_mutate may contain multiple operations of single
-    // puts and removes.
+    // puts and removes. Besides, a batch put may contain multiple puts of different hash keys.
     std::array<uint32_t, static_cast<size_t>(batch_write_type::COUNT)> _batch_sizes{};
 
     METRIC_VAR_DECLARE_counter(put_requests);
     METRIC_VAR_DECLARE_counter(multi_put_requests);
+    METRIC_VAR_DECLARE_counter(batch_put_requests);
     METRIC_VAR_DECLARE_counter(remove_requests);
     METRIC_VAR_DECLARE_counter(multi_remove_requests);
+    METRIC_VAR_DECLARE_counter(del_range_requests);
     METRIC_VAR_DECLARE_counter(incr_requests);
     METRIC_VAR_DECLARE_counter(check_and_set_requests);
     METRIC_VAR_DECLARE_counter(check_and_mutate_requests);
@@ -300,8 +325,10 @@ private:
 
     METRIC_VAR_DECLARE_percentile_int64(put_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(multi_put_latency_ns);
+    METRIC_VAR_DECLARE_percentile_int64(batch_put_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(remove_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(multi_remove_latency_ns);
+    METRIC_VAR_DECLARE_percentile_int64(del_range_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(incr_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(check_and_set_latency_ns);
     METRIC_VAR_DECLARE_percentile_int64(check_and_mutate_latency_ns);
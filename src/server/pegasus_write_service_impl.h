@@ -24,9 +24,12 @@
 #include "base/idl_utils.h"
 #include "base/meta_store.h"
 #include "base/pegasus_key_schema.h"
+#include "base/pegasus_utils.h"
+#include "base/pegasus_value_schema.h"
 #include "logging_utils.h"
 #include "pegasus_server_impl.h"
 #include "pegasus_write_service.h"
+#include "pending_write_overlay.h"
 #include "rocksdb_wrapper.h"
 #include "utils/defer.h"
 #include "utils/env.h"
@@ -43,6 +46,7 @@ static constexpr int FAIL_DB_WRITE_BATCH_PUT = -101;
 static constexpr int FAIL_DB_WRITE_BATCH_DELETE = -102;
 static constexpr int FAIL_DB_WRITE = -103;
 static constexpr int FAIL_DB_GET = -104;
+static constexpr int FAIL_DB_WRITE_BATCH_DELETE_RANGE = -105;
 
 struct db_get_context
 {
@@ -82,11 +86,20 @@ public:
     explicit impl(pegasus_server_impl *server)
         : replica_base(server),
           _primary_host_port(server->_primary_host_port),
-          _pegasus_data_version(server->_pegasus_data_version)
+          _pegasus_data_version(server->_pegasus_data_version),
+          _pending_writes(std::make_shared<pending_write_overlay>())
     {
         _rocksdb_wrapper = std::make_unique<rocksdb_wrapper>(server);
     }
 
+    // Record the results of an atomic write which has been made idempotent, to be read by the
+    // following atomic writes until the returned holder is released.
+    pending_write_overlay::holder_ptr
+    record_pending_writes(const std::vector<dsn::apps::update_request> &updates)
+    {
+        return _pending_writes->record(updates);
+    }
+
     int empty_put(int64_t decree)
     {
         int err =
@@ -168,15 +181,56 @@ public:
         return resp.error;
     }
 
+    int del_range(int64_t decree,
+                  const dsn::apps::del_range_request &update,
+                  dsn::apps::del_range_response &resp)
+    {
+        resp.app_id = get_gpid().get_app_id();
+        resp.partition_index = get_gpid().get_partition_index();
+        resp.decree = decree;
+        resp.server = _primary_host_port;
+
+        if (update.hash_key.empty()) {
+            // The rows with an empty hash key are distributed over all the partitions by their
+            // sort keys, thus they could not be deleted by range in a single partition.
+            LOG_ERROR_PREFIX("invalid argument for del_range: decree = {}, error = {}",
+                             decree,
+                             "request.hash_key is empty");
+            resp.error = rocksdb::Status::kInvalidArgument;
+            // we should write empty record to update rocksdb's last flushed decree
+            return empty_put(decree);
+        }
+
+        std::string begin_key;
+        std::string end_key;
+        generate_del_range_keys(update, begin_key, end_key);
+        if (begin_key >= end_key) {
+            // Nothing to delete, but we should still write empty record to update rocksdb's
+            // last flushed decree.
+            resp.error = rocksdb::Status::kOk;
+            return empty_put(decree);
+        }
+
+        auto cleanup = dsn::defer([this]() { _rocksdb_wrapper->clear_up_write_batch(); });
+        resp.error = _rocksdb_wrapper->write_batch_delete_range(decree, begin_key, end_key);
+        if (dsn_unlikely(resp.error != rocksdb::Status::kOk)) {
+            return resp.error;
+        }
+
+        resp.error = _rocksdb_wrapper->write(decree);
+        return resp.error;
+    }
+
     // Tranlate an incr request into a single-put request which is certainly idempotent.
     // Return current status for RocksDB. Only called by primary replicas.
     int make_idempotent(const dsn::apps::incr_request &req,
                         dsn::apps::incr_response &err_resp,
                         dsn::apps::update_request &update)
     {
-        // Get current raw value for the provided key from the RocksDB instance.
+        // Get current value for the provided key.
         db_get_context get_ctx;
-        const int err = _rocksdb_wrapper->get(req.key, &get_ctx);
+        dsn::blob base_value;
+        const int err = get_for_idempotent(req.key, get_ctx, base_value);
         if (dsn_unlikely(err != rocksdb::Status::kOk)) {
             // Failed to read current raw value.
             LOG_ERROR_PREFIX("failed to get current raw value for incr while making "
@@ -195,10 +249,6 @@ public:
                 req.key, req.increment, calc_expire_on_non_existent(req), update);
         }
 
-        // Extract user data from raw value as base for increment.
-        dsn::blob base_value;
-        pegasus_extract_user_data(_pegasus_data_version, std::move(get_ctx.raw_value), base_value);
-
         int64_t new_int = 0;
         if (base_value.empty()) {
             // Old value is also considered as 0 before incr as above once it's empty, thus
@@ -362,7 +412,8 @@ public:
 
         // Get the check value.
         db_get_context get_ctx;
-        const int err = _rocksdb_wrapper->get(check_key, &get_ctx);
+        dsn::blob check_value;
+        const int err = get_for_idempotent(check_key, get_ctx, check_value);
         if (dsn_unlikely(err != rocksdb::Status::kOk)) {
             // Failed to read the check value.
             LOG_ERROR_PREFIX("failed to get the check value for check_and_set while making "
@@ -375,12 +426,7 @@ public:
             return make_error_response(err, err_resp);
         }
 
-        dsn::blob check_value;
         const bool value_exist = !get_ctx.expired && get_ctx.found;
-        if (value_exist) {
-            pegasus_extract_user_data(
-                _pegasus_data_version, std::move(get_ctx.raw_value), check_value);
-        }
 
         bool invalid_argument = false;
         const bool passed = validate_check(
@@ -604,7 +650,8 @@ public:
 
         // Get the check value.
         db_get_context get_ctx;
-        const int err = _rocksdb_wrapper->get(check_key, &get_ctx);
+        dsn::blob check_value;
+        const int err = get_for_idempotent(check_key, get_ctx, check_value);
         if (dsn_unlikely(err != rocksdb::Status::kOk)) {
             // Failed to read the check value.
             LOG_ERROR_PREFIX("failed to get the check value for check_and_mutate while making "
@@ -617,12 +664,7 @@ public:
             return make_error_response(err, err_resp);
         }
 
-        dsn::blob check_value;
         const bool value_exist = !get_ctx.expired && get_ctx.found;
-        if (value_exist) {
-            pegasus_extract_user_data(
-                _pegasus_data_version, std::move(get_ctx.raw_value), check_value);
-        }
 
         bool invalid_argument = false;
         const bool passed = validate_check(
@@ -880,6 +922,24 @@ public:
         return resp.error;
     }
 
+    int batch_put(const db_write_context &ctx,
+                  const dsn::apps::batch_put_request &update,
+                  dsn::apps::update_response &resp)
+    {
+        _update_responses.emplace_back(&resp);
+        for (const auto &entry : update.entries) {
+            resp.error = _rocksdb_wrapper->write_batch_put_ctx(
+                ctx,
+                composite_raw_key(entry.hash_key, entry.sort_key),
+                entry.value,
+                entry.expire_ts_seconds);
+            if (dsn_unlikely(resp.error != rocksdb::Status::kOk)) {
+                return resp.error;
+            }
+        }
+        return rocksdb::Status::kOk;
+    }
+
     int batch_remove(int64_t decree, const dsn::blob &key, dsn::apps::update_response &resp)
     {
         resp.error = _rocksdb_wrapper->write_batch_delete(decree, key.to_string_view());
@@ -928,6 +988,31 @@ private:
         return raw_key;
     }
 
+    // Generate the raw key range [begin_key, end_key) covering the sort key range of `req`.
+    // Since the raw keys of a hash key are ordered by their sort keys, appending '\0' to a
+    // raw key gives the smallest one after it.
+    static void generate_del_range_keys(const dsn::apps::del_range_request &req,
+                                        std::string &begin_key,
+                                        std::string &end_key)
+    {
+        begin_key = composite_raw_key(req.hash_key, req.start_sort_key).to_string();
+        if (!req.start_inclusive) {
+            begin_key.push_back('\0');
+        }
+
+        if (req.stop_sort_key.empty()) {
+            dsn::blob next_hash_key;
+            pegasus_generate_next_blob(next_hash_key, req.hash_key);
+            end_key = next_hash_key.to_string();
+            return;
+        }
+
+        end_key = composite_raw_key(req.hash_key, req.stop_sort_key).to_string();
+        if (req.stop_inclusive) {
+            end_key.push_back('\0');
+        }
+    }
+
     // Calculate expire timestamp in seconds for the keys not contained in the storage
     // according to `req`.
     template <typename TRequest>
@@ -1269,6 +1354,34 @@ private:
         return false;
     }
 
+    // Read the current value of `raw_key` while making an atomic write idempotent, preferring
+    // the pending result of the former atomic writes which have not been applied yet to
+    // RocksDB. `user_value` is set only if the key exists and has not expired.
+    int get_for_idempotent(const dsn::blob &raw_key,
+                           db_get_context &get_ctx,
+                           dsn::blob &user_value)
+    {
+        bool exist = false;
+        std::string pending_value;
+        uint32_t expire_ts = 0;
+        if (_pending_writes->lookup(raw_key.to_string_view(), exist, pending_value, expire_ts)) {
+            get_ctx.found = exist;
+            get_ctx.expire_ts = expire_ts;
+            get_ctx.expired = exist && check_if_ts_expired(utils::epoch_now(), expire_ts);
+            if (get_ctx.found && !get_ctx.expired) {
+                user_value = dsn::blob::create_from_bytes(std::move(pending_value));
+            }
+            return rocksdb::Status::kOk;
+        }
+
+        const int err = _rocksdb_wrapper->get(raw_key, &get_ctx);
+        if (err == rocksdb::Status::kOk && get_ctx.found && !get_ctx.expired) {
+            pegasus_extract_user_data(
+                _pegasus_data_version, std::move(get_ctx.raw_value), user_value);
+        }
+        return err;
+    }
+
     // The same as the above function, only used when the decree has not been assigned.
     bool validate_check(::dsn::apps::cas_check_type::type check_type,
                         const ::dsn::blob &check_operand,
@@ -1290,6 +1403,9 @@ private:
 
     std::unique_ptr<rocksdb_wrapper> _rocksdb_wrapper;
 
+    // The results of the atomic writes which have been made idempotent but not applied.
+    std::shared_ptr<pending_write_overlay> _pending_writes;
+
     // for setting update_response.error after committed.
     std::vector<dsn::apps::update_response *> _update_responses;
 };
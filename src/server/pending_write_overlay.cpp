@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "pending_write_overlay.h"
+
+#include "rrdb/rrdb_types.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+pending_write_overlay::holder_ptr
+pending_write_overlay::record(const std::vector<dsn::apps::update_request> &updates)
+{
+    std::vector<std::pair<std::string, uint64_t>> stamps;
+    stamps.reserve(updates.size());
+
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        for (const auto &update : updates) {
+            const bool exist = !(update.__isset.type &&
+                                 update.type == dsn::apps::update_type::UT_CHECK_AND_MUTATE_REMOVE);
+            auto &e = _entries[update.key.to_string()];
+            e.exist = exist;
+            if (exist) {
+                e.user_value.assign(update.value.data(), update.value.length());
+                e.expire_ts = static_cast<uint32_t>(update.expire_ts_seconds);
+            } else {
+                e.user_value.clear();
+                e.expire_ts = 0;
+            }
+            e.stamp = _next_stamp++;
+            stamps.emplace_back(update.key.to_string(), e.stamp);
+        }
+    }
+
+    return std::make_shared<holder>(weak_from_this(), std::move(stamps));
+}
+
+bool pending_write_overlay::lookup(std::string_view raw_key,
+                                   bool &exist,
+                                   std::string &user_value,
+                                   uint32_t &expire_ts) const
+{
+    std::lock_guard<std::mutex> l(_lock);
+    const auto iter = _entries.find(std::string(raw_key));
+    if (iter == _entries.end()) {
+        return false;
+    }
+
+    exist = iter->second.exist;
+    user_value = iter->second.user_value;
+    expire_ts = iter->second.expire_ts;
+    return true;
+}
+
+size_t pending_write_overlay::size() const
+{
+    std::lock_guard<std::mutex> l(_lock);
+    return _entries.size();
+}
+
+void pending_write_overlay::release(const std::vector<std::pair<std::string, uint64_t>> &stamps)
+{
+    std::lock_guard<std::mutex> l(_lock);
+    for (const auto &[key, stamp] : stamps) {
+        const auto iter = _entries.find(key);
+        // The entry may have been overwritten by a later atomic write, which is still pending.
+        if (iter != _entries.end() && iter->second.stamp == stamp) {
+            _entries.erase(iter);
+        }
+    }
+}
+
+} // namespace server
+} // namespace pegasus
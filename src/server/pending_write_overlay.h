@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utils/ports.h"
+
+namespace dsn {
+namespace apps {
+class update_request;
+} // namespace apps
+} // namespace dsn
+
+namespace pegasus {
+namespace server {
+
+// pending_write_overlay holds the results of the atomic writes (i.e. incr, check_and_set and
+// check_and_mutate) which have been translated into idempotent single-update requests by the
+// primary replica but not applied to RocksDB yet. make_idempotent() consults it before RocksDB,
+// thus the atomic writes on the same key could be pipelined through 2PC rather than waiting for
+// the former ones to be applied.
+//
+// The results of an atomic write are recorded once it has been made idempotent, and are
+// released as soon as the returned holder is destructed, i.e. once the idempotent writer is
+// applied or dropped. The result of a key is only released by the latest atomic write on it,
+// thus it always reflects the latest pending write.
+class pending_write_overlay : public std::enable_shared_from_this<pending_write_overlay>
+{
+public:
+    class holder
+    {
+    public:
+        holder(std::weak_ptr<pending_write_overlay> overlay,
+               std::vector<std::pair<std::string, uint64_t>> &&stamps)
+            : _overlay(std::move(overlay)), _stamps(std::move(stamps))
+        {
+        }
+
+        ~holder()
+        {
+            const auto overlay = _overlay.lock();
+            if (overlay) {
+                overlay->release(_stamps);
+            }
+        }
+
+    private:
+        const std::weak_ptr<pending_write_overlay> _overlay;
+        // The keys and the stamps they were recorded with.
+        const std::vector<std::pair<std::string, uint64_t>> _stamps;
+
+        DISALLOW_COPY_AND_ASSIGN(holder);
+    };
+    using holder_ptr = std::shared_ptr<holder>;
+
+    pending_write_overlay() = default;
+
+    // Record the results of the idempotent single-update requests translated from an atomic
+    // write. The overlay must be owned by a shared_ptr.
+    holder_ptr record(const std::vector<dsn::apps::update_request> &updates);
+
+    // Return true if there is a pending write on `raw_key`, with whether the key exists after
+    // the write, and its user value and expire timestamp if it exists.
+    bool lookup(std::string_view raw_key,
+                bool &exist,
+                std::string &user_value,
+                uint32_t &expire_ts) const;
+
+    size_t size() const;
+
+private:
+    struct entry
+    {
+        bool exist;
+        std::string user_value;
+        uint32_t expire_ts;
+        uint64_t stamp;
+    };
+
+    void release(const std::vector<std::pair<std::string, uint64_t>> &stamps);
+
+    mutable std::mutex _lock;
+    std::unordered_map<std::string, entry> _entries;
+    uint64_t _next_stamp{1};
+
+    DISALLOW_COPY_AND_ASSIGN(pending_write_overlay);
+};
+
+} // namespace server
+} // namespace pegasus
@@ -32,6 +32,8 @@ struct range_read_limiter_options
     uint64_t multi_get_max_iteration_size;
     uint32_t rocksdb_max_iteration_count;
     uint64_t rocksdb_iteration_threshold_time_ms;
+    uint32_t aggregate_scan_max_iteration_count;
+    uint64_t aggregate_scan_iteration_threshold_time_ms;
 };
 
 class range_read_limiter
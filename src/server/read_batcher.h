@@ -0,0 +1,174 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "utils/ports.h"
+
+namespace pegasus {
+namespace server {
+
+// read_batcher coalesces the reads arriving concurrently on a replica into batches, so that
+// each batch could be served by a single call such as rocksdb::DB::MultiGet().
+//
+// There is no dedicated thread, and no caller is blocked to wait for more items: the caller of
+// submit() which finds no batch in progress either executes a batch in its own thread, or
+// schedules a drain after the window by `schedule_drain` (e.g. by enqueuing a delayed task
+// calling drain()), while the other callers just append their items and return at once. The
+// caller whose item fills up a batch executes it without waiting for the scheduled drain. The
+// items appended during a batch are executed by the next batch, which is started by
+// `schedule_drain` with no delay rather than by the caller itself, thus the caller returns as
+// soon as its own batch is finished.
+template <typename T>
+class read_batcher
+{
+public:
+    using execute_func = std::function<void(std::vector<T> &)>;
+    using schedule_func = std::function<void(std::chrono::microseconds delay)>;
+
+    // `window` is the longest time to wait for more items before executing a batch which is
+    // not full, 0 means to execute the items that have been appended at once.
+    read_batcher(size_t max_batch_size,
+                 std::chrono::microseconds window,
+                 execute_func execute,
+                 schedule_func schedule_drain)
+        : _max_batch_size(std::max<size_t>(max_batch_size, 1)),
+          _window(window),
+          _execute(std::move(execute)),
+          _schedule_drain(std::move(schedule_drain))
+    {
+    }
+
+    void submit(T &&item)
+    {
+        std::unique_lock<std::mutex> l(_lock);
+        if (_stopped) {
+            l.unlock();
+            std::vector<T> batch;
+            batch.emplace_back(std::move(item));
+            _execute(batch);
+            return;
+        }
+
+        _pending.emplace_back(std::move(item));
+        if (_executing) {
+            return;
+        }
+
+        if (_window.count() == 0 || _pending.size() >= _max_batch_size) {
+            execute_batch(l);
+            return;
+        }
+
+        // Wait for more items by a drain after the window rather than blocking the caller. At
+        // most one such drain is scheduled at a time.
+        if (!_drain_scheduled) {
+            _drain_scheduled = true;
+            l.unlock();
+            _schedule_drain(_window);
+        }
+    }
+
+    // Execute a batch of the pending items if there is no batch in progress.
+    void drain()
+    {
+        std::unique_lock<std::mutex> l(_lock);
+        _drain_scheduled = false;
+        if (_executing || _pending.empty()) {
+            return;
+        }
+        execute_batch(l);
+    }
+
+    // Wait for the batch in progress and execute all the pending items. Once stopped, each item
+    // is executed by submit() synchronously.
+    void stop()
+    {
+        std::unique_lock<std::mutex> l(_lock);
+        _stopped = true;
+        _cond.notify_all();
+        _cond.wait(l, [this]() { return !_executing; });
+
+        std::vector<T> batch;
+        batch.swap(_pending);
+        l.unlock();
+        if (!batch.empty()) {
+            _execute(batch);
+        }
+    }
+
+private:
+    // `l` should be locked, and is unlocked when this function returns.
+    void execute_batch(std::unique_lock<std::mutex> &l)
+    {
+        _executing = true;
+
+        std::vector<T> batch;
+        if (_pending.size() <= _max_batch_size) {
+            batch.swap(_pending);
+        } else {
+            batch.reserve(_max_batch_size);
+            const auto end = _pending.begin() + _max_batch_size;
+            std::move(_pending.begin(), end, std::back_inserter(batch));
+            _pending.erase(_pending.begin(), end);
+        }
+        l.unlock();
+
+        _execute(batch);
+        batch.clear();
+
+        l.lock();
+        _executing = false;
+        const bool more = !_stopped && !_pending.empty();
+        _cond.notify_all();
+        l.unlock();
+
+        if (more) {
+            _schedule_drain(std::chrono::microseconds(0));
+        }
+    }
+
+    const size_t _max_batch_size;
+    const std::chrono::microseconds _window;
+    const execute_func _execute;
+    const schedule_func _schedule_drain;
+
+    std::mutex _lock;
+    std::condition_variable _cond;
+    std::vector<T> _pending;
+    bool _executing{false};
+    // Whether a drain after the window is scheduled and has not run yet.
+    bool _drain_scheduled{false};
+    bool _stopped{false};
+
+    DISALLOW_COPY_AND_ASSIGN(read_batcher);
+};
+
+} // namespace server
+} // namespace pegasus
@@ -30,6 +30,7 @@
 #include "pegasus_key_schema.h"
 #include "pegasus_utils.h"
 #include "pegasus_write_service_impl.h"
+#include "server/hot_row_cache.h"
 #include "server/logging_utils.h"
 #include "server/pegasus_server_impl.h"
 #include "server/pegasus_write_service.h"
@@ -63,6 +64,7 @@ rocksdb_wrapper::rocksdb_wrapper(pegasus_server_impl *server)
       _rd_opts(server->_data_cf_rd_opts),
       _data_cf(server->_data_cf),
       _meta_cf(server->_meta_cf),
+      _hot_row_cache(server->_hot_row_cache.get()),
       _pegasus_data_version(server->_pegasus_data_version),
       METRIC_VAR_INIT_replica(read_expired_values),
       _default_ttl(0)
@@ -167,7 +169,9 @@ int rocksdb_wrapper::write_batch_put_ctx(const db_write_context &ctx,
     rocksdb::SliceParts svalue = _value_generator->generate_value(
         _pegasus_data_version, value, db_expire_ts(expire_sec), new_timetag);
     rocksdb::Status s = _write_batch->Put(_data_cf, skey_parts, svalue);
-    if (dsn_unlikely(!s.ok())) {
+    if (dsn_likely(s.ok())) {
+        record_written_key(raw_key);
+    } else {
         dsn::blob hash_key;
         dsn::blob sort_key;
         pegasus_restore_key(::dsn::blob(raw_key.data(), 0, raw_key.size()), hash_key, sort_key);
@@ -215,6 +219,8 @@ int rocksdb_wrapper::write(int64_t decree)
     if (dsn_unlikely(!status.ok())) {
         LOG_ERROR_ROCKSDB("Write", status.ToString(), "write rocksdb error, decree: {}", decree);
     }
+    // Invalidate even if the write failed, since the batch may have been partially applied.
+    invalidate_written_keys();
     return status.code();
 }
 
@@ -224,7 +230,9 @@ int rocksdb_wrapper::write_batch_delete(int64_t decree, std::string_view raw_key
                         [](std::string_view) -> int { return FAIL_DB_WRITE_BATCH_DELETE; });
 
     rocksdb::Status s = _write_batch->Delete(_data_cf, utils::to_rocksdb_slice(raw_key));
-    if (dsn_unlikely(!s.ok())) {
+    if (dsn_likely(s.ok())) {
+        record_written_key(raw_key);
+    } else {
         dsn::blob hash_key;
         dsn::blob sort_key;
         pegasus_restore_key(dsn::blob(raw_key.data(), 0, raw_key.size()), hash_key, sort_key);
@@ -243,7 +251,36 @@ int rocksdb_wrapper::write_batch_delete(int64_t decree, const dsn::blob &raw_key
     return write_batch_delete(decree, raw_key.to_string_view());
 }
 
-void rocksdb_wrapper::clear_up_write_batch() { _write_batch->Clear(); }
+int rocksdb_wrapper::write_batch_delete_range(int64_t decree,
+                                              std::string_view begin_raw_key,
+                                              std::string_view end_raw_key)
+{
+    FAIL_POINT_INJECT_F("db_write_batch_delete_range",
+                        [](std::string_view) -> int { return FAIL_DB_WRITE_BATCH_DELETE_RANGE; });
+
+    rocksdb::Status s = _write_batch->DeleteRange(_data_cf,
+                                                  utils::to_rocksdb_slice(begin_raw_key),
+                                                  utils::to_rocksdb_slice(end_raw_key));
+    if (dsn_likely(s.ok())) {
+        _range_deleted = should_record_written_keys();
+    } else {
+        LOG_ERROR_ROCKSDB("write_batch_delete_range",
+                          s.ToString(),
+                          "decree: {}, begin_raw_key: {}, end_raw_key: {}",
+                          decree,
+                          utils::c_escape_sensitive_string(begin_raw_key),
+                          utils::c_escape_sensitive_string(end_raw_key));
+    }
+    return s.code();
+}
+
+void rocksdb_wrapper::clear_up_write_batch()
+{
+    _write_batch->Clear();
+    _written_keys.clear();
+    _batch_cache_generation.reset();
+    _range_deleted = false;
+}
 
 int rocksdb_wrapper::ingest_files(int64_t decree,
                                   const std::vector<std::string> &sst_file_list,
@@ -254,6 +291,9 @@ int rocksdb_wrapper::ingest_files(int64_t decree,
     ifo.ingest_behind = ingest_behind;
     ifo.write_global_seqno = FLAGS_rocksdb_write_global_seqno;
     rocksdb::Status s = _db->IngestExternalFile(_data_cf, sst_file_list, ifo);
+    if (_hot_row_cache != nullptr) {
+        _hot_row_cache->invalidate_all();
+    }
     if (dsn_unlikely(!s.ok())) {
         LOG_ERROR_ROCKSDB("IngestExternalFile",
                           s.ToString(),
@@ -277,6 +317,48 @@ void rocksdb_wrapper::set_default_ttl(uint32_t ttl)
     }
 }
 
+bool rocksdb_wrapper::should_record_written_keys()
+{
+    if (_hot_row_cache == nullptr) {
+        return false;
+    }
+
+    if (!_batch_cache_generation) {
+        _batch_cache_generation = _hot_row_cache->enabled_generation();
+    }
+    return hot_row_cache::is_enabled_generation(*_batch_cache_generation);
+}
+
+void rocksdb_wrapper::record_written_key(std::string_view raw_key)
+{
+    if (!raw_key.empty() && should_record_written_keys()) {
+        _written_keys.emplace_back(raw_key);
+    }
+}
+
+void rocksdb_wrapper::invalidate_written_keys()
+{
+    if (_batch_cache_generation) {
+        if (!hot_row_cache::is_enabled_generation(*_batch_cache_generation)) {
+            // The keys are not recorded since the cache was disabled. If it has been enabled
+            // since then, the reads in progress may fill the values overwritten by the batch.
+            if (_hot_row_cache->enabled_generation() != *_batch_cache_generation) {
+                _hot_row_cache->invalidate_all();
+            }
+        } else if (_range_deleted) {
+            // The cached rows are not ordered, thus they could not be invalidated by range.
+            _hot_row_cache->invalidate_all();
+        } else {
+            for (const auto &key : _written_keys) {
+                _hot_row_cache->invalidate(key);
+            }
+        }
+    }
+    _written_keys.clear();
+    _batch_cache_generation.reset();
+    _range_deleted = false;
+}
+
 uint32_t rocksdb_wrapper::db_expire_ts(uint32_t expire_ts)
 {
     // use '_default_ttl' when ttl is not set for this write operation.
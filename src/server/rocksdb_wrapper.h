@@ -24,6 +24,7 @@
 #include <rocksdb/write_batch.h>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -44,6 +45,7 @@ class DB;
 namespace pegasus {
 
 namespace server {
+class hot_row_cache;
 class pegasus_server_impl;
 struct db_get_context;
 struct db_write_context;
@@ -77,6 +79,10 @@ public:
     int write(int64_t decree);
     int write_batch_delete(int64_t decree, std::string_view raw_key);
     int write_batch_delete(int64_t decree, const dsn::blob &raw_key);
+    // Delete the raw keys within [begin_raw_key, end_raw_key) by a single range tombstone.
+    int write_batch_delete_range(int64_t decree,
+                                 std::string_view begin_raw_key,
+                                 std::string_view end_raw_key);
     void clear_up_write_batch();
     int ingest_files(int64_t decree,
                      const std::vector<std::string> &sst_file_list,
@@ -87,6 +93,15 @@ public:
 private:
     uint32_t db_expire_ts(uint32_t expire_ts);
 
+    // Record the key written into the batch, to be invalidated from the hot row cache once the
+    // batch is applied.
+    void record_written_key(std::string_view raw_key);
+    void invalidate_written_keys();
+
+    // Return true if the keys written into the batch should be recorded, i.e. the hot row cache
+    // is enabled when the first key is written into the batch.
+    bool should_record_written_keys();
+
     rocksdb::DB *_db;
     rocksdb::ReadOptions &_rd_opts;
     std::unique_ptr<pegasus_value_generator> _value_generator;
@@ -94,6 +109,14 @@ private:
     std::unique_ptr<rocksdb::WriteOptions> _wt_opts;
     rocksdb::ColumnFamilyHandle *_data_cf;
     rocksdb::ColumnFamilyHandle *_meta_cf;
+    hot_row_cache *_hot_row_cache;
+    std::vector<std::string> _written_keys;
+    // The enabled generation of the hot row cache got when the first key is written into the
+    // batch, nullopt if no key has been written.
+    std::optional<uint64_t> _batch_cache_generation;
+    // Whether a range has been deleted in the batch, in which case the whole hot row cache
+    // rather than `_written_keys` is invalidated.
+    bool _range_deleted{false};
 
     const uint32_t _pegasus_data_version;
     METRIC_VAR_DECLARE_counter(read_expired_values);
@@ -0,0 +1,173 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "scan_aggregator.h"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <utility>
+
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+scan_aggregator::scan_aggregator(const ::dsn::apps::aggregate_scan_request &request,
+                                 uint32_t epoch_now)
+    : _epoch_now(epoch_now),
+      _ttl_bucket_bounds(request.ttl_bucket_bounds_seconds),
+      _top_k_count(request.top_k_count > 0 ? static_cast<size_t>(request.top_k_count) : 0),
+      _top_k_order(request.top_k_order)
+{
+    if (!_ttl_bucket_bounds.empty()) {
+        _ttl_histogram.resize(_ttl_bucket_bounds.size() + 1, 0);
+    }
+
+    if (request.__isset.last_hash_key_stat) {
+        _has_current = true;
+        _current_hash_key = request.last_hash_key_stat.hash_key.to_string();
+        _current_row_count = request.last_hash_key_stat.row_count;
+        _current_data_size = request.last_hash_key_stat.data_size;
+    }
+}
+
+/*static*/ bool scan_aggregator::validate_request(
+    const ::dsn::apps::aggregate_scan_request &request, std::string &hint)
+{
+    const auto &bounds = request.ttl_bucket_bounds_seconds;
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        if (bounds[i] <= 0 || (i > 0 && bounds[i] <= bounds[i - 1])) {
+            hint = fmt::format("ttl_bucket_bounds_seconds should be positive and ascending, "
+                               "but bounds[{}] = {}",
+                               i,
+                               bounds[i]);
+            return false;
+        }
+    }
+
+    if (request.top_k_count < 0) {
+        hint = fmt::format("top_k_count({}) should not be negative", request.top_k_count);
+        return false;
+    }
+
+    if (request.top_k_order != ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT &&
+        request.top_k_order != ::dsn::apps::aggregate_top_k_order::ATO_DATA_SIZE) {
+        hint = fmt::format("top_k_order({}) is not supported", request.top_k_order);
+        return false;
+    }
+
+    return true;
+}
+
+bool scan_aggregator::add(std::string_view hash_key,
+                          size_t key_size,
+                          size_t value_size,
+                          uint32_t expire_ts)
+{
+    if (expire_ts != 0 && expire_ts <= _epoch_now) {
+        return false;
+    }
+
+    if (!_has_current || hash_key != _current_hash_key) {
+        finish_current_hash_key();
+        _has_current = true;
+        _current_hash_key.assign(hash_key.data(), hash_key.size());
+    }
+
+    ++_current_row_count;
+    _current_data_size += key_size + value_size;
+
+    ++_row_count;
+    _key_bytes += key_size;
+    _value_bytes += value_size;
+
+    if (expire_ts == 0) {
+        ++_no_ttl_count;
+    } else if (!_ttl_histogram.empty()) {
+        const auto ttl = static_cast<int64_t>(expire_ts - _epoch_now);
+        const auto bucket = std::upper_bound(_ttl_bucket_bounds.begin(),
+                                             _ttl_bucket_bounds.end(),
+                                             ttl,
+                                             [](int64_t t, int32_t bound) { return t < bound; }) -
+                            _ttl_bucket_bounds.begin();
+        ++_ttl_histogram[bucket];
+    }
+
+    return true;
+}
+
+void scan_aggregator::finish_current_hash_key()
+{
+    if (!_has_current) {
+        return;
+    }
+
+    ++_hash_key_count;
+
+    if (_top_k_count > 0) {
+        const int64_t weight = _top_k_order == ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT
+                                   ? _current_row_count
+                                   : _current_data_size;
+        if (_top_heap.size() < _top_k_count || weight > _top_heap.top().weight) {
+            top_item item;
+            item.weight = weight;
+            item.stat.hash_key = ::dsn::blob::create_from_bytes(std::move(_current_hash_key));
+            item.stat.row_count = _current_row_count;
+            item.stat.data_size = _current_data_size;
+            _top_heap.emplace(std::move(item));
+            if (_top_heap.size() > _top_k_count) {
+                _top_heap.pop();
+            }
+        }
+    }
+
+    _has_current = false;
+    _current_hash_key.clear();
+    _current_row_count = 0;
+    _current_data_size = 0;
+}
+
+void scan_aggregator::finish(bool complete, ::dsn::apps::aggregate_scan_response &resp)
+{
+    if (complete) {
+        finish_current_hash_key();
+    } else if (_has_current) {
+        ::dsn::apps::hash_key_stat stat;
+        stat.hash_key = ::dsn::blob::create_from_bytes(std::string(_current_hash_key));
+        stat.row_count = _current_row_count;
+        stat.data_size = _current_data_size;
+        resp.__set_last_hash_key_stat(std::move(stat));
+    }
+
+    resp.row_count = _row_count;
+    resp.hash_key_count = _hash_key_count;
+    resp.key_bytes = _key_bytes;
+    resp.value_bytes = _value_bytes;
+    resp.no_ttl_count = _no_ttl_count;
+    resp.ttl_histogram = _ttl_histogram;
+
+    resp.top_hash_keys.resize(_top_heap.size());
+    for (auto it = resp.top_hash_keys.rbegin(); it != resp.top_hash_keys.rend(); ++it) {
+        *it = _top_heap.top().stat;
+        _top_heap.pop();
+    }
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <rrdb/rrdb_types.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace pegasus {
+namespace server {
+
+// scan_aggregator accumulates the statistics of the rows for an aggregate_scan_request.
+//
+// The rows must be added in key order, thus all the rows of a hash key are adjacent. A hash
+// key is "finished" once a row of another hash key is added, or finish() is called with
+// `complete` = true. Only the finished hash keys are counted and ranked, the unfinished one
+// is returned to the client to be carried by the next request, so that the results of all
+// the requests could be merged exactly.
+class scan_aggregator
+{
+public:
+    // `request` should have been validated by validate_request().
+    scan_aggregator(const ::dsn::apps::aggregate_scan_request &request, uint32_t epoch_now);
+
+    // Return false if the parameters for aggregation of `request` are invalid, with the
+    // reason in `hint`.
+    static bool validate_request(const ::dsn::apps::aggregate_scan_request &request,
+                                 std::string &hint);
+
+    // `expire_ts` is 0 if the row has no ttl. Return false without adding the row if it has
+    // expired by epoch_now, in which case the caller should count it as expired.
+    [[nodiscard]] bool
+    add(std::string_view hash_key, size_t key_size, size_t value_size, uint32_t expire_ts);
+
+    // Fill the aggregated result into `resp`. If `complete` is false, the last hash key is
+    // returned as unfinished by `resp.last_hash_key_stat`.
+    void finish(bool complete, ::dsn::apps::aggregate_scan_response &resp);
+
+private:
+    void finish_current_hash_key();
+
+    struct top_item
+    {
+        int64_t weight;
+        ::dsn::apps::hash_key_stat stat;
+
+        bool operator>(const top_item &other) const { return weight > other.weight; }
+    };
+
+    const uint32_t _epoch_now;
+    const std::vector<int32_t> _ttl_bucket_bounds;
+    const size_t _top_k_count;
+    const ::dsn::apps::aggregate_top_k_order::type _top_k_order;
+
+    bool _has_current{false};
+    std::string _current_hash_key;
+    int64_t _current_row_count{0};
+    int64_t _current_data_size{0};
+
+    int64_t _row_count{0};
+    int64_t _hash_key_count{0};
+    int64_t _key_bytes{0};
+    int64_t _value_bytes{0};
+    int64_t _no_ttl_count{0};
+    std::vector<int64_t> _ttl_histogram;
+
+    // A min-heap holding the top `_top_k_count` finished hash keys.
+    std::priority_queue<top_item, std::vector<top_item>, std::greater<top_item>> _top_heap;
+};
+
+} // namespace server
+} // namespace pegasus
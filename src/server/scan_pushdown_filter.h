@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <rrdb/rrdb_types.h>
+#include <stdint.h>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "key_filter.h"
+
+namespace pegasus {
+namespace server {
+
+// scan_pushdown_filter is compiled from dsn::apps::scan_pushdown once for a scan, and then
+// evaluated on each row right after the key filters.
+class scan_pushdown_filter
+{
+public:
+    // Construct a filter that matches everything and projects both key and value.
+    scan_pushdown_filter() = default;
+
+    explicit scan_pushdown_filter(const ::dsn::apps::scan_pushdown &pushdown)
+        : _value_filter(pushdown.__isset.value_filter_type
+                            ? pushdown.value_filter_type
+                            : ::dsn::apps::filter_type::FT_NO_FILTER,
+                        pushdown.value_filter_pattern.to_string_view())
+    {
+        if (pushdown.__isset.value_start) {
+            _value_start = pushdown.value_start.to_string();
+        }
+        if (pushdown.__isset.value_stop) {
+            _value_stop = pushdown.value_stop.to_string();
+        }
+        // A negative bound would be cast to a huge unsigned one, thus it is rejected.
+        if (pushdown.__isset.min_expire_ts_seconds) {
+            _valid_expire_ts = pushdown.min_expire_ts_seconds >= 0;
+            _min_expire_ts = static_cast<uint32_t>(pushdown.min_expire_ts_seconds);
+        }
+        if (pushdown.__isset.max_expire_ts_seconds) {
+            _valid_expire_ts = _valid_expire_ts && pushdown.max_expire_ts_seconds >= 0;
+            _max_expire_ts = static_cast<uint32_t>(pushdown.max_expire_ts_seconds);
+        }
+        if (pushdown.__isset.projection) {
+            _projection = pushdown.projection;
+        }
+
+        _match_all = _value_filter.match_all() && !_value_start && !_value_stop &&
+                     _min_expire_ts == 0 &&
+                     _max_expire_ts == std::numeric_limits<uint32_t>::max();
+    }
+
+    scan_pushdown_filter(scan_pushdown_filter &&) = default;
+    scan_pushdown_filter &operator=(scan_pushdown_filter &&) = default;
+
+    bool valid() const
+    {
+        return _value_filter.valid() && _valid_expire_ts &&
+               _projection >= ::dsn::apps::scan_projection::SP_KEY_VALUE &&
+               _projection <= ::dsn::apps::scan_projection::SP_VALUE_LENGTH;
+    }
+
+    // Return true if every row would pass the predicates, thus no need to call match().
+    bool match_all() const { return _match_all; }
+
+    // Return true if the row with `expire_ts` and `user_value` passes all the predicates.
+    bool match(uint32_t expire_ts, std::string_view user_value) const
+    {
+        if (_match_all) {
+            return true;
+        }
+
+        if (expire_ts < _min_expire_ts || expire_ts > _max_expire_ts) {
+            return false;
+        }
+
+        if (_value_start && user_value < std::string_view(*_value_start)) {
+            return false;
+        }
+
+        if (_value_stop && user_value >= std::string_view(*_value_stop)) {
+            return false;
+        }
+
+        return _value_filter.match_all() || _value_filter.match(user_value);
+    }
+
+    ::dsn::apps::scan_projection::type projection() const { return _projection; }
+
+    bool no_value() const { return _projection != ::dsn::apps::scan_projection::SP_KEY_VALUE; }
+
+    bool return_value_length() const
+    {
+        return _projection == ::dsn::apps::scan_projection::SP_VALUE_LENGTH;
+    }
+
+private:
+    key_filter _value_filter;
+    std::optional<std::string> _value_start;
+    std::optional<std::string> _value_stop;
+    uint32_t _min_expire_ts{0};
+    uint32_t _max_expire_ts{std::numeric_limits<uint32_t>::max()};
+    bool _valid_expire_ts{true};
+    ::dsn::apps::scan_projection::type _projection{::dsn::apps::scan_projection::SP_KEY_VALUE};
+    bool _match_all{true};
+};
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace pegasus {
+namespace server {
+
+struct split_key_candidate
+{
+    std::string key;
+    // The approximate size of the data in [range start, key).
+    uint64_t size_before;
+};
+
+// Select at most `split_count - 1` keys from `candidates` to split a range, whose approximate
+// size is `total_size`, into `split_count` sub-ranges of similar sizes.
+//
+// `candidates` must be sorted by key, and their `size_before` must be non-decreasing. The
+// selected keys are strictly ascending. Fewer keys are returned if there are not enough
+// distinct candidates, e.g. the range is too small.
+inline std::vector<std::string>
+select_split_keys(const std::vector<split_key_candidate> &candidates,
+                  uint64_t total_size,
+                  int32_t split_count)
+{
+    std::vector<std::string> split_keys;
+    if (split_count <= 1 || total_size == 0 || candidates.empty()) {
+        return split_keys;
+    }
+
+    split_keys.reserve(split_count - 1);
+    size_t i = 0;
+    for (int32_t k = 1; k < split_count; ++k) {
+        const auto target =
+            static_cast<uint64_t>(static_cast<double>(total_size) * k / split_count);
+        while (i < candidates.size() && candidates[i].size_before < target) {
+            ++i;
+        }
+        if (i >= candidates.size()) {
+            break;
+        }
+
+        // Never split at a key with no data before it, which would produce an empty sub-range.
+        if (candidates[i].size_before > 0 &&
+            (split_keys.empty() || split_keys.back() < candidates[i].key)) {
+            split_keys.push_back(candidates[i].key);
+        }
+        ++i;
+    }
+
+    return split_keys;
+}
+
+} // namespace server
+} // namespace pegasus
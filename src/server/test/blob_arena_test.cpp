@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/blob_arena.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+TEST(blob_arena_test, copy_into_shared_blocks)
+{
+    blob_arena arena(64);
+    ASSERT_EQ(0, arena.allocated_blocks());
+
+    // Empty data never allocates.
+    ASSERT_TRUE(arena.copy("", 0).empty());
+    ASSERT_EQ(0, arena.allocated_blocks());
+
+    std::vector<dsn::blob> blobs;
+    for (int i = 0; i < 8; ++i) {
+        blobs.emplace_back(arena.copy(std::string(10, 'a' + i)));
+    }
+    // 8 pieces of 10 bytes need 2 blocks of 64 bytes.
+    ASSERT_EQ(2, arena.allocated_blocks());
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_EQ(std::string(10, 'a' + i), blobs[i].to_string());
+    }
+
+    // Pieces in the same block share the same buffer.
+    ASSERT_EQ(blobs[0].buffer_ptr(), blobs[5].buffer_ptr());
+    ASSERT_NE(blobs[0].buffer_ptr(), blobs[6].buffer_ptr());
+}
+
+TEST(blob_arena_test, large_piece_allocated_individually)
+{
+    blob_arena arena(64);
+    auto small = arena.copy(std::string(8, 's'));
+    auto large = arena.copy(std::string(32, 'l'));
+    ASSERT_EQ(1, arena.allocated_blocks());
+    ASSERT_NE(small.buffer_ptr(), large.buffer_ptr());
+    ASSERT_EQ(std::string(32, 'l'), large.to_string());
+}
+
+TEST(blob_arena_test, blobs_outlive_arena)
+{
+    dsn::blob b;
+    {
+        blob_arena arena;
+        b = arena.copy(std::string("pegasus"));
+    }
+    ASSERT_EQ("pegasus", b.to_string());
+}
+
+} // namespace server
+} // namespace pegasus
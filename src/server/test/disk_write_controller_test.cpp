@@ -0,0 +1,173 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/disk_write_controller.h"
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/status.h>
+#include <rocksdb/write_buffer_manager.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/fs_manager.h"
+#include "gtest/gtest.h"
+#include "test_util/test_util.h"
+#include "utils/filesystem.h"
+
+namespace pegasus {
+namespace server {
+
+class disk_write_controller_test : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        dsn::utils::filesystem::remove_path(kDir);
+        ASSERT_TRUE(dsn::utils::filesystem::create_directory(kDir));
+        _controller = std::make_shared<disk_write_controller>(
+            _dn.disk_metric_entity(), 64 << 20, nullptr);
+    }
+
+    void TearDown() override
+    {
+        for (auto *db : _dbs) {
+            _controller->remove_db(db);
+            delete db;
+        }
+        _dbs.clear();
+        _controller.reset();
+        dsn::utils::filesystem::remove_path(kDir);
+    }
+
+    rocksdb::DB *open_db(const std::string &name)
+    {
+        rocksdb::Options opts;
+        opts.create_if_missing = true;
+        opts.write_buffer_manager = _controller->write_buffer_manager();
+        rocksdb::DB *db = nullptr;
+        const auto s =
+            rocksdb::DB::Open(opts, dsn::utils::filesystem::path_combine(kDir, name), &db);
+        EXPECT_TRUE(s.ok()) << s.ToString();
+        _dbs.push_back(db);
+        _controller->add_db(db, {db->DefaultColumnFamily()});
+        return db;
+    }
+
+    static void put(rocksdb::DB *db, int count)
+    {
+        const std::string value(1024, 'v');
+        for (int i = 0; i < count; ++i) {
+            ASSERT_TRUE(db->Put(rocksdb::WriteOptions(), std::to_string(i), value).ok());
+        }
+    }
+
+    static uint64_t memtable_size(rocksdb::DB *db)
+    {
+        uint64_t size = 0;
+        EXPECT_TRUE(db->GetIntProperty(rocksdb::DB::Properties::kCurSizeActiveMemTable, &size));
+        return size;
+    }
+
+    static void wait_flushed(rocksdb::DB *db)
+    {
+        ASSERT_IN_TIME(
+            [db] {
+                uint64_t pending = 0;
+                uint64_t running = 0;
+                ASSERT_TRUE(
+                    db->GetIntProperty(rocksdb::DB::Properties::kMemTableFlushPending, &pending));
+                ASSERT_TRUE(
+                    db->GetIntProperty(rocksdb::DB::Properties::kNumRunningFlushes, &running));
+                ASSERT_EQ(0, pending + running);
+            },
+            10);
+    }
+
+    const std::string kDir = "disk_write_controller_test";
+    dsn::replication::dir_node _dn{"test_disk", kDir};
+    std::shared_ptr<disk_write_controller> _controller;
+    std::vector<rocksdb::DB *> _dbs;
+};
+
+TEST_F(disk_write_controller_test, get_or_create)
+{
+    auto c1 = disk_write_controller::get_or_create("disk1", _dn.disk_metric_entity(), 100, nullptr);
+    auto c2 = disk_write_controller::get_or_create("disk1", _dn.disk_metric_entity(), 200, nullptr);
+    auto c3 = disk_write_controller::get_or_create("disk2", _dn.disk_metric_entity(), 300, nullptr);
+    ASSERT_EQ(c1, c2);
+    ASSERT_NE(c1, c3);
+    ASSERT_EQ(100, c1->write_buffer_manager()->buffer_size());
+    ASSERT_EQ(300, c3->write_buffer_manager()->buffer_size());
+
+    // The controller is recreated once all the replicas on the disk have released it.
+    c1.reset();
+    c2.reset();
+    auto c4 = disk_write_controller::get_or_create("disk1", _dn.disk_metric_entity(), 400, nullptr);
+    ASSERT_EQ(400, c4->write_buffer_manager()->buffer_size());
+}
+
+TEST_F(disk_write_controller_test, below_watermark)
+{
+    auto *db = open_db("db1");
+    put(db, 100);
+    ASSERT_FALSE(_controller->maybe_flush(1000, 1000, 90));
+    ASSERT_GT(memtable_size(db), 0);
+}
+
+TEST_F(disk_write_controller_test, check_interval)
+{
+    auto *db = open_db("db1");
+    put(db, 100);
+    // A watermark of 0 makes every check flush as long as there is any data.
+    ASSERT_TRUE(_controller->maybe_flush(1000, 1000, 0));
+    wait_flushed(db);
+
+    put(db, 100);
+    ASSERT_FALSE(_controller->maybe_flush(1500, 1000, 0));
+    ASSERT_TRUE(_controller->maybe_flush(2000, 1000, 0));
+}
+
+TEST_F(disk_write_controller_test, prefer_cold_db)
+{
+    auto *hot = open_db("hot");
+    auto *cold = open_db("cold");
+    put(hot, 200);
+    put(cold, 150);
+
+    // The first check records the sizes and flushes the largest memtable, since none of the
+    // replicas could be considered as cold yet.
+    ASSERT_TRUE(_controller->maybe_flush(1000, 1000, 0));
+    wait_flushed(hot);
+    ASSERT_LT(memtable_size(hot), memtable_size(cold));
+
+    // Now `hot` keeps being written while `cold` does not, thus `cold` is flushed although its
+    // memtable is smaller.
+    put(hot, 250);
+    const auto cold_size = memtable_size(cold);
+    ASSERT_GT(memtable_size(hot), cold_size);
+    ASSERT_TRUE(_controller->maybe_flush(2000, 1000, 0));
+    wait_flushed(cold);
+    ASSERT_LT(memtable_size(cold), cold_size / 2);
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,166 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/hot_row_cache.h"
+
+#include <stdint.h>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+const uint32_t kEpochNow = 1000;
+
+// Fill `key` with `value` as a reader missing the cache.
+void fill(hot_row_cache &cache,
+          const std::string &key,
+          const std::string &value,
+          uint32_t expire_ts = 0)
+{
+    std::string cached;
+    uint64_t ticket = 0;
+    ASSERT_FALSE(cache.lookup(key, kEpochNow, cached, ticket));
+    cache.insert(key, value, expire_ts, ticket);
+}
+
+bool cached(hot_row_cache &cache, const std::string &key, std::string *value = nullptr)
+{
+    std::string cached_value;
+    uint64_t ticket = 0;
+    if (!cache.lookup(key, kEpochNow, cached_value, ticket)) {
+        return false;
+    }
+    if (value != nullptr) {
+        *value = cached_value;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+TEST(hot_row_cache_test, lookup_and_invalidate)
+{
+    hot_row_cache cache(1 << 20, 4);
+
+    // Nothing is cached while disabled.
+    fill(cache, "k1", "v1");
+    ASSERT_FALSE(cached(cache, "k1"));
+
+    cache.set_enabled(true);
+    fill(cache, "k1", "v1");
+    fill(cache, "k2", "v2", kEpochNow);
+    fill(cache, "k3", "v3", kEpochNow + 1);
+
+    std::string value;
+    ASSERT_TRUE(cached(cache, "k1", &value));
+    ASSERT_EQ("v1", value);
+    // The expired row is dropped.
+    ASSERT_FALSE(cached(cache, "k2"));
+    ASSERT_TRUE(cached(cache, "k3", &value));
+    ASSERT_EQ("v3", value);
+    ASSERT_GT(cache.mem_usage(), 0);
+
+    cache.invalidate("k1");
+    ASSERT_FALSE(cached(cache, "k1"));
+    ASSERT_TRUE(cached(cache, "k3"));
+
+    cache.set_enabled(false);
+    ASSERT_FALSE(cached(cache, "k3"));
+    ASSERT_EQ(0, cache.mem_usage());
+}
+
+TEST(hot_row_cache_test, reject_stale_fill)
+{
+    hot_row_cache cache(1 << 20, 1);
+    cache.set_enabled(true);
+
+    // A write is applied between the lookup and the fill of a reader.
+    std::string value;
+    uint64_t ticket = 0;
+    ASSERT_FALSE(cache.lookup("k1", kEpochNow, value, ticket));
+    cache.invalidate("k1");
+    cache.insert("k1", "stale", 0, ticket);
+    ASSERT_FALSE(cached(cache, "k1"));
+
+    ASSERT_FALSE(cache.lookup("k1", kEpochNow, value, ticket));
+    cache.invalidate_all();
+    cache.insert("k1", "stale", 0, ticket);
+    ASSERT_FALSE(cached(cache, "k1"));
+
+    fill(cache, "k1", "fresh");
+    ASSERT_TRUE(cached(cache, "k1", &value));
+    ASSERT_EQ("fresh", value);
+}
+
+TEST(hot_row_cache_test, enabled_generation)
+{
+    hot_row_cache cache(1 << 20, 1);
+    const auto disabled = cache.enabled_generation();
+    ASSERT_FALSE(hot_row_cache::is_enabled_generation(disabled));
+
+    // Setting the same state does not change the generation.
+    cache.set_enabled(false);
+    ASSERT_EQ(disabled, cache.enabled_generation());
+
+    cache.set_enabled(true);
+    const auto enabled = cache.enabled_generation();
+    ASSERT_TRUE(hot_row_cache::is_enabled_generation(enabled));
+    ASSERT_NE(disabled, enabled);
+    cache.set_enabled(true);
+    ASSERT_EQ(enabled, cache.enabled_generation());
+
+    cache.set_enabled(false);
+    cache.set_enabled(true);
+    ASSERT_TRUE(cache.enabled());
+    ASSERT_NE(enabled, cache.enabled_generation());
+}
+
+TEST(hot_row_cache_test, clock_eviction)
+{
+    // Each row is charged much more than its key and value, so a shard of 1KB holds only a few.
+    hot_row_cache cache(1024, 1);
+    cache.set_enabled(true);
+
+    fill(cache, "hot", "v");
+    int count = 0;
+    for (; count < 100 && cache.mem_usage() + 256 < 1024; ++count) {
+        fill(cache, "cold" + std::to_string(count), "v");
+    }
+    ASSERT_GT(count, 0);
+
+    // The referenced row survives a round of eviction, while the cold ones are evicted.
+    ASSERT_TRUE(cached(cache, "hot"));
+    for (int i = 0; i < count; ++i) {
+        fill(cache, "new" + std::to_string(i), "v");
+    }
+    ASSERT_TRUE(cached(cache, "hot"));
+    ASSERT_FALSE(cached(cache, "cold0"));
+    ASSERT_LE(cache.mem_usage(), 1024);
+
+    // The row larger than a shard is never cached.
+    fill(cache, "large", std::string(2048, 'v'));
+    ASSERT_FALSE(cached(cache, "large"));
+}
+
+} // namespace server
+} // namespace pegasus
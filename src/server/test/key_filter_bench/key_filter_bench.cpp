@@ -0,0 +1,197 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <fmt/core.h>
+#include <rocksdb/slice.h>
+#include <rrdb/rrdb_types.h>
+#include <stdint.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "base/pegasus_key_schema.h"
+#include "runtime/api_layer1.h"
+#include "server/key_filter.h"
+#include "utils/blob.h"
+#include "utils/rand.h"
+#include "utils/string_conv.h"
+#include "utils/strings.h"
+
+void print_usage(const char *cmd)
+{
+    fmt::print("USAGE: {} <num_keys> <hash_key_size> <sort_key_size> <filter_type> <pattern>\n",
+               cmd);
+    fmt::print("Run a simple benchmark that compares the scan key filter applied on restored\n"
+               "keys (the legacy way) with the compiled raw_key_filter.\n\n");
+
+    fmt::print("    <num_keys>             the number of keys to be filtered.\n");
+    fmt::print("    <hash_key_size>        the size of each hash key.\n");
+    fmt::print("    <sort_key_size>        the size of each sort key.\n");
+    fmt::print("    <filter_type>          the hash key filter type, could be anywhere, \n"
+               "                           prefix or postfix.\n");
+    fmt::print("    <pattern>              the hash key filter pattern.\n");
+}
+
+// The way the filter was applied before raw_key_filter was introduced.
+bool legacy_validate_filter(::dsn::apps::filter_type::type filter_type,
+                            const ::dsn::blob &filter_pattern,
+                            const ::dsn::blob &value)
+{
+    if (filter_pattern.length() == 0)
+        return true;
+    if (value.length() < filter_pattern.length())
+        return false;
+    if (filter_type == ::dsn::apps::filter_type::FT_MATCH_ANYWHERE) {
+        return value.to_string_view().find(filter_pattern.to_string_view()) !=
+               std::string_view::npos;
+    } else if (filter_type == ::dsn::apps::filter_type::FT_MATCH_PREFIX) {
+        return dsn::utils::mequals(value.data(), filter_pattern.data(), filter_pattern.length());
+    } else {
+        return dsn::utils::mequals(value.data() + value.length() - filter_pattern.length(),
+                                   filter_pattern.data(),
+                                   filter_pattern.length());
+    }
+}
+
+std::string random_string(size_t size)
+{
+    static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::string str(size, '\0');
+    for (auto &c : str) {
+        c = kAlphabet[dsn::rand::next_u32(0, sizeof(kAlphabet) - 2)];
+    }
+    return str;
+}
+
+void run_bench(uint64_t num_keys,
+               uint64_t hash_key_size,
+               uint64_t sort_key_size,
+               ::dsn::apps::filter_type::type filter_type,
+               const std::string &pattern)
+{
+    std::vector<dsn::blob> raw_keys;
+    raw_keys.reserve(num_keys);
+    for (uint64_t i = 0; i < num_keys; ++i) {
+        dsn::blob raw_key;
+        pegasus::pegasus_generate_key(
+            raw_key, random_string(hash_key_size), random_string(sort_key_size));
+        raw_keys.emplace_back(std::move(raw_key));
+    }
+
+    uint64_t legacy_matched = 0;
+    const dsn::blob pattern_blob(pattern.data(), 0, pattern.size());
+    auto start = dsn_now_ns();
+    for (const auto &raw_key : raw_keys) {
+        dsn::blob hash_key, sort_key;
+        pegasus::pegasus_restore_key(raw_key, hash_key, sort_key);
+        if (legacy_validate_filter(filter_type, pattern_blob, hash_key)) {
+            ++legacy_matched;
+        }
+    }
+    auto legacy_time_ns = dsn_now_ns() - start;
+
+    uint64_t compiled_matched = 0;
+    start = dsn_now_ns();
+    pegasus::server::raw_key_filter filter(
+        filter_type, pattern, ::dsn::apps::filter_type::FT_NO_FILTER, "");
+    if (!filter.valid()) {
+        fmt::print(stderr, "Invalid filter: type = {}, pattern = {}\n", filter_type, pattern);
+        ::exit(-1);
+    }
+    for (const auto &raw_key : raw_keys) {
+        if (filter.match(rocksdb::Slice(raw_key.data(), raw_key.length())) ==
+            pegasus::server::raw_key_filter::result::kMatched) {
+            ++compiled_matched;
+        }
+    }
+    auto compiled_time_ns = dsn_now_ns() - start;
+
+    auto to_seconds = [](uint64_t ns) {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(
+                   std::chrono::nanoseconds(ns))
+            .count();
+    };
+
+    if (legacy_matched != compiled_matched) {
+        fmt::print(
+            "legacy_matched({}) != compiled_matched({})\n", legacy_matched, compiled_matched);
+        ::exit(-1);
+    }
+    fmt::print("Filtering {} keys by legacy filter took {} seconds, {} matched.\n",
+               num_keys,
+               to_seconds(legacy_time_ns),
+               legacy_matched);
+    fmt::print("Filtering {} keys by compiled filter took {} seconds, {} matched.\n",
+               num_keys,
+               to_seconds(compiled_time_ns),
+               compiled_matched);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 6) {
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t num_keys;
+    if (!dsn::buf2uint64(argv[1], num_keys) || num_keys == 0) {
+        fmt::print(stderr, "Invalid num_keys: {}\n\n", argv[1]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t hash_key_size;
+    if (!dsn::buf2uint64(argv[2], hash_key_size) || hash_key_size >= UINT16_MAX) {
+        fmt::print(stderr, "Invalid hash_key_size: {}\n\n", argv[2]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t sort_key_size;
+    if (!dsn::buf2uint64(argv[3], sort_key_size)) {
+        fmt::print(stderr, "Invalid sort_key_size: {}\n\n", argv[3]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    const std::string type_str(argv[4]);
+    ::dsn::apps::filter_type::type filter_type;
+    if (type_str == "anywhere") {
+        filter_type = ::dsn::apps::filter_type::FT_MATCH_ANYWHERE;
+    } else if (type_str == "prefix") {
+        filter_type = ::dsn::apps::filter_type::FT_MATCH_PREFIX;
+    } else if (type_str == "postfix") {
+        filter_type = ::dsn::apps::filter_type::FT_MATCH_POSTFIX;
+    } else {
+        fmt::print(stderr, "Invalid filter_type: {}\n\n", type_str);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    run_bench(num_keys, hash_key_size, sort_key_size, filter_type, argv[5]);
+
+    return 0;
+}
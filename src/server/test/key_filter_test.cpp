@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/key_filter.h"
+
+#include <rocksdb/slice.h>
+#include <rrdb/rrdb_types.h>
+#include <string>
+#include <string_view>
+
+#include "base/pegasus_key_schema.h"
+#include "gtest/gtest.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+TEST(key_filter_test, find_substring)
+{
+    struct test_case
+    {
+        std::string haystack;
+        std::string needle;
+    } tests[] = {
+        {"", ""},
+        {"abc", ""},
+        {"", "a"},
+        {"a", "a"},
+        {"abc", "c"},
+        {"abc", "abcd"},
+        {"abcabcabd", "abd"},
+        {"abcabcabc", "abd"},
+        // Longer than a SIMD vector, with the match in the middle or the tail.
+        {std::string(100, 'x') + "needle" + std::string(100, 'y'), "needle"},
+        {std::string(100, 'x') + "needle", "needle"},
+        {std::string(100, 'x') + "needl", "needle"},
+        {std::string(63, 'n') + "e", "ne"},
+        {std::string(64, 'a'), std::string(33, 'a')},
+        {std::string(64, 'a'), std::string(65, 'a')},
+    };
+
+    for (const auto &test : tests) {
+        ASSERT_EQ(std::string_view(test.haystack).find(test.needle),
+                  find_substring(test.haystack, test.needle))
+            << "haystack = " << test.haystack << ", needle = " << test.needle;
+    }
+}
+
+TEST(key_filter_test, match)
+{
+    struct test_case
+    {
+        ::dsn::apps::filter_type::type type;
+        std::string pattern;
+        std::string data;
+        bool expected_match;
+    } tests[] = {
+        {::dsn::apps::filter_type::FT_NO_FILTER, "", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_ANYWHERE, "", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_ANYWHERE, "b", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_ANYWHERE, "d", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_ANYWHERE, "abcd", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_PREFIX, "ab", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_PREFIX, "bc", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_POSTFIX, "bc", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_POSTFIX, "ab", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_EXACT, "abc", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_EXACT, "ab", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_EXACT, "", "", true},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "*", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "", "", true},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "a?c", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "a*", "abc", true},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "b*", "abc", false},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "user_*_2024*", "user_1_2024_01", true},
+        {::dsn::apps::filter_type::FT_MATCH_GLOB, "user_*_2024*", "user_1_2023_01", false},
+    };
+
+    for (const auto &test : tests) {
+        key_filter filter(test.type, test.pattern);
+        ASSERT_TRUE(filter.valid());
+        ASSERT_EQ(test.expected_match, filter.match(test.data))
+            << "type = " << test.type << ", pattern = " << test.pattern
+            << ", data = " << test.data;
+    }
+}
+
+TEST(key_filter_test, glob_match_all)
+{
+    ASSERT_TRUE(key_filter(::dsn::apps::filter_type::FT_MATCH_GLOB, "*").match_all());
+    ASSERT_TRUE(key_filter(::dsn::apps::filter_type::FT_MATCH_GLOB, "**").match_all());
+    ASSERT_FALSE(key_filter(::dsn::apps::filter_type::FT_MATCH_GLOB, "").match_all());
+    ASSERT_FALSE(key_filter(::dsn::apps::filter_type::FT_MATCH_GLOB, "*?").match_all());
+}
+
+TEST(key_filter_test, invalid_filter)
+{
+    ASSERT_FALSE(key_filter(static_cast<::dsn::apps::filter_type::type>(100), "a").valid());
+}
+
+TEST(key_filter_test, raw_key_filter)
+{
+    raw_key_filter no_filter;
+    ASSERT_TRUE(no_filter.match_all());
+
+    raw_key_filter filter(::dsn::apps::filter_type::FT_MATCH_PREFIX,
+                          "hash",
+                          ::dsn::apps::filter_type::FT_MATCH_POSTFIX,
+                          "sort");
+    ASSERT_TRUE(filter.valid());
+    ASSERT_FALSE(filter.match_all());
+
+    struct test_case
+    {
+        std::string hash_key;
+        std::string sort_key;
+        raw_key_filter::result expected_result;
+    } tests[] = {
+        {"hash_key", "the_sort", raw_key_filter::result::kMatched},
+        {"hash", "sort", raw_key_filter::result::kMatched},
+        {"has", "sort", raw_key_filter::result::kHashKeyFiltered},
+        {"", "hashsort", raw_key_filter::result::kHashKeyFiltered},
+        {"hash_key", "sort_key", raw_key_filter::result::kSortKeyFiltered},
+        {"hash_key", "", raw_key_filter::result::kSortKeyFiltered},
+    };
+
+    for (const auto &test : tests) {
+        dsn::blob raw_key;
+        pegasus_generate_key(raw_key, test.hash_key, test.sort_key);
+        ASSERT_EQ(test.expected_result,
+                  filter.match(rocksdb::Slice(raw_key.data(), raw_key.length())))
+            << "hash_key = " << test.hash_key << ", sort_key = " << test.sort_key;
+    }
+}
+
+} // namespace server
+} // namespace pegasus
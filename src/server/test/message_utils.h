@@ -32,12 +32,24 @@ inline dsn::message_ex *create_multi_put_request(const dsn::apps::multi_put_requ
                                                         dsn::apps::RPC_RRDB_RRDB_MULTI_PUT);
 }
 
+inline dsn::message_ex *create_batch_put_request(const dsn::apps::batch_put_request &request)
+{
+    return dsn::from_thrift_request_to_received_message(request,
+                                                        dsn::apps::RPC_RRDB_RRDB_BATCH_PUT);
+}
+
 inline dsn::message_ex *create_multi_remove_request(const dsn::apps::multi_remove_request &request)
 {
     return dsn::from_thrift_request_to_received_message(request,
                                                         dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE);
 }
 
+inline dsn::message_ex *create_del_range_request(const dsn::apps::del_range_request &request)
+{
+    return dsn::from_thrift_request_to_received_message(request,
+                                                        dsn::apps::RPC_RRDB_RRDB_DEL_RANGE);
+}
+
 inline dsn::message_ex *create_put_request(const dsn::apps::update_request &request)
 {
     return dsn::from_thrift_request_to_received_message(request, dsn::apps::RPC_RRDB_RRDB_PUT);
@@ -0,0 +1,141 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/pegasus_scan_context.h"
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "server/key_filter.h"
+#include "server/scan_pushdown_filter.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+std::unique_ptr<pegasus_scan_context> make_context(std::string stop)
+{
+    return std::make_unique<pegasus_scan_context>(nullptr,
+                                                  std::move(stop),
+                                                  false,
+                                                  raw_key_filter(),
+                                                  scan_pushdown_filter(),
+                                                  100,
+                                                  0,
+                                                  false,
+                                                  false,
+                                                  false,
+                                                  false);
+}
+
+// Put a context whose stop key is `stop`, and return its handle.
+int64_t put(pegasus_context_cache &cache,
+            const std::string &stop,
+            uint64_t charge,
+            uint64_t now_ms,
+            uint64_t *evicted_count = nullptr)
+{
+    uint64_t evicted = 0;
+    const auto handle = cache.put(make_context(stop), charge, now_ms, evicted);
+    if (evicted_count != nullptr) {
+        *evicted_count = evicted;
+    }
+    return handle;
+}
+
+} // anonymous namespace
+
+TEST(pegasus_context_cache_test, put_and_fetch)
+{
+    pegasus_context_cache cache(4, 1 << 20);
+    const auto h1 = put(cache, "k1", 100, 0);
+    const auto h2 = put(cache, "k2", 200, 0);
+    ASSERT_NE(h1, h2);
+    ASSERT_EQ(2, cache.count());
+    ASSERT_EQ(300, cache.mem_usage());
+
+    auto context = cache.fetch(h1);
+    ASSERT_NE(nullptr, context);
+    ASSERT_EQ("k1", context->stop.ToString());
+    ASSERT_EQ(nullptr, cache.fetch(h1));
+    ASSERT_EQ(1, cache.count());
+    ASSERT_EQ(200, cache.mem_usage());
+
+    cache.clear();
+    ASSERT_EQ(nullptr, cache.fetch(h2));
+    ASSERT_EQ(0, cache.count());
+    ASSERT_EQ(0, cache.mem_usage());
+}
+
+TEST(pegasus_context_cache_test, evict_idle)
+{
+    pegasus_context_cache cache(4, 1 << 20);
+    std::vector<int64_t> handles;
+    for (uint64_t i = 0; i < 10; ++i) {
+        handles.push_back(put(cache, "k" + std::to_string(i), 10, i * 1000));
+    }
+
+    // The contexts put at [0, 5000] have been idle for at least 5000ms at 10000ms.
+    ASSERT_EQ(6, cache.evict_idle(10000, 5000));
+    ASSERT_EQ(4, cache.count());
+    ASSERT_EQ(40, cache.mem_usage());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        ASSERT_EQ(i > 5, cache.fetch(handles[i]) != nullptr) << i;
+    }
+    ASSERT_EQ(0, cache.evict_idle(10000, 5000));
+}
+
+TEST(pegasus_context_cache_test, evict_for_capacity)
+{
+    pegasus_context_cache cache(4, 1000);
+    std::vector<int64_t> handles;
+    uint64_t evicted = 0;
+    for (uint64_t i = 0; i < 5; ++i) {
+        handles.push_back(put(cache, "k" + std::to_string(i), 200, i, &evicted));
+        ASSERT_EQ(0, evicted);
+    }
+    ASSERT_EQ(1000, cache.mem_usage());
+
+    // The least recently used contexts are evicted to hold the new one, whatever shards they
+    // are in.
+    handles.push_back(put(cache, "k5", 500, 5, &evicted));
+    ASSERT_EQ(3, evicted);
+    ASSERT_EQ(3, cache.count());
+    ASSERT_EQ(900, cache.mem_usage());
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_EQ(nullptr, cache.fetch(handles[i])) << i;
+    }
+    for (size_t i = 3; i < handles.size(); ++i) {
+        ASSERT_NE(nullptr, cache.fetch(handles[i])) << i;
+    }
+
+    // The new context is never evicted even if it exceeds the capacity alone.
+    put(cache, "k6", 200, 6, &evicted);
+    const auto large = put(cache, "large", 2000, 6, &evicted);
+    ASSERT_EQ(1, cache.count());
+    ASSERT_NE(nullptr, cache.fetch(large));
+    ASSERT_EQ(0, cache.mem_usage());
+}
+
+} // namespace server
+} // namespace pegasus
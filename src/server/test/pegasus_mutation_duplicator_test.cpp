@@ -308,6 +308,17 @@ TEST_P(pegasus_mutation_duplicator_test, get_hash_from_request)
         ASSERT_EQ(hash, get_hash_from_request(dsn::apps::RPC_RRDB_RRDB_MULTI_PUT, data));
     }
 
+    {
+        dsn::apps::batch_put_request request;
+        request.entries.emplace_back();
+        request.entries.back().hash_key.assign(hash_key.data(), 0, hash_key.length());
+        request.entries.back().sort_key.assign(sort_key.data(), 0, sort_key.length());
+        dsn::message_ptr msg = dsn::from_thrift_request_to_received_message(
+            request, dsn::apps::RPC_RRDB_RRDB_BATCH_PUT);
+        auto data = dsn::move_message_to_blob(msg.get());
+        ASSERT_EQ(hash, get_hash_from_request(dsn::apps::RPC_RRDB_RRDB_BATCH_PUT, data));
+    }
+
     {
         dsn::apps::multi_remove_request request;
         request.hash_key.assign(hash_key.data(), 0, hash_key.length());
@@ -318,6 +329,16 @@ TEST_P(pegasus_mutation_duplicator_test, get_hash_from_request)
         ASSERT_EQ(hash, get_hash_from_request(dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE, data));
     }
 
+    {
+        dsn::apps::del_range_request request;
+        request.hash_key.assign(hash_key.data(), 0, hash_key.length());
+        dsn::message_ptr msg = dsn::from_thrift_request_to_received_message(
+            request, dsn::apps::RPC_RRDB_RRDB_DEL_RANGE);
+
+        auto data = dsn::move_message_to_blob(msg.get());
+        ASSERT_EQ(hash, get_hash_from_request(dsn::apps::RPC_RRDB_RRDB_DEL_RANGE, data));
+    }
+
     {
         dsn::apps::update_request request;
         pegasus::pegasus_generate_key(request.key, hash_key, sort_key);
@@ -30,6 +30,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -39,25 +40,33 @@
 #include "common/replication_other_types.h"
 #include "consensus_types.h"
 #include "gmock/gmock.h"
+#include "base/pegasus_rpc_types.h"
 #include "gtest/gtest.h"
+#include "message_utils.h"
 #include "pegasus_server_test_base.h"
 #include "replica/replica_stub.h"
 #include "rpc/rpc_holder.h"
+#include "rpc/rpc_message.h"
 #include "rrdb/rrdb.code.definition.h"
 #include "rrdb/rrdb_types.h"
 #include "runtime/serverlet.h"
 #include "server/pegasus_read_service.h"
+#include "server/pegasus_scan_context.h"
+#include "task/async_calls.h"
 #include "test_util/test_util.h"
 #include "utils/autoref_ptr.h"
 #include "utils/blob.h"
 #include "utils/defer.h"
 #include "utils/error_code.h"
 #include "utils/filesystem.h"
+#include "utils/flags.h"
 #include "utils/fmt_logging.h"
 #include "utils/metrics.h"
 #include "utils/test_macros.h"
 #include "utils_types.h"
 
+DSN_DECLARE_uint32(mutation_2pc_min_replica_count);
+
 namespace pegasus::server {
 
 class pegasus_server_impl_test : public pegasus_server_test_base
@@ -111,6 +120,88 @@ protected:
         }
     }
 
+    // Apply the write in the same way as applying a committed mutation. `write` is released
+    // by the rpc_holder created for it.
+    void apply_write(dsn::message_ex *write)
+    {
+        ASSERT_EQ(rocksdb::Status::kOk,
+                  _server->on_batched_write_requests(++_last_decree, 0, &write, 1, nullptr));
+    }
+
+    void put(const std::string &hash_key,
+             const std::string &sort_key,
+             const std::string &value,
+             int32_t expire_ts_seconds = 0)
+    {
+        dsn::apps::update_request request;
+        pegasus_generate_key(request.key, hash_key, sort_key);
+        request.value = dsn::blob::create_from_bytes(std::string(value));
+        request.expire_ts_seconds = expire_ts_seconds;
+        apply_write(create_put_request(request));
+    }
+
+    void del_range(const std::string &hash_key,
+                   const std::string &start_sort_key,
+                   bool start_inclusive,
+                   const std::string &stop_sort_key,
+                   bool stop_inclusive)
+    {
+        dsn::apps::del_range_request request;
+        request.hash_key = dsn::blob::create_from_bytes(std::string(hash_key));
+        request.start_sort_key = dsn::blob::create_from_bytes(std::string(start_sort_key));
+        request.start_inclusive = start_inclusive;
+        request.stop_sort_key = dsn::blob::create_from_bytes(std::string(stop_sort_key));
+        request.stop_inclusive = stop_inclusive;
+        apply_write(create_del_range_request(request));
+    }
+
+    // Get all the unexpired sort keys of `hash_key` by the scan handler.
+    std::vector<std::string> scan_sort_keys(const std::string &hash_key)
+    {
+        dsn::apps::get_scanner_request request;
+        pegasus_generate_key(request.start_key, hash_key, std::string());
+        pegasus_generate_next_blob(request.stop_key, hash_key);
+        request.start_inclusive = true;
+        request.stop_inclusive = false;
+        request.batch_size = 1000;
+        get_scanner_rpc rpc(std::make_unique<dsn::apps::get_scanner_request>(request),
+                            dsn::apps::RPC_RRDB_RRDB_GET_SCANNER);
+        _server->on_get_scanner(rpc);
+        CHECK_EQ(rocksdb::Status::kOk, rpc.response().error);
+
+        std::vector<std::string> sort_keys;
+        for (const auto &kv : rpc.response().kvs) {
+            std::string actual_hash_key;
+            std::string sort_key;
+            pegasus_restore_key(kv.key, actual_hash_key, sort_key);
+            sort_keys.push_back(sort_key);
+        }
+        return sort_keys;
+    }
+
+    // Get all the raw keys in the data column family, including the expired ones which have
+    // not been compacted, as "<hash_key>:<sort_key>".
+    std::vector<std::string> raw_keys_in_db()
+    {
+        std::vector<std::string> keys;
+        std::unique_ptr<rocksdb::Iterator> iter(
+            _server->_db->NewIterator(rocksdb::ReadOptions(), _server->_data_cf));
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            if (iter->key().size() < 2) {
+                // Skip the empty writes.
+                continue;
+            }
+            std::string hash_key;
+            std::string sort_key;
+            pegasus_restore_key(
+                dsn::blob(iter->key().data(), 0, iter->key().size()), hash_key, sort_key);
+            keys.push_back(fmt::format("{}:{}", hash_key, sort_key));
+        }
+        return keys;
+    }
+
+    int64_t _last_decree{0};
+
     void test_open_db_with_rocksdb_envs(bool is_restart)
     {
         struct create_test
@@ -359,6 +450,376 @@ TEST_P(pegasus_server_impl_test, default_data_version)
     ASSERT_EQ(_server->_pegasus_data_version, 1);
 }
 
+TEST_P(pegasus_server_impl_test, del_range)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+
+    RPC_MOCKING(put_rpc)
+    RPC_MOCKING(del_range_rpc)
+    {
+        struct test_case
+        {
+            std::string start_sort_key;
+            bool start_inclusive;
+            std::string stop_sort_key;
+            bool stop_inclusive;
+            std::vector<std::string> expected_sort_keys;
+        } tests[] = {
+            {"b", true, "d", false, {"", "a", "d", "e"}},
+            {"b", false, "d", true, {"", "a", "b", "e"}},
+            {"b", true, "d", true, {"", "a", "e"}},
+            {"b", false, "d", false, {"", "a", "b", "d", "e"}},
+            // An empty stop sort key means no limit.
+            {"c", true, "", false, {"", "a", "b"}},
+            {"", false, "c", false, {"", "c", "d", "e"}},
+            // The whole hash key.
+            {"", true, "", false, {}},
+            // Empty ranges.
+            {"d", true, "b", true, {"", "a", "b", "c", "d", "e"}},
+            {"c", false, "c", true, {"", "a", "b", "c", "d", "e"}},
+        };
+
+        for (const auto &test : tests) {
+            for (const auto &hash_key : {"h0", "h1", "h2"}) {
+                for (const auto &sort_key : {"", "a", "b", "c", "d", "e"}) {
+                    put(hash_key, sort_key, "value");
+                }
+            }
+
+            del_range("h1",
+                      test.start_sort_key,
+                      test.start_inclusive,
+                      test.stop_sort_key,
+                      test.stop_inclusive);
+            ASSERT_EQ(rocksdb::Status::kOk, del_range_rpc::mail_box().back().response().error);
+            ASSERT_EQ(test.expected_sort_keys, scan_sort_keys("h1"));
+
+            // The neighbouring hash keys are not affected.
+            const std::vector<std::string> all_sort_keys = {"", "a", "b", "c", "d", "e"};
+            ASSERT_EQ(all_sort_keys, scan_sort_keys("h0"));
+            ASSERT_EQ(all_sort_keys, scan_sort_keys("h2"));
+        }
+
+        // The rows with an empty hash key could not be deleted by range.
+        put("", "a", "value");
+        del_range("", "", true, "", false);
+        ASSERT_EQ(rocksdb::Status::kInvalidArgument,
+                  del_range_rpc::mail_box().back().response().error);
+        dsn::blob key;
+        pegasus_generate_key(key, std::string(), std::string("a"));
+        get_rpc rpc(std::make_unique<dsn::blob>(key), dsn::apps::RPC_RRDB_RRDB_GET);
+        _server->on_get(rpc);
+        ASSERT_EQ(rocksdb::Status::kOk, rpc.response().error);
+    }
+}
+
+TEST_P(pegasus_server_impl_test, del_range_with_ttl_compaction)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+
+    RPC_MOCKING(put_rpc)
+    RPC_MOCKING(del_range_rpc)
+    {
+        // "b" and "d" have expired.
+        put("h0", "a", "value", 1);
+        put("h1", "a", "value");
+        put("h1", "b", "value", 1);
+        put("h1", "c", "value");
+        put("h1", "d", "value", 1);
+        put("h1", "e", "value");
+        put("h2", "a", "value");
+        ASSERT_TRUE(_server->_db->Flush(rocksdb::FlushOptions(), _server->_data_cf).ok());
+
+        del_range("h1", "b", true, "d", true);
+        // The key written after the range tombstone is visible.
+        put("h1", "c", "new_value");
+        ASSERT_EQ(std::vector<std::string>({"a", "c", "e"}), scan_sort_keys("h1"));
+
+        rocksdb::CompactRangeOptions options;
+        options.bottommost_level_compaction = rocksdb::BottommostLevelCompaction::kForce;
+        ASSERT_TRUE(_server->_db->CompactRange(options, _server->_data_cf, nullptr, nullptr).ok());
+
+        // Both the keys covered by the range tombstone and the expired ones are dropped by
+        // the compaction, while the others, including the key put after the tombstone, are kept.
+        ASSERT_EQ(std::vector<std::string>({"h1:a", "h1:c", "h1:e", "h2:a"}), raw_keys_in_db());
+        ASSERT_EQ(std::vector<std::string>({"a", "c", "e"}), scan_sort_keys("h1"));
+    }
+}
+
+TEST_P(pegasus_server_impl_test, del_range_invalidates_hot_row_cache)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+    _server->_hot_row_cache->set_enabled(true);
+
+    RPC_MOCKING(put_rpc)
+    RPC_MOCKING(del_range_rpc)
+    {
+        put("h1", "a", "value");
+
+        dsn::blob key;
+        pegasus_generate_key(key, std::string("h1"), std::string("a"));
+        for (int i = 0; i < 2; ++i) {
+            // The first get fills the cache, and the second one hits it.
+            get_rpc rpc(std::make_unique<dsn::blob>(key), dsn::apps::RPC_RRDB_RRDB_GET);
+            _server->on_get(rpc);
+            ASSERT_EQ(rocksdb::Status::kOk, rpc.response().error);
+        }
+        ASSERT_GT(_server->_hot_row_cache->mem_usage(), 0);
+
+        del_range("h1", "", true, "", false);
+        get_rpc rpc(std::make_unique<dsn::blob>(key), dsn::apps::RPC_RRDB_RRDB_GET);
+        _server->on_get(rpc);
+        ASSERT_EQ(rocksdb::Status::kNotFound, rpc.response().error);
+    }
+}
+
+TEST_P(pegasus_server_impl_test, reopen_invalidates_hot_row_cache)
+{
+    const std::map<std::string, std::string> envs = {
+        {dsn::replica_envs::HOT_ROW_CACHE_ENABLED, "true"}};
+    ASSERT_EQ(dsn::ERR_OK, start(envs));
+    ASSERT_TRUE(_server->_hot_row_cache->enabled());
+
+    dsn::blob key;
+    pegasus_generate_key(key, std::string("h1"), std::string("a"));
+    const auto fill_cache = [this, &key]() {
+        get_rpc rpc(std::make_unique<dsn::blob>(key), dsn::apps::RPC_RRDB_RRDB_GET);
+        _server->on_get(rpc);
+        ASSERT_EQ(rocksdb::Status::kOk, rpc.response().error);
+        ASSERT_GT(_server->_hot_row_cache->mem_usage(), 0);
+    };
+
+    RPC_MOCKING(put_rpc)
+    {
+        put("h1", "a", "value");
+        fill_cache();
+
+        // Reopen the db.
+        ASSERT_EQ(dsn::ERR_OK, _server->stop(false));
+        ASSERT_EQ(0, _server->_hot_row_cache->mem_usage());
+        ASSERT_EQ(dsn::ERR_OK, start(envs));
+        ASSERT_TRUE(_server->_hot_row_cache->enabled());
+        fill_cache();
+
+        // Change the default ttl.
+        _server->update_app_envs({{dsn::replica_envs::HOT_ROW_CACHE_ENABLED, "true"},
+                                  {dsn::replica_envs::TABLE_LEVEL_DEFAULT_TTL, "3600"}});
+        ASSERT_EQ(0, _server->_hot_row_cache->mem_usage());
+    }
+}
+
+TEST_P(pegasus_server_impl_test, streaming_scan)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+
+    const auto open_scanner = [this](bool stream) {
+        dsn::apps::get_scanner_request request;
+        pegasus_generate_key(request.start_key, std::string("h1"), std::string());
+        pegasus_generate_next_blob(request.stop_key, std::string("h1"));
+        request.start_inclusive = true;
+        request.stop_inclusive = false;
+        request.batch_size = 2;
+        request.__set_stream(stream);
+        get_scanner_rpc rpc(std::make_unique<dsn::apps::get_scanner_request>(request),
+                            dsn::apps::RPC_RRDB_RRDB_GET_SCANNER);
+        _server->on_get_scanner(rpc);
+        return rpc.response();
+    };
+    const auto make_scan_rpc = [](int64_t context_id, int64_t sequence) {
+        dsn::apps::scan_request request;
+        request.context_id = context_id;
+        if (sequence > 0) {
+            request.__set_sequence(sequence);
+        }
+        return scan_rpc(std::make_unique<dsn::apps::scan_request>(request),
+                        dsn::apps::RPC_RRDB_RRDB_SCAN);
+    };
+    const auto scan = [this, &make_scan_rpc](int64_t context_id, int64_t sequence) {
+        auto rpc = make_scan_rpc(context_id, sequence);
+        _server->on_scan(rpc);
+        return rpc.response();
+    };
+
+    RPC_MOCKING(put_rpc)
+    {
+        for (const auto &sort_key : {"a", "b", "c", "d", "e"}) {
+            put("h1", sort_key, "value");
+        }
+    }
+
+    // The batches of a streaming scan are requested by the same context id in order.
+    auto resp = open_scanner(true);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    ASSERT_TRUE(resp.__isset.stream && resp.stream);
+    ASSERT_EQ(2, resp.kvs.size());
+    const int64_t context_id = resp.context_id;
+    ASSERT_GE(context_id, pegasus_scan_context::SCAN_CONTEXT_ID_VALID_MIN);
+
+    resp = scan(context_id, 1);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    ASSERT_EQ(context_id, resp.context_id);
+    ASSERT_EQ(2, resp.kvs.size());
+
+    resp = scan(context_id, 2);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    ASSERT_EQ(pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED, resp.context_id);
+    ASSERT_EQ(1, resp.kvs.size());
+
+    // The requests beyond the end find no context.
+    ASSERT_EQ(rocksdb::Status::kNotFound, scan(context_id, 3).error);
+
+    // A request ahead of its turn is parked, and served once its predecessor is done.
+    resp = open_scanner(true);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    auto ahead = make_scan_rpc(resp.context_id, 2);
+    _server->on_scan(ahead);
+    ASSERT_TRUE(ahead.response().kvs.empty());
+    ASSERT_EQ(1, _server->_stream_scans.size());
+    const auto former = scan(resp.context_id, 1);
+    ASSERT_EQ(rocksdb::Status::kOk, former.error);
+    ASSERT_EQ(2, former.kvs.size());
+    ASSERT_EQ(rocksdb::Status::kOk, ahead.response().error);
+    ASSERT_EQ(pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED, ahead.response().context_id);
+    ASSERT_EQ(1, ahead.response().kvs.size());
+
+    // A request whose sequence has been served drops the context.
+    resp = open_scanner(true);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    ASSERT_EQ(rocksdb::Status::kOk, scan(resp.context_id, 1).error);
+    ASSERT_EQ(rocksdb::Status::kNotFound, scan(resp.context_id, 1).error);
+    ASSERT_EQ(rocksdb::Status::kNotFound, scan(resp.context_id, 2).error);
+
+    resp = open_scanner(true);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    ASSERT_EQ(rocksdb::Status::kNotFound, scan(resp.context_id, 0).error);
+
+    // The context id of a non-streaming scan changes with each batch.
+    resp = open_scanner(false);
+    ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+    ASSERT_FALSE(resp.__isset.stream);
+    const auto next = scan(resp.context_id, 0);
+    ASSERT_EQ(rocksdb::Status::kOk, next.error);
+    ASSERT_NE(resp.context_id, next.context_id);
+    ASSERT_EQ(2, next.kvs.size());
+}
+
+TEST_P(pegasus_server_impl_test, concurrent_streaming_scan)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+
+    static const int kRowCount = 100;
+    static const int kBatchSize = 2;
+    static const int kThreadCount = 4;
+    RPC_MOCKING(put_rpc)
+    {
+        for (int i = 0; i < kRowCount; ++i) {
+            put("h1", fmt::format("{:03}", i), "value");
+        }
+    }
+
+    dsn::apps::get_scanner_request request;
+    pegasus_generate_key(request.start_key, std::string("h1"), std::string());
+    pegasus_generate_next_blob(request.stop_key, std::string("h1"));
+    request.start_inclusive = true;
+    request.stop_inclusive = false;
+    request.batch_size = kBatchSize;
+    request.__set_stream(true);
+    get_scanner_rpc scanner(std::make_unique<dsn::apps::get_scanner_request>(request),
+                            dsn::apps::RPC_RRDB_RRDB_GET_SCANNER);
+    _server->on_get_scanner(scanner);
+    ASSERT_EQ(rocksdb::Status::kOk, scanner.response().error);
+    ASSERT_EQ(kBatchSize, scanner.response().kvs.size());
+    const int64_t context_id = scanner.response().context_id;
+
+    // The continuations are issued by several threads at once, each of which takes every
+    // kThreadCount-th sequence in reverse order, so that most of them arrive ahead of their turn.
+    const int batch_count = kRowCount / kBatchSize - 1;
+    std::vector<scan_rpc> rpcs;
+    for (int64_t sequence = 1; sequence <= batch_count; ++sequence) {
+        dsn::apps::scan_request scan_request;
+        scan_request.context_id = context_id;
+        scan_request.__set_sequence(sequence);
+        rpcs.emplace_back(std::make_unique<dsn::apps::scan_request>(scan_request),
+                          dsn::apps::RPC_RRDB_RRDB_SCAN);
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreadCount; ++t) {
+        threads.emplace_back([this, &rpcs, t]() {
+            for (int i = static_cast<int>(rpcs.size()) - 1 - t; i >= 0; i -= kThreadCount) {
+                _server->on_scan(rpcs[i]);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Every batch is served by the same context without restarting the scan.
+    int row = kBatchSize;
+    for (int i = 0; i < batch_count; ++i) {
+        const auto &resp = rpcs[i].response();
+        ASSERT_EQ(rocksdb::Status::kOk, resp.error) << i;
+        ASSERT_EQ(i + 1 == batch_count ? pegasus_scan_context::SCAN_CONTEXT_ID_COMPLETED
+                                       : context_id,
+                  resp.context_id)
+            << i;
+        for (const auto &kv : resp.kvs) {
+            dsn::blob hash_key, sort_key;
+            pegasus_restore_key(kv.key, hash_key, sort_key);
+            ASSERT_EQ(fmt::format("{:03}", row++), sort_key.to_string());
+        }
+    }
+    ASSERT_EQ(kRowCount, row);
+    ASSERT_EQ(0, _server->_stream_scans.size());
+}
+
+TEST_P(pegasus_server_impl_test, batch_put_through_replica)
+{
+    ASSERT_EQ(dsn::ERR_OK, start());
+
+    // There is only one replica for the unit test.
+    PRESERVE_FLAG(mutation_2pc_min_replica_count);
+    FLAGS_mutation_2pc_min_replica_count = 1;
+    become_single_primary("./test_dir/batch_put_through_replica");
+    auto cleanup = dsn::defer([this]() { become_inactive(); });
+
+    dsn::apps::batch_put_request request;
+    for (int i = 0; i < 10; ++i) {
+        request.entries.emplace_back();
+        auto &entry = request.entries.back();
+        entry.hash_key = dsn::blob::create_from_bytes(fmt::format("hash_key_{}", i));
+        entry.sort_key = dsn::blob::create_from_bytes("sort_key");
+        entry.value = dsn::blob::create_from_bytes(fmt::format("value_{}", i));
+    }
+
+    RPC_MOCKING(batch_put_rpc)
+    {
+        // The request is parsed for the rows of all its hash keys on the primary, and then
+        // goes through the mutation queue, the private log and the commit to be applied.
+        dsn::message_ptr msg = create_batch_put_request(request);
+        dsn::tasking::enqueue(
+            LPC_REPLICATION_COMMON,
+            _replica->tracker(),
+            [this, msg]() { _replica->on_client_write(msg.get(), false); },
+            _gpid.thread_hash());
+        ASSERT_IN_TIME([]() { ASSERT_EQ(1, batch_put_rpc::mail_box().size()); }, 10);
+
+        const auto &resp = batch_put_rpc::mail_box().front().response();
+        ASSERT_EQ(rocksdb::Status::kOk, resp.error);
+        ASSERT_EQ(1, resp.decree);
+        ASSERT_EQ(1, _server->last_committed_decree());
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        dsn::blob key;
+        pegasus_generate_key(key, fmt::format("hash_key_{}", i), std::string("sort_key"));
+        get_rpc rpc(std::make_unique<dsn::blob>(key), dsn::apps::RPC_RRDB_RRDB_GET);
+        _server->on_get(rpc);
+        ASSERT_EQ(rocksdb::Status::kOk, rpc.response().error) << i;
+        ASSERT_EQ(fmt::format("value_{}", i), rpc.response().value.to_string()) << i;
+    }
+}
+
 TEST_P(pegasus_server_impl_test, test_open_db_with_latest_options)
 {
     // open a new db with no app env.
@@ -24,6 +24,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "common/fs_manager.h"
+#include "replica/mutation_log.h"
 #include "replica/replica_stub.h"
 #include "test_util/test_util.h"
 #include "utils/casts.h"
@@ -114,6 +115,34 @@ public:
         _server->set_last_durable_decree(d);
     }
 
+    // Make the replica a primary without secondaries, whose private log is under `log_dir`, so
+    // that the writes could go through its whole write path. FLAGS_mutation_2pc_min_replica_count
+    // should be 1.
+    void become_single_primary(const std::string &log_dir)
+    {
+        _replica->_app_info.max_replica_count = 1;
+
+        dsn::replication::replica_configuration config;
+        config.pid = _gpid;
+        config.ballot = 1;
+        config.status = dsn::replication::partition_status::PS_PRIMARY;
+        _replica->_config = config;
+
+        dsn::utils::filesystem::remove_path(log_dir);
+        _replica->_private_log =
+            new dsn::replication::mutation_log_private(log_dir, 32, _gpid, _replica.get());
+        const auto err = _replica->_private_log->open(
+            nullptr, [](dsn::error_code err) { CHECK_EQ(dsn::ERR_OK, err); });
+        CHECK_EQ(dsn::ERR_OK, err);
+    }
+
+    // Make the replica inactive after all of its tasks finish, so that it could be closed.
+    void become_inactive()
+    {
+        _replica->tracker()->wait_outstanding_tasks();
+        _replica->_config.status = dsn::replication::partition_status::PS_INACTIVE;
+    }
+
     ~pegasus_server_test_base() override
     {
         // do not clear state
@@ -61,6 +61,9 @@ TEST(value_schema, generate_and_extract_v1_v0)
             ASSERT_EQ(t.timetag, pegasus_extract_timetag(t.value_schema_version, raw_value));
         }
 
+        ASSERT_EQ(t.user_data,
+                  pegasus_extract_user_data_view(t.value_schema_version, raw_value));
+
         dsn::blob user_data;
         pegasus_extract_user_data(t.value_schema_version, std::move(raw_value), user_data);
         ASSERT_EQ(t.user_data, user_data.to_string());
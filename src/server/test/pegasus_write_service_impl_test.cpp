@@ -445,6 +445,22 @@ TEST_P(IdempotentIncrTest, IncrOnExpireRecord)
     test_incr_and_check_db_record(0, 100);
 }
 
+TEST_P(IdempotentIncrTest, IncrOnPendingRecord)
+{
+    single_set(req.key, dsn::blob::create_from_numeric(static_cast<int64_t>(10)));
+
+    // The former incr has been made idempotent but not applied yet.
+    test_make_idempotent(1, rocksdb::Status::kOk);
+    auto pending = _write_impl->record_pending_writes({update});
+
+    // The latter incr should be based on the pending result rather than the one in DB.
+    test_incr_and_check_db_record(11, 100);
+
+    // Once the former incr is released, the latter incr would read DB.
+    pending.reset();
+    test_incr_and_check_db_record(111, 1);
+}
+
 INSTANTIATE_TEST_SUITE_P(PegasusWriteServiceImplTest,
                          IdempotentIncrTest,
                          testing::Values(false, true));
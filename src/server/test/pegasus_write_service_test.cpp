@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "base/pegasus_key_schema.h"
+#include "base/pegasus_value_schema.h"
 #include "common/gpid.h"
 #include "duplication_internal_types.h"
 #include "gtest/gtest.h"
@@ -208,6 +209,43 @@ public:
         }
     }
 
+    void test_batch_put_across_hash_keys()
+    {
+        int64_t decree = 10;
+        auto ctx = db_write_context::create(decree, 1000);
+
+        constexpr int kv_num = 10;
+        std::string hash_key[kv_num];
+        std::string value[kv_num];
+        dsn::apps::batch_put_request request;
+        for (int i = 0; i < kv_num; i++) {
+            hash_key[i] = "hash_key_" + std::to_string(i);
+            value[i] = "value_" + std::to_string(i);
+            request.entries.emplace_back();
+            request.entries.back().hash_key.assign(hash_key[i].data(), 0, hash_key[i].size());
+            request.entries.back().sort_key = dsn::blob::create_from_bytes("sort_key");
+            request.entries.back().value.assign(value[i].data(), 0, value[i].size());
+        }
+
+        dsn::apps::update_response response;
+        _write_svc->batch_prepare(decree);
+        ASSERT_EQ(0, _write_svc->batch_put(ctx, request, response));
+        ASSERT_EQ(0, _write_svc->batch_commit(decree));
+        verify_response(response, 0, decree);
+
+        for (int i = 0; i < kv_num; i++) {
+            dsn::blob key;
+            pegasus::pegasus_generate_key(key, hash_key[i], std::string("sort_key"));
+            db_get_context get_ctx;
+            ASSERT_EQ(0, _write_svc->_impl->_rocksdb_wrapper->get(key, &get_ctx));
+            ASSERT_TRUE(get_ctx.found);
+            dsn::blob data;
+            pegasus_extract_user_data(
+                _write_svc->_impl->_pegasus_data_version, std::move(get_ctx.raw_value), data);
+            ASSERT_EQ(value[i], data.to_string());
+        }
+    }
+
     template <typename TResponse>
     void verify_response(const TResponse &response, int err, int64_t decree)
     {
@@ -229,6 +267,11 @@ TEST_P(pegasus_write_service_test, multi_remove) { test_multi_remove(); }
 
 TEST_P(pegasus_write_service_test, batched_writes) { test_batched_writes(); }
 
+TEST_P(pegasus_write_service_test, batch_put_across_hash_keys)
+{
+    test_batch_put_across_hash_keys();
+}
+
 TEST_P(pegasus_write_service_test, duplicate_not_batched)
 {
     std::string hash_key = "hash_key";
@@ -277,6 +320,25 @@ TEST_P(pegasus_write_service_test, duplicate_not_batched)
         _write_svc->duplicate(1, duplicate, resp);
         ASSERT_EQ(resp.error, 0);
     }
+
+    {
+        dsn::apps::batch_put_request bput;
+        for (int i = 0; i < kv_num; i++) {
+            bput.entries.emplace_back();
+            bput.entries.back().hash_key.assign(hash_key.data(), 0, hash_key.size());
+            bput.entries.back().sort_key.assign(sort_key[i].data(), 0, sort_key[i].size());
+            bput.entries.back().value.assign(value[i].data(), 0, value[i].size());
+        }
+        dsn::message_ptr bput_msg = pegasus::create_batch_put_request(bput);
+
+        entry.task_code = dsn::apps::RPC_RRDB_RRDB_BATCH_PUT;
+        entry.raw_message = dsn::move_message_to_blob(bput_msg.get());
+        duplicate.entries.clear();
+        duplicate.entries.emplace_back(entry);
+
+        _write_svc->duplicate(1, duplicate, resp);
+        ASSERT_EQ(resp.error, 0);
+    }
 }
 
 TEST_P(pegasus_write_service_test, duplicate_batched)
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/pending_write_overlay.h"
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "rrdb/rrdb_types.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+dsn::apps::update_request
+make_put(const std::string &key, const std::string &value, int32_t expire_ts = 0)
+{
+    dsn::apps::update_request update;
+    update.key = dsn::blob::create_from_bytes(std::string(key));
+    update.value = dsn::blob::create_from_bytes(std::string(value));
+    update.expire_ts_seconds = expire_ts;
+    return update;
+}
+
+dsn::apps::update_request make_remove(const std::string &key)
+{
+    dsn::apps::update_request update;
+    update.key = dsn::blob::create_from_bytes(std::string(key));
+    update.__set_type(dsn::apps::update_type::UT_CHECK_AND_MUTATE_REMOVE);
+    return update;
+}
+
+} // anonymous namespace
+
+TEST(pending_write_overlay_test, record_and_release)
+{
+    auto overlay = std::make_shared<pending_write_overlay>();
+
+    bool exist = false;
+    std::string value;
+    uint32_t expire_ts = 0;
+    ASSERT_FALSE(overlay->lookup("k1", exist, value, expire_ts));
+
+    auto h1 = overlay->record({make_put("k1", "v1", 100), make_remove("k2")});
+    ASSERT_EQ(2, overlay->size());
+
+    ASSERT_TRUE(overlay->lookup("k1", exist, value, expire_ts));
+    ASSERT_TRUE(exist);
+    ASSERT_EQ("v1", value);
+    ASSERT_EQ(100, expire_ts);
+
+    // The removed key is pending as non-existent.
+    ASSERT_TRUE(overlay->lookup("k2", exist, value, expire_ts));
+    ASSERT_FALSE(exist);
+
+    h1.reset();
+    ASSERT_EQ(0, overlay->size());
+    ASSERT_FALSE(overlay->lookup("k1", exist, value, expire_ts));
+}
+
+TEST(pending_write_overlay_test, release_by_latest_write)
+{
+    auto overlay = std::make_shared<pending_write_overlay>();
+
+    auto h1 = overlay->record({make_put("k1", "v1"), make_put("k2", "v2")});
+    auto h2 = overlay->record({make_put("k1", "v11")});
+
+    // Releasing the former write should not drop the latter one on the same key.
+    h1.reset();
+    ASSERT_EQ(1, overlay->size());
+
+    bool exist = false;
+    std::string value;
+    uint32_t expire_ts = 0;
+    ASSERT_TRUE(overlay->lookup("k1", exist, value, expire_ts));
+    ASSERT_EQ("v11", value);
+    ASSERT_FALSE(overlay->lookup("k2", exist, value, expire_ts));
+
+    h2.reset();
+    ASSERT_EQ(0, overlay->size());
+}
+
+TEST(pending_write_overlay_test, release_after_overlay_destroyed)
+{
+    auto overlay = std::make_shared<pending_write_overlay>();
+    auto h1 = overlay->record({make_put("k1", "v1")});
+
+    // The holder might outlive the overlay, e.g. once the replica is closed.
+    overlay.reset();
+    h1.reset();
+}
+
+} // namespace server
+} // namespace pegasus
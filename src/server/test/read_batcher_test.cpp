@@ -0,0 +1,185 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/read_batcher.h"
+
+#include <stddef.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace pegasus {
+namespace server {
+
+class read_batcher_test : public testing::Test
+{
+protected:
+    void create_batcher(size_t max_batch_size, std::chrono::microseconds window)
+    {
+        _batcher = std::make_unique<read_batcher<int>>(
+            max_batch_size,
+            window,
+            [this](std::vector<int> &batch) {
+                if (_block_first_batch && _batches.empty()) {
+                    _first_batch_started.set_value();
+                    _unblock_first_batch.get_future().wait();
+                }
+                std::lock_guard<std::mutex> l(_lock);
+                _batches.push_back(batch);
+            },
+            [this](std::chrono::microseconds delay) {
+                std::lock_guard<std::mutex> l(_lock);
+                _schedule_delays.push_back(delay);
+            });
+    }
+
+    std::vector<std::vector<int>> batches()
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        return _batches;
+    }
+
+    std::vector<std::chrono::microseconds> schedule_delays()
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        return _schedule_delays;
+    }
+
+    size_t schedule_count() { return schedule_delays().size(); }
+
+    std::unique_ptr<read_batcher<int>> _batcher;
+    std::mutex _lock;
+    std::vector<std::vector<int>> _batches;
+    std::vector<std::chrono::microseconds> _schedule_delays;
+
+    bool _block_first_batch{false};
+    std::promise<void> _first_batch_started;
+    std::promise<void> _unblock_first_batch;
+};
+
+TEST_F(read_batcher_test, execute_at_once_without_contention)
+{
+    create_batcher(4, std::chrono::microseconds(0));
+    _batcher->submit(1);
+    _batcher->submit(2);
+    ASSERT_EQ(std::vector<std::vector<int>>({{1}, {2}}), batches());
+    ASSERT_EQ(0, schedule_count());
+}
+
+TEST_F(read_batcher_test, coalesce_during_batch)
+{
+    _block_first_batch = true;
+    create_batcher(2, std::chrono::microseconds(0));
+
+    std::thread leader([this]() { _batcher->submit(1); });
+    _first_batch_started.get_future().wait();
+
+    // The items submitted while the leader is executing its batch are only appended.
+    _batcher->submit(2);
+    _batcher->submit(3);
+    _batcher->submit(4);
+    ASSERT_TRUE(batches().empty());
+
+    _unblock_first_batch.set_value();
+    leader.join();
+    ASSERT_EQ(std::vector<std::vector<int>>({{1}}), batches());
+    ASSERT_EQ(1, schedule_count());
+
+    // Each drain executes at most one full batch, and schedules another one if there are more.
+    _batcher->drain();
+    ASSERT_EQ(std::vector<std::vector<int>>({{1}, {2, 3}}), batches());
+    ASSERT_EQ(2, schedule_count());
+
+    _batcher->drain();
+    ASSERT_EQ(std::vector<std::vector<int>>({{1}, {2, 3}, {4}}), batches());
+    ASSERT_EQ(2, schedule_count());
+
+    // Nothing to drain.
+    _batcher->drain();
+    ASSERT_EQ(3, batches().size());
+}
+
+TEST_F(read_batcher_test, wait_for_window)
+{
+    create_batcher(4, std::chrono::milliseconds(5));
+
+    // The items are not executed until the drain scheduled after the window, while the callers
+    // are not blocked.
+    _batcher->submit(1);
+    _batcher->submit(2);
+    ASSERT_TRUE(batches().empty());
+    ASSERT_EQ(std::vector<std::chrono::microseconds>({std::chrono::milliseconds(5)}),
+              schedule_delays());
+
+    _batcher->drain();
+    ASSERT_EQ(std::vector<std::vector<int>>({{1, 2}}), batches());
+
+    // Another drain is scheduled for the next items once the last one has run.
+    _batcher->submit(3);
+    ASSERT_EQ(2, schedule_count());
+    _batcher->drain();
+    ASSERT_EQ(std::vector<std::vector<int>>({{1, 2}, {3}}), batches());
+}
+
+TEST_F(read_batcher_test, execute_full_batch_within_window)
+{
+    create_batcher(2, std::chrono::seconds(60));
+
+    // The caller filling up a batch executes it at once rather than waiting for the window.
+    _batcher->submit(1);
+    ASSERT_TRUE(batches().empty());
+    _batcher->submit(2);
+    ASSERT_EQ(std::vector<std::vector<int>>({{1, 2}}), batches());
+    ASSERT_EQ(1, schedule_count());
+
+    // The scheduled drain finds nothing to execute.
+    _batcher->drain();
+    ASSERT_EQ(1, batches().size());
+}
+
+TEST_F(read_batcher_test, stop)
+{
+    _block_first_batch = true;
+    create_batcher(8, std::chrono::microseconds(0));
+
+    std::thread leader([this]() { _batcher->submit(1); });
+    _first_batch_started.get_future().wait();
+    _batcher->submit(2);
+    _batcher->submit(3);
+
+    auto stopped = std::async(std::launch::async, [this]() { _batcher->stop(); });
+    _unblock_first_batch.set_value();
+    leader.join();
+    stopped.wait();
+
+    // The pending items are executed before stop() returns.
+    ASSERT_EQ(std::vector<std::vector<int>>({{1}, {2, 3}}), batches());
+
+    // Once stopped, each item is executed at once.
+    _batcher->submit(4);
+    ASSERT_EQ(std::vector<std::vector<int>>({{1}, {2, 3}, {4}}), batches());
+}
+
+} // namespace server
+} // namespace pegasus
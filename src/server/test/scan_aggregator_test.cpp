@@ -0,0 +1,188 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/scan_aggregator.h"
+
+#include <rrdb/rrdb_types.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+namespace {
+
+const uint32_t kEpochNow = 1000;
+
+struct row
+{
+    std::string hash_key;
+    size_t key_size;
+    size_t value_size;
+    uint32_t expire_ts;
+};
+
+} // anonymous namespace
+
+TEST(scan_aggregator_test, validate_request)
+{
+    struct test_case
+    {
+        std::vector<int32_t> ttl_bucket_bounds;
+        int32_t top_k_count;
+        bool expected_valid;
+    } tests[] = {
+        {{}, 0, true},
+        {{10, 100, 1000}, 10, true},
+        {{0, 100}, 0, false},
+        {{100, 100}, 0, false},
+        {{100, 10}, 0, false},
+        {{}, -1, false},
+    };
+
+    for (const auto &test : tests) {
+        ::dsn::apps::aggregate_scan_request request;
+        request.ttl_bucket_bounds_seconds = test.ttl_bucket_bounds;
+        request.top_k_count = test.top_k_count;
+        std::string hint;
+        ASSERT_EQ(test.expected_valid, scan_aggregator::validate_request(request, hint)) << hint;
+    }
+}
+
+TEST(scan_aggregator_test, aggregate)
+{
+    ::dsn::apps::aggregate_scan_request request;
+    request.ttl_bucket_bounds_seconds = {10, 100};
+    request.top_k_count = 2;
+    request.top_k_order = ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT;
+
+    const row rows[] = {
+        {"a", 2, 10, 0},
+        {"b", 2, 10, kEpochNow + 5},
+        {"b", 2, 10, kEpochNow + 10},
+        {"b", 2, 10, kEpochNow + 99},
+        {"c", 2, 100, kEpochNow + 100},
+        {"c", 2, 100, 0},
+    };
+
+    scan_aggregator aggregator(request, kEpochNow);
+    for (const auto &r : rows) {
+        ASSERT_TRUE(aggregator.add(r.hash_key, r.key_size, r.value_size, r.expire_ts));
+    }
+
+    ::dsn::apps::aggregate_scan_response resp;
+    aggregator.finish(true, resp);
+    ASSERT_EQ(6, resp.row_count);
+    ASSERT_EQ(3, resp.hash_key_count);
+    ASSERT_EQ(12, resp.key_bytes);
+    ASSERT_EQ(240, resp.value_bytes);
+    ASSERT_EQ(2, resp.no_ttl_count);
+    ASSERT_EQ(std::vector<int64_t>({1, 2, 1}), resp.ttl_histogram);
+    ASSERT_FALSE(resp.__isset.last_hash_key_stat);
+
+    ASSERT_EQ(2, resp.top_hash_keys.size());
+    ASSERT_EQ("b", resp.top_hash_keys[0].hash_key.to_string());
+    ASSERT_EQ(3, resp.top_hash_keys[0].row_count);
+    ASSERT_EQ(36, resp.top_hash_keys[0].data_size);
+    ASSERT_EQ("c", resp.top_hash_keys[1].hash_key.to_string());
+    ASSERT_EQ(2, resp.top_hash_keys[1].row_count);
+}
+
+TEST(scan_aggregator_test, top_k_by_data_size)
+{
+    ::dsn::apps::aggregate_scan_request request;
+    request.top_k_count = 1;
+    request.top_k_order = ::dsn::apps::aggregate_top_k_order::ATO_DATA_SIZE;
+
+    scan_aggregator aggregator(request, kEpochNow);
+    ASSERT_TRUE(aggregator.add("a", 1, 1, 0));
+    ASSERT_TRUE(aggregator.add("a", 1, 1, 0));
+    ASSERT_TRUE(aggregator.add("b", 1, 100, 0));
+
+    ::dsn::apps::aggregate_scan_response resp;
+    aggregator.finish(true, resp);
+    ASSERT_TRUE(resp.ttl_histogram.empty());
+    ASSERT_EQ(1, resp.top_hash_keys.size());
+    ASSERT_EQ("b", resp.top_hash_keys[0].hash_key.to_string());
+    ASSERT_EQ(101, resp.top_hash_keys[0].data_size);
+}
+
+TEST(scan_aggregator_test, skip_expired)
+{
+    ::dsn::apps::aggregate_scan_request request;
+    request.ttl_bucket_bounds_seconds = {10};
+    request.top_k_count = 1;
+    request.top_k_order = ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT;
+
+    // The rows that have expired by epoch_now are neither counted nor put into the histogram.
+    scan_aggregator aggregator(request, kEpochNow);
+    ASSERT_TRUE(aggregator.add("a", 1, 1, kEpochNow + 1));
+    ASSERT_FALSE(aggregator.add("a", 1, 1, kEpochNow));
+    ASSERT_FALSE(aggregator.add("b", 1, 1, kEpochNow - 1));
+
+    ::dsn::apps::aggregate_scan_response resp;
+    aggregator.finish(true, resp);
+    ASSERT_EQ(1, resp.row_count);
+    ASSERT_EQ(1, resp.hash_key_count);
+    ASSERT_EQ(0, resp.no_ttl_count);
+    ASSERT_EQ(std::vector<int64_t>({1, 0}), resp.ttl_histogram);
+}
+
+TEST(scan_aggregator_test, resume)
+{
+    ::dsn::apps::aggregate_scan_request request;
+    request.top_k_count = 10;
+    request.top_k_order = ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT;
+
+    // The rows of hash key "b" are split into two requests.
+    scan_aggregator first(request, kEpochNow);
+    ASSERT_TRUE(first.add("a", 1, 1, 0));
+    ASSERT_TRUE(first.add("b", 1, 1, 0));
+    ASSERT_TRUE(first.add("b", 1, 1, 0));
+
+    ::dsn::apps::aggregate_scan_response first_resp;
+    first.finish(false, first_resp);
+    ASSERT_EQ(3, first_resp.row_count);
+    ASSERT_EQ(1, first_resp.hash_key_count);
+    ASSERT_EQ(1, first_resp.top_hash_keys.size());
+    ASSERT_TRUE(first_resp.__isset.last_hash_key_stat);
+    ASSERT_EQ("b", first_resp.last_hash_key_stat.hash_key.to_string());
+    ASSERT_EQ(2, first_resp.last_hash_key_stat.row_count);
+
+    request.__set_last_hash_key_stat(first_resp.last_hash_key_stat);
+    scan_aggregator second(request, kEpochNow);
+    ASSERT_TRUE(second.add("b", 1, 1, 0));
+    ASSERT_TRUE(second.add("c", 1, 1, 0));
+
+    ::dsn::apps::aggregate_scan_response second_resp;
+    second.finish(true, second_resp);
+    ASSERT_EQ(2, second_resp.row_count);
+    ASSERT_EQ(2, second_resp.hash_key_count);
+    ASSERT_FALSE(second_resp.__isset.last_hash_key_stat);
+    ASSERT_EQ(2, second_resp.top_hash_keys.size());
+    ASSERT_EQ("b", second_resp.top_hash_keys[0].hash_key.to_string());
+    ASSERT_EQ(3, second_resp.top_hash_keys[0].row_count);
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/scan_pushdown_filter.h"
+
+#include <rrdb/rrdb_types.h>
+#include <stdint.h>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "utils/blob.h"
+
+namespace pegasus {
+namespace server {
+
+TEST(scan_pushdown_filter_test, default_filter)
+{
+    scan_pushdown_filter filter;
+    ASSERT_TRUE(filter.valid());
+    ASSERT_TRUE(filter.match_all());
+    ASSERT_FALSE(filter.no_value());
+    ASSERT_FALSE(filter.return_value_length());
+
+    filter = scan_pushdown_filter(::dsn::apps::scan_pushdown());
+    ASSERT_TRUE(filter.valid());
+    ASSERT_TRUE(filter.match_all());
+}
+
+TEST(scan_pushdown_filter_test, projection)
+{
+    struct test_case
+    {
+        ::dsn::apps::scan_projection::type projection;
+        bool expected_valid;
+        bool expected_no_value;
+        bool expected_return_value_length;
+    } tests[] = {
+        {::dsn::apps::scan_projection::SP_KEY_VALUE, true, false, false},
+        {::dsn::apps::scan_projection::SP_KEY_ONLY, true, true, false},
+        {::dsn::apps::scan_projection::SP_VALUE_LENGTH, true, true, true},
+        {static_cast<::dsn::apps::scan_projection::type>(100), false, true, false},
+    };
+
+    for (const auto &test : tests) {
+        ::dsn::apps::scan_pushdown pushdown;
+        pushdown.__set_projection(test.projection);
+        scan_pushdown_filter filter(pushdown);
+        ASSERT_EQ(test.expected_valid, filter.valid());
+        ASSERT_TRUE(filter.match_all());
+        ASSERT_EQ(test.expected_no_value, filter.no_value());
+        ASSERT_EQ(test.expected_return_value_length, filter.return_value_length());
+    }
+}
+
+TEST(scan_pushdown_filter_test, match)
+{
+    ::dsn::apps::scan_pushdown pushdown;
+    pushdown.__set_value_filter_type(::dsn::apps::filter_type::FT_MATCH_PREFIX);
+    pushdown.__set_value_filter_pattern(::dsn::blob::create_from_bytes("v"));
+    pushdown.__set_value_start(::dsn::blob::create_from_bytes("v1"));
+    pushdown.__set_value_stop(::dsn::blob::create_from_bytes("v5"));
+    pushdown.__set_min_expire_ts_seconds(100);
+    pushdown.__set_max_expire_ts_seconds(200);
+
+    scan_pushdown_filter filter(pushdown);
+    ASSERT_TRUE(filter.valid());
+    ASSERT_FALSE(filter.match_all());
+
+    struct test_case
+    {
+        uint32_t expire_ts;
+        std::string value;
+        bool expected_match;
+    } tests[] = {
+        {100, "v1", true},
+        {200, "v4_value", true},
+        {150, "v", false},
+        {150, "v5", false},
+        {150, "w", false},
+        {99, "v2", false},
+        {201, "v2", false},
+        {0, "v2", false},
+    };
+
+    for (const auto &test : tests) {
+        ASSERT_EQ(test.expected_match, filter.match(test.expire_ts, test.value))
+            << "expire_ts = " << test.expire_ts << ", value = " << test.value;
+    }
+}
+
+TEST(scan_pushdown_filter_test, invalid_value_filter)
+{
+    ::dsn::apps::scan_pushdown pushdown;
+    pushdown.__set_value_filter_type(static_cast<::dsn::apps::filter_type::type>(100));
+    pushdown.__set_value_filter_pattern(::dsn::blob::create_from_bytes("a"));
+    ASSERT_FALSE(scan_pushdown_filter(pushdown).valid());
+}
+
+TEST(scan_pushdown_filter_test, invalid_expire_ts)
+{
+    {
+        ::dsn::apps::scan_pushdown pushdown;
+        pushdown.__set_min_expire_ts_seconds(-1);
+        ASSERT_FALSE(scan_pushdown_filter(pushdown).valid());
+    }
+    {
+        ::dsn::apps::scan_pushdown pushdown;
+        pushdown.__set_max_expire_ts_seconds(-1);
+        ASSERT_FALSE(scan_pushdown_filter(pushdown).valid());
+    }
+    {
+        ::dsn::apps::scan_pushdown pushdown;
+        pushdown.__set_min_expire_ts_seconds(0);
+        pushdown.__set_max_expire_ts_seconds(0);
+        ASSERT_TRUE(scan_pushdown_filter(pushdown).valid());
+    }
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,68 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "server/scan_split_keys.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace pegasus {
+namespace server {
+
+TEST(scan_split_keys_test, select_split_keys)
+{
+    const std::vector<split_key_candidate> candidates = {
+        {"a", 0}, {"b", 10}, {"c", 20}, {"d", 50}, {"e", 60}, {"f", 90}};
+
+    struct test_case
+    {
+        std::vector<split_key_candidate> candidates;
+        uint64_t total_size;
+        int32_t split_count;
+        std::vector<std::string> expected_split_keys;
+    } tests[] = {
+        // No split is needed.
+        {candidates, 100, 1, {}},
+        {candidates, 100, 0, {}},
+        // Nothing to split.
+        {candidates, 0, 4, {}},
+        {{}, 100, 4, {}},
+        // Split at the first candidate reaching each target.
+        {candidates, 100, 2, {"d"}},
+        {candidates, 100, 4, {"d", "e", "f"}},
+        {candidates, 100, 5, {"c", "d", "e", "f"}},
+        // More splits than candidates.
+        {candidates, 100, 100, {"b", "c", "d", "e", "f"}},
+        // The candidate without data before it is never selected.
+        {{{"a", 0}, {"b", 0}}, 100, 4, {}},
+        // Duplicate keys are selected only once.
+        {{{"a", 10}, {"a", 60}, {"b", 80}}, 100, 4, {"a", "b"}},
+    };
+
+    for (const auto &test : tests) {
+        ASSERT_EQ(test.expected_split_keys,
+                  select_split_keys(test.candidates, test.total_size, test.split_count));
+    }
+}
+
+} // namespace server
+} // namespace pegasus
@@ -0,0 +1,242 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <fmt/core.h>
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+#include <rocksdb/status.h>
+#include <rocksdb/write_batch.h>
+#include <stdint.h>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "runtime/api_layer1.h"
+#include "utils/filesystem.h"
+#include "utils/rand.h"
+#include "utils/string_conv.h"
+#include "utils/strings.h"
+
+void print_usage(const char *cmd)
+{
+    fmt::print("USAGE: {} <dir> <replica_counts> <writes_per_replica> <threads> <value_size> "
+               "<mode>\n",
+               cmd);
+    fmt::print("Run a simple benchmark that measures the write throughput of a disk shared by\n"
+               "multiple replicas, each of which commits small write batches with WAL disabled\n"
+               "into its own RocksDB instance, the same as rocksdb_wrapper::write().\n\n");
+
+    fmt::print("    <dir>                  the directory on the disk, which will be cleared.\n");
+    fmt::print("    <replica_counts>       comma-separated replica counts, e.g. 1,16,64,128.\n");
+    fmt::print("    <writes_per_replica>   the number of write batches for each replica.\n");
+    fmt::print("    <threads>              the number of writer threads, among which the\n"
+               "                           replicas are distributed.\n");
+    fmt::print("    <value_size>           the size of each value.\n");
+    fmt::print("    <mode>                 the write mode, could be default, pipelined or\n"
+               "                           unordered.\n");
+}
+
+std::string random_string(size_t size)
+{
+    static const char kAlphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    std::string str(size, '\0');
+    for (auto &c : str) {
+        c = kAlphabet[dsn::rand::next_u32(0, sizeof(kAlphabet) - 2)];
+    }
+    return str;
+}
+
+struct replica_db
+{
+    std::unique_ptr<rocksdb::DB> db;
+    std::vector<rocksdb::ColumnFamilyHandle *> cfs;
+};
+
+replica_db open_db(const std::string &path, const std::string &mode)
+{
+    rocksdb::DBOptions db_opts;
+    db_opts.create_if_missing = true;
+    db_opts.create_missing_column_families = true;
+    db_opts.atomic_flush = true;
+    db_opts.enable_pipelined_write = (mode == "pipelined");
+    db_opts.unordered_write = (mode == "unordered");
+
+    std::vector<rocksdb::ColumnFamilyDescriptor> descs = {
+        {rocksdb::kDefaultColumnFamilyName, rocksdb::ColumnFamilyOptions()},
+        {"pegasus_meta_cf", rocksdb::ColumnFamilyOptions()}};
+
+    replica_db r;
+    rocksdb::DB *db = nullptr;
+    const auto s = rocksdb::DB::Open(db_opts, path, descs, &r.cfs, &db);
+    if (!s.ok()) {
+        fmt::print(stderr, "Failed to open {}: {}\n", path, s.ToString());
+        ::exit(-1);
+    }
+    r.db.reset(db);
+    return r;
+}
+
+void close_db(replica_db &r)
+{
+    for (auto *cf : r.cfs) {
+        r.db->DestroyColumnFamilyHandle(cf);
+    }
+    r.cfs.clear();
+    r.db.reset();
+}
+
+void run_bench(const std::string &dir,
+               uint64_t replica_count,
+               uint64_t writes_per_replica,
+               uint64_t threads,
+               uint64_t value_size,
+               const std::string &mode)
+{
+    dsn::utils::filesystem::remove_path(dir);
+    if (!dsn::utils::filesystem::create_directory(dir)) {
+        fmt::print(stderr, "Failed to create {}\n", dir);
+        ::exit(-1);
+    }
+
+    std::vector<replica_db> dbs;
+    dbs.reserve(replica_count);
+    for (uint64_t i = 0; i < replica_count; ++i) {
+        dbs.emplace_back(
+            open_db(dsn::utils::filesystem::path_combine(dir, std::to_string(i)), mode));
+    }
+
+    const std::string value = random_string(value_size);
+    rocksdb::WriteOptions wt_opts;
+    wt_opts.disableWAL = true;
+
+    auto start = dsn_now_ns();
+    std::vector<std::thread> workers;
+    for (uint64_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            // Each thread commits the batches of its own replicas round-robin, just like the
+            // replication threads each of which serves a subset of the replicas.
+            rocksdb::WriteBatch batch;
+            for (uint64_t n = 0; n < writes_per_replica; ++n) {
+                for (uint64_t i = t; i < replica_count; i += threads) {
+                    batch.Clear();
+                    batch.Put(dbs[i].cfs[0], random_string(32), value);
+                    batch.Put(dbs[i].cfs[1], "pegasus_last_flushed_decree", std::to_string(n));
+                    const auto s = dbs[i].db->Write(wt_opts, &batch);
+                    if (!s.ok()) {
+                        fmt::print(stderr, "Failed to write: {}\n", s.ToString());
+                        ::exit(-1);
+                    }
+                }
+            }
+        });
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    auto time_ns = dsn_now_ns() - start;
+
+    for (auto &r : dbs) {
+        close_db(r);
+    }
+    dsn::utils::filesystem::remove_path(dir);
+
+    const auto seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::nanoseconds(time_ns))
+            .count();
+    const auto total_writes = replica_count * writes_per_replica;
+    fmt::print("Writing {} batches into {} replicas by {} threads in {} mode took {} seconds, "
+               "{:.0f} batches per second.\n",
+               total_writes,
+               replica_count,
+               threads,
+               mode,
+               seconds,
+               total_writes / seconds);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 7) {
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    const std::string dir(argv[1]);
+
+    std::vector<std::string> count_strs;
+    dsn::utils::split_args(argv[2], count_strs, ',');
+    std::vector<uint64_t> replica_counts;
+    for (const auto &str : count_strs) {
+        uint64_t count;
+        if (!dsn::buf2uint64(str, count) || count == 0) {
+            fmt::print(stderr, "Invalid replica_counts: {}\n\n", argv[2]);
+
+            print_usage(argv[0]);
+            ::exit(-1);
+        }
+        replica_counts.push_back(count);
+    }
+    if (replica_counts.empty()) {
+        fmt::print(stderr, "Invalid replica_counts: {}\n\n", argv[2]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t writes_per_replica;
+    if (!dsn::buf2uint64(argv[3], writes_per_replica) || writes_per_replica == 0) {
+        fmt::print(stderr, "Invalid writes_per_replica: {}\n\n", argv[3]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t threads;
+    if (!dsn::buf2uint64(argv[4], threads) || threads == 0) {
+        fmt::print(stderr, "Invalid threads: {}\n\n", argv[4]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    uint64_t value_size;
+    if (!dsn::buf2uint64(argv[5], value_size)) {
+        fmt::print(stderr, "Invalid value_size: {}\n\n", argv[5]);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    const std::string mode(argv[6]);
+    if (mode != "default" && mode != "pipelined" && mode != "unordered") {
+        fmt::print(stderr, "Invalid mode: {}\n\n", mode);
+
+        print_usage(argv[0]);
+        ::exit(-1);
+    }
+
+    for (const auto count : replica_counts) {
+        run_bench(dir, count, writes_per_replica, threads, value_size, mode);
+    }
+
+    return 0;
+}
@@ -284,6 +284,8 @@ inline bool validate_filter(pegasus::pegasus_client::filter_type filter_type,
         return true;
     case pegasus::pegasus_client::FT_MATCH_EXACT:
         return filter_pattern == value;
+    case pegasus::pegasus_client::FT_MATCH_GLOB:
+        return dsn::utils::glob_match(value, filter_pattern);
     case pegasus::pegasus_client::FT_MATCH_ANYWHERE:
     case pegasus::pegasus_client::FT_MATCH_PREFIX:
     case pegasus::pegasus_client::FT_MATCH_POSTFIX: {
@@ -51,6 +51,7 @@
 #include "pegasus_key_schema.h"
 #include "pegasus_utils.h"
 #include "rpc/rpc_host_port.h"
+#include "rrdb/rrdb.client.h"
 #include "rrdb/rrdb_types.h"
 #include "shell/args.h"
 #include "shell/command_executor.h"
@@ -80,6 +81,22 @@ print_current_scan_state(const std::vector<std::unique_ptr<scan_data_context>> &
                          std::shared_ptr<rocksdb::Statistics> statistics,
                          bool count_hash_key);
 
+static void count_data_by_aggregate_scan(shell_context *sc,
+                                         const ::dsn::apps::aggregate_scan_request &request,
+                                         int32_t partition,
+                                         int timeout_ms,
+                                         int run_seconds,
+                                         bool diff_hash_key);
+
+// Return the rpc error of the del_range request, which has been printed except
+// ERR_HANDLER_NOT_FOUND, i.e. the server does not support del_range.
+static ::dsn::error_code
+del_range_by_tombstone(shell_context *sc,
+                       const std::string &hash_key,
+                       const std::string &start_sort_key,
+                       const std::string &stop_sort_key,
+                       const pegasus::pegasus_client::scan_options &options);
+
 void escape_sds_argv(int argc, sds *argv);
 int mutation_check(int args_count, sds *args);
 int load_mutations(shell_context *sc, pegasus::pegasus_client::mutations &mutations);
@@ -504,6 +521,7 @@ bool multi_del_range(command_executor *e, shell_context *sc, arguments args)
     options.timeout_ms = sc->timeout_ms;
     std::string sort_key_filter_type_name("no_filter");
     bool silent = false;
+    bool by_scan = false;
     FILE *file = stderr;
     int batch_del_count = 100;
 
@@ -513,6 +531,7 @@ bool multi_del_range(command_executor *e, shell_context *sc, arguments args)
                                            {"sort_key_filter_pattern", required_argument, 0, 'y'},
                                            {"output", required_argument, 0, 'o'},
                                            {"silent", no_argument, 0, 'i'},
+                                           {"by_scan", no_argument, 0, 'r'},
                                            {0, 0, 0, 0}};
 
     escape_sds_argv(args.argc, args.argv);
@@ -520,7 +539,7 @@ bool multi_del_range(command_executor *e, shell_context *sc, arguments args)
     while (true) {
         int option_index = 0;
         int c;
-        c = getopt_long(args.argc, args.argv, "a:b:s:y:o:i", long_options, &option_index);
+        c = getopt_long(args.argc, args.argv, "a:b:s:y:o:ir", long_options, &option_index);
         if (c == -1)
             break;
         switch (c) {
@@ -560,6 +579,9 @@ bool multi_del_range(command_executor *e, shell_context *sc, arguments args)
         case 'i':
             silent = true;
             break;
+        case 'r':
+            by_scan = true;
+            break;
         default:
             return false;
         }
@@ -580,8 +602,29 @@ bool multi_del_range(command_executor *e, shell_context *sc, arguments args)
                 pegasus::utils::c_escape_string(options.sort_key_filter_pattern).c_str());
     }
     fprintf(stderr, "silent: %s\n", silent ? "true" : "false");
+    fprintf(stderr, "by_scan: %s\n", by_scan ? "true" : "false");
     fprintf(stderr, "\n");
 
+    // Without a sort key filter, the whole range is deleted by a single range tombstone on the
+    // server side, rather than by scanning the keys and deleting them one by one. The deleted
+    // keys could only be listed by scanning.
+    if (options.sort_key_filter_type == pegasus::pegasus_client::FT_NO_FILTER && !by_scan &&
+        file == stderr) {
+        // The rows with an empty hash key are distributed over all the partitions by their
+        // sort keys, thus they could not be deleted by range in a single partition.
+        if (hash_key.empty()) {
+            fprintf(stderr, "ERROR: hash_key should not be empty\n");
+            return true;
+        }
+        if (del_range_by_tombstone(sc, hash_key, start_sort_key, stop_sort_key, options) !=
+            ::dsn::ERR_HANDLER_NOT_FOUND) {
+            return true;
+        }
+        fprintf(stderr,
+                "WARNING: the server does not support deleting a range by tombstone, "
+                "delete by scan instead\n\n");
+    }
+
     int count = 0;
     bool error_occured = false;
     pegasus::pegasus_client::pegasus_scanner *scanner = nullptr;
@@ -1595,6 +1638,8 @@ bool copy_data(command_executor *e, shell_context *sc, arguments args)
                                            {"no_value", no_argument, 0, 'i'},
                                            {"geo_data", no_argument, 0, 'g'},
                                            {"no_ttl", no_argument, 0, 'e'},
+                                           {"max_splits_per_partition", required_argument, 0, 'l'},
+                                           {"stream_credits", required_argument, 0, 'w'},
                                            {0, 0, 0, 0}};
 
     std::string target_cluster_name;
@@ -1622,8 +1667,11 @@ bool copy_data(command_executor *e, shell_context *sc, arguments args)
     while (true) {
         int option_index = 0;
         int c;
-        c = getopt_long(
-            args.argc, args.argv, "c:a:p:b:t:h:x:s:y:v:z:m:o:nigeu", long_options, &option_index);
+        c = getopt_long(args.argc,
+                        args.argv,
+                        "c:a:p:b:t:h:x:s:y:v:z:m:o:l:w:nigeu",
+                        long_options,
+                        &option_index);
         if (c == -1)
             break;
         switch (c) {
@@ -1701,6 +1749,18 @@ bool copy_data(command_executor *e, shell_context *sc, arguments args)
                 return false;
             }
             break;
+        case 'l':
+            if (!dsn::buf2int32(optarg, options.max_splits_per_partition)) {
+                fprintf(stderr, "ERROR: parse %s as max_splits_per_partition failed\n", optarg);
+                return false;
+            }
+            break;
+        case 'w':
+            if (!dsn::buf2int32(optarg, options.stream_credits)) {
+                fprintf(stderr, "ERROR: parse %s as stream_credits failed\n", optarg);
+                return false;
+            }
+            break;
         case 'n':
             no_overwrite = true;
             break;
@@ -1751,6 +1811,16 @@ bool copy_data(command_executor *e, shell_context *sc, arguments args)
         return false;
     }
 
+    if (options.max_splits_per_partition <= 0) {
+        fprintf(stderr, "ERROR: max_splits_per_partition should be greater than 0\n");
+        return false;
+    }
+
+    if (partition != -1 && options.max_splits_per_partition > 1) {
+        fprintf(stderr, "ERROR: max_splits_per_partition should not be set with partition\n");
+        return false;
+    }
+
     if (use_multi_set && no_overwrite) {
         fprintf(stderr, "ERROR: copy with multi_set not support no_overwrite!\n");
         return false;
@@ -1773,6 +1843,7 @@ bool copy_data(command_executor *e, shell_context *sc, arguments args)
             partition >= 0 ? boost::lexical_cast<std::string>(partition).c_str() : "all");
     fprintf(stderr, "INFO: max_batch_count = %d\n", max_batch_count);
     fprintf(stderr, "INFO: timeout_ms = %d\n", timeout_ms);
+    fprintf(stderr, "INFO: stream_credits = %d\n", options.stream_credits);
     fprintf(stderr, "INFO: hash_key_filter_type = %s\n", hash_key_filter_type_name.c_str());
     if (options.hash_key_filter_type != pegasus::pegasus_client::FT_NO_FILTER) {
         fprintf(stderr,
@@ -2318,6 +2389,10 @@ bool count_data(command_executor *e, shell_context *sc, arguments args)
                                            {"stat_size", no_argument, 0, 'a'},
                                            {"top_count", required_argument, 0, 'n'},
                                            {"run_seconds", required_argument, 0, 'r'},
+                                           {"client_side", no_argument, 0, 'g'},
+                                           {"top_hash_key_count", required_argument, 0, 'k'},
+                                           {"top_hash_key_order", required_argument, 0, 'o'},
+                                           {"ttl_histogram", no_argument, 0, 'l'},
                                            {0, 0, 0, 0}};
 
     // "count_data" usually need scan all online records to get precise result, which may affect
@@ -2340,6 +2415,10 @@ bool count_data(command_executor *e, shell_context *sc, arguments args)
     bool stat_size = false;
     int top_count = 0;
     int run_seconds = 0;
+    bool client_side = false;
+    int top_hash_key_count = 0;
+    std::string top_hash_key_order("rows");
+    bool ttl_histogram = false;
     pegasus::pegasus_client::scan_options options;
 
     optind = 0;
@@ -2347,7 +2426,7 @@ bool count_data(command_executor *e, shell_context *sc, arguments args)
         int option_index = 0;
         int c;
         c = getopt_long(
-            args.argc, args.argv, "cp:b:t:h:x:s:y:v:z:dan:r:", long_options, &option_index);
+            args.argc, args.argv, "cp:b:t:h:x:s:y:v:z:dan:r:gk:o:l", long_options, &option_index);
         if (c == -1)
             break;
         // input any valid parameter means you want to get precise count by scanning.
@@ -2429,6 +2508,25 @@ bool count_data(command_executor *e, shell_context *sc, arguments args)
                 return false;
             }
             break;
+        case 'g':
+            client_side = true;
+            break;
+        case 'k':
+            if (!dsn::buf2int32(optarg, top_hash_key_count) || top_hash_key_count < 0) {
+                fprintf(stderr, "parse %s as top_hash_key_count failed\n", optarg);
+                return false;
+            }
+            break;
+        case 'o':
+            top_hash_key_order = optarg;
+            if (top_hash_key_order != "rows" && top_hash_key_order != "size") {
+                fprintf(stderr, "ERROR: top_hash_key_order should be rows or size\n");
+                return false;
+            }
+            break;
+        case 'l':
+            ttl_histogram = true;
+            break;
         default:
             return false;
         }
@@ -2520,6 +2618,52 @@ bool count_data(command_executor *e, shell_context *sc, arguments args)
     fprintf(stderr, "INFO: top_count = %d\n", top_count);
     fprintf(stderr, "INFO: run_seconds = %d\n", run_seconds);
 
+    // Aggregate on the server side unless the size histograms (which need every row) are
+    // required, or the client side aggregation is specified explicitly (e.g. for the servers
+    // which have not supported aggregate_scan yet).
+    if (!stat_size && !client_side) {
+        fprintf(stderr, "INFO: aggregate on the server side\n");
+        fprintf(stderr, "INFO: top_hash_key_count = %d\n", top_hash_key_count);
+        fprintf(stderr, "INFO: top_hash_key_order = %s\n", top_hash_key_order.c_str());
+
+        ::dsn::apps::aggregate_scan_request request;
+        // Scan the whole partition, the same as get_unordered_scanners().
+        request.start_key = ::dsn::blob::create_from_bytes(std::string("\x00\x00", 2));
+        request.stop_key = ::dsn::blob::create_from_bytes(std::string("\xFF\xFF", 2));
+        request.start_inclusive = true;
+        request.stop_inclusive = false;
+        request.hash_key_filter_type =
+            static_cast<::dsn::apps::filter_type::type>(options.hash_key_filter_type);
+        request.hash_key_filter_pattern =
+            ::dsn::blob::create_from_bytes(std::string(options.hash_key_filter_pattern));
+        request.sort_key_filter_type =
+            static_cast<::dsn::apps::filter_type::type>(sort_key_filter_type);
+        request.sort_key_filter_pattern =
+            ::dsn::blob::create_from_bytes(std::string(sort_key_filter_pattern));
+        if (value_filter_type != pegasus::pegasus_client::FT_NO_FILTER) {
+            ::dsn::apps::scan_pushdown pushdown;
+            pushdown.__set_value_filter_type(
+                static_cast<::dsn::apps::filter_type::type>(value_filter_type));
+            pushdown.__set_value_filter_pattern(
+                ::dsn::blob::create_from_bytes(std::string(value_filter_pattern)));
+            request.__set_pushdown(std::move(pushdown));
+        }
+        request.validate_partition_hash = true;
+        request.full_scan = true;
+        if (ttl_histogram) {
+            // 1 hour, 1 day, 7 days and 30 days.
+            request.ttl_bucket_bounds_seconds = {3600, 86400, 604800, 2592000};
+        }
+        request.top_k_count = top_hash_key_count;
+        request.top_k_order = top_hash_key_order == "rows"
+                                  ? ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT
+                                  : ::dsn::apps::aggregate_top_k_order::ATO_DATA_SIZE;
+
+        count_data_by_aggregate_scan(
+            sc, request, partition, timeout_ms, run_seconds, diff_hash_key);
+        return true;
+    }
+
     std::vector<pegasus::pegasus_client::pegasus_scanner *> raw_scanners;
     options.timeout_ms = timeout_ms;
     if (sort_key_filter_type != pegasus::pegasus_client::FT_NO_FILTER) {
@@ -2852,6 +2996,236 @@ print_current_scan_state(const std::vector<std::unique_ptr<scan_data_context>> &
     }
 }
 
+static ::dsn::error_code
+del_range_by_tombstone(shell_context *sc,
+                       const std::string &hash_key,
+                       const std::string &start_sort_key,
+                       const std::string &stop_sort_key,
+                       const pegasus::pegasus_client::scan_options &options)
+{
+    ::dsn::apps::del_range_request request;
+    request.hash_key = ::dsn::blob::create_from_bytes(std::string(hash_key));
+    request.start_sort_key = ::dsn::blob::create_from_bytes(std::string(start_sort_key));
+    request.start_inclusive = options.start_inclusive;
+    request.stop_sort_key = ::dsn::blob::create_from_bytes(std::string(stop_sort_key));
+    request.stop_inclusive = options.stop_inclusive;
+
+    ::dsn::apps::rrdb_client client(
+        sc->current_cluster_name.c_str(), sc->meta_list, sc->current_app_name.c_str());
+    const auto r = client.del_range_sync(request,
+                                         std::chrono::milliseconds(sc->timeout_ms),
+                                         pegasus::pegasus_hash_key_hash(request.hash_key));
+    if (r.first != ::dsn::ERR_OK) {
+        if (r.first != ::dsn::ERR_HANDLER_NOT_FOUND) {
+            fprintf(stderr, "ERROR: delete range failed: %s\n", r.first.to_string());
+        }
+        return r.first;
+    }
+
+    const auto &resp = r.second;
+    if (resp.error != 0) {
+        fprintf(stderr,
+                "ERROR: delete range failed: rocksdb error %d {app_id=%d, partition_index=%d, "
+                "server=%s}\n",
+                resp.error,
+                resp.app_id,
+                resp.partition_index,
+                resp.server.c_str());
+        return r.first;
+    }
+
+    fprintf(stderr,
+            "OK, the sort key range is deleted {app_id=%d, partition_index=%d, server=%s}.\n",
+            resp.app_id,
+            resp.partition_index,
+            resp.server.c_str());
+    return r.first;
+}
+
+static void count_data_by_aggregate_scan(shell_context *sc,
+                                         const ::dsn::apps::aggregate_scan_request &request,
+                                         int32_t partition,
+                                         int timeout_ms,
+                                         int run_seconds,
+                                         bool diff_hash_key)
+{
+    static const int kMaxConcurrency = 16;
+
+    int32_t app_id = 0;
+    int32_t partition_count = 0;
+    std::vector<::dsn::partition_configuration> pcs;
+    auto err = sc->ddl_client->list_app(sc->current_app_name, app_id, partition_count, pcs);
+    if (err != ::dsn::ERR_OK) {
+        fprintf(stderr,
+                "ERROR: list app %s failed: %s\n",
+                sc->current_app_name.c_str(),
+                err.to_string());
+        return;
+    }
+    if (partition >= partition_count) {
+        fprintf(stderr, "ERROR: invalid partition param: %d\n", partition);
+        return;
+    }
+
+    std::vector<int32_t> partitions;
+    if (partition >= 0) {
+        partitions.push_back(partition);
+    } else {
+        for (int32_t i = 0; i < partition_count; ++i) {
+            partitions.push_back(i);
+        }
+    }
+
+    ::dsn::apps::rrdb_client client(
+        sc->current_cluster_name.c_str(), sc->meta_list, sc->current_app_name.c_str());
+    std::vector<::dsn::apps::aggregate_scan_response> results(partitions.size());
+    std::vector<std::string> errors(partitions.size());
+    std::atomic_int next_index(0);
+    std::atomic_bool stopped_by_run_seconds(false);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(run_seconds);
+
+    // Each partition is aggregated by a sequence of requests, each of which continues from
+    // where the previous one stopped, and the results are merged exactly.
+    auto worker = [&]() {
+        for (int i = next_index++; i < static_cast<int>(partitions.size()); i = next_index++) {
+            auto &result = results[i];
+            ::dsn::apps::aggregate_scan_request req = request;
+            while (true) {
+                if (run_seconds > 0 && std::chrono::steady_clock::now() >= deadline) {
+                    stopped_by_run_seconds = true;
+                    break;
+                }
+
+                auto r = client.aggregate_scan_sync(
+                    req, std::chrono::milliseconds(timeout_ms), partitions[i]);
+                if (r.first != ::dsn::ERR_OK) {
+                    errors[i] = r.first.to_string();
+                    break;
+                }
+                const auto &resp = r.second;
+                if (resp.error != 0) {
+                    errors[i] = fmt::format("rocksdb error {}", resp.error);
+                    break;
+                }
+
+                result.row_count += resp.row_count;
+                result.hash_key_count += resp.hash_key_count;
+                result.key_bytes += resp.key_bytes;
+                result.value_bytes += resp.value_bytes;
+                result.no_ttl_count += resp.no_ttl_count;
+                result.expire_count += resp.expire_count;
+                result.filter_count += resp.filter_count;
+                result.ttl_histogram.resize(resp.ttl_histogram.size(), 0);
+                for (size_t j = 0; j < resp.ttl_histogram.size(); ++j) {
+                    result.ttl_histogram[j] += resp.ttl_histogram[j];
+                }
+                result.top_hash_keys.insert(result.top_hash_keys.end(),
+                                            resp.top_hash_keys.begin(),
+                                            resp.top_hash_keys.end());
+
+                if (resp.complete) {
+                    result.complete = true;
+                    break;
+                }
+                req.start_key = resp.next_start_key;
+                req.start_inclusive = true;
+                if (resp.__isset.last_hash_key_stat) {
+                    req.__set_last_hash_key_stat(resp.last_hash_key_stat);
+                } else {
+                    req.__isset.last_hash_key_stat = false;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::min<int>(kMaxConcurrency, partitions.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    ::dsn::apps::aggregate_scan_response total;
+    bool all_complete = true;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        const auto &result = results[i];
+        fprintf(stderr, "INFO: split[%d]: %" PRId64 " rows", partitions[i], result.row_count);
+        if (diff_hash_key) {
+            fprintf(stderr, " (%" PRId64 " hash keys)", result.hash_key_count);
+        }
+        fprintf(stderr,
+                ", %" PRId64 " key bytes, %" PRId64 " value bytes%s%s\n",
+                result.key_bytes,
+                result.value_bytes,
+                errors[i].empty() ? "" : ", error: ",
+                errors[i].c_str());
+        all_complete = all_complete && result.complete;
+
+        total.row_count += result.row_count;
+        total.hash_key_count += result.hash_key_count;
+        total.key_bytes += result.key_bytes;
+        total.value_bytes += result.value_bytes;
+        total.no_ttl_count += result.no_ttl_count;
+        total.ttl_histogram.resize(result.ttl_histogram.size(), 0);
+        for (size_t j = 0; j < result.ttl_histogram.size(); ++j) {
+            total.ttl_histogram[j] += result.ttl_histogram[j];
+        }
+        total.top_hash_keys.insert(
+            total.top_hash_keys.end(), result.top_hash_keys.begin(), result.top_hash_keys.end());
+    }
+
+    std::string stop_desc = "done";
+    if (!all_complete) {
+        stop_desc = stopped_by_run_seconds.load() ? "terminated as run time used out"
+                                                  : "terminated as error occurred";
+    }
+    fprintf(stderr, "Count %s, total %" PRId64 " rows.", stop_desc.c_str(), total.row_count);
+    if (diff_hash_key) {
+        fprintf(stderr, " (%" PRId64 " hash keys)", total.hash_key_count);
+    }
+    fprintf(stderr,
+            " %" PRId64 " key bytes, %" PRId64 " value bytes.\n",
+            total.key_bytes,
+            total.value_bytes);
+
+    if (!request.ttl_bucket_bounds_seconds.empty()) {
+        const auto &bounds = request.ttl_bucket_bounds_seconds;
+        fprintf(stderr, "[ttl] no ttl: %" PRId64 "\n", total.no_ttl_count);
+        for (size_t i = 0; i < total.ttl_histogram.size(); ++i) {
+            if (i < bounds.size()) {
+                fprintf(stderr, "[ttl] < %ds: %" PRId64 "\n", bounds[i], total.ttl_histogram[i]);
+            } else {
+                fprintf(stderr,
+                        "[ttl] >= %ds: %" PRId64 "\n",
+                        bounds.back(),
+                        total.ttl_histogram[i]);
+            }
+        }
+    }
+
+    if (request.top_k_count > 0) {
+        auto &tops = total.top_hash_keys;
+        const bool by_rows =
+            request.top_k_order == ::dsn::apps::aggregate_top_k_order::ATO_ROW_COUNT;
+        std::sort(tops.begin(),
+                  tops.end(),
+                  [by_rows](const ::dsn::apps::hash_key_stat &a,
+                            const ::dsn::apps::hash_key_stat &b) {
+                      return by_rows ? a.row_count > b.row_count : a.data_size > b.data_size;
+                  });
+        for (int i = 0; i < request.top_k_count && i < static_cast<int>(tops.size()); ++i) {
+            fprintf(stderr,
+                    "[top][%d].hash_key = \"%s\"\n",
+                    i + 1,
+                    pegasus::utils::c_escape_string(tops[i].hash_key.to_string(), sc->escape_all)
+                        .c_str());
+            fprintf(stderr, "[top][%d].row_count = %" PRId64 "\n", i + 1, tops[i].row_count);
+            fprintf(stderr, "[top][%d].data_size = %" PRId64 "\n", i + 1, tops[i].data_size);
+        }
+    }
+}
+
 bool calculate_hash_value(command_executor *e, shell_context *sc, arguments args)
 {
     if (args.argc != 3) {
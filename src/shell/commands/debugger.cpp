@@ -185,6 +185,19 @@ bool mlog_dump(command_executor *e, shell_context *sc, arguments args)
                            << pegasus::utils::c_escape_string(kv.value, sc->escape_all) << "\""
                            << std::endl;
                     }
+                } else if (msg->local_rpc_code == ::dsn::apps::RPC_RRDB_RRDB_BATCH_PUT) {
+                    ::dsn::apps::batch_put_request update;
+                    ::dsn::unmarshall(request, update);
+                    os << INDENT << "[BATCH_PUT] " << update.entries.size() << std::endl;
+                    for (const auto &entry : update.entries) {
+                        os << INDENT << INDENT << "[PUT] \""
+                           << pegasus::utils::c_escape_string(entry.hash_key, sc->escape_all)
+                           << "\" : \""
+                           << pegasus::utils::c_escape_string(entry.sort_key, sc->escape_all)
+                           << "\" => " << entry.expire_ts_seconds << " : \""
+                           << pegasus::utils::c_escape_string(entry.value, sc->escape_all) << "\""
+                           << std::endl;
+                    }
                 } else if (msg->local_rpc_code == ::dsn::apps::RPC_RRDB_RRDB_MULTI_REMOVE) {
                     ::dsn::apps::multi_remove_request update;
                     ::dsn::unmarshall(request, update);
@@ -195,6 +208,16 @@ bool mlog_dump(command_executor *e, shell_context *sc, arguments args)
                            << "\" : \"" << pegasus::utils::c_escape_string(sort_key, sc->escape_all)
                            << "\"" << std::endl;
                     }
+                } else if (msg->local_rpc_code == ::dsn::apps::RPC_RRDB_RRDB_DEL_RANGE) {
+                    ::dsn::apps::del_range_request update;
+                    ::dsn::unmarshall(request, update);
+                    os << INDENT << "[DEL_RANGE] \""
+                       << pegasus::utils::c_escape_string(update.hash_key, sc->escape_all)
+                       << "\" : " << (update.start_inclusive ? "[" : "(") << "\""
+                       << pegasus::utils::c_escape_string(update.start_sort_key, sc->escape_all)
+                       << "\", \""
+                       << pegasus::utils::c_escape_string(update.stop_sort_key, sc->escape_all)
+                       << "\"" << (update.stop_inclusive ? "]" : ")") << std::endl;
                 } else if (msg->local_rpc_code == ::dsn::apps::RPC_RRDB_RRDB_INCR) {
                     ::dsn::apps::incr_request update;
                     ::dsn::unmarshall(request, update);
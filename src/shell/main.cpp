@@ -216,7 +216,7 @@ static command_executor commands[] = {
         "get multiple values under sort key range for a single hash key",
         "<hash_key> <start_sort_key> <stop_sort_key> "
         "[-a|--start_inclusive true|false] [-b|--stop_inclusive true|false] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|glob] "
         "[-y|--sort_key_filter_pattern str] "
         "[-n|--max_count num] [-i|--no_value] [-r|--reverse]",
         data_operations,
@@ -244,9 +244,9 @@ static command_executor commands[] = {
         "delete multiple values under sort key range for a single hash key",
         "<hash_key> <start_sort_key> <stop_sort_key> "
         "[-a|--start_inclusive true|false] [-b|--stop_inclusive true|false] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|glob] "
         "[-y|--sort_key_filter_pattern str] "
-        "[-o|--output file_name] [-i|--silent]",
+        "[-o|--output file_name] [-i|--silent] [-r|--by_scan]",
         data_operations,
     },
     {
@@ -307,9 +307,9 @@ static command_executor commands[] = {
         "scan all sorted keys for a single hash key",
         "<hash_key> <start_sort_key> <stop_sort_key> "
         "[-a|--start_inclusive true|false] [-b|--stop_inclusive true|false] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|glob] "
         "[-y|--sort_key_filter_pattern str] "
-        "[-v|--value_filter_type anywhere|prefix|postfix|exact] "
+        "[-v|--value_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-z|--value_filter_pattern str] "
         "[-o|--output file_name] [-n|--max_count num] [-t|--timeout_ms num] "
         "[-d|--detailed] [-i|--no_value]",
@@ -318,11 +318,11 @@ static command_executor commands[] = {
     {
         "full_scan",
         "scan all hash keys",
-        "[-h|--hash_key_filter_type anywhere|prefix|postfix] "
+        "[-h|--hash_key_filter_type anywhere|prefix|postfix|glob] "
         "[-x|--hash_key_filter_pattern str] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-y|--sort_key_filter_pattern str] "
-        "[-v|--value_filter_type anywhere|prefix|postfix|exact] "
+        "[-v|--value_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-z|--value_filter_pattern str] "
         "[-o|--output file_name] [-n|--max_count num] [-t|--timeout_ms num] "
         "[-d|--detailed] [-i|--no_value] [-p|--partition num]",
@@ -333,25 +333,26 @@ static command_executor commands[] = {
         "copy app data",
         "<-c|--target_cluster_name str> <-a|--target_app_name str> "
         "[-p|--partition num] [-b|--max_batch_count num] [-t|--timeout_ms num] "
-        "[-h|--hash_key_filter_type anywhere|prefix|postfix] "
+        "[-h|--hash_key_filter_type anywhere|prefix|postfix|glob] "
         "[-x|--hash_key_filter_pattern str] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-y|--sort_key_filter_pattern str] "
-        "[-v|--value_filter_type anywhere|prefix|postfix|exact] "
+        "[-v|--value_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-z|--value_filter_pattern str] [-m|--max_multi_set_concurrency] "
-        "[-o|--scan_option_batch_size] [-e|--no_ttl] "
-        "[-n|--no_overwrite] [-i|--no_value] [-g|--geo_data] [-u|--use_multi_set]",
+        "[-o|--scan_option_batch_size] [-e|--no_ttl] [-l|--max_splits_per_partition num] "
+        "[-w|--stream_credits num] [-n|--no_overwrite] [-i|--no_value] [-g|--geo_data] "
+        "[-u|--use_multi_set]",
         data_operations,
     },
     {
         "clear_data",
         "clear app data",
         "[-p|--partition num] [-b|--max_batch_count num] [-t|--timeout_ms num] "
-        "[-h|--hash_key_filter_type anywhere|prefix|postfix] "
+        "[-h|--hash_key_filter_type anywhere|prefix|postfix|glob] "
         "[-x|--hash_key_filter_pattern str] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-y|--sort_key_filter_pattern str] "
-        "[-v|--value_filter_type anywhere|prefix|postfix|exact] "
+        "[-v|--value_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-z|--value_filter_pattern str] "
         "[-f|--force]",
         data_operations,
@@ -361,13 +362,15 @@ static command_executor commands[] = {
         "get app row count",
         "[-c|--precise][-p|--partition num] "
         "[-b|--max_batch_count num][-t|--timeout_ms num] "
-        "[-h|--hash_key_filter_type anywhere|prefix|postfix] "
+        "[-h|--hash_key_filter_type anywhere|prefix|postfix|glob] "
         "[-x|--hash_key_filter_pattern str] "
-        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact] "
+        "[-s|--sort_key_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-y|--sort_key_filter_pattern str] "
-        "[-v|--value_filter_type anywhere|prefix|postfix|exact] "
+        "[-v|--value_filter_type anywhere|prefix|postfix|exact|glob] "
         "[-z|--value_filter_pattern str][-d|--diff_hash_key] "
-        "[-a|--stat_size] [-n|--top_count num] [-r|--run_seconds num]",
+        "[-a|--stat_size] [-n|--top_count num] [-r|--run_seconds num] "
+        "[-g|--client_side] [-k|--top_hash_key_count num] "
+        "[-o|--top_hash_key_order rows|size] [-l|--ttl_histogram]",
         data_operations,
     },
     {
@@ -20,7 +20,7 @@ if [ -z "${REPORT_DIR}" ]; then
     REPORT_DIR="."
 fi
 
-test_cases=(config-test.ini config-test-sim.ini)
+test_cases=(config-test.ini config-test-sim.ini config-test-work-stealing.ini)
 for test_case in ${test_cases[*]}; do
     output_xml="${REPORT_DIR}/dsn_task_tests_${test_case/.ini/.xml}"
     echo "============ run dsn_task_tests ${test_case} ============"
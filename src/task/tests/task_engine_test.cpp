@@ -30,11 +30,19 @@
 #include <nlohmann/json.hpp>
 #include <nlohmann/json_fwd.hpp>
 #include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "runtime/global_config.h"
 #include "runtime/service_engine.h"
+#include "task/async_calls.h"
 #include "task/task.h"
+#include "task/task_code.h"
+#include "task/task_tracker.h"
 #include "runtime/test_utils.h"
 #include "utils/enum_helper.h"
 #include "utils/threadpool_code.h"
@@ -47,6 +55,10 @@ using namespace ::dsn;
 
 DEFINE_THREAD_POOL_CODE(THREAD_POOL_FOR_TEST_1)
 DEFINE_THREAD_POOL_CODE(THREAD_POOL_FOR_TEST_2)
+DEFINE_THREAD_POOL_CODE(THREAD_POOL_FOR_TEST_3)
+
+DEFINE_TASK_CODE(LPC_TEST_SKEWED_LOAD, TASK_PRIORITY_COMMON, THREAD_POOL_FOR_TEST_3)
+DEFINE_TASK_CODE(LPC_TEST_SELF_FEEDING_LOAD, TASK_PRIORITY_COMMON, THREAD_POOL_FOR_TEST_1)
 
 TEST(task_engine_test, basic)
 {
@@ -68,7 +80,8 @@ TEST(task_engine_test, basic)
     std::vector<task_worker_pool *> &pools = engine->pools();
     for (size_t i = 0; i < pools.size(); ++i) {
         if (i == THREAD_POOL_DEFAULT || i == THREAD_POOL_TEST_SERVER ||
-            i == THREAD_POOL_FOR_TEST_1 || i == THREAD_POOL_FOR_TEST_2) {
+            i == THREAD_POOL_FOR_TEST_1 || i == THREAD_POOL_FOR_TEST_2 ||
+            i == THREAD_POOL_FOR_TEST_3) {
             ASSERT_NE(nullptr, pools[i]);
         }
     }
@@ -97,3 +110,141 @@ TEST(task_engine_test, basic)
     std::vector<task_worker *> workers2 = pool2->workers();
     ASSERT_EQ(2u, workers2.size());
 }
+
+// All the tasks with zero hash are dispatched to the first queue of a partitioned pool, while
+// the tasks with the same non-zero hash must be run in order whatever the task queue is.
+TEST(task_engine_test, skewed_load)
+{
+    if (dsn::service_engine::instance().spec().tool == "simulator") {
+        GTEST_SKIP() << "Skip the test in simulator mode, set 'tool = nativerun' in '[core]' "
+                        "section in config file to enable it.";
+    }
+
+    constexpr int kUnorderedTaskCount = 2000;
+    constexpr int kHashCount = 8;
+    constexpr int kOrderedTaskCountPerHash = 500;
+    const auto busy = [](std::chrono::microseconds duration) {
+        const auto deadline = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < deadline) {
+        }
+    };
+
+    task_worker_pool *pool = task::get_current_node2()->computation()->get_pool(
+        THREAD_POOL_FOR_TEST_3);
+    ASSERT_NE(nullptr, pool);
+    ASSERT_TRUE(pool->spec().partitioned);
+
+    std::atomic<int> unordered_count(0);
+    std::atomic<int> ordered_count(0);
+    std::atomic<int> out_of_order_count(0);
+    // Each element is only accessed by the tasks with the same hash, which run one by one.
+    std::vector<int> last_sequences(kHashCount, -1);
+
+    task_tracker tracker;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kUnorderedTaskCount; ++i) {
+        tasking::enqueue(LPC_TEST_SKEWED_LOAD, &tracker, [&]() {
+            busy(std::chrono::microseconds(50));
+            ++unordered_count;
+        });
+
+        if (i % (kUnorderedTaskCount / kOrderedTaskCountPerHash) != 0) {
+            continue;
+        }
+        const int sequence = i / (kUnorderedTaskCount / kOrderedTaskCountPerHash);
+        for (int hash = 1; hash < kHashCount; ++hash) {
+            tasking::enqueue(
+                LPC_TEST_SKEWED_LOAD,
+                &tracker,
+                [&, hash, sequence]() {
+                    busy(std::chrono::microseconds(10));
+                    if (last_sequences[hash] + 1 != sequence) {
+                        ++out_of_order_count;
+                    }
+                    last_sequences[hash] = sequence;
+                    ++ordered_count;
+                },
+                hash);
+        }
+    }
+    tracker.wait_outstanding_tasks();
+    const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+
+    ASSERT_EQ(kUnorderedTaskCount, unordered_count.load());
+    ASSERT_EQ(kOrderedTaskCountPerHash * (kHashCount - 1), ordered_count.load());
+    ASSERT_EQ(0, out_of_order_count.load());
+    fmt::print(stdout,
+               "skewed load on {} workers with {}: {} ms\n",
+               pool->spec().worker_count,
+               pool->spec().queue_factory_name,
+               elapsed_ms);
+}
+
+// A worker of a work-stealing pool pops the newest task of its own deque first, while the older
+// ones must still be run with bounded latency once all the workers keep feeding themselves.
+TEST(task_engine_test, self_feeding_load)
+{
+    if (dsn::service_engine::instance().spec().tool == "simulator") {
+        GTEST_SKIP() << "Skip the test in simulator mode, set 'tool = nativerun' in '[core]' "
+                        "section in config file to enable it.";
+    }
+
+    constexpr int kProbeCount = 16;
+    constexpr int kWarmUpFeedCount = 1000;
+    constexpr auto kMaxFeedDuration = std::chrono::seconds(3);
+    constexpr auto kMaxProbeLatency = std::chrono::milliseconds(500);
+
+    task_worker_pool *pool = task::get_current_node2()->computation()->get_pool(
+        THREAD_POOL_FOR_TEST_1);
+    ASSERT_NE(nullptr, pool);
+    ASSERT_FALSE(pool->spec().partitioned);
+
+    std::atomic<int> feed_count(0);
+    std::atomic<bool> probes_enqueued(false);
+    std::atomic<int> probe_count(0);
+    // Each element is only written by the probe with the same index.
+    std::vector<std::chrono::microseconds> probe_latencies(kProbeCount,
+                                                           std::chrono::microseconds::max());
+
+    task_tracker tracker;
+    const auto deadline = std::chrono::steady_clock::now() + kMaxFeedDuration;
+    std::function<void()> feed = [&]() {
+        const auto busy_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(10);
+        while (std::chrono::steady_clock::now() < busy_deadline) {
+        }
+
+        // The probes are enqueued by a worker after all the workers are feeding themselves, so
+        // that they are pushed into its own deque under the task feeding it.
+        if (++feed_count >= kWarmUpFeedCount && !probes_enqueued.exchange(true)) {
+            for (int i = 0; i < kProbeCount; ++i) {
+                const auto enqueue_time = std::chrono::steady_clock::now();
+                tasking::enqueue(LPC_TEST_SELF_FEEDING_LOAD, &tracker, [&, i, enqueue_time]() {
+                    probe_latencies[i] = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - enqueue_time);
+                    ++probe_count;
+                });
+            }
+        }
+
+        if (probe_count.load() < kProbeCount && std::chrono::steady_clock::now() < deadline) {
+            tasking::enqueue(LPC_TEST_SELF_FEEDING_LOAD, &tracker, feed);
+        }
+    };
+
+    for (int i = 0; i < pool->spec().worker_count * 2; ++i) {
+        tasking::enqueue(LPC_TEST_SELF_FEEDING_LOAD, &tracker, feed);
+    }
+    tracker.wait_outstanding_tasks();
+
+    ASSERT_EQ(kProbeCount, probe_count.load());
+    const auto max_latency = *std::max_element(probe_latencies.begin(), probe_latencies.end());
+    ASSERT_LT(max_latency, kMaxProbeLatency);
+    fmt::print(stdout,
+               "self-feeding load on {} workers with {}: {} feeds, max probe latency {} us\n",
+               pool->spec().worker_count,
+               pool->spec().queue_factory_name,
+               feed_count.load(),
+               max_latency.count());
+}
@@ -0,0 +1,311 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "work_stealing_task_queue.h"
+
+#include <stddef.h>
+#include <algorithm>
+#include <thread>
+
+#include "task.h"
+#include "task_engine.h"
+#include "task_spec.h"
+#include "task_worker.h"
+#include "utils/rand.h"
+#include "utils/threadpool_spec.h"
+
+namespace dsn {
+namespace tools {
+
+namespace {
+
+// The tasks pushed by a worker while its deque is full are put into the global queue.
+constexpr size_t kDequeCapacity = 1024;
+
+// Once every so many tasks taken by a worker, the global queue and then the oldest task of its
+// own deque are checked before the newest one.
+constexpr uint32_t kGlobalCheckInterval = 61;
+
+} // anonymous namespace
+
+struct work_stealing_task_queue::task_list
+{
+    void append(task *t)
+    {
+        t->next = nullptr;
+        if (tail != nullptr) {
+            tail->next = t;
+        } else {
+            head = t;
+        }
+        tail = t;
+        ++count;
+    }
+
+    task *head = nullptr;
+    task *tail = nullptr;
+    int count = 0;
+};
+
+work_stealing_task_queue::worker_slot::worker_slot() : dequeue_count(0)
+{
+    for (auto &deque : deques) {
+        deque = std::make_unique<utils::work_stealing_deque<task *>>(kDequeCapacity);
+    }
+}
+
+work_stealing_task_queue::work_stealing_task_queue(task_worker_pool *pool,
+                                                   int index,
+                                                   task_queue *inner_provider)
+    : task_queue(pool, index, inner_provider),
+      _partitioned(pool->spec().partitioned),
+      _idle(false),
+      _steal_hints(0)
+{
+    // The only worker of a pool has nobody to share its tasks with, while popping them from a
+    // deque would run them in LIFO order, thus all of them go through the global queue.
+    if (!_partitioned && pool->spec().worker_count > 1) {
+        for (int i = 0; i < pool->spec().worker_count; ++i) {
+            _slots.emplace_back(std::make_unique<worker_slot>());
+        }
+    }
+}
+
+work_stealing_task_queue::~work_stealing_task_queue() = default;
+
+void work_stealing_task_queue::enqueue(task *task)
+{
+    const auto priority = task->spec().priority;
+
+    if (_partitioned) {
+        if (task->hash() != 0) {
+            _ordered[priority].enqueue(task);
+            _sema.signal(1);
+            return;
+        }
+
+        _global[priority].enqueue(task);
+        _sema.signal(1);
+
+        // Pairs with the fence in dequeue(): either an idle sibling finds this task before it
+        // blocks, or it is found idle here.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!_idle.load(std::memory_order_relaxed)) {
+            wake_up_idle_sibling();
+        }
+        return;
+    }
+
+    auto *slot = current_slot();
+    if (slot == nullptr || !slot->deques[priority]->push(task)) {
+        _global[priority].enqueue(task);
+    }
+    _sema.signal(1);
+}
+
+task *work_stealing_task_queue::dequeue(/*inout*/ int &batch_size)
+{
+    task_list tasks;
+    while (tasks.count == 0) {
+        auto units = static_cast<int>(_sema.tryWaitMany(batch_size));
+        if (units == 0) {
+            if (_partitioned) {
+                steal_from_siblings(batch_size, tasks);
+                if (tasks.count > 0) {
+                    break;
+                }
+
+                // Try again after being marked idle, otherwise the unordered tasks enqueued in
+                // the meantime would wait for their busy owners, see enqueue().
+                _idle.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                steal_from_siblings(batch_size, tasks);
+                if (tasks.count > 0) {
+                    _idle.store(false, std::memory_order_relaxed);
+                    break;
+                }
+            }
+
+            units = static_cast<int>(_sema.waitMany(batch_size));
+            if (_partitioned) {
+                _idle.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        const int hints = _partitioned ? take_steal_hints(units) : 0;
+        collect(units - hints, tasks);
+        if (hints > 0) {
+            steal_from_siblings(hints, tasks);
+        }
+    }
+
+    batch_size = tasks.count;
+    return tasks.head;
+}
+
+work_stealing_task_queue::worker_slot *work_stealing_task_queue::current_slot() const
+{
+    if (_slots.empty()) {
+        return nullptr;
+    }
+
+    auto *worker = task::get_current_worker();
+    if (worker == nullptr || worker->pool() != pool()) {
+        return nullptr;
+    }
+    return _slots[worker->index()].get();
+}
+
+void work_stealing_task_queue::collect(int count, task_list &tasks)
+{
+    auto *slot = current_slot();
+    while (count > 0) {
+        bool found = false;
+        for (int priority = TASK_PRIORITY_COUNT - 1; priority >= 0 && count > 0; --priority) {
+            task *t = nullptr;
+            while (count > 0 && take(priority, slot, t)) {
+                tasks.append(t);
+                --count;
+                found = true;
+            }
+        }
+
+        // Each acquired unit has a task in the queue, which might be missed just because
+        // another worker is stealing the same one and would then leave another one.
+        if (!found) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool work_stealing_task_queue::take(int priority, worker_slot *slot, task *&t)
+{
+    if (_partitioned) {
+        return _ordered[priority].try_dequeue(t) || _global[priority].try_dequeue(t);
+    }
+
+    if (slot == nullptr) {
+        return _global[priority].try_dequeue(t) || steal_from_slots(priority, nullptr, t);
+    }
+
+    // Otherwise the tasks enqueued from the outside of the pool, and the oldest ones of its own
+    // deque since it is popped in LIFO order, would be starved while the workers keep feeding
+    // themselves.
+    if (++slot->dequeue_count % kGlobalCheckInterval == 0 &&
+        (_global[priority].try_dequeue(t) || slot->deques[priority]->steal(t))) {
+        return true;
+    }
+
+    return slot->deques[priority]->pop(t) || _global[priority].try_dequeue(t) ||
+           steal_from_slots(priority, slot, t);
+}
+
+bool work_stealing_task_queue::steal_from_slots(int priority, const worker_slot *slot, task *&t)
+{
+    const auto n = _slots.size();
+    const auto start = rand::next_u32(static_cast<uint32_t>(n));
+    for (size_t i = 0; i < n; ++i) {
+        const auto &victim = _slots[(start + i) % n];
+        if (victim.get() != slot && victim->deques[priority]->steal(t)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<work_stealing_task_queue *> &work_stealing_task_queue::siblings()
+{
+    // All the queues have been created before the pool is started.
+    std::call_once(_siblings_once, [this]() {
+        for (auto *q : pool()->queues()) {
+            // The queues wrapped by the aspects are never stolen from.
+            auto *sibling = dynamic_cast<work_stealing_task_queue *>(q);
+            if (sibling != nullptr && sibling != this) {
+                _siblings.push_back(sibling);
+            }
+        }
+    });
+    return _siblings;
+}
+
+void work_stealing_task_queue::steal_from_siblings(int max_count, task_list &tasks)
+{
+    const auto &siblings = this->siblings();
+    const auto n = siblings.size();
+    const auto start = rand::next_u32(static_cast<uint32_t>(n));
+    for (size_t i = 0; i < n && tasks.count < max_count; ++i) {
+        auto *victim = siblings[(start + i) % n];
+
+        // Leave half of the backlog to the owner. A unit could be acquired only if the owner
+        // is busy, since the units are all taken once it is blocked.
+        auto quota = std::max<size_t>(1, victim->_sema.availableApprox() / 2);
+        while (quota-- > 0 && tasks.count < max_count && victim->_sema.tryWait()) {
+            task *t = nullptr;
+            bool found = false;
+            for (int priority = TASK_PRIORITY_COUNT - 1; priority >= 0 && !found; --priority) {
+                found = victim->_global[priority].try_dequeue(t);
+            }
+
+            if (!found) {
+                // The unit is for an ordered task, give it back to the owner.
+                victim->_sema.signal(1);
+                break;
+            }
+
+            // The task is counted by this queue from now on, since the worker decreases the
+            // count of its own queue once the tasks are dequeued.
+            victim->decrease_count();
+            increase_count();
+            tasks.append(t);
+        }
+    }
+}
+
+void work_stealing_task_queue::wake_up_idle_sibling()
+{
+    const auto &siblings = this->siblings();
+    const auto n = siblings.size();
+    const auto start = rand::next_u32(static_cast<uint32_t>(n));
+    for (size_t i = 0; i < n; ++i) {
+        auto *sibling = siblings[(start + i) % n];
+        bool idle = true;
+        if (sibling->_idle.load(std::memory_order_relaxed) &&
+            sibling->_idle.compare_exchange_strong(idle, false)) {
+            // The hint must be visible before the sibling is woken up by the unit.
+            ++sibling->_steal_hints;
+            sibling->_sema.signal(1);
+            return;
+        }
+    }
+}
+
+int work_stealing_task_queue::take_steal_hints(int units)
+{
+    auto hints = _steal_hints.load();
+    while (hints > 0) {
+        const auto taken = std::min(hints, units);
+        if (_steal_hints.compare_exchange_weak(hints, hints - taken)) {
+            return taken;
+        }
+    }
+    return 0;
+}
+
+} // namespace tools
+} // namespace dsn
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "concurrentqueue/concurrentqueue.h"
+#include "concurrentqueue/lightweightsemaphore.h"
+#include "task_code.h"
+#include "task_queue.h"
+#include "utils/ports.h"
+#include "utils/work_stealing_deque.h"
+
+namespace dsn {
+class task;
+class task_worker_pool;
+
+namespace tools {
+
+/// work_stealing_task_queue lets the idle workers of a pool take over the tasks queued for the
+/// busy ones, while the tasks that must run in order are never moved.
+///
+/// If the pool is not partitioned, all the workers share a single queue, and each of them owns
+/// a Chase-Lev deque: the tasks enqueued by a worker of the pool are pushed into its own deque
+/// and popped in LIFO order while they are still hot in the cache, and the other workers steal
+/// them from the other end once they run out of tasks. The tasks enqueued from the outside of
+/// the pool are shared by all the workers through a global queue, which is also checked
+/// periodically by a worker to make sure that these tasks would not be starved.
+///
+/// If the pool is partitioned, each worker owns a queue, to which the tasks are dispatched by
+/// their hashes. The tasks with non-zero hashes are ordered by the hash, thus they are only run
+/// by the owner in FIFO order, the same as hpc_concurrent_task_queue. The tasks with zero hash
+/// are bound to no partition (they are all dispatched to the first queue), thus they could be
+/// stolen by any idle worker of the pool; once such a task is enqueued while the owner is busy,
+/// an idle worker is woken up to steal it.
+class work_stealing_task_queue : public task_queue
+{
+public:
+    work_stealing_task_queue(task_worker_pool *pool, int index, task_queue *inner_provider);
+    ~work_stealing_task_queue() override;
+
+    void enqueue(task *task) override;
+
+    // Block until there is at least one task, more tasks (up to `batch_size`) are returned if
+    // available.
+    task *dequeue(/*inout*/ int &batch_size) override;
+
+private:
+    struct task_list;
+
+    // The deques owned by a worker of a non-partitioned pool.
+    struct worker_slot
+    {
+        worker_slot();
+
+        std::unique_ptr<utils::work_stealing_deque<task *>> deques[TASK_PRIORITY_COUNT];
+        // Only accessed by the owner.
+        uint32_t dequeue_count;
+    };
+
+    // The slot owned by the current thread, or nullptr if it is not a worker of this queue.
+    worker_slot *current_slot() const;
+
+    // Take `count` tasks for the units acquired from `_sema`, by the order of priority.
+    void collect(int count, task_list &tasks);
+    bool take(int priority, worker_slot *slot, task *&t);
+    bool steal_from_slots(int priority, const worker_slot *slot, task *&t);
+
+    //
+    // The following functions are only used by the partitioned pools.
+    //
+    const std::vector<work_stealing_task_queue *> &siblings();
+    // Steal at most `max_count` unordered tasks from the other queues of the pool.
+    void steal_from_siblings(int max_count, task_list &tasks);
+    void wake_up_idle_sibling();
+    int take_steal_hints(int units);
+
+    const bool _partitioned;
+
+    // The units of the semaphore are the sum of the tasks in this queue and the steal hints,
+    // each unit acquired by a worker (or a thief) entitles it to take a task.
+    moodycamel::LightweightSemaphore _sema;
+
+    // The tasks run by the owner in FIFO order.
+    moodycamel::ConcurrentQueue<task *> _ordered[TASK_PRIORITY_COUNT];
+    // The tasks that could be run by any worker of the pool.
+    moodycamel::ConcurrentQueue<task *> _global[TASK_PRIORITY_COUNT];
+
+    std::vector<std::unique_ptr<worker_slot>> _slots;
+
+    std::once_flag _siblings_once;
+    std::vector<work_stealing_task_queue *> _siblings;
+    // Whether the owner is blocked waiting for tasks.
+    CACHELINE_ALIGNED std::atomic_bool _idle;
+    // The units signaled to the owner to steal from the siblings rather than for its own tasks.
+    std::atomic<int> _steal_hints;
+
+    DISALLOW_COPY_AND_ASSIGN(work_stealing_task_queue);
+    DISALLOW_MOVE_AND_ASSIGN(work_stealing_task_queue);
+};
+
+} // namespace tools
+} // namespace dsn
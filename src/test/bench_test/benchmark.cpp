@@ -63,7 +63,8 @@ DSN_DEFINE_string(
     "\treadrandom_pegasus       -- pegasus read N times in random order\n"
     "\tdeleterandom_pegasus     -- pegasus delete N keys in random order\n"
     "\tmultisetrandom_pegasus   -- pegasus write N random values with multi_count hash keys list\n"
-    "\tmultigetrandom_pegasus   -- pegasus read N random keys with multi_count hash list\n");
+    "\tmultigetrandom_pegasus   -- pegasus read N random keys with multi_count hash list\n"
+    "\tincrhotkey_pegasus       -- pegasus incr a single hot counter N times\n");
 
 DSN_DEFINE_validator(benchmarks,
                      [](const char *value) -> bool { return !dsn::utils::is_empty(value); });
@@ -107,7 +108,8 @@ benchmark::benchmark()
                          {kWrite, &benchmark::write_random},
                          {kMultiSet, &benchmark::multi_set_random},
                          {kMultiGet, &benchmark::multi_get_random},
-                         {kDelete, &benchmark::delete_random}};
+                         {kDelete, &benchmark::delete_random},
+                         {kIncr, &benchmark::incr_hot_key}};
 }
 
 void benchmark::run()
@@ -370,6 +372,34 @@ void benchmark::delete_random(thread_arg *thread)
     }
 }
 
+void benchmark::incr_hot_key(thread_arg *thread)
+{
+    // All the threads incr the same counter, to measure the throughput of the atomic writes
+    // on a single hot key.
+    static const std::string kHashKey("incr_hot_hash_key");
+    static const std::string kSortKey("incr_hot_sort_key");
+
+    for (int i = 0; i < FLAGS_benchmark_num; i++) {
+        int try_count = 0;
+        while (true) {
+            try_count++;
+            int64_t new_value = 0;
+            int ret = _client->incr(kHashKey, kSortKey, 1, new_value, FLAGS_pegasus_timeout_ms);
+            if (ret == ::pegasus::PERR_OK) {
+                break;
+            }
+            if (ret != ::pegasus::PERR_TIMEOUT || try_count > 3) {
+                fmt::print(stderr, "Incr returned an error: {}\n", _client->get_error_string(ret));
+                dsn_exit(1);
+            }
+            fmt::print(stderr, "Incr timeout, retry({})\n", try_count);
+        }
+
+        // Count this operation.
+        thread->stats.finished_ops(1, kIncr);
+    }
+}
+
 void benchmark::generate_kv_pair(std::string &hashkey, std::string &sortkey, std::string &value)
 {
     hashkey = generate_string(FLAGS_hashkey_size);
@@ -390,6 +420,8 @@ operation_type benchmark::get_operation_type(const std::string &name)
         op_type = kMultiSet;
     } else if (name == "multigetrandom_pegasus") {
         op_type = kMultiGet;
+    } else if (name == "incrhotkey_pegasus") {
+        op_type = kIncr;
     } else if (!name.empty()) { // No error message for empty name
         fmt::print(stderr, "unknown benchmark '{}'\n", name);
         dsn_exit(1);
@@ -75,6 +75,7 @@ private:
     void delete_random(thread_arg *thread);
     void multi_set_random(thread_arg *thread);
     void multi_get_random(thread_arg *thread);
+    void incr_hot_key(thread_arg *thread);
 
     /**  generate hash/sort key and value */
     void generate_kv_pair(std::string &hashkey, std::string &sortkey, std::string &value);
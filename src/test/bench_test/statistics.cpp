@@ -36,7 +36,8 @@ std::unordered_map<operation_type, std::string, std::hash<unsigned char>> operat
     {kWrite, "write"},
     {kDelete, "delete"},
     {kMultiSet, "multiSet"},
-    {kMultiGet, "multiGet"}};
+    {kMultiGet, "multiGet"},
+    {kIncr, "incr"}};
 
 statistics::statistics(std::shared_ptr<rocksdb::Statistics> hist_stats)
 {
@@ -28,7 +28,8 @@ enum operation_type
     kWrite,
     kDelete,
     kMultiGet,
-    kMultiSet
+    kMultiSet,
+    kIncr
 };
 } // namespace test
 } // namespace pegasus
@@ -189,6 +189,11 @@ DEFINE_ERR_CODE(ERR_HTTP_ERROR)
 
 DEFINE_ERR_CODE(ERR_NOT_MATCHED)
 
+// Some rows written by a request do not belong to the partition it is sent to, e.g. after the
+// partition is split. Unlike ERR_PARENT_PARTITION_MISUSED, resending the same request would
+// never succeed, thus it is not retried by the partition resolver.
+DEFINE_ERR_CODE(ERR_PARTITION_HASH_MISMATCHED)
+
 } // namespace dsn
 
 USER_DEFINED_STRUCTURE_FORMATTER(::dsn::error_code);
@@ -0,0 +1,164 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "utils/io_uring.h"
+
+#ifdef DSN_HAS_IO_URING
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "utils/fmt_logging.h"
+#include "utils/safe_strerror_posix.h"
+
+namespace dsn {
+namespace utils {
+
+io_uring_queue::io_uring_queue()
+    : sq_ptr(MAP_FAILED), cq_ptr(MAP_FAILED), sqes(static_cast<io_uring_sqe *>(MAP_FAILED))
+{
+}
+
+io_uring_queue::~io_uring_queue()
+{
+    if (sqes != MAP_FAILED) {
+        ::munmap(sqes, sqes_size);
+    }
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+        ::munmap(cq_ptr, cq_size);
+    }
+    if (sq_ptr != MAP_FAILED) {
+        ::munmap(sq_ptr, sq_size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+/*static*/ std::unique_ptr<io_uring_queue> io_uring_queue::create(uint32_t entries,
+                                                                  uint32_t cq_entries)
+{
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (cq_entries > 0) {
+        params.flags |= IORING_SETUP_CQSIZE;
+        params.cq_entries = cq_entries;
+    }
+
+    std::unique_ptr<io_uring_queue> q(new io_uring_queue());
+    q->fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (q->fd < 0) {
+        LOG_WARNING("io_uring_setup failed: {}", safe_strerror(errno));
+        return nullptr;
+    }
+    q->sq_entries = params.sq_entries;
+    q->cq_entries = params.cq_entries;
+    q->features = params.features;
+
+    q->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    q->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        q->sq_size = q->cq_size = std::max(q->sq_size, q->cq_size);
+    }
+    q->sq_ptr = ::mmap(nullptr,
+                       q->sq_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       q->fd,
+                       IORING_OFF_SQ_RING);
+    if (q->sq_ptr == MAP_FAILED) {
+        LOG_WARNING("mmap the submission queue failed: {}", safe_strerror(errno));
+        return nullptr;
+    }
+    if (single_mmap) {
+        q->cq_ptr = q->sq_ptr;
+    } else {
+        q->cq_ptr = ::mmap(nullptr,
+                           q->cq_size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE,
+                           q->fd,
+                           IORING_OFF_CQ_RING);
+        if (q->cq_ptr == MAP_FAILED) {
+            LOG_WARNING("mmap the completion queue failed: {}", safe_strerror(errno));
+            return nullptr;
+        }
+    }
+    q->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    q->sqes = static_cast<io_uring_sqe *>(::mmap(nullptr,
+                                                 q->sqes_size,
+                                                 PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE,
+                                                 q->fd,
+                                                 IORING_OFF_SQES));
+    if (q->sqes == MAP_FAILED) {
+        LOG_WARNING("mmap the submission queue entries failed: {}", safe_strerror(errno));
+        return nullptr;
+    }
+
+    auto *sq = static_cast<char *>(q->sq_ptr);
+    q->sq_head = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    q->sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    q->sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    q->sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    auto *cq = static_cast<char *>(q->cq_ptr);
+    q->cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    q->cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    q->cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    q->cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    return q;
+}
+
+io_uring_sqe *io_uring_queue::get_sqe()
+{
+    // Only the submitter updates the tail, while the kernel updates the head once the entries
+    // are consumed.
+    const unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    const unsigned tail = *sq_tail;
+    if (tail - head >= sq_entries) {
+        return nullptr;
+    }
+
+    const unsigned index = tail & *sq_mask;
+    auto *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+int io_uring_queue::enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+{
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+int io_uring_queue::register_op(uint32_t opcode, void *arg, uint32_t nr_args)
+{
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+} // namespace utils
+} // namespace dsn
+
+#endif // DSN_HAS_IO_URING
@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) &&                              \
+    defined(__NR_io_uring_register)
+#define DSN_HAS_IO_URING 1
+#endif
+#endif
+
+namespace dsn {
+namespace utils {
+
+// The submission and completion queues shared with the kernel, see io_uring_setup(2). liburing
+// is not available, so the rings are driven by the raw syscalls.
+//
+// The submission queue must be filled by only one thread at a time, and so is the completion
+// queue consumed.
+struct io_uring_queue
+{
+#ifdef DSN_HAS_IO_URING
+    // Returns nullptr if io_uring is not supported by the kernel. The completion queue is twice
+    // as large as the submission queue if `cq_entries` is 0.
+    static std::unique_ptr<io_uring_queue> create(uint32_t entries, uint32_t cq_entries = 0);
+
+    ~io_uring_queue();
+
+    // Get the entry at the tail of the submission queue, or nullptr if the queue is full. The
+    // entry is reset and made visible to the kernel at once, thus it must be filled before the
+    // next enter().
+    io_uring_sqe *get_sqe();
+
+    // See io_uring_enter(2) and io_uring_register(2), returns -1 with `errno` set on failure.
+    int enter(uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+    int register_op(uint32_t opcode, void *arg, uint32_t nr_args);
+
+    int fd = -1;
+    uint32_t sq_entries = 0;
+    uint32_t cq_entries = 0;
+    uint32_t features = 0;
+
+    void *sq_ptr;
+    size_t sq_size = 0;
+    void *cq_ptr;
+    size_t cq_size = 0;
+    io_uring_sqe *sqes;
+    size_t sqes_size = 0;
+
+    unsigned *sq_head = nullptr;
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+private:
+    io_uring_queue();
+#endif // DSN_HAS_IO_URING
+};
+
+} // namespace utils
+} // namespace dsn
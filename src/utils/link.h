@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cassert>
 
 // single linked list.
@@ -194,6 +195,58 @@ public:
     }
 
 private:
+    friend class dlink_mpsc_queue;
+
     dlink *_next;
     dlink *_prev;
 };
+
+// lock-free multiple-producer single-consumer queue of dlink nodes.
+//
+// the producers link the pushed nodes by their _next (thus a pushed node is not alone any more),
+// while the consumer takes all of them at once and moves them into a dlink list in FIFO order.
+class dlink_mpsc_queue
+{
+public:
+    dlink_mpsc_queue() : _head(nullptr) {}
+
+    // could be called concurrently
+    void push(dlink *node)
+    {
+        assert(node->is_alone()); //, "must not be linked to other list before push");
+
+        auto *head = _head.load(std::memory_order_relaxed);
+        do {
+            node->_next = head;
+        } while (!_head.compare_exchange_weak(head, node));
+    }
+
+    bool empty() const { return _head.load() == nullptr; }
+
+    // move all the pushed nodes to the tail of list, return the count of the moved nodes.
+    // must not be called concurrently
+    int pop_all(dlink *list)
+    {
+        // the nodes are popped in LIFO order, reverse them firstly
+        dlink *first = nullptr;
+        for (auto *node = _head.exchange(nullptr); node != nullptr;) {
+            auto *next = node->_next;
+            node->_next = first;
+            first = node;
+            node = next;
+        }
+
+        int count = 0;
+        while (first != nullptr) {
+            auto *next = first->_next;
+            first->_next = first->_prev = first;
+            first->insert_before(list);
+            first = next;
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    std::atomic<dlink *> _head;
+};
@@ -825,7 +825,11 @@ ENUM_END(metric_type)
     DEF(FileLoads)                                                                                 \
     DEF(FileUploads)                                                                               \
     DEF(BulkLoads)                                                                                 \
-    DEF(Beacons)
+    DEF(Beacons)                                                                                   \
+    DEF(Contexts)                                                                                  \
+    DEF(Allocations)                                                                               \
+    DEF(Messages)                                                                                  \
+    DEF(Batches)
 
 enum class metric_unit : size_t
 {
@@ -159,6 +159,45 @@ error_s pattern_match(const std::string &str,
     return error_s::ok();
 }
 
+bool glob_match(std::string_view str, std::string_view pattern)
+{
+    size_t s = 0;
+    size_t p = 0;
+
+    // The position of the latest '*' in `pattern`, and the position in `str` from which
+    // the bytes are consumed by it.
+    size_t star = std::string_view::npos;
+    size_t star_s = 0;
+
+    while (s < str.size()) {
+        if (p < pattern.size() && pattern[p] == '*') {
+            // Let '*' match the empty sequence first.
+            star = p++;
+            star_s = s;
+            continue;
+        }
+
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s])) {
+            ++s;
+            ++p;
+            continue;
+        }
+
+        if (star == std::string_view::npos) {
+            return false;
+        }
+
+        // Let the latest '*' consume one more byte, and resume matching after it.
+        p = star + 1;
+        s = ++star_s;
+    }
+
+    // The remaining pattern could only be matched by the empty sequence.
+    for (; p < pattern.size() && pattern[p] == '*'; ++p) {
+    }
+    return p == pattern.size();
+}
+
 std::string_view get_last_component(std::string_view str, std::string_view splitters)
 {
     const auto pos = str.find_last_of(splitters);
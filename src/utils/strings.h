@@ -85,6 +85,13 @@ error_s pattern_match(const std::string &str,
                       const std::string &pattern,
                       pattern_match_type::type match_type);
 
+// Return true if the whole `str` is matched by the glob `pattern`, where '*' matches any
+// sequence of bytes (including the empty one), '?' matches any single byte, and any other
+// byte matches itself. Once a mismatch occurs, matching is resumed only from the latest '*',
+// thus it never recurses and takes at most O(str.size() * pattern.size()) time, which is
+// linear in the size of `str` for a given pattern.
+bool glob_match(std::string_view str, std::string_view pattern);
+
 // Split the `input` string by the only character `separator` into tokens. Leading and trailing
 // spaces of each token will be stripped. Once the token is empty, or become empty after
 // stripping, an empty string will be added into `output` if `keep_place_holder` is enabled.
@@ -428,6 +428,68 @@ TEST_P(PatternMatchTest, PatternMatch)
 
 INSTANTIATE_TEST_SUITE_P(StringTest, PatternMatchTest, testing::ValuesIn(pattern_match_tests));
 
+struct glob_match_case
+{
+    std::string str;
+    std::string pattern;
+    bool expected_matched;
+};
+
+class GlobMatchTest : public testing::TestWithParam<glob_match_case>
+{
+};
+
+const std::vector<glob_match_case> glob_match_tests = {
+    // Empty string is only matched by the empty pattern or '*'s.
+    {"", "", true},
+    {"", "*", true},
+    {"", "**", true},
+    {"", "?", false},
+    // Non-empty string cannot be matched by empty pattern.
+    {"abc", "", false},
+    // The pattern without wildcards is matched exactly.
+    {"abc", "abc", true},
+    {"abc", "ab", false},
+    {"ab", "abc", false},
+    // '?' matches exactly one byte.
+    {"abc", "a?c", true},
+    {"abc", "???", true},
+    {"abc", "??", false},
+    {"abc", "????", false},
+    // '*' matches any sequence of bytes.
+    {"abc", "*", true},
+    {"abc", "a*", true},
+    {"abc", "*c", true},
+    {"abc", "*b*", true},
+    {"abc", "a*b*c", true},
+    {"abc", "a***c", true},
+    {"abc", "*d*", false},
+    {"abc", "b*", false},
+    {"abc", "*b", false},
+    // Matching is resumed from the latest '*' once a mismatch occurs.
+    {"abcbcd", "a*bcd", true},
+    {"aaaaab", "*a*b", true},
+    {"mississippi", "m*iss*ppi", true},
+    {"mississippi", "m*iss*pi?", false},
+    {"user_123_profile", "user_*_profile", true},
+    {"user_123_profiles", "user_*_profile", false},
+    // The patterns which make a backtracking matcher blow up are still matched quickly.
+    {std::string(4096, 'a'), "*a*a*a*a*a*a*a*a*b", false},
+    {std::string(4096, 'a') + "b", "*a*a*a*a*a*a*a*a*b", true},
+    // Bytes other than '*' and '?' are matched literally, including the binary ones.
+    {std::string("a\0b", 3), std::string("a\0*", 3), true},
+    {"a.c", "a.c", true},
+    {"abc", "a.c", false},
+};
+
+TEST_P(GlobMatchTest, GlobMatch)
+{
+    const auto &test_case = GetParam();
+    EXPECT_EQ(test_case.expected_matched, glob_match(test_case.str, test_case.pattern));
+}
+
+INSTANTIATE_TEST_SUITE_P(StringTest, GlobMatchTest, testing::ValuesIn(glob_match_tests));
+
 // For containers such as std::unordered_set, the expected result will be deduplicated
 // at initialization. Therefore, it can be used to compare with actual result safely.
 template <typename Container>
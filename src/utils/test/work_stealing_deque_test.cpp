@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "utils/work_stealing_deque.h"
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace dsn {
+namespace utils {
+
+TEST(work_stealing_deque_test, push_pop_steal)
+{
+    work_stealing_deque<int> q(4);
+    int item = 0;
+    ASSERT_FALSE(q.pop(item));
+    ASSERT_FALSE(q.steal(item));
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(q.push(i));
+    }
+    ASSERT_EQ(4u, q.size_approx());
+
+    // The deque is full.
+    ASSERT_FALSE(q.push(4));
+
+    // The owner pops the latest one, while the thieves steal the earliest one.
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(3, item);
+    ASSERT_TRUE(q.steal(item));
+    ASSERT_EQ(0, item);
+    ASSERT_TRUE(q.steal(item));
+    ASSERT_EQ(1, item);
+    ASSERT_TRUE(q.pop(item));
+    ASSERT_EQ(2, item);
+
+    ASSERT_FALSE(q.pop(item));
+    ASSERT_FALSE(q.steal(item));
+    ASSERT_EQ(0u, q.size_approx());
+
+    // The slots are reused once the items are taken.
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(q.push(i + 10));
+    }
+    ASSERT_FALSE(q.push(14));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(q.steal(item));
+        ASSERT_EQ(i + 10, item);
+    }
+}
+
+// The owner pushes, pops and steals while the thieves keep stealing, each item must be taken
+// exactly once.
+TEST(work_stealing_deque_test, concurrent_steal)
+{
+    constexpr int kItemCount = 1000000;
+    constexpr int kThiefCount = 3;
+
+    work_stealing_deque<int> q(256);
+    std::vector<std::atomic<int>> taken(kItemCount);
+    for (auto &t : taken) {
+        t.store(0);
+    }
+    std::atomic_bool done{false};
+    std::atomic<int> stolen{0};
+
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < kThiefCount; ++i) {
+        thieves.emplace_back([&]() {
+            int item = 0;
+            while (!done.load()) {
+                if (q.steal(item)) {
+                    ++taken[item];
+                    ++stolen;
+                }
+            }
+        });
+    }
+
+    int item = 0;
+    int popped = 0;
+    for (int i = 0; i < kItemCount; ++i) {
+        while (!q.push(i)) {
+            if (q.pop(item)) {
+                ++taken[item];
+                ++popped;
+            }
+        }
+        // Pop sometimes to race with the thieves on the last item.
+        if (i % 3 == 0 && q.pop(item)) {
+            ++taken[item];
+            ++popped;
+        }
+        // Steal the oldest item sometimes, as work_stealing_task_queue does to avoid starving
+        // it, which races with the thieves on the same end.
+        if (i % 5 == 0 && q.steal(item)) {
+            ++taken[item];
+            ++popped;
+        }
+    }
+    while (q.pop(item)) {
+        ++taken[item];
+        ++popped;
+    }
+    // The thieves might be taking the last items.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (popped + stolen.load() < kItemCount && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+
+    done = true;
+    for (auto &t : thieves) {
+        t.join();
+    }
+
+    ASSERT_EQ(kItemCount, popped + stolen.load());
+    for (int i = 0; i < kItemCount; ++i) {
+        ASSERT_EQ(1, taken[i].load()) << "item " << i;
+    }
+}
+
+} // namespace utils
+} // namespace dsn
@@ -0,0 +1,136 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "utils/fmt_logging.h"
+#include "utils/ports.h"
+
+namespace dsn {
+namespace utils {
+
+// The lock-free work-stealing deque of Chase and Lev ("Dynamic Circular Work-Stealing Deque",
+// SPAA'05), with the memory orders given by Le et al. ("Correct and Efficient Work-Stealing for
+// Weak Memory Models", PPoPP'13).
+//
+// Only the owner thread pushes and pops at the bottom (LIFO), while any thread could steal from
+// the top (FIFO). Unlike the original one, the capacity is fixed rather than growing, thus no
+// buffer has to be reclaimed; push() just fails once the deque is full.
+template <typename T>
+class work_stealing_deque
+{
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+    // `capacity` must be a power of 2.
+    explicit work_stealing_deque(size_t capacity)
+        : _top(0),
+          _bottom(0),
+          _mask(static_cast<int64_t>(capacity) - 1),
+          _items(new std::atomic<T>[capacity])
+    {
+        CHECK((capacity & (capacity - 1)) == 0 && capacity > 0,
+              "the capacity({}) must be a power of 2",
+              capacity);
+    }
+
+    // Called only by the owner. Returns false if the deque is full.
+    bool push(T item)
+    {
+        const auto b = _bottom.load(std::memory_order_relaxed);
+        const auto t = _top.load(std::memory_order_acquire);
+        if (b - t > _mask) {
+            return false;
+        }
+
+        _items[b & _mask].store(item, std::memory_order_relaxed);
+        // Publish the item to the thieves, which load the bottom with acquire.
+        _bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Called only by the owner. Returns false if the deque is empty.
+    bool pop(T &item)
+    {
+        const auto b = _bottom.load(std::memory_order_relaxed) - 1;
+        _bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = _top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            // Empty.
+            _bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = _items[b & _mask].load(std::memory_order_relaxed);
+        if (t < b) {
+            return true;
+        }
+
+        // The last item, which might be stolen at the same time.
+        const bool won = _top.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        _bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    // Called by any thread. Returns false if the deque is empty, or the item is taken by
+    // another thread at the same time.
+    bool steal(T &item)
+    {
+        auto t = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = _bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        item = _items[t & _mask].load(std::memory_order_relaxed);
+        return _top.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // Might be inaccurate while the deque is being updated.
+    size_t size_approx() const
+    {
+        const auto b = _bottom.load(std::memory_order_relaxed);
+        const auto t = _top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+private:
+    // The thieves and the owner update the two ends respectively, keep them apart.
+    CACHELINE_ALIGNED std::atomic<int64_t> _top;
+    CACHELINE_ALIGNED std::atomic<int64_t> _bottom;
+    const int64_t _mask;
+    std::unique_ptr<std::atomic<T>[]> _items;
+
+    DISALLOW_COPY_AND_ASSIGN(work_stealing_deque);
+    DISALLOW_MOVE_AND_ASSIGN(work_stealing_deque);
+};
+
+} // namespace utils
+} // namespace dsn